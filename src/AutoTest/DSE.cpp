@@ -0,0 +1,394 @@
+/*
+  Design-space exploration driver for FloPoCo
+
+  Builds all the points of a parameter grid for one operator, each in a
+  forked worker process (so that a crash or a memory blow-up of one
+  candidate does not affect the others), and keeps the Pareto front
+  with respect to latency, LUTs and DSPs.
+
+  This file is part of the FloPoCo project
+
+  Initial software.
+  Copyright © INSA-Lyon, INRIA, CNRS, UCBL.
+  All rights reserved.
+
+*/
+
+#include "DSE.hpp"
+#include "../Operator.hpp"
+#include "../Signal.hpp"
+#include "../Target.hpp"
+#include "../utils.hpp"
+#include "../Table.hpp"
+#include "../BitHeap/Compressor.hpp"
+#include "../IntAddSubCmp/IntAdder.hpp"
+#include "../IntMult/DSPBlock.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <math.h>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace flopoco
+{
+
+	OperatorPtr DSE::parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args)
+	{
+		string opName;
+		int jobs;
+		string outputFile;
+		UserInterface::parseString(args, "operator", &opName);
+		UserInterface::parseInt(args, "jobs", &jobs);
+		UserInterface::parseString(args, "outputFile", &outputFile);
+
+		// All the remaining arguments define the grid
+		vector<pair<string, vector<string>>> grid;
+		for (unsigned i=1; i<args.size(); i++) {
+			size_t eqPos = args[i].find('=');
+			if(eqPos == string::npos || eqPos == 0)
+				throw(string("DSE: expected a grid parameter as name=values, got ") + args[i]);
+			grid.push_back(make_pair(args[i].substr(0, eqPos), expandValues(args[i].substr(eqPos+1))));
+		}
+		args.erase(args.begin()+1, args.end());
+
+		DSE dse(target, opName, grid, jobs, outputFile);
+
+		return nullptr;
+	}
+
+	void DSE::registerFactory()
+	{
+		UserInterface::add("DSE", // name
+			"Design-space exploration: builds all the points of a parameter grid for one operator, and reports the Pareto-optimal ones (latency, LUTs, DSPs).",
+			"AutoTest",
+			"", //seeAlso
+			"operator(string): name of the operator to explore;\
+			jobs(int)=0: number of worker processes, 0 for one per hardware thread;\
+			outputFile(string)=dse: the results are written to outputFile.csv and outputFile.json;",
+			"All the other parameters are parameters of the explored operator, given as a comma-separated list of values and integer ranges, \
+for instance <code>flopoco DSE operator=FPExp wE=8 wF=23 k=8..11 d=1,2</code>. \
+<code>frequency</code> may also be part of the grid. \
+FF are the pipeline registers. DSPs are the DSP blocks instantiated. LUTs are summed over the components that have a cost model (bit heap compressors, logic tables, adders, ResourceEstimationHelper estimations), and reported as unknown when there is none.",
+			DSE::parseArguments
+			) ;
+	}
+
+
+
+	// The LUT count, or unknown when no component of the candidate has a cost model
+	static string lutString(int lut)
+	{
+		return (lut < 0 ? string("unknown") : to_string(lut));
+	}
+
+
+
+	DSE::DSE(Target* target_, string opName_, vector<pair<string, vector<string>>> grid, int jobs, string outputFile):
+		target(target_), opName(opName_)
+	{
+		UserInterface::getFactoryByName(opName); // throws if there is no such operator
+
+		// Enumerate the cartesian product of the grid
+		for(auto g: grid)
+			paramNames.push_back(g.first);
+		vector<map<string,string>> points(1);
+		for(auto g: grid) {
+			vector<map<string,string>> newPoints;
+			for(auto p: points)
+				for(auto v: g.second) {
+					map<string,string> q = p;
+					q[g.first] = v;
+					newPoints.push_back(q);
+				}
+			points = newPoints;
+		}
+		for(auto p: points) {
+			Candidate c;
+			c.params = p;
+			c.ok = false;
+			c.pareto = false;
+			candidates.push_back(c);
+		}
+
+		if(jobs <= 0)
+			jobs = std::max(1u, std::thread::hardware_concurrency());
+		cerr << "> DSE: exploring " << candidates.size() << " configuration(s) of " << opName << " with " << jobs << " worker process(es)" << endl;
+
+		// Each candidate is built in its own worker process, at most jobs at a time
+		size_t done = 0;
+		forkMap(candidates.size(), jobs,
+						[&](int i) {
+							UserInterface::workers = 1; // the DSE workers already use all the cores
+							if(UserInterface::verbose < DETAILED) {
+								int devNull = open("/dev/null", O_WRONLY);
+								dup2(devNull, 1);
+								dup2(devNull, 2);
+							}
+							return evaluate(candidates[i].params);
+						},
+						[&](int i, string result) {
+							if(result == "")
+								result = "ERROR the worker process died";
+							Candidate &c = candidates[i];
+							parseResult(c, result);
+							done++;
+							cerr << "> DSE: [" << done << "/" << candidates.size() << "]";
+							for(auto p: c.params)
+								cerr << " " << p.first << "=" << p.second;
+							if(c.ok)
+								cerr << "  latency=" << c.latency << " LUT=" << lutString(c.lut) << " DSP=" << c.dsp << " FF=" << c.ff << endl;
+							else
+								cerr << "  failed: " << c.error << endl;
+							return true;
+						},
+						0, true);
+
+		computeParetoFront();
+		outputCSV(outputFile + ".csv");
+		outputJSON(outputFile + ".json");
+
+		cerr << "> DSE: Pareto front:" << endl;
+		for(auto c: candidates) {
+			if(!c.pareto)
+				continue;
+			cerr << tab;
+			for(auto p: c.params)
+				cerr << p.first << "=" << p.second << " ";
+			cerr << " latency=" << c.latency << " LUT=" << lutString(c.lut) << " DSP=" << c.dsp << " (critical path " << c.criticalPath << "ns)" << endl;
+		}
+		cerr << "> DSE: results written to " << outputFile << ".csv and " << outputFile << ".json" << endl;
+	}
+
+
+
+	vector<string> DSE::expandValues(string values)
+	{
+		vector<string> result;
+		stringstream s(values);
+		string item;
+		while(getline(s, item, ',')) {
+			size_t dotPos = item.find("..");
+			if(dotPos == string::npos) {
+				result.push_back(item);
+			}
+			else {
+				int first, last;
+				try {
+					first = stoi(item.substr(0, dotPos));
+					last = stoi(item.substr(dotPos+2));
+				}
+				catch(std::exception &e) {
+					throw(string("DSE: can't parse the range ") + item);
+				}
+				for(int i=first; i<=last; i++)
+					result.push_back(to_string(i));
+			}
+		}
+		if(result.empty())
+			throw(string("DSE: empty list of values in ") + values);
+		return result;
+	}
+
+
+
+	// Accumulates the figures of merit of op and of the operators it instantiates, each shared operator once per instance.
+	// LUTs are only counted for the components that have a cost model, lutKnown tells if there was any.
+	// DSPs are the DSPBlock instances.
+	static void collectFigures(Operator* op, int &ff, int &lut, bool &lutKnown, int &dsp, double &criticalPath)
+	{
+		for(auto s: op->getSignalList()) {
+			criticalPath = max(criticalPath, s->getCriticalPath());
+			if((s->type() == Signal::wire || s->type() == Signal::in) && s->getLifeSpan() > 0)
+				ff += s->getLifeSpan() * s->width();
+		}
+		for(auto s: *op->getIOList())
+			criticalPath = max(criticalPath, s->getCriticalPath());
+
+		if(op->reHelper->estimatedCountLUT > 0) {
+			lut += op->reHelper->estimatedCountLUT;
+			lutKnown = true;
+		}
+		if(Compressor* c = dynamic_cast<Compressor*>(op)) {
+			lut += ceil(c->area);
+			lutKnown = true;
+		}
+		else if(Table* t = dynamic_cast<Table*>(op)) {
+			if(t->isLogicTable())
+				lut += t->size_in_LUTs();
+			lutKnown = true;
+		}
+		else if(dynamic_cast<IntAdder*>(op)) {
+			lut += op->getSignalByName("R")->width(); // one LUT per bit in front of the carry chain
+			lutKnown = true;
+		}
+		else if(dynamic_cast<DSPBlock*>(op))
+			dsp++;
+
+		for(auto i: op->getInstanceOps())
+			collectFigures(i.second, ff, lut, lutKnown, dsp, criticalPath);
+	}
+
+
+
+	string DSE::evaluate(map<string,string> params)
+	{
+		ostringstream result;
+		try {
+			vector<string> args;
+			args.push_back(opName);
+			for(auto p: params) {
+				if(p.first == "frequency")
+					target->setFrequency(1e6*stod(p.second));
+				else
+					args.push_back(p.first + "=" + p.second);
+			}
+			OperatorPtr op = UserInterface::getFactoryByName(opName)->parseArguments(nullptr, target, args);
+			if(op == nullptr)
+				throw(string("the factory did not build an operator"));
+			UserInterface::globalOpList.push_back(op);
+			op->schedule();
+			op->applySchedule();
+			int ff = 0, lut = 0, dsp = 0;
+			bool lutKnown = false;
+			double criticalPath = 0;
+			collectFigures(op, ff, lut, lutKnown, dsp, criticalPath);
+			result << "OK " << op->getPipelineDepth() << " " << criticalPath*1e9 << " " << ff << " " << (lutKnown ? lut : -1) << " " << dsp;
+		}
+		catch(string &s) {
+			result << "ERROR " << s;
+		}
+		catch(const char* s) {
+			result << "ERROR " << s;
+		}
+		catch(std::exception &e) {
+			result << "ERROR " << e.what();
+		}
+		string r = result.str();
+		replace(r.begin(), r.end(), '\n', ' '); // one line, as forkMap() passes the results of the workers
+		return r;
+	}
+
+
+
+	void DSE::parseResult(Candidate &c, string result)
+	{
+		istringstream s(result);
+		string status;
+		s >> status;
+		if(status == "OK") {
+			s >> c.latency >> c.criticalPath >> c.ff >> c.lut >> c.dsp;
+			c.ok = !s.fail();
+			if(!c.ok)
+				c.error = "unreadable result: " + result;
+		}
+		else {
+			c.ok = false;
+			c.error = (result.size() > 6 ? result.substr(6) : result);
+		}
+	}
+
+
+
+	void DSE::computeParetoFront()
+	{
+		for(auto &c: candidates) {
+			if(!c.ok)
+				continue;
+			c.pareto = true;
+			for(auto &d: candidates) {
+				if(!d.ok)
+					continue;
+				// an unknown LUT count (-1) is only comparable to another unknown one
+				if((d.lut < 0) != (c.lut < 0))
+					continue;
+				bool noWorse = d.latency <= c.latency && d.lut <= c.lut && d.dsp <= c.dsp;
+				bool better = d.latency < c.latency || d.lut < c.lut || d.dsp < c.dsp;
+				if(noWorse && better) {
+					c.pareto = false;
+					break;
+				}
+			}
+		}
+	}
+
+
+
+	void DSE::outputCSV(string fileName)
+	{
+		ofstream file(fileName.c_str(), ios::out);
+		if(!file)
+			throw(string("DSE: can't open ") + fileName);
+		for(auto p: paramNames)
+			file << p << ",";
+		file << "latency,criticalPath_ns,FF,LUT,DSP,pareto,error" << endl;
+		for(auto c: candidates) {
+			for(auto p: paramNames)
+				file << "\"" << c.params[p] << "\",";
+			if(c.ok)
+				file << c.latency << "," << c.criticalPath << "," << c.ff << "," << lutString(c.lut) << "," << c.dsp << "," << (c.pareto ? 1 : 0) << "," << endl;
+			else {
+				string e = c.error;
+				replace(e.begin(), e.end(), '"', '\'');
+				file << ",,,,,0,\"" << e << "\"" << endl;
+			}
+		}
+		file.close();
+	}
+
+
+
+	static string jsonString(string s)
+	{
+		ostringstream o;
+		o << "\"";
+		for(auto ch: s) {
+			if(ch == '"' || ch == '\\')
+				o << "\\" << ch;
+			else if(ch == '\t')
+				o << "\\t";
+			else
+				o << ch;
+		}
+		o << "\"";
+		return o.str();
+	}
+
+
+
+	void DSE::outputJSON(string fileName)
+	{
+		ofstream file(fileName.c_str(), ios::out);
+		if(!file)
+			throw(string("DSE: can't open ") + fileName);
+		file << "{" << endl;
+		file << tab << "\"operator\": " << jsonString(opName) << "," << endl;
+		file << tab << "\"target\": " << jsonString(target->getID()) << "," << endl;
+		file << tab << "\"frequencyMHz\": " << target->frequencyMHz() << "," << endl;
+		file << tab << "\"candidates\": [" << endl;
+		for(size_t i=0; i<candidates.size(); i++) {
+			Candidate &c = candidates[i];
+			file << tab << tab << "{\"params\": {";
+			bool first = true;
+			for(auto p: c.params) {
+				file << (first ? "" : ", ") << jsonString(p.first) << ": " << jsonString(p.second);
+				first = false;
+			}
+			file << "}, ";
+			if(c.ok)
+				file << "\"latency\": " << c.latency << ", \"criticalPath_ns\": " << c.criticalPath
+						 << ", \"FF\": " << c.ff << ", \"LUT\": " << (c.lut < 0 ? "null" : to_string(c.lut)) << ", \"DSP\": " << c.dsp
+						 << ", \"pareto\": " << (c.pareto ? "true" : "false") << "}";
+			else
+				file << "\"error\": " << jsonString(c.error) << ", \"pareto\": false}";
+			file << (i+1 < candidates.size() ? "," : "") << endl;
+		}
+		file << tab << "]" << endl;
+		file << "}" << endl;
+		file.close();
+	}
+
+};
@@ -0,0 +1,72 @@
+#ifndef DSE_hpp
+#define DSE_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include "../UserInterface.hpp"
+
+using namespace std;
+
+namespace flopoco{
+
+	/**
+	 * Design-space exploration: builds every point of a parameter grid for one operator,
+	 * each in its own worker process, and reports the Pareto-optimal ones
+	 * with respect to latency (pipeline depth), LUTs and DSPs.
+	 */
+	class DSE
+	{
+
+	public:
+
+		/** The figures of merit of one point of the grid */
+		typedef struct {
+			map<string,string> params;
+			bool ok;
+			string error;
+			int latency;
+			double criticalPath; // in ns
+			int ff;
+			int lut; // -1 if unknown
+			int dsp;
+			bool pareto;
+		} Candidate;
+
+		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
+
+		static void registerFactory();
+
+		/**
+		 * @param target the target, shared by all the candidates
+		 * @param opName the name of the operator factory to explore
+		 * @param grid for each parameter, the list of values to try
+		 * @param jobs the number of worker processes, 0 for one per hardware thread
+		 * @param outputFile prefix of the .csv and .json result files
+		 */
+		DSE(Target* target, string opName, vector<pair<string, vector<string>>> grid, int jobs, string outputFile);
+
+	private:
+
+		/** Expands a value list such as 1,2,5..8 */
+		static vector<string> expandValues(string values);
+
+		/** Builds one candidate, called in the worker process. Returns the line to send to the parent */
+		string evaluate(map<string,string> params);
+
+		/** Fills candidate from the line sent by the worker */
+		void parseResult(Candidate &c, string result);
+
+		void computeParetoFront();
+
+		void outputCSV(string fileName);
+
+		void outputJSON(string fileName);
+
+		Target* target;
+		string opName;
+		vector<string> paramNames;
+		vector<Candidate> candidates;
+	};
+};
+#endif
@@ -2,6 +2,7 @@
 #include "CompressionStrategy.hpp"
 #include <climits>
 #include "PrimitiveComponents/Xilinx/XilinxGPC.hpp"
+#include "IntAddSubCmp/IntAdder.hpp"
 #include "assert.h"
 
 using namespace std;
@@ -852,9 +853,26 @@ namespace flopoco{
 			//create the instance of the adder
 			bitheap->getOp()->vhdl << bitheap->getOp()->instance(adder, join("bitheapFinalAdd_bh", bitheap->guid)) << endl;
 #else
+			//the final adder may use any architecture that does not lengthen the pipeline beyond the classical one,
+			//given the slack left in the cycle of its latest input bit
+			int adderWidth = bitheap->msb-adderStartIndex+1+1-bitheap->lsb;
+			int latestCycle = 0;
+			double latestCriticalPath = 0.0;
+			for(int i=bitheap->width-1; i>(int)compressionDoneIndex; i--){
+				for(unsigned j=0; j<bitheap->bits[i].size() && j<3; j++){
+					Signal* s = bitheap->bits[i][j]->signal;
+					if(s->getCycle() > latestCycle || (s->getCycle() == latestCycle && s->getCriticalPath() > latestCriticalPath)){
+						latestCycle = s->getCycle();
+						latestCriticalPath = s->getCriticalPath();
+					}
+				}
+			}
+			vector<IntAdder::TradeoffPoint> points = IntAdder::getTradeoffPoints(bitheap->getOp()->getTarget(), adderWidth, latestCriticalPath);
+			string adderLatency = (points.empty() ? "" : " maxLatency=" + to_string(points[0].latency));
+			REPORT(DEBUG, "final adder of " << adderWidth << " bits, with an input critical path of " << latestCriticalPath << adderLatency);
 			bitheap->getOp()->newInstance("IntAdder",
 																					"bitheapFinalAdd_bh"+to_string(bitheap->guid),
-																					"wIn=" + to_string(bitheap->msb-adderStartIndex+1+1-bitheap->lsb),
+																					"wIn=" + to_string(adderWidth) + adderLatency,
 																					"X=>"+ adderIn0Name.str()
 																					+ ",Y=>"+adderIn1Name.str()
 																					+ ",Cin=>" + adderCinName.str(),
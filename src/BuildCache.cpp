@@ -0,0 +1,440 @@
+/*
+  An on-disk cache of sub-operators, to avoid rebuilding the unchanged parts of a design.
+
+  This file is part of the FloPoCo project
+
+  Initial software.
+  Copyright © INSA-Lyon, INRIA, CNRS, UCBL.
+  All rights reserved.
+
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <climits>
+#include <cmath>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "BuildCache.hpp"
+#include "UserInterface.hpp"
+#include "utils.hpp"
+
+using namespace std;
+
+namespace flopoco{
+
+	string BuildCache::directory = "";
+	map<string, map<string, string>> BuildCache::tables;
+
+	// Bump this when the format of the entries, or the VHDL generation of the core, changes
+	static const string formatVersion = "2";
+
+	// The resource estimations of a subtree that the cache records, in the order of the entries
+	static const vector<int ResourceEstimationHelper::*> estimatedCounts = {
+		&ResourceEstimationHelper::estimatedCountFF, &ResourceEstimationHelper::estimatedCountLUT,
+		&ResourceEstimationHelper::estimatedCountMultiplier, &ResourceEstimationHelper::estimatedCountMemory,
+		&ResourceEstimationHelper::estimatedCountDSP, &ResourceEstimationHelper::estimatedCountRAM,
+		&ResourceEstimationHelper::estimatedCountROM, &ResourceEstimationHelper::estimatedCountSRL,
+		&ResourceEstimationHelper::estimatedCountWire, &ResourceEstimationHelper::estimatedCountIOB,
+		&ResourceEstimationHelper::estimatedCountMux, &ResourceEstimationHelper::estimatedCountCounter,
+		&ResourceEstimationHelper::estimatedCountAccumulator, &ResourceEstimationHelper::estimatedCountDecoder,
+		&ResourceEstimationHelper::estimatedCountArithOp, &ResourceEstimationHelper::estimatedCountAdderSubtracter,
+		&ResourceEstimationHelper::estimatedCountReg, &ResourceEstimationHelper::estimatedCountFSM};
+	static const vector<map<int, int> ResourceEstimationHelper::*> estimatedTypes = {
+		&ResourceEstimationHelper::estimatedLUTTypes, &ResourceEstimationHelper::estimatedAdderTypes,
+		&ResourceEstimationHelper::estimatedMultiplierTypes, &ResourceEstimationHelper::estimatedRegisterTypes,
+		&ResourceEstimationHelper::estimatedShifterTypes, &ResourceEstimationHelper::estimatedCounterTypes,
+		&ResourceEstimationHelper::estimatedArithOpTypes};
+
+	// Sums the resource estimations of op and of the operators it instantiates, each shared operator once per instance
+	static void sumEstimates(Operator* op, vector<int> &counts, vector<map<int, int>> &types)
+	{
+		for(size_t i=0; i<estimatedCounts.size(); i++)
+			counts[i] += op->reHelper->*estimatedCounts[i];
+		for(size_t i=0; i<estimatedTypes.size(); i++)
+			for(auto t: op->reHelper->*estimatedTypes[i])
+				types[i][t.first] += t.second;
+		for(auto i: op->getInstanceOps())
+			sumEstimates(i.second, counts, types);
+	}
+
+
+	string BuildCache::key(Operator* parentOp, vector<string> parameters, map<string, string> inPortMap)
+	{
+		if(directory == "")
+			return "";
+		Target* target = parentOp->getTarget();
+		// The depth of the clock enable tree is chosen by the root operator once the whole hierarchy is built,
+		// and it is in the VHDL of every sub-operator: such VHDL can not be reused under another root
+		if(target->useClockEnable() && target->useClockEnableTree())
+			return "";
+		ostringstream k;
+		k << "v" << formatVersion << " " << parameters[0];
+		// The parameters, in a canonical order
+		vector<string> params(parameters.begin()+1, parameters.end());
+		sort(params.begin(), params.end());
+		for(auto p: params)
+			k << " " << p;
+		// The target and the generic options
+		k << " | " << target->getID() << " " << target->frequencyMHz() << "MHz"
+			<< " ce=" << target->useClockEnable()
+			<< " plainVHDL=" << target->plainVHDL()
+			<< " useHardMult=" << target->useHardMultipliers()
+			<< " hardMultThreshold=" << target->unusedHardMultThreshold()
+			<< " registerLargeTables=" << target->registerLargeTables()
+			<< " retiming=" << target->retiming()
+			<< " delayLines=" << target->useDelayLines()
+			<< " tableCompression=" << target->tableCompression()
+			<< " useTargetOptimizations=" << target->useTargetOptimizations()
+			<< " compression=" << target->getCompressionMethod()
+			<< " tiling=" << target->getTilingMethod()
+			<< " ilpSolver=" << target->getILPSolver()
+			<< " ilpTimeout=" << target->getILPTimeout()
+			<< " adderGraphTimeout=" << target->getAdderGraphTimeout()
+			<< " asyncReset=" << UserInterface::allRegistersWithAsyncReset;
+		// The timing of the inputs, relative to the earliest one, since the sub-operator is scheduled accordingly
+		int minCycle = INT_MAX;
+		for(auto i: inPortMap) {
+			Signal* s = parentOp->getSignalByName(i.second);
+			if(s->type() != Signal::constant)
+				minCycle = min(minCycle, s->getCycle());
+		}
+		if(minCycle == INT_MAX) // only constant inputs: nothing to replay the timing from
+			return "";
+		k << " |";
+		for(auto i: inPortMap) {
+			Signal* s = parentOp->getSignalByName(i.second);
+			if(s->type() == Signal::constant)
+				k << " " << i.first << "=" << i.second.substr(0, i.second.find("_cst"));
+			else
+				k << " " << i.first << "@" << s->getCycle() - minCycle << "+" << llround(s->getCriticalPath()*1e12) << "ps";
+		}
+		return k.str();
+	}
+
+
+
+	string BuildCache::fileName(string key)
+	{
+		ostringstream f;
+		f << directory << "/" << hex << std::hash<string>()(key) << ".entry";
+		return f.str();
+	}
+
+
+
+	OperatorPtr BuildCache::lookup(Operator* parentOp, Target* target, string key)
+	{
+		ifstream file(fileName(key).c_str());
+		if(!file)
+			return nullptr;
+
+		string line;
+		getline(file, line);
+		if(line != "key " + key) // hash collision
+			return nullptr;
+
+		string tag, name;
+		int n;
+		bool sequential, reset;
+		vector<string> entityNames;
+		vector<CachedIO> io;
+		file >> tag >> name;
+		file >> tag >> n;
+		for(int i=0; i<n; i++) {
+			string e;
+			file >> e;
+			entityNames.push_back(e);
+		}
+		file >> tag >> sequential >> tag >> reset;
+		file >> tag >> n;
+		for(int i=0; i<n; i++) {
+			CachedIO c;
+			int type;
+			file >> c.name >> type >> c.width >> c.isBus >> c.isFix >> c.isSigned >> c.msb >> c.lsb
+					 >> c.isFP >> c.isIEEE >> c.wE >> c.wF >> c.cycle >> c.criticalPath;
+			c.type = (Signal::SignalType) type;
+			io.push_back(c);
+		}
+		vector<int> counts(estimatedCounts.size());
+		vector<map<int, int>> types(estimatedTypes.size());
+		file >> tag;
+		for(auto &c: counts)
+			file >> c;
+		for(auto &t: types) {
+			file >> tag >> n;
+			for(int i=0; i<n; i++) {
+				int width, count;
+				file >> width >> count;
+				t[width] = count;
+			}
+		}
+		file >> tag >> n;
+		getline(file, line); // end of the line
+		ostringstream report;
+		for(int i=0; i<n; i++) {
+			getline(file, line);
+			report << line << endl;
+		}
+		getline(file, line); // "vhdl"
+		if(file.fail() || line != "vhdl")
+			return nullptr;
+		ostringstream vhdlCode;
+		vhdlCode << file.rdbuf();
+
+		CachedOperator* op = new CachedOperator(parentOp, target, name, entityNames, sequential, reset, io, report.str(), vhdlCode.str());
+		// the black box carries the estimations of the whole subtree it replaces
+		for(size_t i=0; i<estimatedCounts.size(); i++)
+			op->reHelper->*estimatedCounts[i] = counts[i];
+		for(size_t i=0; i<estimatedTypes.size(); i++)
+			op->reHelper->*estimatedTypes[i] = types[i];
+		return op;
+	}
+
+
+
+	void BuildCache::saveAll(vector<OperatorPtr> &oplist)
+	{
+		if(directory == "")
+			return;
+		mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+		for(auto op: oplist) {
+			if(op->getBuildCacheKey() != "" && dynamic_cast<CachedOperator*>(op) == nullptr)
+				save(op);
+			saveAll(op->getSubComponentListR());
+		}
+	}
+
+
+
+	string BuildCache::tableFileName(string table)
+	{
+		return directory + "/" + table + ".cache";
+	}
+
+
+
+	map<string, string>& BuildCache::loadTable(string table)
+	{
+		if(tables.find(table) == tables.end()) {
+			map<string, string> &entries = tables[table];
+			ifstream file(tableFileName(table).c_str());
+			string line;
+			while(getline(file, line)) {
+				size_t tab = line.find('\t');
+				if(tab != string::npos)
+					entries[line.substr(0, tab)] = line.substr(tab+1);
+			}
+		}
+		return tables[table];
+	}
+
+
+
+	string BuildCache::lookupValue(string table, string key)
+	{
+		if(directory == "")
+			return "";
+		map<string, string> &entries = loadTable(table);
+		auto it = entries.find(key);
+		return (it == entries.end() ? "" : it->second);
+	}
+
+
+
+	void BuildCache::storeValue(string table, string key, string value)
+	{
+		if(directory == "")
+			return;
+		loadTable(table)[key] = value;
+		mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+		string line = key + "\t" + value + "\n";
+		int fd = open(tableFileName(table).c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+		if(fd < 0)
+			return; // no cache, no big deal
+		if(write(fd, line.c_str(), line.size()) != (ssize_t)line.size())
+			cerr << "WARNING: could not write to " << tableFileName(table) << endl;
+		close(fd);
+	}
+
+
+
+	void BuildCache::save(OperatorPtr op)
+	{
+		string key = op->getBuildCacheKey();
+		// The VHDL of the whole subtree, as UserInterface would output it
+		vector<OperatorPtr> subtree(1, op);
+		set<string> entityNames;
+		ostringstream vhdlCode;
+		UserInterface::outputVHDLToFile(subtree, vhdlCode, entityNames);
+
+		// The reference input is the earliest one that is not connected to a constant, as in key()
+		int minCycle = INT_MAX;
+		for(auto s: *op->getIOList()) {
+			if(s->type() == Signal::in
+				 && !s->predecessors()->empty()
+				 && s->predecessor(0)->type() != Signal::constant)
+				minCycle = min(minCycle, s->getCycle());
+		}
+		if(minCycle == INT_MAX)
+			return;
+
+		ostringstream report;
+		op->outputFinalReport(report, 1);
+		string reportString = report.str();
+		int reportLines = count(reportString.begin(), reportString.end(), '\n');
+
+		ofstream file(fileName(key).c_str());
+		if(!file) {
+			cerr << "WARNING: could not write to the build cache directory " << directory << endl;
+			return;
+		}
+		file.precision(17);
+		file << "key " << key << endl;
+		file << "name " << op->getName() << endl;
+		file << "entities " << entityNames.size();
+		for(auto e: entityNames)
+			file << " " << e;
+		file << endl;
+		file << "sequential " << op->isSequential() << " reset " << op->hasReset() << endl;
+		file << "io " << op->getIOList()->size() << endl;
+		for(auto s: *op->getIOList()) {
+			file << s->getName() << " " << s->type() << " " << s->width() << " " << s->isBus()
+					 << " " << s->isFix() << " " << s->isSigned() << " " << s->MSB() << " " << s->LSB()
+					 << " " << s->isFP() << " " << s->isIEEE() << " " << s->wE() << " " << s->wF()
+					 << " " << s->getCycle() - minCycle << " " << s->getCriticalPath() << endl;
+		}
+		vector<int> counts(estimatedCounts.size(), 0);
+		vector<map<int, int>> types(estimatedTypes.size());
+		sumEstimates(op, counts, types);
+		file << "resources";
+		for(auto c: counts)
+			file << " " << c;
+		file << endl;
+		for(auto t: types) {
+			file << "types " << t.size();
+			for(auto wc: t)
+				file << " " << wc.first << " " << wc.second;
+			file << endl;
+		}
+		file << "report " << reportLines << endl;
+		file << reportString;
+		file << "vhdl" << endl;
+		file << vhdlCode.str();
+		file.close();
+	}
+
+
+
+
+	CachedOperator::CachedOperator(OperatorPtr parentOp, Target* target, string originalName, vector<string> entityNames,
+																 bool sequential, bool reset_, vector<CachedIO> io, string report_, string vhdlCode_):
+		Operator(parentOp, target), reset(reset_), report(report_)
+	{
+		srcFileName = "CachedOperator";
+		// Entities get a new suffix, so that they do not clash with those built in this run
+		string suffix = "_cached" + to_string(getNewUId());
+		setName(originalName + suffix);
+		if(sequential)
+			setSequential();
+		else
+			setCombinatorial();
+
+		// Rename all the entities of the subtree, identifier by identifier
+		unordered_map<string, string> renaming;
+		for(auto e: entityNames)
+			renaming[e] = e + suffix;
+		ostringstream renamed;
+		size_t i = 0;
+		while(i < vhdlCode_.size()) {
+			if(isalnum(vhdlCode_[i]) || vhdlCode_[i] == '_') {
+				size_t j = i;
+				while(j < vhdlCode_.size() && (isalnum(vhdlCode_[j]) || vhdlCode_[j] == '_'))
+					j++;
+				string identifier = vhdlCode_.substr(i, j-i);
+				auto r = renaming.find(identifier);
+				renamed << (r == renaming.end() ? identifier : r->second);
+				i = j;
+			}
+			else
+				renamed << vhdlCode_[i++];
+		}
+		vhdlCode = renamed.str();
+
+		// The IOs
+		Signal* referenceInput = nullptr;
+		double referenceCriticalPath = 0;
+		for(auto c: io) {
+			if(c.type == Signal::in) {
+				if(c.isFix)
+					addFixInput(c.name, c.isSigned, c.msb, c.lsb);
+				else if(c.isFP)
+					addFPInput(c.name, c.wE, c.wF);
+				else if(c.isIEEE)
+					addIEEEInput(c.name, c.wE, c.wF);
+				else
+					addInput(c.name, c.width, c.isBus);
+				Signal* s = getSignalByName(c.name);
+				if(c.cycle == 0 && !s->predecessors()->empty() && s->predecessor(0)->type() != Signal::constant
+					 && referenceInput == nullptr) {
+					referenceInput = s;
+					referenceCriticalPath = c.criticalPath;
+				}
+			}
+			else {
+				if(c.isFix)
+					addFixOutput(c.name, c.isSigned, c.msb, c.lsb);
+				else if(c.isFP)
+					addFPOutput(c.name, c.wE, c.wF);
+				else if(c.isIEEE)
+					addIEEEOutput(c.name, c.wE, c.wF);
+				else
+					addOutput(c.name, c.width, 1, c.isBus);
+			}
+		}
+		if(referenceInput == nullptr)
+			THROWERROR("corrupted build cache entry for " << originalName);
+
+		// Each output depends on the reference input, with the recorded delay.
+		// Since the timing of the inputs is part of the key, this reproduces the recorded timing of the outputs.
+		for(auto c: io) {
+			if(c.type != Signal::out)
+				continue;
+			Signal* s = getSignalByName(c.name);
+			s->addPredecessor(referenceInput, c.cycle);
+			referenceInput->addSuccessor(s, c.cycle);
+			s->setCriticalPathContribution(c.criticalPath - referenceCriticalPath);
+		}
+	}
+
+
+	void CachedOperator::outputVHDL(std::ostream& o, std::string name)
+	{
+		o << vhdlCode;
+	}
+
+
+	void CachedOperator::outputFinalReport(ostream& s, int level)
+	{
+		// The report was recorded at level 1
+		istringstream r(report);
+		string line;
+		while(getline(r, line)) {
+			for (int i=0; i<level-1; i++)
+				s << "|" << tab;
+			s << line << endl;
+		}
+	}
+
+
+	bool CachedOperator::hasReset()
+	{
+		return reset;
+	}
+
+}
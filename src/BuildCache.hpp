@@ -0,0 +1,113 @@
+/*
+  An on-disk cache of sub-operators, to avoid rebuilding the unchanged parts of a design.
+
+  This file is part of the FloPoCo project
+
+  Initial software.
+  Copyright © INSA-Lyon, INRIA, CNRS, UCBL.
+  All rights reserved.
+
+*/
+#ifndef BuildCache_hpp
+#define BuildCache_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include "Operator.hpp"
+
+namespace flopoco{
+
+	/**
+	 * The build cache stores, for each sub-operator built by Operator::newInstance(),
+	 * the VHDL of its whole subtree, its IO timing, the resource estimations of the subtree and its final report.
+	 * The key is built from the factory name, the parameters, the target and all the generic options,
+	 * and the timing of the inputs (since the pipeline of a sub-operator depends on it).
+	 * On a cache hit, newInstance() gets a CachedOperator, a black box that replays the recorded timing.
+	 * The cache is enabled by the generic option cache=<directory>.
+	 * It is bypassed with clockEnableTree=1, since the depth of the tree is only known once the root is built.
+	 */
+	class BuildCache
+	{
+	public:
+		/** The cache directory, empty if the cache is disabled */
+		static string directory;
+
+		/**
+		 * Computes the key of the sub-operator that parentOp is about to build.
+		 * @param parameters the factory name followed by the parameters, as passed to the factory
+		 * @param inPortMap the input port map of the instance, with actual signals of parentOp
+		 * @return the key, or "" if this sub-operator should not be cached
+		 */
+		static string key(Operator* parentOp, vector<string> parameters, map<string, string> inPortMap);
+
+		/** Returns a CachedOperator built from the entry for key, or nullptr if there is none */
+		static OperatorPtr lookup(Operator* parentOp, Target* target, string key);
+
+		/** Stores all the operators of the tree under oplist that have a key and were not read from the cache */
+		static void saveAll(vector<OperatorPtr> &oplist);
+
+		/**
+		 * The results of slow searches (polynomial approximations, adder graphs...) are stored in tables of the cache directory,
+		 * one file per table with one "key<tab>value" line per entry. Keys and values may not contain tabs or newlines.
+		 * @return the value of key in table, or "" if there is none or if the cache is disabled
+		 */
+		static string lookupValue(string table, string key);
+
+		/** Appends an entry to table, if the cache is enabled. A single write() in append mode, so that concurrent processes may share the file */
+		static void storeValue(string table, string key, string value);
+
+	private:
+		static void save(OperatorPtr op);
+		static string fileName(string key);
+		static string tableFileName(string table);
+
+		/** The tables, each loaded from its file when first used */
+		static map<string, map<string, string>> tables;
+		static map<string, string>& loadTable(string table);
+	};
+
+
+
+	/** What the cache knows of one IO of a cached operator */
+	typedef struct {
+		string name;
+		Signal::SignalType type;
+		int width;
+		bool isBus;
+		bool isFix;
+		bool isSigned;
+		int msb;
+		int lsb;
+		bool isFP;
+		bool isIEEE;
+		int wE;
+		int wF;
+		int cycle; // relative to the earliest input
+		double criticalPath;
+	} CachedIO;
+
+
+
+	/** A black-box operator read from the build cache, whose reHelper holds the resource estimations of the subtree it replaces */
+	class CachedOperator : public Operator
+	{
+	public:
+		CachedOperator(OperatorPtr parentOp, Target* target, string originalName, vector<string> entityNames,
+									 bool sequential, bool reset, vector<CachedIO> io, string report, string vhdlCode);
+
+		/** Outputs the recorded VHDL of the whole subtree, with all the entities renamed */
+		void outputVHDL(std::ostream& o, std::string name);
+
+		void outputFinalReport(ostream& s, int level);
+
+		bool hasReset();
+
+	private:
+		bool reset;
+		string report;
+		string vhdlCode;
+	};
+
+}
+#endif
@@ -0,0 +1,428 @@
+/*
+  A streaming fixed-point FFT for FloPoCo, in the radix-2 single-path delay feedback (SDF) architecture
+
+  One complex sample enters per cycle, one complex bin leaves per cycle:
+  the area grows as log2(N) complex multipliers and N complex words of delay lines,
+  when FixFFTFullyPA has N/2.log2(N) butterflies and inputs a whole frame per cycle.
+
+  This file is part of the FloPoCo project
+
+  Author: agent
+
+  Initial software.
+  Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
+  2026.
+  All rights reserved.
+  */
+
+#include "FixFFTSDF.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <gmp.h>
+#include <mpfr.h>
+#include <gmpxx.h>
+#include <utils.hpp>
+#include <Operator.hpp>
+
+#include "../Table.hpp"
+
+using namespace std;
+
+namespace flopoco{
+
+
+	FixFFTSDF::FixFFTSDF(OperatorPtr parentOp, Target* target, int msbIn_, int lsbIn_, int msbOut_, int lsbOut_, int N_, bool signedIn_) :
+		Operator(parentOp, target), msbIn(msbIn_), lsbIn(lsbIn_), msbOut(msbOut_), lsbOut(lsbOut_), N(N_), signedIn(signedIn_), sampleCount(0) {
+
+		srcFileName="FixFFTSDF";
+
+		if(N < 2 || (N & (N-1)) != 0)
+			THROWERROR("N=" << N << ": the number of points should be a power of two, at least 2");
+		if(msbIn < lsbIn)
+			THROWERROR("msbIn=" << msbIn << " is smaller than lsbIn=" << lsbIn);
+		if(msbOut < lsbOut)
+			THROWERROR("msbOut=" << msbOut << " is smaller than lsbOut=" << lsbOut);
+		n = intlog2(N-1);
+
+		ostringstream name;
+		name << "FixFFTSDF_" << N << "_" << vhdlize(msbIn) << "_" << vhdlize(lsbIn) << "_" << vhdlize(msbOut) << "_" << vhdlize(lsbOut);
+		setNameWithFreqAndUID(name.str());
+		setCopyrightString("agent (2026)");
+		// The feedback delay lines and the sample counter are functional registers
+		setSequential();
+
+		int wIn = msbIn-lsbIn+1;
+		int wOut = msbOut-lsbOut+1;
+		addInput("Xr", wIn);
+		addInput("Xi", wIn);
+		addOutput("Yr", wOut);
+		addOutput("Yi", wOut);
+
+		// The error analysis: stage s adds an error of at most 1.5 units of the internal LSB on each part of its output
+		// (truncation of the product, plus the rounding of the twiddle factor). It reaches 2^(n-1-s) bins of the output,
+		// with unit-modulus coefficients, hence a total error below 2.2N units, which must remain below half an ulp of the output,
+		// the other half being for the final rounding.
+		int guardBits = n + 3;
+		lsbInt = min(lsbIn, lsbOut - guardBits);
+		// The internal format is signed. Stage s outputs partial DFTs of 2^(s+1) points, multiplied by a twiddle,
+		// which are smaller than sqrt(2).2^(s+1) times the largest input
+		int msbSigned = (signedIn ? msbIn : msbIn+1);
+		int msbLast = msbSigned + n + 1;
+		if(lsbOut > msbLast)
+			THROWERROR("lsbOut=" << lsbOut << " is larger than the MSB of the FFT, " << msbLast);
+		REPORT(INFO, "Internal LSB: " << lsbInt << ", MSB of the last stage: " << msbLast
+					 << ". The bins of a frame start " << N-1 << " cycles after its first sample, plus the pipeline depth");
+
+		double cycleTime = 1.0/getTarget()->frequency() - getTarget()->ffDelay();
+
+		vhdl << tab << "-- the position of the current sample in its frame" << endl;
+		disablePipelining();
+		vhdl << tab << declare("counter_next", n, true) << " <= counter + 1;" << endl;
+		addFeedbackRegister("counter", "counter_next", "Xr", Signal::syncReset);
+		enablePipelining();
+
+		string ri[2] = {"r", "i"};
+		for(int s=0; s<n; s++) {
+			// the delay of the feedback loop, and the number of twiddle factors, of this stage
+			int D = N >> (s+1);
+			int msbS = msbSigned + s + 2;
+			int wS = msbS - lsbInt + 1;
+			string ctrl = "counter" + of(n-1-s);
+			vhdl << endl << tab << "-- stage " << s << ": butterflies between samples " << D << " apart" << endl;
+
+			double loopDelay = getTarget()->adderDelay(wS) + getTarget()->logicDelay();
+			if(getTarget()->isPipelined() && loopDelay > cycleTime)
+				REPORT(LIST, "WARNING: the feedback loop of stage " << s << " takes about " << loopDelay*1e9 << "ns, more than the cycle time:"
+							 << " the target frequency will not be reached");
+
+			for(int c=0; c<2; c++) {
+				string a = join("a"+ri[c]+"_", s);
+				string fifoIn = join("fifoIn"+ri[c]+"_", s);
+				string fifoOut = join("fifoOut"+ri[c]+"_", s);
+				string bf = join("bf"+ri[c]+"_", s);
+				// the loop entry carries the critical path of the loop, so that the loop fits in one cycle
+				vhdl << tab << declare(min(loopDelay, cycleTime), a, wS) << " <= ";
+				if(s==0) {
+					string X = string("X") + ri[c];
+					string sign = (signedIn ? X + of(wIn-1) : "'0'");
+					vhdl << rangeAssign(msbS-msbIn-1, 0, sign) << " & " << X;
+					if(lsbIn > lsbInt)
+						vhdl << " & " << zg(lsbIn-lsbInt);
+				}
+				else {
+					string y = join("y"+ri[c]+"_", s-1);
+					vhdl << y << of(wS-2) << " & " << y;
+				}
+				vhdl << ";" << endl;
+				// The first D samples of a block of 2D enter the delay line, which outputs the differences of the previous block.
+				// The next D samples are added to and subtracted from the first ones, the sums are output and the differences enter the delay line.
+				disablePipelining();
+				vhdl << tab << declare(fifoIn, wS) << " <= " << a << " when " << ctrl << "='0' else " << fifoOut << " - " << a << ";" << endl;
+				vhdl << tab << declare(bf, wS) << " <= " << fifoOut << " when " << ctrl << "='0' else " << fifoOut << " + " << a << ";" << endl;
+				addFeedbackRegister(fifoOut, fifoIn, a, Signal::noReset, D);
+				enablePipelining();
+			}
+
+			// The differences are output when ctrl is 0, and must be multiplied by the twiddle exp(-i.pi.p/D),
+			// where p is the position of the difference in its block. The sums, and the difference for p=0, are not multiplied.
+			if(s < n-2) {
+				int wP = n-1-s;
+				// the twiddles are in ]-1,1[ once p=0 is excluded. Their rounding error on each part of the product must remain below half a unit of the internal LSB
+				int lsbT = lsbInt - 1 - msbS;
+				int wT = 1 - lsbT;
+				vhdl << tab << declare(join("twIndex_",s), wP) << " <= counter" << range(wP-1, 0) << ";" << endl;
+				vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wP), join("bypass_",s))
+						 << " <= '1' when " << ctrl << "='1' or " << join("twIndex_",s) << "=" << zg(wP) << " else '0';" << endl;
+				vector<mpz_class> values;
+				mpz_class mask = (mpz_class(1) << wT) - 1;
+				for(int p=0; p<D; p++) {
+					if(p==0) // bypassed
+						values.push_back(0);
+					else
+						values.push_back(((twiddle(p, D, false, lsbT) & mask) << wT) + (twiddle(p, D, true, lsbT) & mask));
+				}
+				Table::newUniqueInstance(this, join("twIndex_",s), join("tw_",s), values, join("TwiddleROM_",s), wP, 2*wT);
+				vhdl << tab << declare(join("twr_",s), wT) << " <= " << join("tw_",s) << range(2*wT-1, wT) << ";" << endl;
+				vhdl << tab << declare(join("twi_",s), wT) << " <= " << join("tw_",s) << range(wT-1, 0) << ";" << endl;
+				// The four real products are exact, the truncation is done after their sums
+				for(int c=0; c<2; c++) {
+					for(int d=0; d<2; d++) {
+						newInstance("IntMultiplier",
+												join("Mult"+ri[c]+ri[d]+"_",s),
+												"wX=" + to_string(wS) + " wY=" + to_string(wT) + " signedIO=true",
+												"X=>" + join("bf"+ri[c]+"_",s) + ",Y=>" + join("tw"+ri[d]+"_",s),
+												"R=>" + join("p"+ri[c]+ri[d]+"_",s));
+					}
+				}
+				vhdl << tab << declare(getTarget()->adderDelay(wS+wT), join("prodr_",s), wS+wT)
+						 << " <= " << join("prr_",s) << " - " << join("pii_",s) << ";" << endl;
+				vhdl << tab << declare(getTarget()->adderDelay(wS+wT), join("prodi_",s), wS+wT)
+						 << " <= " << join("pri_",s) << " + " << join("pir_",s) << ";" << endl;
+				for(int c=0; c<2; c++) {
+					vhdl << tab << declare(getTarget()->logicDelay(2), join("y"+ri[c]+"_",s), wS) << " <= " << join("bf"+ri[c]+"_",s)
+							 << " when " << join("bypass_",s) << "='1' else " << join("prod"+ri[c]+"_",s) << range(2*wS-1, wS) << ";" << endl;
+				}
+			}
+			else if(s == n-2) {
+				// the twiddle is 1 or -i
+				string bypass = "counter(0)='0' or " + ctrl + "='1'";
+				vhdl << tab << declare(getTarget()->logicDelay(2), join("yr_",s), wS) << " <= " << join("bfr_",s)
+						 << " when " << bypass << " else " << join("bfi_",s) << ";" << endl;
+				vhdl << tab << declare(getTarget()->adderDelay(wS), join("yi_",s), wS) << " <= " << join("bfi_",s)
+						 << " when " << bypass << " else " << zg(wS) << " - " << join("bfr_",s) << ";" << endl;
+			}
+		}
+
+		// The last stage has no twiddle: round its sums and differences to the output format
+		int wLast = msbLast - lsbInt + 1;
+		int k = lsbOut - lsbInt;
+		int wR = msbLast - lsbOut + 1;
+		vhdl << endl << tab << "-- rounding to the output format" << endl;
+		for(int c=0; c<2; c++) {
+			string rnd = string("rnd") + ri[c];
+			vhdl << tab << declare(getTarget()->adderDelay(wR+1), rnd, wR+1)
+					 << " <= " << join("bf"+ri[c]+"_", n-1) << range(wLast-1, k-1) << " + 1;" << endl;
+			vhdl << tab << "Y" << ri[c] << " <= ";
+			if(wOut <= wR)
+				vhdl << rnd << range(wOut, 1);
+			else
+				vhdl << rangeAssign(wOut-wR-1, 0, rnd+of(wR)) << " & " << rnd << range(wR, 1);
+			vhdl << ";" << endl;
+		}
+	}
+
+
+	FixFFTSDF::~FixFFTSDF() {
+	}
+
+
+	mpz_class FixFFTSDF::twiddle(int p, int D, bool imaginary, int lsb)
+	{
+		mpfr_t a, v;
+		mpfr_init2(a, 3*(-lsb)+64);
+		mpfr_init2(v, 3*(-lsb)+64);
+		mpfr_const_pi(a, GMP_RNDN);
+		mpfr_mul_si(a, a, p, GMP_RNDN);
+		mpfr_div_si(a, a, D, GMP_RNDN);
+		if(imaginary) {
+			mpfr_sin(v, a, GMP_RNDN);
+			mpfr_neg(v, v, GMP_RNDN);
+		}
+		else
+			mpfr_cos(v, a, GMP_RNDN);
+		mpfr_mul_2si(v, v, -lsb, GMP_RNDN);
+		mpz_class r;
+		mpfr_get_z(r.get_mpz_t(), v, GMP_RNDN);
+		mpfr_clears(a, v, NULL);
+		return r;
+	}
+
+
+	int FixFFTSDF::bitReverse(int j)
+	{
+		int r = 0;
+		for(int i=0; i<n; i++) {
+			r = (r << 1) | (j & 1);
+			j >>= 1;
+		}
+		return r;
+	}
+
+
+	void FixFFTSDF::emulate(TestCase * tc)
+	{
+		int wIn = msbIn-lsbIn+1;
+		int wOut = msbOut-lsbOut+1;
+		if(frameRe.empty()) {
+			frameRe.resize(N);
+			frameIm.resize(N);
+		}
+
+		mpz_class x[2] = {tc->getInputValue("Xr"), tc->getInputValue("Xi")};
+		if(signedIn) {
+			for(int c=0; c<2; c++)
+				if((x[c] >> (wIn-1)) == 1)
+					x[c] -= mpz_class(1) << wIn;
+		}
+		int t = sampleCount % N;
+		frameRe[t] = x[0];
+		frameIm[t] = x[1];
+		sampleCount++;
+
+		if(t == N-1) {
+			// The frame is complete: compute its DFT. The angles are reduced to [0, 2pi[, and the multiples of pi/2 are exact
+			int prec = wIn + wOut + n + 64;
+			mpfr_t *cosTab = new mpfr_t[N];
+			mpfr_t *sinTab = new mpfr_t[N];
+			mpfr_t a, sr, si, tmp;
+			mpfr_inits2(prec, a, sr, si, tmp, NULL);
+			for(int m=0; m<N; m++) {
+				mpfr_inits2(prec, cosTab[m], sinTab[m], NULL);
+				if(N >= 4 && m % (N/4) == 0) {
+					int q = m / (N/4);
+					mpfr_set_si(cosTab[m], (q==0 ? 1 : (q==2 ? -1 : 0)), GMP_RNDN);
+					mpfr_set_si(sinTab[m], (q==1 ? 1 : (q==3 ? -1 : 0)), GMP_RNDN);
+				}
+				else if(N == 2) {
+					mpfr_set_si(cosTab[m], (m==0 ? 1 : -1), GMP_RNDN);
+					mpfr_set_si(sinTab[m], 0, GMP_RNDN);
+				}
+				else {
+					mpfr_const_pi(a, GMP_RNDN);
+					mpfr_mul_si(a, a, 2*m, GMP_RNDN);
+					mpfr_div_si(a, a, N, GMP_RNDN);
+					mpfr_sin_cos(sinTab[m], cosTab[m], a, GMP_RNDN);
+				}
+			}
+			binReRD.resize(N);
+			binReRU.resize(N);
+			binImRD.resize(N);
+			binImRU.resize(N);
+			mpz_class mask = (mpz_class(1) << wOut) - 1;
+			for(int b=0; b<N; b++) {
+				// X_b = sum of x_j.(cos - i.sin)(2.pi.j.b/N)
+				mpfr_set_si(sr, 0, GMP_RNDN);
+				mpfr_set_si(si, 0, GMP_RNDN);
+				for(int j=0; j<N; j++) {
+					int m = (int)(((long long)j*b) % N);
+					mpfr_mul_z(tmp, cosTab[m], frameRe[j].get_mpz_t(), GMP_RNDN);
+					mpfr_add(sr, sr, tmp, GMP_RNDN);
+					mpfr_mul_z(tmp, sinTab[m], frameIm[j].get_mpz_t(), GMP_RNDN);
+					mpfr_add(sr, sr, tmp, GMP_RNDN);
+					mpfr_mul_z(tmp, cosTab[m], frameIm[j].get_mpz_t(), GMP_RNDN);
+					mpfr_add(si, si, tmp, GMP_RNDN);
+					mpfr_mul_z(tmp, sinTab[m], frameRe[j].get_mpz_t(), GMP_RNDN);
+					mpfr_sub(si, si, tmp, GMP_RNDN);
+				}
+				// scale to the output LSB; the output format wraps around, as the hardware does
+				mpfr_mul_2si(sr, sr, lsbIn-lsbOut, GMP_RNDN);
+				mpfr_mul_2si(si, si, lsbIn-lsbOut, GMP_RNDN);
+				mpz_class r;
+				mpfr_get_z(r.get_mpz_t(), sr, GMP_RNDD);
+				binReRD[b] = r & mask;
+				mpfr_get_z(r.get_mpz_t(), sr, GMP_RNDU);
+				binReRU[b] = r & mask;
+				mpfr_get_z(r.get_mpz_t(), si, GMP_RNDD);
+				binImRD[b] = r & mask;
+				mpfr_get_z(r.get_mpz_t(), si, GMP_RNDU);
+				binImRU[b] = r & mask;
+			}
+			for(int m=0; m<N; m++)
+				mpfr_clears(cosTab[m], sinTab[m], NULL);
+			delete[] cosTab;
+			delete[] sinTab;
+			mpfr_clears(a, sr, si, tmp, NULL);
+		}
+
+		// The output of this cycle is the bin at position j of the last complete frame, in bit-reversed order.
+		// Nothing is expected before the first frame is complete.
+		long long pos = sampleCount - N;
+		if(pos < 0)
+			return;
+		int b = bitReverse(pos % N);
+		tc->addExpectedOutput("Yr", binReRD[b]);
+		tc->addExpectedOutput("Yr", binReRU[b]);
+		tc->addExpectedOutput("Yi", binImRD[b]);
+		tc->addExpectedOutput("Yi", binImRU[b]);
+	}
+
+
+	void FixFFTSDF::buildStandardTestCases(TestCaseList* tcl)
+	{
+		// A few whole frames: an impulse, a constant, an alternating sequence, and the most negative input
+		int wIn = msbIn-lsbIn+1;
+		mpz_class one = mpz_class(1) << (signedIn ? wIn-2 : wIn-1);
+		mpz_class minusOne = (mpz_class(1) << wIn) - one;
+		mpz_class mostNegative = mpz_class(1) << (wIn-1);
+		int nbFrames = (signedIn ? 4 : 2);
+		for(int f=0; f<nbFrames; f++) {
+			for(int j=0; j<N; j++) {
+				mpz_class xr, xi;
+				switch(f) {
+				case 0: xr = (j==0 ? one : mpz_class(0)); xi = 0; break;
+				case 1: xr = one; xi = one; break;
+				case 2: xr = (j%2==0 ? one : minusOne); xi = 0; break;
+				default: xr = mostNegative; xi = mostNegative; break;
+				}
+				TestCase* tc = new TestCase(this);
+				tc->addInput("Xr", xr);
+				tc->addInput("Xi", xi);
+				emulate(tc);
+				tcl->add(tc);
+			}
+		}
+	}
+
+
+	OperatorPtr FixFFTSDF::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
+		int msbIn, lsbIn, msbOut, lsbOut, N;
+		bool signedIn;
+		UserInterface::parseInt(args, "msbIn", &msbIn);
+		UserInterface::parseInt(args, "lsbIn", &lsbIn);
+		UserInterface::parseInt(args, "msbOut", &msbOut);
+		UserInterface::parseInt(args, "lsbOut", &lsbOut);
+		UserInterface::parseStrictlyPositiveInt(args, "N", &N);
+		UserInterface::parseBoolean(args, "signedIn", &signedIn);
+		return new FixFFTSDF(parentOp, target, msbIn, lsbIn, msbOut, lsbOut, N, signedIn);
+	}
+
+
+	TestList FixFFTSDF::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+
+		if(index==-1)
+		{ // The unit tests
+			for(int N: {2, 4, 8, 16, 64}) {
+				for(int lsb: {-8, -15}) {
+					for(int signedIn=0; signedIn<2; signedIn++) {
+						int n = intlog2(N-1);
+						paramList.push_back(make_pair("msbIn", "0"));
+						paramList.push_back(make_pair("lsbIn", to_string(lsb)));
+						paramList.push_back(make_pair("msbOut", to_string(n+2)));
+						paramList.push_back(make_pair("lsbOut", to_string(lsb)));
+						paramList.push_back(make_pair("N", to_string(N)));
+						paramList.push_back(make_pair("signedIn", to_string(signedIn)));
+						paramList.push_back(make_pair("TestBench n=", to_string(10*N)));
+						testStateList.push_back(paramList);
+						paramList.clear();
+					}
+				}
+			}
+		}
+		else
+		{
+			// finite number of random test computed out of index
+		}
+
+		return testStateList;
+	}
+
+
+	void FixFFTSDF::registerFactory(){
+		UserInterface::add("FixFFTSDF", // name
+			"A streaming radix-2 FFT (single-path delay feedback), one complex sample per cycle in natural order, one bin per cycle in bit-reversed order.",
+			"Complex",
+			"FixFFTFullyPA", //seeAlso
+			"msbIn(int): weight of the MSB of the real and imaginary parts of the input; \
+			lsbIn(int): weight of the LSB of the real and imaginary parts of the input; \
+			msbOut(int): weight of the MSB of the real and imaginary parts of the output; \
+			lsbOut(int): weight of the LSB of the real and imaginary parts of the output; \
+			N(int): number of points, a power of two; \
+			signedIn(bool)=true: if false, the inputs are unsigned;",
+			"The frames follow each other without gap, the first one starting at the first sample after the reset. \
+			The bins of a frame start N-1 cycles after its first sample, plus the pipeline depth. \
+			Stage s holds a delay line of N/2<sup>s+1</sup> complex words, built in block RAM for the large ones, and a twiddle ROM. \
+			The result is faithful. msbOut=msbIn+log2(N)+1 (one more for unsigned inputs) avoids any overflow; a smaller msbOut wraps around.",
+			FixFFTSDF::parseArguments,
+			FixFFTSDF::unitTest
+			) ;
+	}
+
+
+}
@@ -0,0 +1,83 @@
+#ifndef FIXFFTSDF_HPP
+#define FIXFFTSDF_HPP
+#include <vector>
+#include <sstream>
+#include <gmp.h>
+#include <mpfr.h>
+#include <gmpxx.h>
+
+#include "../Operator.hpp"
+
+namespace flopoco{
+
+	/** A streaming radix-2 FFT in the single-path delay feedback (SDF) architecture.
+	 * It inputs one complex sample per cycle, in natural order, and outputs one complex bin per cycle, in bit-reversed order.
+	 * Frames follow each other without any gap: a counter, reset by rst, gives the position of each sample in its frame.
+	 * The bins of a frame come out N-1 cycles (plus the pipeline depth) after its first sample went in.
+	 *
+	 * The architecture is decimation in frequency: stage s (0 <= s < log2(N)) holds a feedback delay line of D=N/2^(s+1) samples,
+	 * which is built as a block RAM or shift register delay line by mapDelayLines(), and adds and subtracts samples D apart.
+	 * The differences are then multiplied by a twiddle factor read from a ROM. The last two stages have trivial twiddles.
+	 *
+	 * The internal format is signed, with one more MSB per stage, and enough guard LSBs (log2(N)+3) for a faithful result.
+	 */
+	class FixFFTSDF : public Operator
+	{
+	public:
+		/**
+		 * The FixFFTSDF constructor
+		 * @param[in]		parentOp	parent operator in the instance hierarchy
+		 * @param[in]		target		target device
+		 * @param[in]		msbIn			weight of the MSB of the real and imaginary parts of the input
+		 * @param[in]		lsbIn			weight of the LSB of the real and imaginary parts of the input
+		 * @param[in]		msbOut		weight of the MSB of the real and imaginary parts of the output
+		 * @param[in]		lsbOut		weight of the LSB of the real and imaginary parts of the output
+		 * @param[in]		N					number of points, a power of two
+		 * @param[in]		signedIn	true if the inputs are signed
+		 */
+		FixFFTSDF(OperatorPtr parentOp, Target* target, int msbIn, int lsbIn, int msbOut, int lsbOut, int N, bool signedIn=true);
+
+		~FixFFTSDF();
+
+		/** Emulates one cycle of the stream: the expected output is the bin of a past frame, or nothing before the first frame is complete */
+		void emulate(TestCase * tc);
+		void buildStandardTestCases(TestCaseList* tcl);
+
+		/** Factory method that parses arguments and calls the constructor */
+		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
+
+		/** Factory register method */
+		static void registerFactory();
+
+		/** Unit tests */
+		static TestList unitTest(int index);
+
+	private:
+		int msbIn;
+		int lsbIn;
+		int msbOut;
+		int lsbOut;
+		int N;
+		bool signedIn;
+
+		/** log2(N), the number of stages */
+		int n;
+		/** the LSB of the internal datapath */
+		int lsbInt;
+
+		/** The twiddle factor exp(-i.pi.p/D), real or imaginary part, rounded to the nearest multiple of 2^lsb */
+		mpz_class twiddle(int p, int D, bool imaginary, int lsb);
+		/** The index of the bin output at position j of a frame */
+		int bitReverse(int j);
+
+		/** the samples of the current frame, for emulate() */
+		vector<mpz_class> frameRe, frameIm;
+		/** the rounded down and up bins of the last complete frame */
+		vector<mpz_class> binReRD, binReRU, binImRD, binImRU;
+		/** the number of samples emulated so far */
+		long long sampleCount;
+	};
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+	Search of the adder graphs of shift-and-add (multiple) constant multipliers.
+
+	This file is part of the FloPoCo project
+
+	All rights reserved.
+*/
+#if defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <climits>
+#include <algorithm>
+
+#include "../utils.hpp"
+#include "../UserInterface.hpp"
+#include "../BuildCache.hpp"
+
+#include "AdderGraphSearch.hpp"
+#include "IntConstMult.hpp"
+#include "ShiftAddOp.hpp"
+#include "ShiftAddDag.hpp"
+#include "IntConstMultShiftAddTypes.hpp"
+#include "adder_cost.hpp"
+
+#include "pagsuite/rpag.h"
+#include "pagsuite/log2_64.h"
+#include "pagsuite/csd.h"
+
+using namespace std;
+
+namespace flopoco{
+
+	string AdderGraphSearch::compute(Target* target, set<int64_t> targets, int wIn)
+	{
+		int timeout = target->getAdderGraphTimeout();
+		ostringstream key;
+		key << "wIn=" << wIn << " timeout=" << timeout << " targets";
+		for(auto t: targets)
+			key << " " << t;
+		string adderGraph = BuildCache::lookupValue("AdderGraph", key.str());
+		if(adderGraph != "") {
+			if(UserInterface::verbose >= DETAILED)
+				cerr << "> AdderGraphSearch: adder graph found in the cache" << endl;
+			return adderGraph;
+		}
+
+		if(timeout <= 0) {
+			// A single RPAG run, with limits on the effort for the deep constants
+			int depth = 0;
+			for(auto t: targets)
+				depth = max(depth, PAGSuite::log2c_64(PAGSuite::nonzeros(t)));
+			adderGraph = rpagAdderGraph(targets, wIn, (depth > 3 ? 1 : -1), (depth > 4 ? 1000 : -1));
+		}
+		else {
+			// Anytime search: the Booth graph is always there, the RPAG runs improve on it as long as time permits
+			adderGraph = boothAdderGraph(target, targets, wIn);
+			int bestCost = cost(adderGraph, wIn);
+			if(UserInterface::verbose >= INFO)
+				cerr << "> AdderGraphSearch: Booth adder graph requires " << bestCost << " full adders" << endl;
+			// (search limit, MSD permutation limit), by increasing effort: each worker runs them in this order
+			// until the time budget is exhausted
+			vector<pair<int,int>> efforts = {{1, 1000}, {1, -1}};
+			for(int searchLimit = 2; searchLimit <= maxSearchLimit; searchLimit *= 2)
+				efforts.push_back(make_pair(searchLimit, -1));
+			try {
+				bool complete = forkMap(efforts.size(), UserInterface::workers,
+																[&](int i) {
+																	string g = rpagAdderGraph(targets, wIn, efforts[i].first, efforts[i].second);
+																	replace(g.begin(), g.end(), '\n', ' ');
+																	return g;
+																},
+																[&](int i, string g) {
+																	int c = cost(g, wIn);
+																	if(UserInterface::verbose >= INFO)
+																		cerr << "> AdderGraphSearch: RPAG with search limit " << efforts[i].first
+																				 << " requires " << c << " full adders" << endl;
+																	if(c < bestCost) {
+																		bestCost = c;
+																		adderGraph = g;
+																	}
+																	return true;
+																},
+																timeout);
+				if(!complete && UserInterface::verbose >= INFO)
+					cerr << "> AdderGraphSearch: time budget of " << timeout << "s exhausted" << endl;
+			}
+			catch(string &e) { // an RPAG run crashed: keep the best graph so far
+				cerr << "WARNING: " << e << endl;
+			}
+		}
+
+		string entry = adderGraph;
+		replace(entry.begin(), entry.end(), '\n', ' '); // one line per entry
+		BuildCache::storeValue("AdderGraph", key.str(), entry);
+		return adderGraph;
+	}
+
+
+
+	int AdderGraphSearch::cost(string adderGraph, int wIn)
+	{
+		PAGSuite::adder_graph_t graph;
+		graph.quiet = true;
+		if(!graph.parse_to_graph(adderGraph))
+			return INT_MAX;
+		graph.check_and_correct(adderGraph);
+		int c = IntConstMultShiftAdd_TYPES::getGraphAdderCost(graph, wIn, false);
+		graph.clear();
+		return c;
+	}
+
+
+
+	string AdderGraphSearch::boothAdderGraph(Target* target, set<int64_t> targets, int wIn)
+	{
+		IntConstMult icm(nullptr, target, wIn); // only used for its shift-and-add DAGs
+		icm.implementation = nullptr;
+		ostringstream graph;
+		set<string> nodes; // the trees of the different targets may share nodes
+		vector<pair<int64_t, string>> outputs; // the target, and its source in the graph
+		int outputStage = 0;
+
+		for(auto t: targets) {
+			delete icm.implementation;
+			icm.implementation = icm.buildMultBoothTreeFromRight(mpz_class(to_string(t)));
+			for(auto sao: icm.implementation->saolist) {
+				if(sao->rpagdesc.empty() || nodes.find(sao->rpagdesc) != nodes.end()) // a shift or negation, or already there
+					continue;
+				nodes.insert(sao->rpagdesc);
+				graph << sao->rpagdesc << ",";
+			}
+			ShiftAddOp* result = icm.implementation->result;
+			int shift = 0;
+			int sign = 1;
+			ShiftAddOp::unfoldRPAGOperand(result, shift, sign);
+			ostringstream source;
+			source << "[" << sign*result->n << "]," << result->rpaglevel << "," << shift;
+			outputs.push_back(make_pair(t, source.str()));
+			outputStage = max(outputStage, result->rpaglevel);
+		}
+
+		// all the outputs are in the last stage
+		for(auto o: outputs)
+			graph << "{'O',[" << o.first << "]," << outputStage << "," << o.second << "},";
+		string g = graph.str();
+		return "{" + g.substr(0, g.length()-1) + "}";
+	}
+
+
+
+	string AdderGraphSearch::rpagAdderGraph(set<int64_t> targets, int wIn, int searchLimit, int msdPermutationLimit)
+	{
+		set<PAGSuite::int_t> targetSet(targets.begin(), targets.end());
+
+		PAGSuite::rpag *rpag = new PAGSuite::rpag(); //default is RPAG with 2 input adders
+		for(PAGSuite::int_t t : targetSet)
+			rpag->target_set->insert(t);
+		if(searchLimit >= 0)
+			rpag->search_limit = searchLimit;
+		if(msdPermutationLimit >= 0)
+			rpag->msd_digit_permutation_limit = msdPermutationLimit;
+		PAGSuite::global_verbose = UserInterface::verbose-1; //set rpag to one less than verbose of FloPoCo
+
+		rpag->input_wordsize = wIn;
+		rpag->set_cost_model(PAGSuite::LL_FPGA);
+		rpag->optimize();
+
+		vector<set<PAGSuite::int_t>> pipelineSet = rpag->get_best_pipeline_set();
+		list<PAGSuite::realization_row<PAGSuite::int_t> > rpagAdderGraph;
+		PAGSuite::pipeline_set_to_adder_graph(pipelineSet, rpagAdderGraph, true, rpag->get_c_max());
+		PAGSuite::append_targets_to_adder_graph(pipelineSet, rpagAdderGraph, targetSet);
+		delete rpag;
+
+		return PAGSuite::output_adder_graph(rpagAdderGraph, true);
+	}
+
+}
+
+#endif //defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
@@ -0,0 +1,55 @@
+/**
+	Search of the adder graphs of shift-and-add (multiple) constant multipliers.
+
+	By default this is a single run of RPAG, with effort limits that depend on the depth of the constants.
+	With the generic option adderGraphTimeout, it becomes an anytime search:
+	it starts from the Booth-recoded adder graph of IntConstMult, then runs RPAG with increasing effort
+	in worker processes until the time budget is exhausted, and keeps the graph with the fewest full adders.
+	With the generic option cache=, the graphs found are cached on disk, so that repeated constant sets cost nothing.
+
+	This file is part of the FloPoCo project
+
+	All rights reserved.
+*/
+
+#ifndef ADDERGRAPHSEARCH_HPP
+#define ADDERGRAPHSEARCH_HPP
+
+#if defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+
+#include <set>
+#include <string>
+#include <cstdint> //for int64_t
+
+namespace flopoco{
+
+	class Target;
+
+	class AdderGraphSearch
+	{
+	public:
+		/**
+		 * @param target the target, which holds the time budget (0 for a single RPAG run)
+		 * @param targets the (positive) constants
+		 * @param wIn the input word size
+		 * @return an adder graph computing all the targets, in the syntax of IntConstMultShiftAdd
+		 */
+		static std::string compute(Target* target, std::set<int64_t> targets, int wIn);
+
+		/** The number of full adders of an adder graph, INT_MAX if it can not be parsed */
+		static int cost(std::string adderGraph, int wIn);
+
+	private:
+		/** The largest RPAG search limit of the anytime search, which doubles it from one run to the next */
+		static const int maxSearchLimit = 1024;
+
+		/** The union of the Booth-recoded trees of IntConstMult for each target, through the adder graph export of ShiftAddOp */
+		static std::string boothAdderGraph(Target* target, std::set<int64_t> targets, int wIn);
+
+		/** One RPAG run. A limit of -1 keeps the default of RPAG */
+		static std::string rpagAdderGraph(std::set<int64_t> targets, int wIn, int searchLimit, int msdPermutationLimit);
+	};
+}
+
+#endif //defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+#endif
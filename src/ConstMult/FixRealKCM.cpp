@@ -63,6 +63,8 @@ using namespace std;
 
 namespace flopoco{
 
+	map<string, map<string, Table*>> FixRealKCM::tablePools;
+
 
 	//standalone operator
 	FixRealKCM::FixRealKCM(OperatorPtr parentOp, Target* target, bool signedIn_, int msbIn_, int lsbIn_, int lsbOut_, string constant_, double targetUlpError_):
@@ -477,8 +479,6 @@ namespace flopoco{
 											 << "-- input address  m=" << m[i] << "  l=" << l[i]
 											 << endl;
 
-				vector<mpz_class> tableContent = kcmTableContent(i);
-
 				string tablename;
 				if(thisOp==this) // non-virtual
 					tablename = join(getName()+"_T",i);
@@ -490,14 +490,31 @@ namespace flopoco{
 				thisOp->inPortMap ("X", sliceInName);
 				thisOp->outPortMap("Y", sliceOutName);
 
-				Table* t = new Table(thisOp->getParentOp(),
-														 thisOp->getTarget(),
-														 tableContent,
-														 tablename, //name
-														 m[i] - l[i]+1, // wIn
-														 tableOutSize, //wOut
-														 1 // logicTable
-														 );
+				// Tables are only shared inside the tree of one top-level operator, which is output as a whole
+				Operator* root = thisOp;
+				while(root->getParentOp() != nullptr)
+					root = root->getParentOp();
+				map<string, Table*> &tablePool = tablePools[root->getName()];
+				string key = tableKey(i);
+				Table* t;
+				auto pooled = tablePool.find(key);
+				if(pooled != tablePool.end() && root->getName() != "") {
+					t = pooled->second;
+					REPORT(DETAILED, "Table " << i << " has the same content as " << t->getName() << ", sharing it");
+				}
+				else {
+					vector<mpz_class> tableContent = kcmTableContent(i);
+					t = new Table(thisOp->getParentOp(),
+												thisOp->getTarget(),
+												tableContent,
+												tablename, //name
+												m[i] - l[i]+1, // wIn
+												tableOutSize, //wOut
+												1 // logicTable
+												);
+					if(root->getName() != "") // a root without a name yet can not be told from another one
+						tablePool[key] = t;
+				}
 				
 				thisOp->vhdl << thisOp->instance(t , instanceName);
 
@@ -583,6 +600,33 @@ namespace flopoco{
 	
 	/************************** The FixRealKCMTable class ********************/
 
+	// Table i tabulates round(x * C * 2^(l[i]-lsbOut+g)) for x the value of the chunk as an integer, plus the round bit for table 0.
+	// Therefore its content only depends on the scaled constant, not on C, l[i], lsbOut and g separately:
+	// tables of constants that differ by a power of two may be shared as well.
+	// Only the chunk that holds the input sign (tableOutputSign==0) uses the signed constant, the others use its absolute value.
+	string FixRealKCM::tableKey(int i) {
+		mpfr_t scaledC;
+		mpfr_init2(scaledC, mpfr_get_prec(mpC));
+		mpfr_mul_2si(scaledC, (tableOutputSign[i]==0 ? mpC : absC), l[i] - lsbOut + g, GMP_RNDN); // exact
+		mpfr_exp_t e;
+		char* digits = mpfr_get_str(NULL, &e, 16, 0, scaledC, GMP_RNDN); // exact in base 16
+		int roundBit = 0;
+		if(addRoundBit && (i==0) && (g>0))
+			roundBit = (tableOutputSign[0] >= 0 ? 1 : -1) * (1<<(g-1));
+		ostringstream key;
+		key << thisOp->getTarget()->getID() << " " << thisOp->getTarget()->frequencyMHz() << "MHz "
+				<< (tableOutputSign[i]==0 ? "signed" : "unsigned")
+				<< " wIn=" << m[i] - l[i] + 1
+				<< " wOut=" << m[i] + msbC - lsbOut + g + 1
+				<< " C=0." << digits << "p" << e
+				<< " round=" << roundBit;
+		mpfr_free_str(digits);
+		mpfr_clear(scaledC);
+		return key.str();
+	}
+
+
+
 	
 	vector<mpz_class> FixRealKCM::kcmTableContent(int i) {
 		vector<mpz_class> r;
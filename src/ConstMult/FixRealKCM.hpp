@@ -141,12 +141,19 @@ namespace flopoco{
 
 		void computeGuardBits();
 
+		/** The KCM tables built so far, for each top-level operator (by its unique name), indexed by tableKey().
+				Tables are shared operators, so all the KCMs under the same top-level operator
+				(e.g. the taps of a symmetric filter, or the real and imaginary parts of a complex KCM)
+				instantiate the same component whenever their tables have the same content and target */
+		static map<string, map<string, Table*>> tablePools;
+
 	private:
 		Operator*	thisOp; 		/**< The Operator for this constant multiplier: either "this" in the case of a standalone op, or the operator that instanciated its bitHeap in the case of a virtual KCM */
 		bool specialCasesForBitHeap();
 		void buildTablesForBitHeap();
 		string createShiftedPowerOfTwo(string resultSignalName);
 		vector<mpz_class> kcmTableContent(int i);
+		string tableKey(int i); /**< a string that determines the content of table i, see kcmTableContent() */
 
 
 	};
@@ -1481,7 +1481,9 @@ namespace flopoco{
 	void IntConstMult::showRPAG(){
 		string rpag="{";
 		for (uint32_t i=0; i<implementation->saolist.size(); i++) {
-			if (i>0)
+			if (implementation->saolist[i]->rpagdesc.empty()) // a shift or negation, folded into its users
+				continue;
+			if (rpag.size()>1)
 					rpag+=",";
 			rpag += implementation->saolist[i] -> rpagdesc;
 		}
@@ -68,7 +68,8 @@ namespace flopoco{
         }
         else
         {
-		  cerr << "Error: (Odd) value of constant must be less than " << MAX_SCM_CONST << " (is " << coeffOdd << ")" << endl;
+		  cerr << "Error: (Odd) value of constant must be less than " << MAX_SCM_CONST << " (is " << coeffOdd << ")" << endl
+			   << "  Larger constants are handled by IntConstMultShiftAddRPAG, with a bounded generation time using the option adderGraphTimeout" << endl;
           exit(-1);
         }
 
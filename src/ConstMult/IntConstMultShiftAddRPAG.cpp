@@ -23,6 +23,7 @@
 #include "../Operator.hpp"
 
 #include "IntConstMultShiftAddRPAG.hpp"
+#include "AdderGraphSearch.hpp"
 
 #include "pagsuite/pagexponents.hpp"
 #include "pagsuite/compute_successor_set.h"
@@ -41,44 +42,12 @@ namespace flopoco{
     {
 		srcFileName="IntConstMultShiftAddRPAG";
 
-		set<int_t> target_set;
 		int_t coeff = mpz_get_ui(coeffMpz.get_mpz_t());
 
-    	target_set.insert(coeff);
+		REPORT(INFO, "depth=" << log2c_64(nonzeros(coeff)));
 
-		int depth = log2c_64(nonzeros(coeff));
-
-		REPORT(INFO, "depth=" << depth);
-
-		PAGSuite::rpag *rpag = new PAGSuite::rpag(); //default is RPAG with 2 input adders
-
-		for(int_t t : target_set)
-			rpag->target_set->insert(t);
-
-		if(depth > 3)
-		{
-			REPORT(DEBUG, "depth is 4 or more, limit search limit to 1");
-			rpag->search_limit = 1;
-		}
-		if(depth > 4)
-		{
-			REPORT(DEBUG, "depth is 5 or more, limit MSD permutation limit");
-			rpag->msd_digit_permutation_limit = 1000;
-		}
-		PAGSuite::global_verbose = UserInterface::verbose-1; //set rpag to one less than verbose of FloPoCo
-
-		PAGSuite::cost_model_t cost_model = PAGSuite::LL_FPGA;// with default value
-		rpag->input_wordsize = wIn;
-		rpag->set_cost_model(cost_model);
-		rpag->optimize();
-
-		vector<set<int_t>> pipeline_set = rpag->get_best_pipeline_set();
-
-		list<realization_row<int_t> > pipelined_adder_graph;
-		pipeline_set_to_adder_graph(pipeline_set, pipelined_adder_graph, true, rpag->get_c_max());
-		append_targets_to_adder_graph(pipeline_set, pipelined_adder_graph, target_set);
-
-		string adderGraph = output_adder_graph(pipelined_adder_graph,true);
+		// A single RPAG run, or an anytime search if the generic option adderGraphTimeout is set
+		string adderGraph = AdderGraphSearch::compute(target, {coeff}, wIn);
 
 		REPORT(INFO, "adderGraph=" << adderGraph);
 
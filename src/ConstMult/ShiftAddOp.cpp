@@ -55,15 +55,6 @@ namespace flopoco{
 				cost_in_full_adders = 0;
 			else
 				cost_in_full_adders = size - s - 1; // -1 because the cout bit is for free    
-			rpaglevel = 1+max(i->rpaglevel, j->rpaglevel);
-			rpag << "{'A',[" << n << "],"   << rpaglevel << ","
-				// left child
-					 <<  "[" << i->n << "]," << i->rpaglevel <<  "," << s << ",";
-			// right child
-			rpag <<  "[" << j->n << "]," << j->rpaglevel <<  ",0";
-			rpag <<  "}";
-			rpagdesc=rpag.str();
-			
 			break;
 		case Sub:      
 			cost_in_full_adders = size - 1; // -1 because the cout bit is for free    
@@ -79,6 +70,37 @@ namespace flopoco{
 		case Neg:      cost_in_full_adders = size -1; // -1 because the cout bit is for free
 			break;
 		}   
+
+		// the adder graph description, in the syntax of PAGSuite.
+		// Shifts and negations are folded into the adders that use them, so they have no description.
+		switch(op) {
+		case X:
+			rpagdesc="{'R',[1],1,[1],0}";
+			rpaglevel=0;
+			break;
+		case Shift:
+		case Neg:
+			rpaglevel=i->rpaglevel;
+			break;
+		default: {
+			// the node is described as computing |n|, which negates both operands when n<0
+			int sign = (n>=0 ? 1 : -1);
+			ShiftAddOp *a=i, *b=j;
+			int sa=s, sb=0;
+			int signa = (op==RSub ? -sign : sign);
+			int signb = (op==Sub ? -sign : sign);
+			unfoldRPAGOperand(a, sa, signa);
+			unfoldRPAGOperand(b, sb, signb);
+			rpaglevel = 1+max(a->rpaglevel, b->rpaglevel);
+			rpag << "{'A',[" << sign*n << "],"   << rpaglevel << ","
+				// left child
+					 <<  "[" << signa*a->n << "]," << a->rpaglevel <<  "," << sa << ",";
+			// right child
+			rpag <<  "[" << signb*b->n << "]," << b->rpaglevel <<  "," << sb;
+			rpag <<  "}";
+			rpagdesc=rpag.str();
+		}
+		}
 	
 		// build the variable name
 		ostringstream o;
@@ -95,6 +117,17 @@ namespace flopoco{
 
 	}
 
+	void ShiftAddOp::unfoldRPAGOperand(ShiftAddOp* &sao, int &shift, int &sign)
+	{
+		while(sao->op==Shift || sao->op==Neg) {
+			if(sao->op==Shift)
+				shift += sao->s;
+			else
+				sign = -sign;
+			sao = sao->i;
+		}
+	}
+
 	std::ostream& operator<<(std::ostream& o, const ShiftAddOp& sao ) // output
 	{    
 		o << sao.name << " <-  ";
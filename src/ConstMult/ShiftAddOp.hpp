@@ -49,8 +49,9 @@ namespace flopoco{
 		/** string representation of the constant */
 		string name;
 
-		/** string representation of the constant */
+		/** the adder graph description of the node, in the syntax of PAGSuite (empty for Shift and Neg) */
 		string rpagdesc;
+		/** the adder depth of the node */
 		int rpaglevel;
 
 		/** size of the constant */
@@ -66,6 +67,9 @@ namespace flopoco{
 		/** @brief Constructor */
 		ShiftAddOp(ShiftAddDag* impl, ShiftAddOpType op, ShiftAddOp* i=NULL, int s=0, ShiftAddOp* j=NULL);
 
+		/** @brief Follows the Shift and Neg nodes down to the node that an adder graph may reference, accumulating their shift and sign */
+		static void unfoldRPAGOperand(ShiftAddOp* &sao, int &shift, int &sign);
+
 		friend std::ostream& operator<<(std::ostream& o, const ShiftAddOp& sao ); // output
 
 		friend FlopocoStream& operator<<(FlopocoStream& o, const ShiftAddOp& sao ); // output
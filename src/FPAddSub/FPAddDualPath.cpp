@@ -317,8 +317,16 @@ With combined shifter sticky (despite a few useless gates)
 
 		// perform carry in addition
 		REPORT(DETAILED, "Building far path adder");
+		// The far path only needs to be ready when the close path is: give its slack to the adder
+		string farAdderParams = join("wIn=", wF+4);
+		if(!onlyPositiveIO) {
+			schedule();
+			int farCycle = max(getCycleFromSignal("fracXfar"), max(getCycleFromSignal("fracYfarXorOp"), getCycleFromSignal("cInAddFar")));
+			int slack = getCycleFromSignal("resultBeforeRoundClose") - farCycle;
+			farAdderParams += join(" maxLatency=", max(slack, 0));
+		}
 		newInstance("IntAdder", getName()+"_fracAddFar",
-								join("wIn=", wF+4),
+								farAdderParams,
 								"X=>fracXfar,Y=>fracYfarXorOp,Cin=>cInAddFar", "R=>fracResultfar0");
 
 
@@ -0,0 +1,445 @@
+/*
+  A multi-operand floating-point adder for FloPoCo
+
+  The n significands are aligned to the largest exponent, summed in one bit heap,
+  then the sum is normalized and rounded once: compared to a tree of FPAdd,
+  the log2(n) levels of normalization and rounding are saved.
+
+  This file is part of the FloPoCo project
+
+  Author: agent
+
+  Initial software.
+  Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
+  2026.
+  All rights reserved.
+  */
+
+#include "FPAddN.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include <gmp.h>
+#include <mpfr.h>
+#include <gmpxx.h>
+#include <utils.hpp>
+#include <Operator.hpp>
+
+#include "../BitHeap/BitHeap.hpp"
+#include "../ShiftersEtc/Shifters.hpp"
+#include "../ShiftersEtc/Normalizer.hpp"
+#include "../IntAddSubCmp/IntAdder.hpp"
+
+using namespace std;
+
+namespace flopoco{
+
+
+	FPAddN::FPAddN(OperatorPtr parentOp, Target* target, int wE, int wF, int n, bool correctRounding) :
+		Operator(parentOp, target), wE(wE), wF(wF), n(n), correctRounding(correctRounding) {
+
+		srcFileName="FPAddN";
+
+		if(n < 2)
+			THROWERROR("n=" << n << ": at least two inputs are needed");
+
+		ostringstream name;
+		name << "FPAddN_" << wE << "_" << wF << "_" << n << (correctRounding ? "_CR" : "");
+		setNameWithFreqAndUID(name.str());
+		setCopyrightString("agent (2026)");
+
+		for(int i=0; i<n; i++)
+			addFPInput(join("X",i), wE, wF);
+		addFPOutput("R", wE, wF);
+
+		// The largest possible exponent difference: beyond it, all the inputs fit in the window
+		int maxExpDiff = (1<<wE) - 1;
+		// The window keeps guardBits below the significand of the largest input, and the result is the correct rounding
+		// of the sum of the inputs truncated to this window.
+		// Each truncated input is off by less than one unit of the window LSB, so n units in total,
+		// which remain below half an ulp of the result, hence a faithful result, unless the sum cancels to less than 2^-(wF+2) times the largest input.
+		if(correctRounding)
+			guardBits = maxExpDiff;
+		else
+			guardBits = min(wF + 2 + intlog2(n), maxExpDiff);
+		// the width of the aligned significands
+		int wWindow = wF + 1 + guardBits;
+		// the width of the bit heap: the sum of n such values, and a sign bit
+		int wSum = wWindow + intlog2(n) + 1;
+		REPORT(INFO, "alignment window of " << wWindow << " bits, bit heap of " << wSum << " bits");
+
+		addComment("Exceptions and exponents of the inputs, zeros and special values having a null significand");
+		for(int i=0; i<n; i++) {
+			string x = join("X",i);
+			vhdl << tab << declare(join("exc",i),2) << " <= " << x << range(wE+wF+2, wE+wF+1) << ";" << endl;
+			vhdl << tab << declare(join("sign",i)) << " <= " << x << of(wE+wF) << ";" << endl;
+			vhdl << tab << declare(getTarget()->logicDelay(3), join("expX",i), wE)
+					 << " <= " << x << range(wE+wF-1, wF) << " when " << join("exc",i) << "=\"01\" else " << zg(wE) << ";" << endl;
+			vhdl << tab << declare(getTarget()->logicDelay(3), join("sig",i), wF+1)
+					 << " <= '1' & " << x << range(wF-1, 0) << " when " << join("exc",i) << "=\"01\" else " << zg(wF+1) << ";" << endl;
+		}
+
+		addComment("The largest exponent, by a tree of comparisons");
+		vector<string> level;
+		for(int i=0; i<n; i++)
+			level.push_back(join("expX",i));
+		int l = 0;
+		while(level.size() > 1) {
+			vector<string> next;
+			for(unsigned k=0; k<level.size(); k+=2) {
+				if(k+1 == level.size()) {
+					next.push_back(level[k]);
+				}
+				else {
+					string m = join("expMax", l, "_", k/2);
+					vhdl << tab << declare(getTarget()->adderDelay(wE+1) + getTarget()->logicDelay(3), m, wE)
+							 << " <= " << level[k] << " when " << level[k] << " > " << level[k+1] << " else " << level[k+1] << ";" << endl;
+					next.push_back(m);
+				}
+			}
+			level = next;
+			l++;
+		}
+		vhdl << tab << declare("expMax", wE) << " <= " << level[0] << ";" << endl;
+
+		addComment("Alignment of the significands to the largest exponent, and two's complement in the bit heap");
+		// A negative input is added as (aligned xor sign) + sign - sign*2^wWindow, the last term being
+		// (not sign)*2^wWindow - 2^wWindow: the -2^wWindow of all the inputs are added as one constant
+		int maxShift = min(wWindow, maxExpDiff);
+		int wShift = intlog2(maxShift);
+		BitHeap* bh = new BitHeap(this, wSum);
+		for(int i=0; i<n; i++) {
+			vhdl << tab << declare(getTarget()->adderDelay(wE), join("shift",i), wE)
+					 << " <= expMax - " << join("expX",i) << ";" << endl;
+			if(maxShift < maxExpDiff) {
+				vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wE) + getTarget()->logicDelay(2), join("shiftVal",i), wShift)
+						 << " <= " << join("shift",i) << range(wShift-1, 0) << " when " << join("shift",i) << " <= " << maxShift
+						 << " else CONV_STD_LOGIC_VECTOR(" << maxShift << "," << wShift << ");" << endl;
+			}
+			else {
+				vhdl << tab << declare(join("shiftVal",i), wShift) << " <= " << join("shift",i) << range(wShift-1, 0) << ";" << endl;
+			}
+			newInstance("Shifter",
+									join("AlignmentShifter",i),
+									"wX=" + to_string(wF+1) + " wR=" + to_string(wWindow) + " maxShift=" + to_string(maxShift) + " dir=1",
+									"X=>" + join("sig",i) + ",S=>" + join("shiftVal",i),
+									"R=>" + join("aligned",i));
+			vhdl << tab << declareFixPoint(getTarget()->logicDelay(2), join("alignedXor",i), false, wWindow-1, 0)
+					 << " <= unsigned(" << join("aligned",i) << " xor " << rangeAssign(wWindow-1, 0, join("sign",i)) << ");" << endl;
+			bh->addSignal(join("alignedXor",i));
+			bh->addBit(join("sign",i), 0);
+			bh->addBit("not " + join("sign",i), wWindow);
+		}
+		bh->subtractConstant(n, wWindow);
+		bh->startCompression();
+
+		vhdl << tab << declare("sum", wSum) << " <= " << bh->getSumName() << ";" << endl;
+
+		addComment("Conversion of the sum to sign-magnitude");
+		int wAbs = wSum - 1;
+		vhdl << tab << declare("resSign") << " <= sum" << of(wSum-1) << ";" << endl;
+		vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wSum), "sumIsZero") << " <= '1' when sum=" << zg(wSum) << " else '0';" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(2), "notSum", wAbs) << " <= sum" << range(wAbs-1, 0) << " xor " << rangeAssign(wAbs-1, 0, "resSign") << ";" << endl;
+		newInstance("IntAdder",
+								"SignMagnitudeAdder",
+								"wIn=" + to_string(wAbs),
+								"X=>notSum,Cin=>resSign",
+								"R=>absSum",
+								"Y=>" + zg(wAbs,0));
+
+		addComment("Normalization: the leading one, wF fraction bits, the round bit, and a sticky out of the other bits");
+		newInstance("Normalizer",
+								"LZCShifter",
+								"wX=" + to_string(wAbs) + " wR=" + to_string(wF+2) + " maxShift=" + to_string(wAbs-1) + " computeSticky=1 countType=0",
+								"X=>absSum",
+								"R=>normSum, Count=>nZ, Sticky=>stickyLow");
+		int countWidth = getSignalByName("nZ")->width();
+
+		// The MSB of absSum has the weight of the leading bit of the largest input, plus intlog2(n).
+		// The exponent is computed on enough bits to detect overflow and underflow
+		int wExpExt = max(wE, countWidth) + 2;
+		vhdl << tab << declare(getTarget()->adderDelay(wExpExt), "expExt", wExpExt)
+				 << " <= (" << zg(wExpExt-wE) << " & expMax) + CONV_STD_LOGIC_VECTOR(" << intlog2(n) << "," << wExpExt << ")"
+				 << " - (" << zg(wExpExt-countWidth) << " & nZ);" << endl;
+
+		addComment("Rounding to nearest, the carry of the fraction propagating to the exponent");
+		vhdl << tab << declare("rnd") << " <= normSum" << of(0) << ";" << endl;
+		vhdl << tab << declare("lsb") << " <= normSum" << of(1) << ";" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(3), "needToRound") << " <= rnd and (stickyLow or lsb);" << endl;
+		vhdl << tab << declare("expFrac", wExpExt+wF) << " <= expExt & normSum" << range(wF, 1) << ";" << endl;
+		newInstance("IntAdder",
+								"RoundingAdder",
+								"wIn=" + to_string(wExpExt+wF),
+								"X=>expFrac,Cin=>needToRound",
+								"R=>roundedExpFrac",
+								"Y=>" + zg(wExpExt+wF,0));
+		vhdl << tab << declare("expRounded", wExpExt) << " <= roundedExpFrac" << range(wExpExt+wF-1, wF) << ";" << endl;
+		vhdl << tab << declare("expUnderflow") << " <= expRounded" << of(wExpExt-1) << ";" << endl;
+		vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wExpExt-wE), "expOverflow")
+				 << " <= '1' when expUnderflow='0' and expRounded" << range(wExpExt-2, wE) << "/=" << zg(wExpExt-1-wE) << " else '0';" << endl;
+
+		addComment("Exception management: NaN if any input is NaN, or for inf-inf; the sum of zeros is -0 only if they all are -0");
+		ostringstream anyNaN, plusInf, minusInf, allZero, zeroSign;
+		for(int i=0; i<n; i++) {
+			string sep = (i>0 ? " or " : "");
+			anyNaN << sep << join("exc",i) << "=\"11\"";
+			plusInf << sep << "(" << join("exc",i) << "=\"10\" and " << join("sign",i) << "='0')";
+			minusInf << sep << "(" << join("exc",i) << "=\"10\" and " << join("sign",i) << "='1')";
+			allZero << (i>0 ? " and " : "") << join("exc",i) << "=\"00\"";
+			zeroSign << (i>0 ? " and " : "") << join("sign",i);
+		}
+		vhdl << tab << declare(getTarget()->logicDelay(2*n), "anyNaN") << " <= '1' when " << anyNaN.str() << " else '0';" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(3*n), "plusInf") << " <= '1' when " << plusInf.str() << " else '0';" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(3*n), "minusInf") << " <= '1' when " << minusInf.str() << " else '0';" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(2*n), "allZero") << " <= '1' when " << allZero.str() << " else '0';" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(n), "zeroSign") << " <= " << zeroSign.str() << ";" << endl;
+
+		vhdl << tab << declare(getTarget()->logicDelay(6), "excR", 2) << " <= \"11\" when anyNaN='1' or (plusInf='1' and minusInf='1')" << endl
+				 << tab << tab << "else \"10\" when plusInf='1' or minusInf='1'" << endl
+				 << tab << tab << "else \"00\" when sumIsZero='1' or expUnderflow='1'" << endl
+				 << tab << tab << "else \"10\" when expOverflow='1'" << endl
+				 << tab << tab << "else \"01\";" << endl;
+		// IEEE standard says in 6.3: if exact sum is zero, it should be +zero in RN
+		vhdl << tab << declare(getTarget()->logicDelay(6), "signR") << " <= '0' when anyNaN='1' or (plusInf='1' and minusInf='1')" << endl
+				 << tab << tab << "else minusInf when plusInf='1' or minusInf='1'" << endl
+				 << tab << tab << "else zeroSign when allZero='1'" << endl
+				 << tab << tab << "else '0' when sumIsZero='1'" << endl
+				 << tab << tab << "else resSign;" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(2), "expR", wE) << " <= expRounded" << range(wE-1, 0) << " when excR=\"01\" else " << zg(wE) << ";" << endl;
+		vhdl << tab << declare(getTarget()->logicDelay(2), "fracR", wF) << " <= roundedExpFrac" << range(wF-1, 0) << " when excR=\"01\" else " << zg(wF) << ";" << endl;
+
+		vhdl << tab << "R <= excR & signR & expR & fracR;" << endl;
+	}
+
+
+
+	FPAddN::~FPAddN() {
+	}
+
+
+
+	void FPAddN::emulate(TestCase * tc)
+	{
+		// The exact sum: the inputs span at most 2^wE binades, plus the growth of the sum
+		int wSum = (1<<wE) + wF + intlog2(n) + 2;
+		mpfr_t x, s, t, r;
+		mpfr_init2(x, 1+wF);
+		mpfr_init2(s, wSum);
+		mpfr_init2(t, wSum);
+		mpfr_init2(r, 1+wF);
+		vector<mpfr_exp_t> exps;
+		mpfr_set_zero(t, 1);
+		for(int i=0; i<n; i++) {
+			FPNumber fpx(wE, wF, tc->getInputValue(join("X",i)));
+			fpx.getMPFR(x);
+			if(i==0)
+				mpfr_set(s, x, GMP_RNDN);
+			else
+				mpfr_add(s, s, x, GMP_RNDN); // exact, and with the IEEE signs of zeroes and infinities
+			if(mpfr_regular_p(x))
+				exps.push_back(mpfr_get_exp(x));
+		}
+
+		if(mpfr_regular_p(s)) {
+			// The sum of the inputs truncated (towards zero) to the window, whose LSB is wF+guardBits below the leading bit of the largest input.
+			// With correctRounding, the window covers the whole exponent range and this sum is exact.
+			mpfr_exp_t lsbWindow = *max_element(exps.begin(), exps.end()) - 1 - wF - guardBits;
+			for(int i=0; i<n; i++) {
+				FPNumber fpx(wE, wF, tc->getInputValue(join("X",i)));
+				fpx.getMPFR(x);
+				if(!mpfr_regular_p(x))
+					continue;
+				mpfr_mul_2si(x, x, -lsbWindow, GMP_RNDN);
+				mpfr_trunc(x, x);
+				mpfr_mul_2si(x, x, lsbWindow, GMP_RNDN);
+				mpfr_add(t, t, x, GMP_RNDN); // exact
+			}
+			// when the truncated sum cancels, the result is +0 as for an exact cancellation
+			mpfr_set(s, t, GMP_RNDN);
+		}
+
+		// The hardware rounds this sum to nearest, so there is a single expected output
+		mpfr_set(r, s, GMP_RNDN);
+		FPNumber fpr(wE, wF, r);
+		tc->addExpectedOutput("R", fpr.getSignalValue());
+
+		mpfr_clears(x, s, t, r, NULL);
+	}
+
+
+
+	void FPAddN::buildStandardTestCases(TestCaseList* tcl){
+		TestCase *tc;
+
+		// alternating 1 and -1: exact cancellation, which should return +0
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i%2==0 ? 1.0 : -1.0));
+		emulate(tc);
+		tcl->add(tc);
+
+		// cancellation of the two largest inputs, the result comes from much smaller ones
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? 1.0 : (i==1 ? -1.0 : exp2(-wF-3))));
+		emulate(tc);
+		tcl->add(tc);
+
+		// the same with nonzero fractions, still inside the window
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? 1.0 : (i==1 ? -1.0 : (1.5 + exp2(-wF))*exp2(-wF-3))));
+		emulate(tc);
+		tcl->add(tc);
+
+		// the same with nonzero fractions partly below the window: the result is the rounding of the truncated sum
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? 1.0 : (i==1 ? -1.0 : (1.5 + exp2(-wF))*exp2(-2*wF-3))));
+		emulate(tc);
+		tcl->add(tc);
+
+		// a carry propagating up to the exponent when rounding
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? 2.0 - exp2(-wF) : exp2(-wF-1)));
+		emulate(tc);
+		tcl->add(tc);
+
+		// all the zeros negative, then one positive
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), FPNumber::minusDirtyZero);
+		emulate(tc);
+		tcl->add(tc);
+
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==n-1 ? FPNumber::plusDirtyZero : FPNumber::minusDirtyZero));
+		emulate(tc);
+		tcl->add(tc);
+
+		// overflow
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), FPNumber::largestPositive);
+		emulate(tc);
+		tcl->add(tc);
+
+		// infinities
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? FPNumber::minusInfty : FPNumber::largestPositive));
+		emulate(tc);
+		tcl->add(tc);
+
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==0 ? FPNumber::plusInfty : (i==1 ? FPNumber::minusInfty : FPNumber::plusDirtyZero)));
+		emulate(tc);
+		tcl->add(tc);
+
+		tc = new TestCase(this);
+		for(int i=0; i<n; i++)
+			tc->addFPInput(join("X",i), (i==n-1 ? FPNumber::NaN : FPNumber::smallestPositive));
+		emulate(tc);
+		tcl->add(tc);
+	}
+
+
+
+	TestCase* FPAddN::buildRandomTestCase(int i){
+		TestCase *tc = new TestCase(this);
+		mpz_class normalExn = mpz_class(1)<<(wE+wF+1);
+		mpz_class negative  = mpz_class(1)<<(wE+wF);
+
+		if((i & 7) == 7) { // fully random, including special values
+			for(int k=0; k<n; k++)
+				tc->addInput(join("X",k), getLargeRandom(wE+wF+3));
+		}
+		else { // normal numbers of both signs with exponents close enough to interact
+			mpz_class e = getLargeRandom(wE);
+			int spread = intlog2(2*wF);
+			for(int k=0; k<n; k++) {
+				mpz_class ek = e - getLargeRandom(spread);
+				if(ek < 0)
+					ek = 0;
+				mpz_class x = getLargeRandom(wF) + (ek << wF) + normalExn;
+				if(getLargeRandom(1) == 1)
+					x += negative;
+				tc->addInput(join("X",k), x);
+			}
+		}
+		emulate(tc);
+		return tc;
+	}
+
+
+
+	OperatorPtr FPAddN::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
+		int wE, wF, n;
+		bool correctRounding;
+		UserInterface::parseStrictlyPositiveInt(args, "wE", &wE);
+		UserInterface::parseStrictlyPositiveInt(args, "wF", &wF);
+		UserInterface::parseStrictlyPositiveInt(args, "n", &n);
+		UserInterface::parseBoolean(args, "correctRounding", &correctRounding);
+		return new FPAddN(parentOp, target, wE, wF, n, correctRounding);
+	}
+
+
+
+	TestList FPAddN::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+
+		if(index==-1)
+		{ // The unit tests
+			vector<pair<int,int>> formats = {{5,10}, {8,23}, {11,52}};
+			for(auto f: formats) {
+				for(int n: {2, 3, 4, 7, 16}) {
+					for(int cr=0; cr<2; cr++) {
+						if(cr==1 && f.first>8) // the window would be thousands of bits wide
+							continue;
+						paramList.push_back(make_pair("wE",to_string(f.first)));
+						paramList.push_back(make_pair("wF",to_string(f.second)));
+						paramList.push_back(make_pair("n",to_string(n)));
+						paramList.push_back(make_pair("correctRounding",to_string(cr)));
+						paramList.push_back(make_pair("TestBench n=",to_string(1000)));
+						testStateList.push_back(paramList);
+						paramList.clear();
+					}
+				}
+			}
+		}
+		else
+		{
+			// finite number of random test computed out of index
+		}
+
+		return testStateList;
+	}
+
+	void FPAddN::registerFactory(){
+		UserInterface::add("FPAddN", // name
+			"A floating-point adder of n inputs, aligning them in one bit heap and rounding once.",
+			"BasicFloatingPoint",
+			"FPAdd", //seeAlso
+			"wE(int): exponent size in bits; \
+			wF(int): mantissa size in bits; \
+			n(int): number of inputs to add; \
+			correctRounding(bool)=false: correct rounding of the exact sum instead of the sum truncated to the window, at a cost exponential in wE;",
+			"The significands are aligned to the largest exponent, in a window of wF+2+log2(n) bits below the largest one. \
+			The result is the correct rounding of the sum truncated to this window. It is faithful, unless the sum cancels to less than 2<sup>-wF-2</sup> times the largest input. \
+			With correctRounding=1, the window covers the full exponent range and the sum is exact before rounding: this is affordable for small exponent sizes only.",
+			FPAddN::parseArguments,
+			FPAddN::unitTest
+			) ;
+	}
+
+
+}
@@ -0,0 +1,72 @@
+#ifndef FPADDN_HPP
+#define FPADDN_HPP
+#include <vector>
+#include <sstream>
+#include <gmp.h>
+#include <mpfr.h>
+#include <gmpxx.h>
+
+#include "../Operator.hpp"
+#include "../TestBenches/FPNumber.hpp"
+
+namespace flopoco{
+
+	/** A multi-operand floating-point adder.
+	 * The n significands are aligned to the largest exponent and summed in a single bit heap,
+	 * then the sum is normalized and rounded once.
+	 * The alignment window extends wF+2+log2(n) bits below the significand of the largest input,
+	 * and the result is the correct rounding of the sum of the inputs truncated to this window.
+	 * This is faithful unless the sum cancels to less than 2^-(wF+2) times the largest input.
+	 * With correctRounding, the window covers the full exponent range: the sum is exact before the final rounding,
+	 * which is correct in all cases but practical only for small exponent sizes.
+	 */
+	class FPAddN : public Operator
+	{
+	public:
+		/**
+		 * The FPAddN constructor
+		 * @param[in]		parentOp	parent operator in the instance hierarchy
+		 * @param[in]		target		target device
+		 * @param[in]		wE				with of the exponent
+		 * @param[in]		wF				with of the fraction
+		 * @param[in]		n					number of inputs
+		 * @param[in]		correctRounding		if false, the result is the rounding of the sum truncated to the window; if true, it is correctly rounded
+		 */
+		FPAddN(OperatorPtr parentOp, Target* target, int wE, int wF, int n, bool correctRounding=false);
+
+		/**
+		 * FPAddN destructor
+		 */
+		~FPAddN();
+
+
+		void emulate(TestCase * tc);
+		void buildStandardTestCases(TestCaseList* tcl);
+		TestCase* buildRandomTestCase(int i);
+
+		/** Factory method that parses arguments and calls the constructor */
+		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
+
+		/** Factory register method */
+		static void registerFactory();
+
+		/** Unit tests */
+		static TestList unitTest(int index);
+
+	private:
+		/** width of the exponent */
+		int wE;
+		/** width of the fraction */
+		int wF;
+		/** number of inputs */
+		int n;
+		/** correct rounding, or faithful rounding */
+		bool correctRounding;
+
+		/** number of bits kept below the significand of the largest input */
+		int guardBits;
+	};
+
+}
+
+#endif
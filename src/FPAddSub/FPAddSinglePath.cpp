@@ -221,19 +221,20 @@ with vrs -i
 		//shift in place
 		vhdl << tab << declare("fracSticky",wF+5) << "<= fracAddResult & sticky; "<<endl;
 
-		Normalizer* lzocs = (Normalizer*)
-			newInstance("Normalizer",
+		newInstance("Normalizer",
 									"LZCAndShifter",
 									"wX=" + to_string(wF+5) + " wR=" + to_string(wF+5) + " maxShift=" + to_string(wF+5) + " countType=0",
 									"X=>fracSticky",
 									"Count=>nZerosNew, R=>shiftedFrac");
+		// the instance may come from the build cache: get the count width from its output
+		int countWidth = getSignalByName("nZerosNew")->width();
 
 		// pipeline: there is plenty of time for this addition during the significand processing
 		vhdl << tab << declare(getTarget()->adderDelay(wE+1), "extendedExpInc",wE+1) << "<= (\"0\" & expX) + '1';"<<endl;
 
 		vhdl << tab << declare(getTarget()->adderDelay(wE+2),
-													 "updatedExp",wE+2) << " <= (\"0\" &extendedExpInc) - (" << zg(wE+2-lzocs->getCountWidth(),0) <<" & nZerosNew);"<<endl;
-		vhdl << tab << declare("eqdiffsign")<< " <= '1' when nZerosNew="<<og(lzocs->getCountWidth(),0)<<" else '0';"<<endl;
+													 "updatedExp",wE+2) << " <= (\"0\" &extendedExpInc) - (" << zg(wE+2-countWidth,0) <<" & nZerosNew);"<<endl;
+		vhdl << tab << declare("eqdiffsign")<< " <= '1' when nZerosNew="<<og(countWidth,0)<<" else '0';"<<endl;
 
 
 		//concatenate exponent with fraction to absorb the possible carry out
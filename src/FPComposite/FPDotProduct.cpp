@@ -29,15 +29,14 @@
 #include "Operator.hpp"
 
 #include "FPDotProduct.hpp"
-#include "FPMultSquare/FPMult.hpp"
 
 
 using namespace std;
 
 namespace flopoco{
 
-	FPDotProduct::FPDotProduct(Target* target, int wE, int wFX, int wFY, int MaxMSBX, int MSBA, int LSBA,  map<string, double> inputDelays):
-		Operator(target), wE(wE), wFX(wFX), wFY(wFY), MaxMSBX(MaxMSBX), LSBA(LSBA), MSBA(MSBA)  {
+	FPDotProduct::FPDotProduct(OperatorPtr parentOp, Target* target, int wE, int wFX, int wFY, int MaxMSBX, int MSBA, int LSBA, int lanes):
+		Operator(parentOp, target), wE(wE), wFX(wFX), wFY(wFY), MaxMSBX(MaxMSBX), LSBA(LSBA), MSBA(MSBA), lanes(lanes)  {
 	
 		ostringstream name;
 
@@ -46,118 +45,93 @@ namespace flopoco{
 			  <<(MaxMSBX>=0?"":"M")<<abs(MaxMSBX)<<"_"
 			  <<(LSBA>=0?"":"M")<<abs(LSBA)<<"_"
 			  <<(MSBA>=0?"":"M")<<abs(MSBA) ;
-
-		if(getTarget()->isPipelined()) 
-			name << getTarget()->frequencyMHz() ;
-		else
-			name << "comb";
+		if (lanes > 1)
+			name << "_x" << lanes;
 		setNameWithFreqAndUID(name.str()); 
 
-		setCopyrightString("Bogdan Pasca, Florent de Dinechin (2008-2011)");		
+		setCopyrightString("Bogdan Pasca, Florent de Dinechin (2008-2023)");		
+		setSequential();
 
-	
+		if (lanes < 1)
+			THROWERROR("the number of lanes should be at least 1");
+		
 		/* Set up the I/O signals of of the entity */
-		addFPInput ("X", wE, wFX);
-		addFPInput ("Y", wE, wFY);
+		for (int k=0; k<lanes; k++){
+			addFPInput (lanes==1 ? "X" : join("X",k), wE, wFX);
+			addFPInput (lanes==1 ? "Y" : join("Y",k), wE, wFY);
+		}
 		addInput   ("newDataSet");
 		
-		addOutput  ("A", MSBA-LSBA+1); //the width of the output represents the accumulator size
-		addOutput  ("C", MSBA-LSBA+1); //the width of the output represents the accumulator size
-		
+ 		sizeAcc_ = MSBA-LSBA+1;
+		for (int k=0; k<lanes; k++){
+			addOutput  (lanes==1 ? "A" : join("A",k), sizeAcc_); //the width of the output represents the accumulator size
+			addOutput  (lanes==1 ? "C" : join("C",k), sizeAcc_); //the width of the output represents the accumulator size
+		}
 		addOutput  ("XOverflow");  
 		addOutput  ("XUnderflow");  
 		addOutput  ("AccOverflow");  
-		
-		
- 		sizeAcc_ = MSBA-LSBA+1;
 
-		vhdl << tab << declare( "sX" ) << " <= X"<<of(wE+wFX+2)<<";"<<endl;
-		vhdl << tab << declare( "sY" ) << " <= Y"<<of(wE+wFY+2)<<";"<<endl;
-		
-		vhdl << tab << declare( "excX", 2 ) << " <= X"<<range(wE+wFX+1,wE+wFX)<<";"<<endl;
-		vhdl << tab << declare( "excY", 2 ) << " <= Y"<<range(wE+wFY+1,wE+wFY)<<";"<<endl;
-		
-		vhdl << tab << declare( "expX", wE ) << " <= X"<<range(wE+wFX-1,wFX)<<";"<<endl;
-		vhdl << tab << declare( "expY", wE ) << " <= Y"<<range(wE+wFY-1,wFY)<<";"<<endl;
-				
-		vhdl << tab << declare("fracX", wFX+1) << " <= \"1\" & X"<<range(wFX-1,0)<<";"<<endl;
-		vhdl << tab << declare("fracY", wFY+1) << " <= \"1\" & Y"<<range(wFY-1,0)<<";"<<endl;
-
-		setCriticalPath( getMaxInputDelays(inputDelays) );
-
-		/* sign */
-		vhdl << tab << declare("signP") << " <= sX xor sY;"<<endl;
-
-		/* multiply mantissas */
-		IntMultiplier *mMult = new IntMultiplier(target, 1+wFX, 1+wFY, 
-		                                         0 /* untruncated*/,  
-		                                         false /*unsigned*/,  
-		                                         inDelayMap("X", getTarget()->localWireDelay() + getCriticalPath()));
+		for (int k=0; k<lanes; k++){
+			string l = (lanes==1 ? "" : to_string(k));
+			string X = "X"+l, Y = "Y"+l;
 
-		inPortMap ( mMult, "X", "fracX");
-		inPortMap ( mMult, "Y", "fracY");
-		outPortMap( mMult, "R", "mFrac");
-		
-		vhdl << tab << instance( mMult, "MantisaMultiplier");
-		setSignalDelay("mFrac", mMult->getOutputDelay("R"));
-
-		/*in parallel manage exponents */
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->adderDelay(wE+1));		
-		vhdl << tab << declare("sumExp",wE+1) << " <= (\"0\" & expX) + (\"0\" & expY);"<<endl;
-		
-		/*check overflow*/
-		vhdl << tab << declare("overflow") << " <= sumExp"<<of(wE)<<";"<<endl;
-		
-		/* subtract bias */
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->adderDelay(wE+1));		
-		vhdl << tab << declare("sumExpMBias",wE+1) << " <= sumExp - (\"0\" & CONV_STD_LOGIC_VECTOR("<<intpow2(wE-1)-1<<","<<wE<<"));"<<endl;
-		
-		/*check underflow*/
-		vhdl << tab << declare("underflow") << " <= sumExpMBias"<<of(wE)<<";"<<endl;
+			vhdl << tab << declare( "sX"+l ) << " <= " << X << of(wE+wFX)<<";"<<endl;
+			vhdl << tab << declare( "sY"+l ) << " <= " << Y << of(wE+wFY)<<";"<<endl;
 		
-		/*set exceptions */
-		vhdl << tab << declare("excConcat",4) << "<= excX & excY;"<<endl;
+			vhdl << tab << declare( "excX"+l, 2 ) << " <= " << X << range(wE+wFX+2,wE+wFX+1)<<";"<<endl;
+			vhdl << tab << declare( "excY"+l, 2 ) << " <= " << Y << range(wE+wFY+2,wE+wFY+1)<<";"<<endl;
 		
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->lutDelay());
-		vhdl << tab << " with excConcat select " << endl;
-		vhdl << tab << declare( "excPhase1",2 ) << " <=  \"00\" when \"0000\","<<endl
-		     << tab << tab << "\"01\" when \"0101\","<<endl
-		     << tab << tab << "\"10\" when \"1001\"|\"0110\"|\"1010\","<<endl
-		     << tab << tab << "\"11\" when others;"<<endl;
-
-		vhdl << tab << declare("excConcatOU",4) << " <= excPhase1 & overflow & underflow;"<<endl;
-
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->lutDelay());
-		vhdl << tab << " with excConcatOU select " << endl;
-		vhdl << tab << declare( "exc",2 ) << " <=  \"00\" when \"0101\","<<endl
-		     << tab << tab << "\"10\" when \"0110\","<<endl
-		     << tab << tab << "excPhase1 when others;"<<endl;
-		
-		setSignalDelay("exc", getCriticalPath());
-		
-		syncCycleFromSignal("mFrac", getSignalDelay("mFrac"));			
+			vhdl << tab << declare( "expX"+l, wE ) << " <= " << X << range(wE+wFX-1,wFX)<<";"<<endl;
+			vhdl << tab << declare( "expY"+l, wE ) << " <= " << Y << range(wE+wFY-1,wFY)<<";"<<endl;
+				
+			vhdl << tab << declare("fracX"+l, wFX+1) << " <= \"1\" & " << X << range(wFX-1,0)<<";"<<endl;
+			vhdl << tab << declare("fracY"+l, wFY+1) << " <= \"1\" & " << Y << range(wFY-1,0)<<";"<<endl;
+
+			/* sign */
+			vhdl << tab << declare(getTarget()->logicDelay(2), "signP"+l) << " <= sX" << l << " xor sY" << l << ";"<<endl;
+
+			/* multiply mantissas: the product is exact */
+			newInstance("IntMultiplier",
+									"MantissaMultiplier"+l,
+									"wX=" + to_string(wFX+1) + " wY=" + to_string(wFY+1),
+									"X=>fracX"+l+",Y=>fracY"+l,
+									"R=>mFrac"+l);
+
+			/*in parallel manage exponents: the sum of the biased exponents is passed to the accumulator, which removes the bias */
+			vhdl << tab << declare(getTarget()->adderDelay(wE+1), "sumExp"+l, wE+1) << " <= (\"0\" & expX" << l << ") + (\"0\" & expY" << l << ");"<<endl;
+
+			/*set exceptions */
+			vhdl << tab << declare("excConcat"+l,4) << "<= excX" << l << " & excY" << l << ";"<<endl;
+			vhdl << tab << " with excConcat" << l << " select " << endl;
+			vhdl << tab << declare(getTarget()->lutDelay(), "exc"+l, 2) << " <=  \"00\" when \"0000\"|\"0001\"|\"0100\","<<endl
+					 << tab << tab << "\"01\" when \"0101\","<<endl
+					 << tab << tab << "\"10\" when \"1001\"|\"0110\"|\"1010\","<<endl
+					 << tab << tab << "\"11\" when others;"<<endl;
+		}
 
 		/* now we instantiate the accumulator */
-		FPLargeAcc* la = new FPLargeAcc(target, wE, wFX, MaxMSBX, MSBA, LSBA, inDelayMap("sigX_dprod",getTarget()->localWireDelay() + getCriticalPath()),true, wFY);
-		
-		inPortMap( la, "sigX_dprod", "signP");
-		inPortMap( la, "excX_dprod", "exc");
-		inPortMap( la, "fracX_dprod", "mFrac");
-		inPortMapCst( la, "expX_dprod", "sumExpMBias"+range(wE-1,0));
-
-		inPortMap( la, "newDataSet", "newDataSet");
-		outPortMap(la, "ready", "accReady");
-		outPortMap(la, "A", "accA");  
-		outPortMap(la, "C", "accC");
-		outPortMap(la, "XOverflow", "accXOverflow");  
-		outPortMap(la, "XUnderflow", "accXUnderflow");  
-		outPortMap(la, "AccOverflow", "accAccOverflow");  
-
-		vhdl << tab << instance(la, "Accumulator");
-		syncCycleFromSignal("A");
+		schedule();
+		for (int k=0; k<lanes; k++){
+			string l = (lanes==1 ? "" : to_string(k));
+			inPortMap("sigX_dprod"+l, "signP"+l);
+			inPortMap("excX_dprod"+l, "exc"+l);
+			inPortMap("fracX_dprod"+l, "mFrac"+l);
+			inPortMap("expX_dprod"+l, "sumExp"+l);
+			outPortMap("A"+l, "accA"+l);  
+			outPortMap("C"+l, "accC"+l);
+		}
+		inPortMap("newDataSet", "newDataSet");
+		outPortMap("XOverflow", "accXOverflow");  
+		outPortMap("XUnderflow", "accXUnderflow");  
+		outPortMap("AccOverflow", "accAccOverflow");  
+		acc_ = new FPLargeAcc(this, getTarget(), wE, wFX, MaxMSBX, MSBA, LSBA, lanes, true, wFY);
+		vhdl << tab << instance(acc_, "Accumulator", false);
 		
-		vhdl << tab << "A <= accA;"<<endl;
-		vhdl << tab << "C <= accC;"<<endl;
+		for (int k=0; k<lanes; k++){
+			string l = (lanes==1 ? "" : to_string(k));
+			vhdl << tab << "A" << l << " <= accA" << l << ";"<<endl;
+			vhdl << tab << "C" << l << " <= accC" << l << ";"<<endl;
+		}
 		vhdl << tab << "XOverflow <= accXOverflow;"<<endl;
 		vhdl << tab << "XUnderflow <= accXUnderflow;"<<endl;
 		vhdl << tab << "AccOverflow <= accAccOverflow;"<<endl;
@@ -332,30 +306,137 @@ namespace flopoco{
 		cout <<endl;
 	}
 	
+	void FPDotProduct::emulate(TestCase* tc){
+		bool newDataSet = (tc->getInputValue("newDataSet") == 1);
+		vector<mpz_class> exn, sign, exp, frac;
+		for (int k=0; k<lanes; k++){
+			string l = (lanes==1 ? "" : to_string(k));
+			mpz_class x = tc->getInputValue("X"+l);
+			mpz_class y = tc->getInputValue("Y"+l);
+			mpz_class excX = x >> (wE+wFX+1), excY = y >> (wE+wFY+1);
+			// the exception of the product
+			if ((excX==0 && excY<=1) || (excY==0 && excX<=1))
+				exn.push_back(0);
+			else if (excX==1 && excY==1)
+				exn.push_back(1);
+			else if (excX<=2 && excY<=2 && excX!=0 && excY!=0)
+				exn.push_back(2);
+			else
+				exn.push_back(3);
+			sign.push_back(((x >> (wE+wFX)) & 1) ^ ((y >> (wE+wFY)) & 1));
+			mpz_class expMask = (mpz_class(1) << wE) - 1;
+			exp.push_back(((x >> wFX) & expMask) + ((y >> wFY) & expMask));
+			mpz_class fracX = (x & ((mpz_class(1) << wFX) - 1)) + (mpz_class(1) << wFX);
+			mpz_class fracY = (y & ((mpz_class(1) << wFY) - 1)) + (mpz_class(1) << wFY);
+			frac.push_back(fracX * fracY);
+		}
+		acc_->emulateAccumulation(tc, newDataSet, exn, sign, exp, frac);
+	}
+
+	TestCase* FPDotProduct::buildRandomTestCase(int i){
+		TestCase *tc = new TestCase(this); 
+
+		/* a new data set at the first test, then from time to time */
+		tc->addInput("newDataSet", mpz_class((i==0 || getLargeRandom(6)==0) ? 1 : 0));
+
+		int bias = (1<<(wE-1)) -1;
+		for (int k=0; k<lanes; k++){
+			string l = (lanes==1 ? "" : to_string(k));
+			/* the exponent of the product mostly in the range that reaches the accumulator, with some underflows */
+			int range = MaxMSBX - LSBA + wFX + wFY + 4;
+			int e = LSBA - wFX - wFY - 3 + mpz_class(getLargeRandom(20) % range).get_si();
+			int eX = e/2;
+			int eY = e - eX;
+			mpz_class op[2];
+			int wF[2] = {wFX, wFY};
+			int exps[2] = {eX, eY};
+			for (int j=0; j<2; j++){
+				/* normal exception bits, with some zeroes and a few infinities and NaNs */
+				mpz_class exn = (getLargeRandom(5)==0 ? 0 : 1);
+				if (getLargeRandom(8)==0)
+					exn = 2 + getLargeRandom(1);
+				mpz_class exponent = min(max(exps[j]+bias, 0), (1<<wE)-1);
+				op[j] = (((((exn << 1) + getLargeRandom(1)) << wE) + exponent) << wF[j]) + getLargeRandom(wF[j]);
+			}
+			tc->addInput("X"+l, op[0]);
+			tc->addInput("Y"+l, op[1]);
+		}
+
+		/* Get correct outputs */
+		emulate(tc);
+		return tc;
+	}
+
 	OperatorPtr FPDotProduct::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
-		int wE, wFX, wFY, MaxMSBX, MSBA, LSBA;
+		int wE, wFX, wFY, MaxMSBX, MSBA, LSBA, lanes;
 		UserInterface::parseStrictlyPositiveInt(args, "wE", &wE); 
 		UserInterface::parseStrictlyPositiveInt(args, "wFX", &wFX);
 		UserInterface::parsePositiveInt(args, "wFY", &wFY);
 		UserInterface::parseInt(args, "MaxMSBX", &MaxMSBX);
 		UserInterface::parseInt(args, "MSBA", &MSBA);
 		UserInterface::parseInt(args, "LSBA", &LSBA);
-		return new FPDotProduct(target, wE, wFX, wFY, MaxMSBX, MSBA, LSBA);
+		UserInterface::parseStrictlyPositiveInt(args, "lanes", &lanes);
+		return new FPDotProduct(parentOp, target, wE, wFX, wFY, MaxMSBX, MSBA, LSBA, lanes);
+	}
+
+	TestList FPDotProduct::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+		
+		if(index==-1) 
+		{ // The unit tests
+			for(int lanes=1; lanes<=2; lanes++) {
+				for(int wF=10; wF<=23; wF+=13) {
+					int wE = (wF==10 ? 5 : 8);
+					paramList.push_back(make_pair("wE",to_string(wE)));
+					paramList.push_back(make_pair("wFX",to_string(wF)));
+					paramList.push_back(make_pair("wFY",to_string(wF)));
+					paramList.push_back(make_pair("MaxMSBX",to_string(wE+2)));
+					paramList.push_back(make_pair("MSBA",to_string(wE+10)));
+					paramList.push_back(make_pair("LSBA",to_string(-2*wF)));
+					paramList.push_back(make_pair("lanes",to_string(lanes)));
+					testStateList.push_back(paramList);
+					paramList.clear();
+				}
+				// a wide accumulator at a high frequency, split in several chunks: the result checks the sum A+C
+				paramList.push_back(make_pair("wE","8"));
+				paramList.push_back(make_pair("wFX","23"));
+				paramList.push_back(make_pair("wFY","23"));
+				paramList.push_back(make_pair("MaxMSBX","40"));
+				paramList.push_back(make_pair("MSBA","50"));
+				paramList.push_back(make_pair("LSBA","-60"));
+				paramList.push_back(make_pair("lanes",to_string(lanes)));
+				paramList.push_back(make_pair("frequency","600"));
+				testStateList.push_back(paramList);
+				paramList.clear();
+			}
+		}
+		else     
+		{
+				// finite number of random test computed out of index
+			// TODO
+		}	
+
+		return testStateList;
 	}
 
 	void FPDotProduct::registerFactory(){
 		UserInterface::add("FPDotProduct", // name
 											 "Floating-point dot product unit based on FPLargeAcc",
 											 "CompositeFloatingPoint",
-											 "", // seeAlso
+											 "FPLargeAcc,LargeAccToFP", // seeAlso
 											 "wE(int): the width of the exponent for the inputs X and Y; \
                         wFX(int): the width of the fraction for the input X;  \
                         wFY(int): the width of the fraction for the input Y;  \
                         MaxMSBX(int): maximum expected weight of the MSB of the summand;  \
-                        MSBA(int): The weight of the LSB of the accumulator determines the final accuracy of the result;  \
-                        LSBA(int): The weight of the MSB of the accumulator has to greater than that of the maximal expected result",
-											 "Kulisch-like dot product operator. It feeds a long accumulator with the unrounded result of a floating-point multiplier, thus removing rounding errors from the multiplication as well. ",
-											 FPDotProduct::parseArguments
+                        MSBA(int): The weight of the MSB of the accumulator has to greater than that of the maximal expected result;  \
+                        LSBA(int): The weight of the LSB of the accumulator determines the final accuracy of the result;\
+                        lanes(int)=1: the number of products accumulated per cycle, each in its own partial accumulator",
+											 "Kulisch-like dot product operator. It feeds a long accumulator with the unrounded result of a floating-point multiplier, thus removing rounding errors from the multiplication as well. Its A and C outputs are converted to floating point by LargeAccToFP. With several lanes, as many products are accumulated per cycle in as many partial accumulators, which LargeAccToFP merges.",
+											 FPDotProduct::parseArguments,
+											 FPDotProduct::unitTest
 											 ) ;
 	}
 }
@@ -8,7 +8,6 @@
 #include <cstdlib>
 
 #include "Operator.hpp"
-#include "IntMult/IntMultiplier.hpp"
 #include "FPLargeAcc.hpp"
 
 namespace flopoco{
@@ -25,10 +24,11 @@ namespace flopoco{
 		 * @param[in]		wFX     the width of the fraction for the input X
 		 * @param[in]		wFY     the width of the fraction for the input Y
 		 * @param[in]		MaxMSBX	maximum expected weight of the MSB of the summand
-		 * @param[in]		LSBA    The weight of the LSB of the accumulator; determines the final accuracy of the result
 		 * @param[in]		MSBA    The weight of the MSB of the accumulator; has to greater than that of the maximal expected result
+		 * @param[in]		LSBA    The weight of the LSB of the accumulator; determines the final accuracy of the result
+		 * @param[in]		lanes   the number of products accumulated per cycle, each in its own partial accumulator
 		 **/ 
-		FPDotProduct(Target* target, int wE, int wFX, int wFY, int MaxMSBX, int MSBA, int LSBA, map<string, double> inputDelays = emptyDelayMap);
+		FPDotProduct(OperatorPtr parentOp, Target* target, int wE, int wFX, int wFY, int MaxMSBX, int MSBA, int LSBA, int lanes=1);
 
 		/**
 		 * FPDotProduct destructor
@@ -40,12 +40,19 @@ namespace flopoco{
 		 * Tests the operator accuracy and relative error
 		 */
 		void test_precision(int n);
+
+		void emulate(TestCase* tc);
+
+		TestCase* buildRandomTestCase(int i);
 		
 		/** Factory method that parses arguments and calls the constructor */
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
 
 		/** Factory register method */ 
 		static void registerFactory();
+
+		/** Unit tests */
+		static TestList unitTest(int index);
 	
 	protected:
 		/** The width of the exponent for the inputs X and Y*/
@@ -60,10 +67,14 @@ namespace flopoco{
 		int LSBA;
 		/** The weight of the MSB of the accumulator; has to greater than that of the maximal expected result*/
 		int MSBA;
+		/** The number of partial accumulators */
+		int lanes;
 		/** The width in bits of the accumulator*/
 		int sizeAcc_;
 
 	private:
+		/** The accumulator, which also emulates the accumulation */
+		FPLargeAcc* acc_;
 	};
 }
 #endif
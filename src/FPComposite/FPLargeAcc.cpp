@@ -33,207 +33,226 @@ using namespace std;
 
 namespace flopoco{
 
-	FPLargeAcc::FPLargeAcc(Target* target, int wEX, int wFX, int MaxMSBX, int MSBA, int LSBA, map<string, double> inputDelays,  bool forDotProd, int wFY): 
-		Operator(target), 
-		wEX_(wEX), wFX_(wFX), MaxMSBX_(MaxMSBX), LSBA_(LSBA), MSBA_(MSBA), AccValue_(0), xOvf(0)
+	FPLargeAcc::FPLargeAcc(OperatorPtr parentOp, Target* target, int wEX, int wFX, int MaxMSBX, int MSBA, int LSBA, int lanes, bool forDotProd, int wFY):
+		Operator(parentOp, target),
+		wEX_(wEX), wFX_(wFX), MaxMSBX_(MaxMSBX), LSBA_(LSBA), MSBA_(MSBA), lanes_(lanes), forDotProd_(forDotProd), wFY_(wFY),
+		xOverflowState_(false), xUnderflowState_(false), accOverflowState_(false)
 	{
-		// You probably want to remove the following line to have the warnings come back
-		//if you modify this operator
+		srcFileName="FPLargeAcc";
+		// The accumulation loops are built with addFeedbackRegister(), which takes care of the delay-1 feedbacks
 		setHasDelay1Feedbacks(); 
+		setCopyrightString("Florent de Dinechin, Bogdan Pasca (2008-2023)");
+
+		// This operator is a sequential one
+		setSequential();
 
 		if (!forDotProd)
-			wFY=wFX;
-		
-		int i;
-		setCopyrightString("Florent de Dinechin, Bogdan Pasca (2008-2009)");		
+			wFY_=wFX;
 
-		//check input constraints, i.e, MaxMSBX <= MSBA, LSBA<MaxMSBx
-		if ((MaxMSBX_ > MSBA_)){
-			cerr << " FPLargeAcc: Input constraint MaxMSBX <= MSBA not met." << endl;
-			exit (EXIT_FAILURE);
-		}
-		if ((LSBA_ >= MaxMSBX_)){
-			cerr << " FPLargeAcc: Input constraint LSBA<MaxMSBx not met:"<<
-				" This accumulator would never accumulate a bit." << endl;
-			exit (EXIT_FAILURE);
-		}
+		//check input constraints, i.e, MaxMSBX < MSBA (the accumulator needs a sign bit above the summand), LSBA<MaxMSBx
+		if (lanes_ < 1)
+			THROWERROR("the number of lanes should be at least 1");
+		if (MaxMSBX_ >= MSBA_)
+			THROWERROR("Input constraint MaxMSBX < MSBA not met: the accumulator needs a sign bit above MaxMSBX.");
+		if (LSBA_ >= MaxMSBX_)
+			THROWERROR("Input constraint LSBA<MaxMSBx not met: this accumulator would never accumulate a bit.");
 
 		ostringstream name; 
 		name <<"FPLargeAcc_"<<wEX_<<"_"<<wFX_<<"_"
 				 <<(MaxMSBX_>=0?"":"M")<<abs(MaxMSBX_)<<"_"
 				 <<(MSBA_>=0?"":"M")<<abs(MSBA_)<<"_" 
 				 <<(LSBA_>=0?"":"M")<<abs(LSBA_);
+		if (forDotProd)
+			name << "_dprod" << wFY_;
+		if (lanes_ > 1)
+			name << "_x" << lanes_;
 		setNameWithFreqAndUID(name.str());
 
-		// This operator is a sequential one
-		setSequential();
-
 		// Set up various architectural parameters
-		sizeAcc_ = MSBA_-LSBA_+1;
-
+		int bias = (1<<(wEX_-1)) -1;      // exponent bias
+		int wExp;                         // the width of the exponent that enters the accumulator
 		if (forDotProd){
-			addInput ("sigX_dprod");
-			addInput ("excX_dprod", 2);
-			addInput ("fracX_dprod", 1+wFX+1+wFY);
-			addInput ("expX_dprod", wEX);
-		}else
-			addFPInput ("X", wEX_,wFX_);
-		
-
+			// the input is the exact product: 2 bits before the point, and an exponent which is the sum of the biased exponents
+			wFrac_         = wFX_+wFY_+2;
+			fracLSBOffset_ = wFX_+wFY_;
+			wExp           = wEX_+1;
+			expBias_       = 2*bias;
+		}
+		else{
+			wFrac_         = wFX_+1;
+			fracLSBOffset_ = wFX_;
+			wExp           = wEX_;
+			expBias_       = bias;
+			//MaxMSBx is one valid exponent value, that is, 
+			//1. after bias is added, value should be >= 0
+			//2. after bias is added, representation should still fit on no more than wEX bits
+			int biasedMaxMSBX = MaxMSBX_ + bias;
+			if(biasedMaxMSBX < 0 || biasedMaxMSBX > (1<<wEX_)-1)
+				THROWERROR("MaxMSBX=" << MaxMSBX_ << " is not a valid exponent of X (range "
+									 << (-bias) << " to " << ((1<<wEX_)-1)-bias << ")");
+		}
+		sizeAcc_     = MSBA_-LSBA_+1;
+		sizeSummand_ = MaxMSBX_-LSBA_+1;         // the size of the summand (the maximum one - when the MSB of the input is on MaxMSBX)
+		// shift is 0 when the LSB of the input integer part is at LSBA, i.e. when the MSB of the input is at LSBA+wFrac-1-fracLSBOffset
+		maxShift_    = MaxMSBX_ - (wFrac_-1-fracLSBOffset_) - LSBA_;
+		if (maxShift_ < 1)
+			THROWERROR("MaxMSBX=" << MaxMSBX_ << " too close to LSBA=" << LSBA_ << ": nothing to shift");
+
+		/* set-up carry-save parameters: each chunk is added in one cycle, with its carry out saved in a register */
+		int chunkSize = sizeAcc_;
+		if (getTarget()->isPipelined())
+			getTarget()->suggestSlackSubaddSize(chunkSize, sizeAcc_, getTarget()->localWireDelay() + getTarget()->lutDelay());
+		if (chunkSize < 1)
+			chunkSize = 1;
+		int nbOfChunks = (sizeAcc_+chunkSize-1)/chunkSize;
+		// balance the chunks
+		int lsb=0;
+		for (int i=0; i<nbOfChunks; i++){
+			chunkLSB_.push_back(lsb);
+			chunkSize_.push_back(sizeAcc_/nbOfChunks + (i < sizeAcc_%nbOfChunks ? 1 : 0));
+			lsb += chunkSize_[i];
+		}
+		REPORT(INFO, "Accumulator of " << sizeAcc_ << " bits split in " << nbOfChunks << " chunk(s) of at most " << chunkSize_[0] << " bits");
+		// the critical path of the accumulation loop, which must fit in one cycle
+		double loopDelay = getTarget()->lutDelay() + getTarget()->adderDelay(chunkSize_[0]+1);
+
+		for (int k=0; k<lanes_; k++){
+			if (forDotProd){
+				addInput (laneName("sigX_dprod",k));
+				addInput (laneName("excX_dprod",k), 2);
+				addInput (laneName("fracX_dprod",k), wFrac_);
+				addInput (laneName("expX_dprod",k), wExp);
+			}else
+				addFPInput (laneName("X",k), wEX_,wFX_);
+		}
 		addInput   ("newDataSet");
-		addOutput  ("ready");
-		addOutput  ("A", sizeAcc_);  
-		addOutput  ("C", sizeAcc_);
+		for (int k=0; k<lanes_; k++){
+			addOutput  (laneName("A",k), sizeAcc_);  
+			addOutput  (laneName("C",k), sizeAcc_);
+		}
 		addOutput  ("XOverflow");  
 		addOutput  ("XUnderflow");  
 		addOutput  ("AccOverflow");  
-		
-		maxShift_        = MaxMSBX_-LSBA_;              // shift is 0 when the implicit 1 is at LSBA_
-		sizeShift_       = intlog2(maxShift_);         // the number of bits needed to control the shifter
-		sizeSummand_     = MaxMSBX_-LSBA_+1;         // the size of the summand (the maximum one - when the inplicit 1 is on MaxMSBX)
-		sizeShiftedFrac_ = maxShift_ + wFX_+1;   
-		E0X_ = (1<<(wEX_-1)) -1;                 // exponent bias
-		// Shift is 0 when implicit 1 is on LSBA, that is when EX-bias = LSBA
-		// that is, EX-bias-LSBA = 0, EX-(bias + LSBA) = 0
-		// We are working in sign-magnitude, so we differentiate 2 cases:
-		// 1. when bias+LSBA >=0, that is, sign bit is 0, then shiftValue = Exp - (bias+LSBA) ;  (0)Exp - (0)(bias+LSBA)
-		// 2. when bias+LSBA <=0, which means that the sign bit is 1. Because in this case we have a substraction of a negative number,
-		// we replace it whit an addition of -(bias+LSBA), that is (0)Exp + (0)(- (bias + LSBA))
-		//	
-		// If the shift value is negative, then the input is shifted out completely, and a 0 is added to the accumulator 
-		// All above computations are performed on wEx+1 bits	
-	
-		//MaxMSBx is one valid exponent value, that is, 
-		//1. after bias is added, value should be >= 0
-		//2. after bias is added, representation should still fit on no more than wEX bits
-		int biasedMaxMSBX_ = MaxMSBX_ + E0X_;
-		if(biasedMaxMSBX_ < 0 || intlog2(biasedMaxMSBX_)>wEX_) {
-			cerr<<"ERROR in FPLargeAcc: MaxMSBX_="<<MaxMSBX_<<" is not a valid exponent of X (range "
-				 <<(-E0X_)<< " to " << ((1<<wEX_)-1)-E0X_ <<endl;
-			exit (EXIT_FAILURE);
-		}
-
-		/* set-up carry-save parameters */		
-		int chunkSize_;
-		getTarget()->suggestSlackSubaddSize(chunkSize_ , sizeAcc_, getTarget()->localWireDelay() + getTarget()->lutDelay());
-		REPORT( DEBUG, "Addition chunk size in FPLargeAcc is:"<<chunkSize_);
-		 
-		int nbOfChunks    = ceil(double(sizeAcc_)/double(chunkSize_));
-		int lastChunkSize = ( sizeAcc_ % chunkSize_ == 0 ? chunkSize_  : sizeAcc_ % chunkSize_);
-
-
-		/* if FPLargeAcc is used in FPDotProduct, then its input fraction is twice as large */
-		if (!forDotProd){
-			vhdl << tab << declare("fracX",wFX_+1) << " <=  \"1\" & X" << range(wFX_-1,0) << ";" << endl;
-			vhdl << tab << declare("expX" ,wEX_  ) << " <= X" << range(wEX_+wFX_-1,wFX_) << ";" << endl;
-			vhdl << tab << declare("signX") << " <= X" << of(wEX_+wFX_) << ";" << endl;
-			vhdl << tab << declare("exnX" ,2     ) << " <= X" << range(wEX_+wFX_+2,wEX_+wFX_+1) << ";" << endl;
-		}else{
-			vhdl << tab << declare("fracX",wFX_ + wFY +2) << " <= fracX_dprod;" << endl;
-			vhdl << tab << declare("expX" ,wEX_  ) << " <= expX_dprod;" << endl;
-			vhdl << tab << declare("signX") << " <= sigX_dprod;" << endl;
-			vhdl << tab << declare("exnX" ,2     ) << " <= excX_dprod;" << endl;
-		}
 
-		setCriticalPath( getMaxInputDelays(inputDelays));
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->adderDelay(wEX+1)); 
-
-		/* declaring the underflow and overflow conditions of the input X. 
-		these two flags are used to reparameter the accumulator following a test
-		run. If Xoverflow has happened, then MaxMSBX needs to be increased and 
-		the accumulation result is invalidated. If Xunderflow is raised then 
-		user can lower LSBA for obtaining a even better accumulation precision */
-		vhdl << tab << declare("xOverflowCond" ,1, false, Signal::registeredWithSyncReset) << " <= '1' when (( expX > CONV_STD_LOGIC_VECTOR("<<MaxMSBX_ + E0X_<<","<< wEX_<<")) or (exnX >= \"10\")) else '0' ;"<<endl; 
-		vhdl << tab << declare("xUnderflowCond",1, false, Signal::registeredWithSyncReset) << " <= '1' when (expX < CONV_STD_LOGIC_VECTOR("<<LSBA_ + E0X_<<","<<wEX_<<")) else '0' ;" << endl;  
-		
-		mpz_class exp_offset = E0X_+LSBA_;
-		vhdl << tab << declare("shiftVal",wEX_+1) << " <= (\"0\" & expX) - CONV_STD_LOGIC_VECTOR("<< exp_offset <<","<<  wEX_+1<<");" << endl;
-
-		shifter_ = new Shifter(this, target, (forDotProd?wFX_+wFY+2:wFX_+1), maxShift_, Shifter::Left);
-
-		inPortMap   (shifter_, "X", "fracX");
-		inPortMapCst(shifter_, "S", "shiftVal"+range(shifter_->getShiftInWidth() - 1,0));
-		outPortMap  (shifter_, "R", "shifted_frac");
-		vhdl << instance(shifter_, "FPLargeAccInputShifter");
-	
-		syncCycleFromSignal("shifted_frac");
-
-
-
-		/* determine if the input has been shifted out from the accumulator. 
-		In this case the accumulator will added 0 */
-		vhdl << tab << declare("flushedToZero") << " <= '1' when (shiftVal" << of(wEX_)<<"='1' or exnX=\"00\") else '0';" << endl;
-
-		/* in most FPGAs computation of the summand2c will be done in one LUT level */
-		vhdl << tab << declare("summand", sizeSummand_, true, Signal::registeredWithSyncReset) << "<= " << 
-					zg(sizeSummand_) << " when flushedToZero='1' else shifted_frac" << range(sizeShiftedFrac_-1,wFX_)<<";" << endl;
-
-		vhdl << tab << "-- 2's complement of the summand" << endl;
-		/* Don't compute 2's complement just yet, just invert the bits and leave 
-		the addition of the extra 1 in accumulation, as a carry in bit for the 
-		first chunk*/
-		vhdl << tab << declare("summand2c", sizeSummand_, true) << " <= summand when (signX='0' or flushedToZero='1') else not(summand);"<< endl;
+		// Shift is 0 when the implicit 1 is on LSBA, that is when EX-bias = LSBA
+		// that is, EX-bias-LSBA = 0, EX-(bias + LSBA) = 0
+		// The shift value is computed in two's complement on enough bits for EX, bias+LSBA and maxShift
+		int expOffset = expBias_+LSBA_;
+		int wShiftVal = max(max(wExp, intlog2(abs(expOffset))), intlog2(maxShift_)) + 2;
+		int wS = intlog2(maxShift_);
+
+		for (int k=0; k<lanes_; k++){
+			string fracX = laneName("fracX",k), expX = laneName("expX",k), signX = laneName("signX",k), exnX = laneName("exnX",k);
+			string shiftVal = laneName("shiftVal",k), negShift = laneName("negShift",k), bigShift = laneName("bigShift",k);
+			string summandValid = laneName("summandValid",k), shifted = laneName("shiftedFrac",k);
+			string summand = laneName("summand",k), negate = laneName("negate",k), summand2c = laneName("summand2c",k);
+			string summandIn = laneName("summandIn",k);
+
+			/* if FPLargeAcc is used in FPDotProduct, then its input fraction is twice as large */
+			if (!forDotProd){
+				string X = laneName("X",k);
+				vhdl << tab << declare(fracX,wFrac_) << " <=  \"1\" & " << X << range(wFX_-1,0) << ";" << endl;
+				vhdl << tab << declare(expX ,wExp  ) << " <= " << X << range(wEX_+wFX_-1,wFX_) << ";" << endl;
+				vhdl << tab << declare(signX) << " <= " << X << of(wEX_+wFX_) << ";" << endl;
+				vhdl << tab << declare(exnX ,2     ) << " <= " << X << range(wEX_+wFX_+2,wEX_+wFX_+1) << ";" << endl;
+			}else{
+				vhdl << tab << declare(fracX,wFrac_) << " <= " << laneName("fracX_dprod",k) << ";" << endl;
+				vhdl << tab << declare(expX ,wExp  ) << " <= " << laneName("expX_dprod",k) << ";" << endl;
+				vhdl << tab << declare(signX) << " <= " << laneName("sigX_dprod",k) << ";" << endl;
+				vhdl << tab << declare(exnX ,2     ) << " <= " << laneName("excX_dprod",k) << ";" << endl;
+			}
 
-		vhdl << tab << "-- sign extension of the summand to accumulator size" << endl;
-		vhdl << tab << declare("ext_summand2c",sizeAcc_,true) << " <= " << (sizeAcc_-1<sizeSummand_?"":rangeAssign(sizeAcc_-1, sizeSummand_, "signX and not flushedToZero")+" & ") << "summand2c;" << endl;
+			vhdl << tab << declare(getTarget()->adderDelay(wShiftVal), shiftVal, wShiftVal) << " <= (" << zg(wShiftVal-wExp) << " & " << expX << ")"
+					 << " - CONV_STD_LOGIC_VECTOR(" << expOffset << "," << wShiftVal << ");" << endl;
+			vhdl << tab << declare(negShift) << " <= " << shiftVal << of(wShiftVal-1) << ";" << endl;
+			vhdl << tab << declare(getTarget()->adderDelay(wShiftVal), bigShift) << " <= '1' when (" << negShift << "='0' and " << shiftVal
+					 << " > CONV_STD_LOGIC_VECTOR(" << maxShift_ << "," << wShiftVal << ")) else '0';" << endl;
+
+			/* the underflow and overflow conditions of the input X. 
+			These flags are used to reparameter the accumulator following a test
+			run. If Xoverflow has happened, then MaxMSBX needs to be increased and 
+			the accumulation result is invalidated. If Xunderflow is raised then 
+			user can lower LSBA for obtaining a even better accumulation precision */
+			vhdl << tab << declare(getTarget()->logicDelay(3), laneName("xOverflowCond",k)) << " <= " << exnX << of(1) << " or (" << exnX << of(0) << " and " << bigShift << ");" << endl;
+			vhdl << tab << declare(getTarget()->logicDelay(3), laneName("xUnderflowCond",k)) << " <= not " << exnX << of(1) << " and " << exnX << of(0) << " and " << negShift << ";" << endl;
+			vhdl << tab << declare(getTarget()->logicDelay(4), summandValid) << " <= '1' when " << exnX << "=\"01\" and " << negShift << "='0' and " << bigShift << "='0' else '0';" << endl;
+
+			newInstance("Shifter",
+									laneName("InputShifter",k),
+									"wX=" + to_string(wFrac_) + " maxShift=" + to_string(maxShift_) + " dir=0",
+									"X=>" + fracX + ",S=>" + shiftVal + range(wS-1,0),
+									"R=>" + shifted);
+
+			/* in most FPGAs computation of the summand2c will be done in one LUT level */
+			vhdl << tab << declare(getTarget()->lutDelay(), summand, sizeSummand_) << " <= "
+					 << shifted << range(wFrac_+maxShift_-1, fracLSBOffset_) << " when " << summandValid << "='1' else " << zg(sizeSummand_) << ";" << endl;
+			vhdl << tab << "-- 2's complement of the summand" << endl;
+			/* Don't compute 2's complement just yet, just invert the bits and leave 
+			the addition of the extra 1 in accumulation, as a carry in bit for the 
+			first chunk*/
+			vhdl << tab << declare(negate) << " <= " << signX << " and " << summandValid << ";" << endl;
+			vhdl << tab << declare(getTarget()->lutDelay(), summand2c, sizeSummand_) << " <= not " << summand << " when " << negate << "='1' else " << summand << ";" << endl;
+			vhdl << tab << "-- sign extension of the summand to accumulator size, with the carry in on top" << endl;
+			// the contribution of summandIn is the critical path of the accumulation loop, so that the loop fits in one cycle
+			vhdl << tab << declare(loopDelay, summandIn, sizeAcc_+1) << " <= " << negate << " & "
+					 << rangeAssign(sizeAcc_-1, sizeSummand_, negate) << " & " << summand2c << ";" << endl;
+
+			vhdl << tab << "-- accumulation itself" << endl;
+			// The loop is not pipelined: each chunk is added in one cycle, and its carry out is added to the next chunk in the next cycle
+			disablePipelining();
+			for (int i=0; i < nbOfChunks; i++) {
+				int w = chunkSize_[i];
+				string acc = laneName(join("acc_",i),k);
+				string accNext = laneName(join("acc_",i,"_next"),k);
+				string accExt = laneName(join("acc_",i,"_ext"),k);
+				string carryIn = (i==0 ? summandIn+of(sizeAcc_) : "(" + laneName(join("carryBit_",i),k) + " and not newDataSet)");
+				vhdl << tab << declare(accExt, w+1) << " <= (\"0\" & (" << acc << " and " << rangeAssign(w-1, 0, "not newDataSet") << ")) + "
+						 << "(\"0\" & " << summandIn << range(chunkLSB_[i]+w-1, chunkLSB_[i]) << ") + " << carryIn << ";" << endl;
+				vhdl << tab << declare(accNext, w) << " <= " << accExt << range(w-1,0) << ";" << endl;
+				addFeedbackRegister(acc, accNext, summandIn);
+				if (i < nbOfChunks-1){
+					string carryBit = laneName(join("carryBit_",i+1),k);
+					vhdl << tab << declare(carryBit+"_next") << " <= " << accExt << of(w) << ";" << endl;
+					addFeedbackRegister(carryBit, carryBit+"_next", summandIn);
+				}
+			}
 
-		vhdl << tab << "-- accumulation itself" << endl;
-		//determine the value of the carry in bit
-		vhdl << tab << declare("carryBit_0",1,false) << " <= signX and not flushedToZero;" << endl; 
-		
-		
-		for (i=0; i < nbOfChunks; i++) {
-			ostringstream accReg;
-			accReg<<"acc_"<<i;
-
-			vhdl << tab << declare(join("acc_",i),(i!=nbOfChunks-1?chunkSize_:lastChunkSize) ,true, Signal::registeredWithSyncReset) << " <= " << 
-				join("acc_",i,"_ext")<<range((i!=nbOfChunks-1?chunkSize_-1:lastChunkSize-1),0) << ";" << endl;
-			vhdl << tab << declare(join("carryBit_",i+1),1, false, Signal::registeredWithSyncReset) <<"  <= " << join("acc_",i,"_ext")<<of((i!=nbOfChunks-1?chunkSize_:lastChunkSize)) << ";" << endl;
-			nextCycle();		
-			vhdl << tab << declare(join("acc_",i,"_ext"),(i!=nbOfChunks-1?chunkSize_:lastChunkSize)+1) << " <= ( \"0\" & (" <<join("acc_",i)<< " and "<<rangeAssign( (i!=nbOfChunks-1?chunkSize_:lastChunkSize)-1,0, "not(newDataSet)") <<")) + " <<
-				"( \"0\" & ext_summand2c" << range( (i!=nbOfChunks-1?chunkSize_*(i+1)-1:sizeAcc_-1), chunkSize_*i) << ") + " << 
-				"("<<join("carryBit_",i) << (i>0?" and not(newDataSet)":"")<< ");" << endl;
-			setCycleFromSignal("carryBit_0");
+			// the accumulator overflows when the sum of two numbers of the same sign has the other sign
+			int top = nbOfChunks-1;
+			int wTop = chunkSize_[top];
+			vhdl << tab << declare(laneName("accOverflowCond",k)) << " <= ((" << laneName(join("acc_",top),k) << of(wTop-1) << " and not newDataSet) xnor "
+					 << summandIn << of(sizeAcc_-1) << ") and (" << laneName(join("acc_",top,"_next"),k) << of(wTop-1) << " xor " << summandIn << of(sizeAcc_-1) << ");" << endl;
+
+			//compose the A and C outputs
+			vhdl << tab << laneName("A",k) << " <= ";
+			for (int i=nbOfChunks-1; i>=0; i--)
+				vhdl << laneName(join("acc_",i,"_next"),k) << (i>0 ? " & " : ";\n");
+			vhdl << tab << laneName("C",k) << " <= ";
+			for (int i=nbOfChunks-1; i>=0; i--){
+				// the carry into chunk i has the weight of its LSB
+				if (i>0)
+					vhdl << (chunkSize_[i]>1 ? zg(chunkSize_[i]-1) + " & " : "") << laneName(join("carryBit_",i,"_next"),k) << " & ";
+				else
+					vhdl << zg(chunkSize_[0]) << ";" << endl;
+			}
+			enablePipelining();
 		}
 
-		setCycleFromSignal("carryBit_0",false);
-		vhdl << tab << declare("xOverflowRegister",1,false, Signal::registeredWithSyncReset) << " <= "; nextCycle(false); vhdl << "xOverflowRegister or xOverflowCond;"<<endl;
-		setCycleFromSignal("carryBit_0",false);
-		vhdl << tab << declare("xUnderflowRegister",1,false, Signal::registeredWithSyncReset) << " <= "; nextCycle(false); vhdl << "xUnderflowRegister or xUnderflowCond;"<<endl;
-		setCycleFromSignal("carryBit_0",false);
-		vhdl << tab << declare("accOverflowRegister",1,false, Signal::registeredWithSyncReset) << " <= "; nextCycle(false); vhdl << "accOverflowRegister or "<<join("carryBit_",nbOfChunks) << ";"<<endl;
-		setCycleFromSignal("carryBit_0",false);
-
-		nextCycle();
-		
-		//compose the acc signal 
-		vhdl << tab << declare("acc", sizeAcc_) << " <= ";
-		for (i=nbOfChunks-1;i>=0;i--)
-			vhdl << join("acc_",i) <<  (i>0?" & ":";\n");
-	
-		vhdl << tab << declare("carry", sizeAcc_) << " <= ";
-		for (i=nbOfChunks-1;i>=0; i--){
-			vhdl << (i<nbOfChunks-1?join("carryBit_",i+1)+" & ":"");
-			vhdl << (i==nbOfChunks-1?zg(lastChunkSize-(i>0?1:0))+(i>0?" & ":""):(i>0?zg(chunkSize_-1)+" & ":zg(chunkSize_)));
-		}vhdl << ";" << endl;
-
-		if (nbOfChunks > 1 ){
-			vhdl << tab << "A <=   acc;" << endl;
-			vhdl << tab << "C <=   carry;" << endl;
-		}else{
-			vhdl << tab << "A <=  acc_0;" << endl;
-			vhdl << tab << "C <=   carry;" << endl;
+		// The flags are sticky until the next data set: they are ORed over the lanes, and accumulated with the same timing as lane 0
+		string flags[3] = {"xOverflow", "xUnderflow", "accOverflow"};
+		string ports[3] = {"XOverflow", "XUnderflow", "AccOverflow"};
+		for (int f=0; f<3; f++){
+			vhdl << tab << declare(flags[f]+"In") << " <= ";
+			for (int k=0; k<lanes_; k++)
+				vhdl << laneName(flags[f]+"Cond",k) << (k<lanes_-1 ? " or " : ";\n");
 		}
-	
-//		nextCycle();
-		//if accumulator overflows this flag will be set to 1 until a maunal reset is performed
-		vhdl << tab << "AccOverflow <= accOverflowRegister;"<<endl; 
-		//if the input overflows then this flag will be set to 1, and will remain 1 until manual reset is performed
-		vhdl << tab << "XOverflow <= xOverflowRegister;"<<endl; 
-		vhdl << tab << "XUnderflow <= xUnderflowRegister;"<<endl; 
-
-		setCycleFromSignal("acc");
-		vhdl << tab << "ready <= newDataSet;"<<endl;
+		disablePipelining();
+		for (int f=0; f<3; f++){
+			vhdl << tab << declare(flags[f]+"Register_next") << " <= (" << flags[f] << "Register and not newDataSet) or " << flags[f] << "In;" << endl;
+			addFeedbackRegister(flags[f]+"Register", flags[f]+"Register_next", laneName("summandIn",0));
+			vhdl << tab << ports[f] << " <= " << flags[f] << "Register_next;" << endl;
+		}
+		enablePipelining();
 	}
 
 
@@ -461,173 +480,208 @@ namespace flopoco{
 
 
 
-	//FIXME 	: IOs are defined as
-   // addFPInput ("X", wEX_,wFX_);
-	// addOutput  ("A", sizeAcc_);  
-	// addOutput  ("XOverflow");  
-	// addOutput  ("XUnderflow");  
-	// addOutput  ("AccOverflow");  
-	// In the following there is no check on the two last ones
-
-	void FPLargeAcc::fillTestCase(mpz_class a[])
+	string FPLargeAcc::laneName(string name, int k)
 	{
-		mpz_class& sX = a[0];
-		mpz_class& sA = a[1];
-		mpz_class& sXOverflow = a[2];
-	
-		currentIteration++;
-
-		//the last additionNumberOfChunks_-1 inputs must be 0 in order to propagate the carry bit in the accumulator
-		if (currentIteration  > numberOfTests - additionNumberOfChunks_ + 1)
-			sX = 0;
-
-		//convert this raw number into a FP number accornding to the flopoco FP format
-		FPNumber fpX(wEX_, wFX_);
-		fpX = sX;
-	
-		//for now, we do not accept inputs which overflow, negative inputs or inputs having the exception bits INF and NaN
-		while ((fpX.getExponentSignalValue()-(intpow2(wEX_-1)-1)>MaxMSBX_)
-				 //||(fpX.getSignSignalValue()==1) 
-				 || (fpX.getExceptionSignalValue()>1)){
-			sX = getLargeRandom(wEX_+wFX_+3);
-			fpX = sX;
-		}
-
-	
-		if ((fpX.getExceptionSignalValue()>1) || (fpX.getExponentSignalValue()-(intpow2(wEX_-1)-1)>MaxMSBX_))
-			xOvf = 1;
-	
-		sXOverflow = xOvf;
-	
-		if (UserInterface::verbose==1)
-			cout<<" i="         << currentIteration
-#ifdef  _WIN32	
-				 <<",a=" << mpz2string(AccValue_);
-#else
-		<<",a=" << AccValue_;
-#endif
+		if (lanes_ == 1)
+			return name;
+		return name + to_string(k);
+	}
 
-		if (fpX.getExceptionSignalValue()!=0)  {
-			if (fpX.getSignSignalValue()==0)
-				AccValue_ = AccValue_ + mapFP2Acc(fpX);
-			else
-				AccValue_ = AccValue_ - mapFP2Acc(fpX);
+	void FPLargeAcc::emulateAccumulation(TestCase* tc, bool newDataSet, vector<mpz_class> &exn, vector<mpz_class> &sign, vector<mpz_class> &exp, vector<mpz_class> &frac)
+	{
+		int nbOfChunks = chunkSize_.size();
+		mpz_class accMask = (mpz_class(1) << sizeAcc_) - 1;
+		if (accState_.empty()){
+			accState_   = vector<vector<mpz_class>>(lanes_, vector<mpz_class>(nbOfChunks, 0));
+			carryState_ = vector<vector<mpz_class>>(lanes_, vector<mpz_class>(nbOfChunks, 0));
 		}
-		if (UserInterface::verbose==1){
-			if (fpX.getExceptionSignalValue()!=0)
-#ifdef  _WIN32
-				cout<< (fpX.getSignSignalValue()==0?" + ":" - ")<< mpz2string(mapFP2Acc(fpX)) << " = "<<mpz2string(AccValue_)<<";"; 
-#else 
-			cout<< (fpX.getSignSignalValue()==0?" + ":" - ")<< mapFP2Acc(fpX) << " = "<<AccValue_<<";"; 
-#endif
 
-#ifdef  _WIN32
-			cout<< "Exc="<<mpz2string(fpX.getExceptionSignalValue())
-				 <<", S="<<mpz2string(fpX.getSignSignalValue())
-				 <<", Exp="<<mpz2string(fpX.getExponentSignalValue()-(intpow2(wEX_-1)-1))
-				 <<", Frac="<<mpz2string(fpX.getFractionSignalValue())<<endl;
+		bool xOverflow=false, xUnderflow=false, accOverflow=false;
+		for (int k=0; k<lanes_; k++){
+			// the input shifter
+			long shift = exp[k].get_si() - (expBias_+LSBA_);
+			bool normal = (exn[k] == 1);
+			bool overflow = (exn[k] >= 2) || (normal && shift > maxShift_);
+			bool underflow = normal && shift < 0;
+			bool valid = normal && !overflow && !underflow;
+			xOverflow  = xOverflow  || overflow;
+			xUnderflow = xUnderflow || underflow;
+			mpz_class summand = 0;
+			if (valid)
+				summand = (frac[k] << shift) >> fracLSBOffset_;
+			bool negate = valid && (sign[k] == 1);
+			// one's complement, the carry in of chunk 0 completes the two's complement
+			mpz_class summandExt = (negate ? summand ^ accMask : summand);
+
+			// the chunked accumulation
+			vector<mpz_class> nextAcc(nbOfChunks), carryOut(nbOfChunks);
+			for (int i=0; i<nbOfChunks; i++){
+				mpz_class chunkMask = (mpz_class(1) << chunkSize_[i]) - 1;
+				mpz_class a = (newDataSet ? mpz_class(0) : accState_[k][i]);
+				mpz_class cin;
+				if (i==0)
+					cin = (negate ? 1 : 0);
+				else
+					cin = (newDataSet ? mpz_class(0) : carryState_[k][i]);
+				mpz_class s = a + ((summandExt >> chunkLSB_[i]) & chunkMask) + cin;
+				nextAcc[i] = s & chunkMask;
+				carryOut[i] = s >> chunkSize_[i];
+			}
 
-#else
-			cout<< "Exc="<<fpX.getExceptionSignalValue()
-				 <<", S="<<fpX.getSignSignalValue()
-				 <<", Exp="<<fpX.getExponentSignalValue()-(intpow2(wEX_-1)-1)
-				 <<", Frac="<<fpX.getFractionSignalValue()<<endl;
-#endif				 
+			// overflow of the top chunk, which holds the sign
+			int top = nbOfChunks-1;
+			mpz_class aMSB = ((newDataSet ? mpz_class(0) : accState_[k][top]) >> (chunkSize_[top]-1)) & 1;
+			mpz_class sMSB = (summandExt >> (sizeAcc_-1)) & 1;
+			mpz_class rMSB = (nextAcc[top] >> (chunkSize_[top]-1)) & 1;
+			accOverflow = accOverflow || (aMSB == sMSB && rMSB != sMSB);
+
+			mpz_class A=0, C=0;
+			for (int i=0; i<nbOfChunks; i++){
+				A += nextAcc[i] << chunkLSB_[i];
+				if (i>0)
+					C += carryOut[i-1] << chunkLSB_[i];
+			}
+			tc->addExpectedOutput(laneName("A",k), A);
+			tc->addExpectedOutput(laneName("C",k), C);
+
+			// update the state
+			for (int i=0; i<nbOfChunks; i++){
+				accState_[k][i] = nextAcc[i];
+				if (i>0)
+					carryState_[k][i] = carryOut[i-1];
+			}
 		}
-	
-		//assign value to sA only at final iteration	
-		if (currentIteration==numberOfTests)
-			sA = sInt2C2(AccValue_, sizeAcc_);
-	
- 
-	}
-
-	mpz_class FPLargeAcc::mapFP2Acc(FPNumber X)
-	{
-		//get true exponent of X
-		mpz_class expX = X.getExponentSignalValue() - ( intpow2(wEX_-1)-1 ); 
-	
-		int keepBits = -LSBA_ + expX.get_si();
-		if (keepBits<0)
-			return 0;
-		else if (wFX_>keepBits)
-			return (X.getFractionSignalValue()/mpz_class(intpow2(wFX_-keepBits)));
-		else
-			return (X.getFractionSignalValue()*mpz_class(intpow2(keepBits-wFX_)));
-	}
 
-	mpz_class FPLargeAcc::sInt2C2(mpz_class X, int width)
-	{
-		if (X>=0)
-			return X;
-		else{
-			return (intpow2( width)+X);
-		}
+		xOverflowState_   = (xOverflowState_   && !newDataSet) || xOverflow;
+		xUnderflowState_  = (xUnderflowState_  && !newDataSet) || xUnderflow;
+		accOverflowState_ = (accOverflowState_ && !newDataSet) || accOverflow;
+		tc->addExpectedOutput("XOverflow",   mpz_class(xOverflowState_   ? 1 : 0));
+		tc->addExpectedOutput("XUnderflow",  mpz_class(xUnderflowState_  ? 1 : 0));
+		tc->addExpectedOutput("AccOverflow", mpz_class(accOverflowState_ ? 1 : 0));
 	}
 
 	void FPLargeAcc::emulate(TestCase* tc){
+		bool newDataSet = (tc->getInputValue("newDataSet") == 1);
+		vector<mpz_class> exn, sign, exp, frac;
+		for (int k=0; k<lanes_; k++){
+			if (forDotProd_){
+				exn.push_back(tc->getInputValue(laneName("excX_dprod",k)));
+				sign.push_back(tc->getInputValue(laneName("sigX_dprod",k)));
+				exp.push_back(tc->getInputValue(laneName("expX_dprod",k)));
+				frac.push_back(tc->getInputValue(laneName("fracX_dprod",k)));
+			}
+			else{
+				mpz_class x = tc->getInputValue(laneName("X",k));
+				exn.push_back(x >> (wEX_+wFX_+1));
+				sign.push_back((x >> (wEX_+wFX_)) & 1);
+				exp.push_back((x >> wFX_) & ((mpz_class(1) << wEX_) - 1));
+				frac.push_back((x & ((mpz_class(1) << wFX_) - 1)) + (mpz_class(1) << wFX_));
+			}
+		}
+		emulateAccumulation(tc, newDataSet, exn, sign, exp, frac);
 	}
 
 	TestCase* FPLargeAcc::buildRandomTestCase(int i){
-
-		TestCase *tc;
-		mpz_class x;
-
-		/* normal exception bits */
-		mpz_class normalExn = mpz_class(1)<<(wEX_+wFX_+1);
-
-		/*really random sign*/
-		mpz_class sign = mpz_class(getLargeRandom(1)%2)<<(wEX_+wFX_);
-
-		/* do exponent */
-		mpz_class exponent = getLargeRandom(wEX_);
-		while (! (MaxMSBX_ >= exponent - (intpow2(wEX_-1)-1))){
-			exponent = getLargeRandom(wEX_);
-		}
-		/* shift exponent in place */
-		exponent = exponent << (wFX_);
-
-		mpz_class frac = getLargeRandom(wFX_);		
-		
-		x = normalExn + sign + exponent + frac;
-
-		tc = new TestCase(this); 
-		tc->addInput("X", x);
-
-		if (i == 0){
-			tc->addInput("newDataSet", mpz_class(1));	
-		}else{
-			tc->addInput("newDataSet", mpz_class(0));	
+		TestCase *tc = new TestCase(this); 
+
+		/* a new data set at the first test, then from time to time */
+		tc->addInput("newDataSet", mpz_class((i==0 || getLargeRandom(6)==0) ? 1 : 0));
+
+		for (int k=0; k<lanes_; k++){
+			if (forDotProd_){
+				/* fully random products, the exponents are mostly out of range */
+				tc->addInput(laneName("excX_dprod",k), getLargeRandom(2));
+				tc->addInput(laneName("sigX_dprod",k), getLargeRandom(1));
+				tc->addInput(laneName("expX_dprod",k), getLargeRandom(wEX_+1));
+				tc->addInput(laneName("fracX_dprod",k), getLargeRandom(wFrac_));
+				continue;
+			}
+			int bias = (1<<(wEX_-1)) -1;
+			/* normal exception bits, with some zeroes */
+			mpz_class exn = (getLargeRandom(5)==0 ? 0 : 1);
+			/*really random sign*/
+			mpz_class sign = getLargeRandom(1);
+			/* exponents mostly in the range that reaches the accumulator, with some underflows and a few overflows */
+			int range = MaxMSBX_ - LSBA_ + wFX_ + 3;
+			int e = LSBA_ - wFX_ - 2 + mpz_class(getLargeRandom(20) % range).get_si();
+			if (getLargeRandom(8)==0)
+				e = MaxMSBX_+1;
+			mpz_class exponent = min(max(e+bias, 0), (1<<wEX_)-1);
+			mpz_class frac = getLargeRandom(wFX_);		
+			tc->addInput(laneName("X",k), (((((exn << 1) + sign) << wEX_) + exponent) << wFX_) + frac);
 		}
 
-
 		/* Get correct outputs */
 		emulate(tc);
 		return tc;
 	}
 	
 	OperatorPtr FPLargeAcc::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
-		int wEX, wFX, MaxMSBX, MSBA, LSBA;
+		int wEX, wFX, MaxMSBX, MSBA, LSBA, lanes;
 		UserInterface::parseStrictlyPositiveInt(args, "wEX", &wEX); 
 		UserInterface::parseStrictlyPositiveInt(args, "wFX", &wFX);
 		UserInterface::parseInt(args, "MaxMSBX", &MaxMSBX);
 		UserInterface::parseInt(args, "MSBA", &MSBA);
 		UserInterface::parseInt(args, "LSBA", &LSBA);
-		return new FPLargeAcc(target, wEX, wFX, MaxMSBX, MSBA, LSBA);
+		UserInterface::parseStrictlyPositiveInt(args, "lanes", &lanes);
+		return new FPLargeAcc(parentOp, target, wEX, wFX, MaxMSBX, MSBA, LSBA, lanes);
+	}
+
+	TestList FPLargeAcc::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+		
+		if(index==-1) 
+		{ // The unit tests
+			for(int lanes=1; lanes<=2; lanes++) {
+				for(int wF=10; wF<=23; wF+=13) {
+					int wE = (wF==10 ? 5 : 8);
+					paramList.push_back(make_pair("wEX",to_string(wE)));
+					paramList.push_back(make_pair("wFX",to_string(wF)));
+					paramList.push_back(make_pair("MaxMSBX",to_string(wE+2)));
+					paramList.push_back(make_pair("MSBA",to_string(wE+10)));
+					paramList.push_back(make_pair("LSBA",to_string(-wF)));
+					paramList.push_back(make_pair("lanes",to_string(lanes)));
+					testStateList.push_back(paramList);
+					paramList.clear();
+				}
+				// a wide accumulator at a high frequency, split in several chunks
+				paramList.push_back(make_pair("wEX","8"));
+				paramList.push_back(make_pair("wFX","23"));
+				paramList.push_back(make_pair("MaxMSBX","40"));
+				paramList.push_back(make_pair("MSBA","50"));
+				paramList.push_back(make_pair("LSBA","-60"));
+				paramList.push_back(make_pair("lanes",to_string(lanes)));
+				paramList.push_back(make_pair("frequency","600"));
+				testStateList.push_back(paramList);
+				paramList.clear();
+			}
+		}
+		else     
+		{
+				// finite number of random test computed out of index
+			// TODO
+		}	
+
+		return testStateList;
 	}
 
 	void FPLargeAcc::registerFactory(){
 		UserInterface::add("FPLargeAcc", // name
 											 "Accumulator of floating-point numbers into a large fixed-point accumulator.",
 											 "CompositeFloatingPoint",
-											 "LargeAccToFP", // seeAlso
+											 "LargeAccToFP,FPDotProduct", // seeAlso
 											 "wEX(int): the width of the exponent ; \
                         wFX(int): the width of the fractional part;  \
                         MaxMSBX(int): the maximum possible exponent of X; \
-                        MSBA(int): the weight of the least significand bit of the accumulator;\
-                        LSBA(int): the weight of the most significand bit of the accumulator",
-											 "Kulisch-like accumulator of floating-point numbers into a large fixed-point accumulator. By tuning the MaxMSB_in, LSB_acc and MSB_acc parameters to a given application, rounding error may be reduced to a provably arbitrarily low level, at a very small hardware cost compared to using a floating-point adder for accumulation. <br> For details on the technique used and an example of application, see <a href=\"bib/flopoco.html#DinechinPascaCret2008:FPT\">this article</a>",
-											 FPLargeAcc::parseArguments
+                        MSBA(int): the weight of the most significand bit of the accumulator;\
+                        LSBA(int): the weight of the least significand bit of the accumulator;\
+                        lanes(int)=1: the number of inputs accumulated per cycle, each in its own partial accumulator",
+											 "Kulisch-like accumulator of floating-point numbers into a large fixed-point accumulator. By tuning the MaxMSB_in, LSB_acc and MSB_acc parameters to a given application, rounding error may be reduced to a provably arbitrarily low level, at a very small hardware cost compared to using a floating-point adder for accumulation. <br> For details on the technique used and an example of application, see <a href=\"bib/flopoco.html#DinechinPascaCret2008:FPT\">this article</a>. <br> The accumulator is split in chunks, with the carries between chunks saved in registers, so that the accumulation runs at the target frequency: its value is the sum of the A and C outputs, which LargeAccToFP converts back to floating point. newDataSet=1 starts a new accumulation with the input of the same cycle. With several lanes, as many inputs are accumulated per cycle in as many partial accumulators, which LargeAccToFP merges.",
+											 FPLargeAcc::parseArguments,
+											 FPLargeAcc::unitTest
 											 ) ;
 		
 	}
@@ -4,83 +4,91 @@
 #include <mpfr.h>
 #include <gmpxx.h>
 #include "Operator.hpp"
-#include "ShiftersEtc/Shifters.hpp"
 #include "TestBenches/FPNumber.hpp"
 #include "utils.hpp"
 
 namespace flopoco{
 
-	/** Implements a long, fixed point accumulator for accumulating floating point numbers
+	/** Implements a long, fixed point accumulator for accumulating floating point numbers.
+	 * The accumulator is split in chunks that each fit in one cycle at the target frequency,
+	 * with the carries between chunks saved in registers: its value is the sum of the A and C outputs,
+	 * to be converted back to floating point by LargeAccToFP.
+	 * With several lanes, as many numbers are accumulated per cycle in as many partial accumulators,
+	 * and LargeAccToFP merges them.
 	 */
 	class FPLargeAcc : public Operator
 	{
 	public:
 		/** Constructor
 		 * @param target the target device
-		 * @param wEX the width of the exponent 
-		 * @param eFX the width of the fractional part
+		 * @param wEX the width of the exponent
+		 * @param wFX the width of the fractional part
 		 * @param MaxMSBX the weight of the MSB of the expected exponent of X
-		 * @param LSBA the weight of the least significand bit of the accumulator
 		 * @param MSBA the weight of the most significand bit of the accumulator
-		 */ 
-		FPLargeAcc(Target* target, int wEX, int wFX, int MaxMSBX, int MSBA, int LSBA, map<string, double> inputDelays = emptyDelayMap, bool forDotProd = false, int wFY = -1);
-	
+		 * @param LSBA the weight of the least significand bit of the accumulator
+		 * @param lanes the number of inputs accumulated per cycle, each in its own partial accumulator
+		 * @param forDotProd if true, the inputs are the unrounded products of FPDotProduct, with separate fields
+		 * @param wFY the width of the fractional part of the second factor of these products
+		 */
+		FPLargeAcc(OperatorPtr parentOp, Target* target, int wEX, int wFX, int MaxMSBX, int MSBA, int LSBA, int lanes=1, bool forDotProd = false, int wFY = -1);
+
 		/** Destructor */
 		~FPLargeAcc();
-	
+
 		void test_precision(int n); /**< Undocumented */
 		void test_precision2(); /**< Undocumented */
-	
-		/**
-		 * Gets the correct value associated to one or more inputs.
-		 * @param a the array which contains both already filled inputs and
-		 *          to be filled outputs in the order specified in getTestIOMap.
-		 */
-		void fillTestCase(mpz_class a[]);
 
 		void emulate(TestCase* tc);
 
 		TestCase* buildRandomTestCase(int i);
 
+		/**
+		 * One cycle of the accumulation, bit-accurate with respect to the chunked accumulators:
+		 * updates the state of the accumulators, and adds the expected A, C and flag outputs to tc.
+		 * The inputs of each lane are given as they enter the input shifters:
+		 * exception, sign, exponent (biased twice for a dot product) and fraction with its implicit 1.
+		 * Used by emulate() and by FPDotProduct::emulate().
+		 */
+		void emulateAccumulation(TestCase* tc, bool newDataSet, vector<mpz_class> &exn, vector<mpz_class> &sign, vector<mpz_class> &exp, vector<mpz_class> &frac);
+
+		/** The name of a port or signal of lane k: name itself if there is only one lane */
+		string laneName(string name, int k);
 
-		mpz_class mapFP2Acc(FPNumber X);
-	
-		mpz_class sInt2C2(mpz_class X, int width);
-		
 		/** Factory method that parses arguments and calls the constructor */
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
 
-		/** Factory register method */ 
+		/** Factory register method */
 		static void registerFactory();
 
+		/** Unit tests */
+		static TestList unitTest(int index);
+
 	protected:
 		int wEX_;     /**< the width of the exponent  */
 		int wFX_;     /**< the width of the fractional part */
 		int MaxMSBX_; /**< the weight of the MSB of the expected exponent of X */
 		int LSBA_;    /**< the weight of the least significand bit of the accumulator */
 		int MSBA_;    /**< the weight of the most significand bit of the accumulator */
-
-		mpz_class AccValue_;
-		int currentIteration;
-		int xOvf;	
+		int lanes_;   /**< the number of partial accumulators */
+		bool forDotProd_; /**< if true, the inputs are the products of FPDotProduct */
+		int wFY_;     /**< the width of the fractional part of the second factor of these products */
 
 	private:
-		Shifter* shifter_;          /**<Shifter object for shifting X in place */
-		int      sizeAcc_;          /**<The size of the accumulator  = MSBA-LSBA+1; */
-		int      sizeAccL_;         /**< used only for carry-select implementation */
+		int      sizeAcc_;          /**< The size of the accumulator  = MSBA-LSBA+1; */
 		int      sizeSummand_;      /**< the maximum size of the summand  = MaxMSBX-LSBA+1; */
-		int      sizeShiftedFrac_;  /**< size of ths shifted frac  = sizeSummand + wFX;  to accomodate very small summands */
+		int      wFrac_;            /**< the width of the fraction that enters the shifter, implicit 1 included */
+		int      fracLSBOffset_;    /**< the number of fraction bits after the point, i.e. right of the implicit 1 */
 		int      maxShift_;         /**< maximum shift ammount */
-		int      E0X_;              /**< the bias value */
-		int      sizeShift_;        /**< the shift size */
-		string   summand2cname_;    /**< ??? */
-		int      c2ChunkSize_;      /**< for c2 addition */
-		int      c2PipelineDepth_;  /**< for c2 addition */
-
-		int additionNumberOfChunks_;         /**< Number of chunks of the accumulation addition */
-		int rebalancedAdditionChunkSize_;    /**< The chunk size after rebalancing */
-		int rebalancedAdditionLastChunkSize_;/**< The size of the last chunk after rebalancing */ 
+		int      expBias_;          /**< the bias of the input exponent (twice the FP bias for a dot product) */
+		vector<int> chunkLSB_;      /**< the position of the LSB of each chunk of the accumulator */
+		vector<int> chunkSize_;     /**< the size of each chunk of the accumulator */
 
+		/* The state of the emulation */
+		vector<vector<mpz_class>> accState_;   /**< for each lane, the value of each chunk */
+		vector<vector<mpz_class>> carryState_; /**< for each lane, the carry saved into each chunk (the one into chunk 0 is unused) */
+		bool xOverflowState_;
+		bool xUnderflowState_;
+		bool accOverflowState_;
 	};
 
 }
@@ -28,166 +28,125 @@
 #include "utils.hpp"
 #include "Operator.hpp"
 #include "LargeAccToFP.hpp"
-#include "ShiftersEtc/Shifters.hpp"
 
 using namespace std;
 
 namespace flopoco{
 
-	LargeAccToFP::LargeAccToFP(Target* target, int MSBA, int LSBA, int wEOut, int wFOut):
-		Operator(target),
-		LSBA_(LSBA), MSBA_(MSBA), wEOut_(wEOut), wFOut_(wFOut)
+	LargeAccToFP::LargeAccToFP(OperatorPtr parentOp, Target* target, int MSBA, int LSBA, int wEOut, int wFOut, int lanes):
+		Operator(parentOp, target),
+		LSBA_(LSBA), MSBA_(MSBA), wEOut_(wEOut), wFOut_(wFOut), lanes_(lanes)
 	{
 		srcFileName = "LargeAccToFP";
-		ownTarget_ = target;
 		ostringstream name;
-		setCopyrightString("Florent de Dinechin, Bogdan Pasca (2008-2014)");
+		setCopyrightString("Florent de Dinechin, Bogdan Pasca (2008-2023)");
 		name <<"LargeAccToFP_"
 			  <<(MSBA_>=0?"":"M")<<abs(MSBA_)<<"_"
 			  <<(LSBA_>=0?"":"M")<<abs(LSBA_)<<"_"
 			  <<wEOut_<<"_"<<wFOut_;
+		if (lanes_ > 1)
+			name << "_x" << lanes_;
 		setNameWithFreqAndUID(name.str());
 
 		sizeAcc_ = MSBA - LSBA + 1;
+		expBias_ = (1<<(wEOut-1)) - 1;
+		if (lanes_ < 1)
+			THROWERROR("the number of lanes should be at least 1");
+		if (sizeAcc_ < 3)
+			THROWERROR("the accumulator should have at least 3 bits, MSBA=" << MSBA << " and LSBA=" << LSBA << " are too close");
 
 		//inputs and outputs
-		addInput    ("A", sizeAcc_);
-		addInput    ("C", sizeAcc_);
+		for (int k=0; k<lanes_; k++){
+			addInput    (laneName("A",k), sizeAcc_);
+			addInput    (laneName("C",k), sizeAcc_);
+		}
 		addInput("AccOverflow");
 		addFPOutput ("R", wEOut_, wFOut_);
 
-		vhdl << tab <<declare("signA") << " <= A" << of(sizeAcc_-1)<<";"<<endl;
-		vhdl << tab <<declare("signC") << " <= C" << of(sizeAcc_-1)<<";"<<endl;
-
-		vhdl << tab <<declare("AccOverflowFlag") << " <= AccOverflow;"<<endl;
-
-		vhdl << tab << declare("extA", sizeAcc_+1) << " <= signA & A;"<<endl;
-		vhdl << tab << declare("extC", sizeAcc_+1) << " <= signC & C;"<<endl;
-
-		IntAdder *a = new IntAdder(this, target, sizeAcc_+1);
-
-		inPortMap( a,   "X",   "extA");
-		inPortMap( a,   "Y",   "extC");
-		inPortMapCst(a, "Cin", "'0'");
-		outPortMap( a,  "R",   "acc");
-		vhdl << instance(a,    "CarryPropagation");
-
-		syncCycleFromSignal("acc");
-		setCriticalPath( a->getOutputDelay("R"));
-		setSignalDelay( "acc", getCriticalPath());
-
-		vhdl << tab << declare("resSign") << " <= acc" << of(sizeAcc_) << ";" << endl;
-
-		/* count the number of zeros/ones in order to determine
-		the value of the exponent */
-
-		lzocShifterSticky_ = new LZOCShifterSticky(this, target, sizeAcc_+1,  wFOut_ + 1, intlog2(sizeAcc_+1), false, -1) ;
-		countWidth_ = lzocShifterSticky_->getCountWidth();
-
-		inPortMapCst ( lzocShifterSticky_, "I"    , "acc");
-		inPortMap    ( lzocShifterSticky_, "OZb"  , "resSign");
-		outPortMap   ( lzocShifterSticky_, "Count", "nZO");
-		outPortMap   ( lzocShifterSticky_, "O"    , "resFrac");
-		vhdl << tab << instance(lzocShifterSticky_, "InputLZOCShifter");
-
-		syncCycleFromSignal("resFrac");
-		setCriticalPath( lzocShifterSticky_->getOutputDelay("O") );
-		setSignalDelay("resFrac",getCriticalPath());
-
-		manageCriticalPath(getTarget()->localWireDelay() + getTarget()->adderDelay(countWidth_+1));
-		vhdl << tab <<declare("unbiasedExp", countWidth_+1) << " <= CONV_STD_LOGIC_VECTOR("<<MSBA_+1<<","<<countWidth_+1<<") - (\"0\" & nZO);"<<endl;
-		expBias_ =  intpow2(wEOut-1) - 1;
-		if (countWidth_+1 < wEOut_){
-			/* accumulator does not cover all exponent range */
-			manageCriticalPath(getTarget()->localWireDelay() + getTarget()->adderDelay(wEOut_));
-			vhdl << tab << declare("bias"     , wEOut_) << " <= CONV_STD_LOGIC_VECTOR("<<expBias_<<","<<wEOut_<<");"<<endl; //fixed value
-			vhdl << tab << declare("expBiased", wEOut_) << " <= bias + ("<< rangeAssign(wEOut_-1,countWidth_+1, "unbiasedExp"+of(countWidth_))<<" & unbiasedExp);"<<endl;
-			vhdl << tab << declare("excBits"  , 2)      << " <=\"01\";"<<endl;
-		} else if (countWidth_+1 == wEOut_){
-			manageCriticalPath(getTarget()->localWireDelay() + getTarget()->adderDelay(wEOut_));
-			vhdl << tab << declare("bias"     ,wEOut_) << " <= CONV_STD_LOGIC_VECTOR("<<expBias_<<","<<wEOut_<<");"<<endl; //fixed value
-			vhdl << tab << declare("expBiased",wEOut_) << " <= bias + unbiasedExp;"<<endl;
-			vhdl << tab << declare("excBits"  ,2)      << " <=\"01\";"<<endl;
-		}else{
-			/* acc covers more range than destination output format */
-			manageCriticalPath(getTarget()->localWireDelay() + getTarget()->adderDelay(countWidth_+1));
-			vhdl << tab << declare("bias"   , countWidth_+1) << " <= CONV_STD_LOGIC_VECTOR("<<expBias_<<","<<countWidth_+1<<");"<<endl;
-			vhdl << tab << declare("expExt" , countWidth_+1) << " <= bias + unbiasedExp;"<<endl;
-			vhdl << tab << declare("signExpExt") << " <= expExt" << of(countWidth_)<<";"<<endl;
-
-			if (countWidth_==wEOut_)
-				vhdl << tab <<declare("expOverflow") <<" <= '0';"<<endl;
-			else
-				vhdl << tab <<declare("expOverflow") <<" <= '1' when ( expExt"<<range(countWidth_-1,wEOut_)<<">"<<zg(countWidth_-wEOut_)<<" and signExpExt='0') else '0';"<<endl;
-			vhdl << tab <<declare("expUnderflow")<<" <= signExpExt;"<<endl;
-
-			declare("excBits",2);
-			vhdl << tab <<"excBits(1) <= expOverflow or expUnderflow or AccOverflow;"<<endl;
-			vhdl << tab <<"excBits(0) <= not(expOverflow) and not(expUnderflow) and not AccOverflow;"<<endl;
-			vhdl << tab <<declare("expBiased",wEOut_) << " <= expExt" << range(wEOut_-1,0)<<";"<<endl;
-		}
-
-		vhdl << tab <<declare("excRes",2) << " <= excBits;"<<endl;
-		setSignalDelay("excRes", getCriticalPath());
-
-		//get back to the fraction part
-		setCycleFromSignal("resFrac");
-		setCriticalPath( getSignalDelay("resFrac"));
-
-		manageCriticalPath( getTarget()->localWireDelay() + getTarget()->lutDelay());
-		vhdl << tab << declare("notResFrac",wFOut_+1) << " <= resFrac xor "<<rangeAssign(wFOut_,0,"resSign")<<";"<<endl;
-
-		//convert fraction in sign-magnitude
-		IntAdder *smFracAdder = new IntAdder(this, target,wFOut_ + 1 );
-
-		inPortMap   (smFracAdder, "X",   "notResFrac");
-		inPortMapCst(smFracAdder, "Y",   zg(wFOut+1,0));
-		inPortMap   (smFracAdder, "Cin", "resSign");
-		outPortMap  (smFracAdder, "R",   "resultFraction");
-
-		vhdl << tab << instance(smFracAdder, "SignMagnitudeFracAdder");
-
-		syncCycleFromSignal("resultFraction");
-		setCriticalPath( smFracAdder->getOutputDelay("R"));
-		syncCycleFromSignal("excRes",  getSignalDelay("excRes"));
-
-		vhdl << tab << "R <= excRes & resSign & expBiased" << range(wEOut_-1,0)<<" & resultFraction" << range(wFOut_-1,0) <<";"<<endl;
+		/* the value of the accumulator is the sum of all the A and C inputs, modulo 2^sizeAcc */
+		ostringstream inMap;
+		for (int k=0; k<lanes_; k++)
+			inMap << (k>0 ? "," : "") << "X" << 2*k << "=>" << laneName("A",k) << ",X" << 2*k+1 << "=>" << laneName("C",k);
+		newInstance("IntMultiAdder",
+								"CarryPropagation",
+								"wIn=" + to_string(sizeAcc_) + " n=" + to_string(2*lanes_) + " signedIn=0 wOut=" + to_string(sizeAcc_),
+								inMap.str(),
+								"R=>acc");
+
+		vhdl << tab << declare("resSign") << " <= acc" << of(sizeAcc_-1) << ";" << endl;
+		vhdl << tab << declare(getTarget()->eqConstComparatorDelay(sizeAcc_), "accIsZero") << " <= '1' when acc=" << zg(sizeAcc_) << " else '0';" << endl;
+
+		//convert the accumulator in sign-magnitude
+		vhdl << tab << declare(getTarget()->logicDelay(2), "notAcc", sizeAcc_) << " <= acc xor " << rangeAssign(sizeAcc_-1, 0, "resSign") << ";" << endl;
+		newInstance("IntAdder",
+								"SignMagnitudeAdder",
+								"wIn=" + to_string(sizeAcc_),
+								"X=>notAcc,Cin=>resSign",
+								"R=>absAcc",
+								"Y=>" + zg(sizeAcc_,0));
+
+		/* count the number of zeros in order to determine
+		the value of the exponent. The fraction is truncated, which is a faithful rounding */
+		int wNorm = max(sizeAcc_, wFOut_+1);
+		vhdl << tab << declare("normIn", wNorm) << " <= absAcc" << (wNorm > sizeAcc_ ? " & " + zg(wNorm-sizeAcc_) : "") << ";" << endl;
+		newInstance("Normalizer",
+								"LZCShifter",
+								"wX=" + to_string(wNorm) + " wR=" + to_string(wFOut_+1) + " maxShift=" + to_string(sizeAcc_-1) + " countType=0",
+								"X=>normIn",
+								"R=>resFrac, Count=>nZ");
+		int countWidth = getSignalByName("nZ")->width();
+
+		/* the exponent of the MSB of the accumulator is MSBA, the result exponent is MSBA-nZ,
+		 computed on enough bits to detect overflow and underflow of the output exponent */
+		int wExpExt = max(max(wEOut_, countWidth), intlog2(abs(MSBA_+expBias_))) + 2;
+		vhdl << tab << declare(getTarget()->adderDelay(wExpExt), "expExt", wExpExt) << " <= CONV_STD_LOGIC_VECTOR(" << MSBA_+expBias_ << "," << wExpExt << ")"
+				 << " - (" << zg(wExpExt-countWidth) << " & nZ);" << endl;
+		vhdl << tab << declare("expUnderflow") << " <= expExt" << of(wExpExt-1) << ";" << endl;
+		vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wExpExt-wEOut_), "expOverflow") << " <= '1' when expUnderflow='0' and expExt" << range(wExpExt-2, wEOut_)
+				 << "/=" << zg(wExpExt-1-wEOut_) << " else '0';" << endl;
+
+		vhdl << tab << declare(getTarget()->logicDelay(4), "excRes", 2) << " <= \"11\" when AccOverflow='1'" << endl
+				 << tab << tab << "else \"00\" when (accIsZero='1' or expUnderflow='1')" << endl
+				 << tab << tab << "else \"10\" when expOverflow='1'" << endl
+				 << tab << tab << "else \"01\";" << endl;
+		vhdl << tab << declare(getTarget()->lutDelay(), "expRes", wEOut_) << " <= expExt" << range(wEOut_-1, 0) << " when excRes=\"01\" else " << zg(wEOut_) << ";" << endl;
+		vhdl << tab << declare(getTarget()->lutDelay(), "fracRes", wFOut_) << " <= resFrac" << range(wFOut_-1, 0) << " when excRes=\"01\" else " << zg(wFOut_) << ";" << endl;
+
+		vhdl << tab << "R <= excRes & (resSign and not AccOverflow) & expRes & fracRes;" << endl;
 	}
 
 	LargeAccToFP::~LargeAccToFP() {
 	}
 
+	string LargeAccToFP::laneName(string name, int k)
+	{
+		if (lanes_ == 1)
+			return name;
+		return name + to_string(k);
+	}
+
 	void LargeAccToFP::emulate(TestCase *tc)
 	{
 		/* Get I/O values */
-		mpz_class svA           = tc->getInputValue("A");
 		mpz_class svAccOverflow = tc->getInputValue("AccOverflow");
-		mpz_class svC           = tc->getInputValue("C");
-
-
-		mpz_class newAcc;
-		newAcc = svA + svC;
-
-		mpz_class tmpSUB = (mpz_class(1) << (MSBA_ - LSBA_+1))    ;
-		mpz_class tmpCMP = (mpz_class(1) << (MSBA_ - LSBA_  )) - 1;
+		mpz_class newAcc = 0;
+		for (int k=0; k<lanes_; k++)
+			newAcc += tc->getInputValue(laneName("A",k)) + tc->getInputValue(laneName("C",k));
+
+		if (svAccOverflow == 1){
+			// a NaN with positive sign and null fields
+			tc->addExpectedOutput("R", mpz_class(3) << (wEOut_+wFOut_+1));
+			return;
+		}
 
-		if (newAcc > tmpCMP)
-			newAcc = newAcc - tmpSUB;
+		newAcc = newAcc & ((mpz_class(1) << sizeAcc_) - 1);
+		if (newAcc >> (sizeAcc_-1) == 1)
+			newAcc -= (mpz_class(1) << sizeAcc_);
 
 		mpfr_t x;
-		mpfr_init2(x, 10000); //init to infinite prec
+		mpfr_init2(x, sizeAcc_+1); // exact
 		mpfr_set_z(x, newAcc.get_mpz_t(), GMP_RNDN);
-
-		mpfr_t cst, tmp2;
-		mpfr_init2(cst, 10000); //init to infinite prec
-		mpfr_init2(tmp2, 10000); //init to infinite prec
-
-
-		mpfr_set_ui(cst, 2 , GMP_RNDN);
-		mpfr_set_si(tmp2, LSBA_ , GMP_RNDN);
-		mpfr_pow(cst, cst, tmp2, GMP_RNDN);
-
-		mpfr_mul(x, x, cst, GMP_RNDN);
+		mpfr_mul_2si(x, x, LSBA_, GMP_RNDN);
 
 		mpfr_t myFP;
 		mpfr_init2(myFP, wFOut_+1);
@@ -202,48 +161,52 @@ namespace flopoco{
 		mpz_class svR2 = fpr2.getSignalValue();
 		tc->addExpectedOutput("R", svR2);
 
-
-
 		// clean-up
 		mpfr_clears(x, myFP, NULL);
 	}
 
 	void LargeAccToFP::buildStandardTestCases(TestCaseList* tcl){
-	}
-
-	TestCase* LargeAccToFP::buildRandomTestCase(int i){
-
 		TestCase *tc;
-		mpz_class A,C;
-
-		C=mpz_class(0);
-		int chunkSize, k;
-
-		getTarget()->suggestSubaddSize(chunkSize, MSBA_-LSBA_+1);
-		if (chunkSize >= MSBA_-LSBA_+1)
-			k=1;
-		else
-			k= int(ceil( double(MSBA_-LSBA_+1)/double(chunkSize)));
-
-
-		C= mpz_class(0);
-		tc = new TestCase(this);
-
-		A = getLargeRandom(MSBA_-LSBA_+1);
-
-		tc->addInput("A", A);
-
-		if (k==1)
-			tc->addInput("C", mpz_class(0));
-		else{
-			for (int j=0;j<k-1;j++){
-				C = C + (  getLargeRandom(1)<< (chunkSize*(j+1)) );
-				tc->addInput("C", C);
+		mpz_class one = 1;
+		// zero, the smallest positive and negative values, the most negative and the largest positive values
+		mpz_class values[5] = {0, one, (one << sizeAcc_) - 1, one << (sizeAcc_-1), (one << (sizeAcc_-1)) - 1};
+		for (int v=0; v<5; v++){
+			tc = new TestCase(this);
+			for (int k=0; k<lanes_; k++){
+				tc->addInput(laneName("A",k), (k==0 ? values[v] : mpz_class(0)));
+				tc->addInput(laneName("C",k), mpz_class(0));
 			}
+			tc->addInput("AccOverflow", mpz_class(0));
+			emulate(tc);
+			tcl->add(tc);
+		}
+		// an overflowed accumulation
+		tc = new TestCase(this);
+		for (int k=0; k<lanes_; k++){
+			tc->addInput(laneName("A",k), one);
+			tc->addInput(laneName("C",k), mpz_class(0));
+		}
+		tc->addInput("AccOverflow", mpz_class(1));
+		emulate(tc);
+		tcl->add(tc);
+	}
 
+	TestCase* LargeAccToFP::buildRandomTestCase(int i){
 
+		TestCase *tc = new TestCase(this);
+		mpz_class mask = (mpz_class(1) << sizeAcc_) - 1;
+
+		for (int k=0; k<lanes_; k++){
+			/* values of all the magnitudes, of both signs */
+			int w = 1 + mpz_class(getLargeRandom(20) % sizeAcc_).get_si();
+			mpz_class A = getLargeRandom(w);
+			if (getLargeRandom(1) == 1)
+				A = (mask + 1 - A) & mask;
+			tc->addInput(laneName("A",k), A);
+			/* the carries of FPLargeAcc are sparse, but any C is correct */
+			tc->addInput(laneName("C",k), (getLargeRandom(2) == 0 ? getLargeRandom(sizeAcc_) : mpz_class(0)));
 		}
-		tc->addInput("AccOverflow",mpz_class(0));
+		tc->addInput("AccOverflow", mpz_class(getLargeRandom(6) == 0 ? 1 : 0));
 
 		/* Get correct outputs */
 		emulate(tc);
@@ -251,25 +214,58 @@ namespace flopoco{
 	}
 
 	OperatorPtr LargeAccToFP::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
-		int MSBA, LSBA, wE_out, wF_out;
+		int MSBA, LSBA, wE_out, wF_out, lanes;
 		UserInterface::parseStrictlyPositiveInt(args, "wE_out", &wE_out); 
 		UserInterface::parseStrictlyPositiveInt(args, "wF_out", &wF_out);
 		UserInterface::parseInt(args, "MSBA", &MSBA);
 		UserInterface::parseInt(args, "LSBA", &LSBA);
-		return new LargeAccToFP(target, MSBA, LSBA, wE_out, wF_out);
+		UserInterface::parseStrictlyPositiveInt(args, "lanes", &lanes);
+		return new LargeAccToFP(parentOp, target, MSBA, LSBA, wE_out, wF_out, lanes);
+	}
+
+	TestList LargeAccToFP::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+		
+		if(index==-1) 
+		{ // The unit tests
+			for(int lanes=1; lanes<=2; lanes++) {
+				for(int wF=10; wF<=23; wF+=13) {
+					int wE = (wF==10 ? 5 : 8);
+					paramList.push_back(make_pair("wE_out",to_string(wE)));
+					paramList.push_back(make_pair("wF_out",to_string(wF)));
+					paramList.push_back(make_pair("MSBA",to_string(wE+10)));
+					paramList.push_back(make_pair("LSBA",to_string(-wF)));
+					paramList.push_back(make_pair("lanes",to_string(lanes)));
+					testStateList.push_back(paramList);
+					paramList.clear();
+				}
+			}
+		}
+		else     
+		{
+				// finite number of random test computed out of index
+			// TODO
+		}	
+
+		return testStateList;
 	}
 
 	void LargeAccToFP::registerFactory(){
 		UserInterface::add("LargeAccToFP", // name
 											 "Post-normalisation unit for FPLargeAcc.",
 											 "CompositeFloatingPoint",
-											 "FPLArgeAcc", // seeAlso
+											 "FPLargeAcc,FPDotProduct", // seeAlso
 											 "wE_out(int): the width of the output exponent ; \
                         wF_out(int): the width of the output fractional part;  \
                         MSBA(int): the weight of the most significand bit of the accumulator; \
-                        LSBA(int): the weight of the least significand bit of the accumulator",
-											 "Converts the (fixed-point) output of FPLargeAcc or FPDotProduct (with the same parameters) into a floating-point number.  <br> For details on the technique used and an example of application, see <a href=\"bib/flopoco.html#DinechinPascaCret2008:FPT\">this article</a>",
-											 LargeAccToFP::parseArguments
+                        LSBA(int): the weight of the least significand bit of the accumulator;\
+                        lanes(int)=1: the number of partial accumulators to merge",
+											 "Converts the (fixed-point) output of FPLargeAcc or FPDotProduct (with the same parameters) into a floating-point number, with faithful rounding.  With several lanes, the partial accumulators are first merged modulo 2^(MSBA-LSBA+1): the total must fit in the accumulator, as each partial accumulation does. <br> For details on the technique used and an example of application, see <a href=\"bib/flopoco.html#DinechinPascaCret2008:FPT\">this article</a>",
+											 LargeAccToFP::parseArguments,
+											 LargeAccToFP::unitTest
 											 ) ;
 		
 	}
@@ -4,13 +4,12 @@
 #include <mpfr.h>
 #include <gmpxx.h>
 #include "Operator.hpp"
-#include "ShiftersEtc/LZOCShifterSticky.hpp"
-#include "IntAddSubCmp/IntAdder.hpp"
 
 
 namespace flopoco{
 
-	/** Operator which converts the output of the long accumulator to the desired FP format
+	/** Operator which converts the output of the long accumulator to the desired FP format.
+	 * With several lanes, the partial accumulators of FPLargeAcc are merged first.
 	 */
 	class LargeAccToFP : public Operator
 	{
@@ -18,13 +17,13 @@ namespace flopoco{
 
 		/** Constructor
 		 * @param target the target device
-		 * @param MaxMSBX the weight of the MSB of the expected exponent of X
-		 * @param LSBA the weight of the least significand bit of the accumulator
 		 * @param MSBA the weight of the most significand bit of the accumulator
+		 * @param LSBA the weight of the least significand bit of the accumulator
 		 * @param wEOut the width of the output exponent 
-		 * @param eFOut the width of the output fractional part
+		 * @param wFOut the width of the output fractional part
+		 * @param lanes the number of partial accumulators to merge
 		 */ 
-		LargeAccToFP(Target* target, int MSBA, int LSBA, int wEOut, int wFOut);
+		LargeAccToFP(OperatorPtr parentOp, Target* target, int MSBA, int LSBA, int wEOut, int wFOut, int lanes=1);
 
 		/** Destructor */
 		~LargeAccToFP();
@@ -41,21 +40,22 @@ namespace flopoco{
 		/** Factory register method */ 
 		static void registerFactory();
 
+		/** Unit tests */
+		static TestList unitTest(int index);
 
 	protected:
 		int LSBA_;    /**< the weight of the least significand bit of the accumulator */
 		int MSBA_;    /**< the weight of the most significand bit of the accumulator */
 		int wEOut_;   /**< the width of the output exponent */
 		int wFOut_;   /**< the width of the output fractional part */
+		int lanes_;   /**< the number of partial accumulators */
 
 	private:
-		Target* ownTarget_;
-		IntAdder* adder_;
-		LZOCShifterSticky* lzocShifterSticky_;   
 		int      sizeAcc_;       /**< The size of the accumulator  = MSBA-LSBA+1; */
 		int      expBias_;       /**< the exponent bias value */
-		int      countWidth_;    /**< the number of bits that the leading zero/one conunter outputs the result on */
 
+		/** The name of an input of lane k: name itself if there is only one lane */
+		string laneName(string name, int k);
 	};
 }
 #endif
@@ -151,8 +151,8 @@ namespace flopoco{
 	
 
 	
-	FPDiv::FPDiv(OperatorPtr parentOp, Target* target, int wE, int wF, int srt) :
-		Operator(parentOp, target), wE(wE), wF(wF) {
+	FPDiv::FPDiv(OperatorPtr parentOp, Target* target, int wE, int wF, int srt, int ii) :
+		Operator(parentOp, target), wE(wE), wF(wF), ii(ii) {
 
 		int i;
 		ostringstream name;
@@ -165,6 +165,13 @@ namespace flopoco{
 		if(srt!=42 && srt!=43 && srt!=87){
 		THROWERROR("Invalid value for srt: " << srt  );
 		}
+		if(ii<1){
+			THROWERROR("Invalid initiation interval: " << ii);
+		}
+		if(ii>1) {
+			name << "_II" << ii;
+			setNameWithFreqAndUID(name.str());
+		}
 
 		if(srt==42) {
 			radix=4;
@@ -183,7 +190,11 @@ namespace flopoco{
 		addFPInput ("X", wE, wF);
 		addFPInput ("Y", wE, wF);
 		addFPOutput("R", wE, wF);
-			
+
+		itersPerCycle=0;
+		if(ii>1)
+			addInputCounter("load0", "X", ii);
+
 
 		vhdl << tab << declare("fX",wF+1) << " <= \"1\" & X(" << wF-1 << " downto 0);" << endl;
 		vhdl << tab << declare("fY",wF+1) << " <= \"1\" & Y(" << wF-1 << " downto 0);" << endl;
@@ -223,6 +234,11 @@ namespace flopoco{
 			extraBit+=3; //floor() and the bits cut to get a result depending on wF instead of nDigit (cf. last step before normalization)
 
 			nDigit = floor(((double)(wF + extraBit))/3);
+			if(ii>1) {
+				// round the number of iterations up to a multiple of ii: the extra digits only make the truncated quotient more accurate
+				itersPerCycle = (nDigit-2)/ii + 1;
+				nDigit = itersPerCycle*ii + 1;
+			}
 
 			/////////////////////////////////////////////////////////////////////////Prescaling
 			//TODO : maybe we can reduce fX and fY
@@ -240,27 +256,36 @@ namespace flopoco{
 					 << tab << tab << tab << "(\"000\" & fX) + (\"0\" & fX & \"00\") when \"01\","<<endl  ////////////////[5/8, 3/4[*5/4 => [25/32, 15/16[
 			     << tab << tab << tab << "\"0\" & fX &\"00\" when others;"<<endl; /////////no prescaling
 
-			vhdl << tab << declare(join("w", nDigit-1), wF+6) << " <=  \"00\" & prescaledfX;" << endl; //TODO : review that, maybe MSB 0 to save
+			// In the folded architecture, the iterations of one cycle work on the loop state, with their own signal names
+			string pfx = (ii>1 ? "loop_" : "");
+			string fY = (ii>1 ? "Dcur" : "prescaledfY");
+			int firstIter = (ii>1 ? itersPerCycle : nDigit-1);
+			if(ii>1) {
+				double iterationDelay = getTarget()->logicDelay(nbBitsD+nbBitsW) + getTarget()->lutDelay()
+					+ 2*getTarget()->adderDelay(wF+7) + getTarget()->fanoutDelay(2*(wF+7));
+				buildFoldedLoopEntry("prescaledfY", wF+3, "\"00\" & prescaledfX", wF+6, "Wreg", iterationDelay);
+			}
+			vhdl << tab << declare(pfx+join("w", firstIter), wF+6) << " <=  " << (ii>1 ? "Wcur" : "\"00\" & prescaledfX") << ";" << endl; //TODO : review that, maybe MSB 0 to save
 
 			vector<mpz_class> tableContent = selFunctionTable(0.75, 1.0, nbBitsD, nbBitsW, alpha, radix);
 			Table* selfunctiontable = new Table(this, target, tableContent,"selFunction7_4", nbBitsD+nbBitsW, 4);
 
-			for(i=nDigit-1; i>=1; i--) {
+			for(i=firstIter; i>=1; i--) {
 
 				REPORT(DEBUG, "Entering iteration " << i);
 				// TODO: get rid of all the ostringstream on the model of qi
-				string qi =join("q", i);						//actual quotient digit, LUT's output
+				string qi =pfx+join("q", i);						//actual quotient digit, LUT's output
 
 				ostringstream wi, wim1, seli, wipad, wim1full, wim1fulla;
-				wi << "w" << i;						//actual partial remainder
-				wim1 << "w" << i-1;					//partial remainder for the next iteration, = left shifted wim1full
-				seli << "sel" << i;					//constructed as the wi's first 4 digits and D's first, LUT's input
-				wipad << "w" << i << "pad";			//1-left-shifted wi
-				wim1full << "w" << i-1 << "full";	//partial remainder after this iteration, = wi+qi*D
-				wim1fulla << "w" << i-1 << "fulla";	//partial remainder after this iteration, = wi+qi*D
+				wi << pfx << "w" << i;						//actual partial remainder
+				wim1 << pfx << "w" << i-1;					//partial remainder for the next iteration, = left shifted wim1full
+				seli << pfx << "sel" << i;					//constructed as the wi's first 4 digits and D's first, LUT's input
+				wipad << pfx << "w" << i << "pad";			//1-left-shifted wi
+				wim1full << pfx << "w" << i-1 << "full";	//partial remainder after this iteration, = wi+qi*D
+				wim1fulla << pfx << "w" << i-1 << "fulla";	//partial remainder after this iteration, = wi+qi*D
 				string tInstance = "SelFunctionTable" + to_string(i);
 
-				vhdl << tab << declare(seli.str(),7) << " <= " << wi.str() << range( wF+5, wF+1)<<" & prescaledfY"<< range(wF, wF-1) <<";" << endl;
+				vhdl << tab << declare(seli.str(),7) << " <= " << wi.str() << range( wF+5, wF+1)<<" & " << fY << range(wF, wF-1) <<";" << endl;
 
 				newSharedInstance(selfunctiontable , tInstance, "X=>"+seli.str(), "Y=>"+ qi);
 				// REPORT(DEBUG, "After table instance " << i);
@@ -270,9 +295,9 @@ namespace flopoco{
 				// qui has a fanout of(wF+7), which we add to both its uses 
 				vhdl << tab << "with " << qi << range(1,0) << " select " << endl
 						 << tab << declare(getTarget()->adderDelay(wF+7)+getTarget()->fanoutDelay(2*(wF+7)), wim1fulla.str(), wF+7) << " <= " << endl
-						 << tab << tab << wipad.str() << " - (\"0000\" & prescaledfY)			when \"01\"," << endl
-						 << tab << tab << wipad.str() << " + (\"0000\" & prescaledfY)			when \"11\"," << endl
-						 << tab << tab << wipad.str() << " + (\"000\" & prescaledfY & \"0\")		when \"10\"," << endl
+						 << tab << tab << wipad.str() << " - (\"0000\" & " << fY << ")			when \"01\"," << endl
+						 << tab << tab << wipad.str() << " + (\"0000\" & " << fY << ")			when \"11\"," << endl
+						 << tab << tab << wipad.str() << " + (\"000\" & " << fY << " & \"0\")		when \"10\"," << endl
 						 << tab << tab << wipad.str() << "							when others;" << endl;
 
 				REPORT(DEBUG, "After with 1 ");
@@ -286,11 +311,11 @@ namespace flopoco{
 				vhdl << tab << tab << wim1fulla.str() << " + (\"0\" & prescaledfY & \"000\")			when \"100\"," << endl;
 				vhdl << tab << tab << wim1fulla.str() << " 			   		  when others;" << endl;
 #else
-				string fYdec =join("fYdec", i-1);	//
+				string fYdec =pfx+join("fYdec", i-1);	//
 				vhdl << tab << "with " << qi << range(3,1) << " select " << endl
 						 << tab << declare(getTarget()->lutDelay()+getTarget()->fanoutDelay(2*(wF+7)), fYdec, wF+7) << " <= " << endl
-						 << tab << tab << "(\"00\" & prescaledfY & \"00\")			when \"001\" | \"010\" | \"110\"| \"101\"," << endl
-						 << tab << tab << "(\"0\" & prescaledfY & \"000\")			when \"011\"| \"100\"," << endl
+						 << tab << tab << "(\"00\" & " << fY << " & \"00\")			when \"001\" | \"010\" | \"110\"| \"101\"," << endl
+						 << tab << tab << "(\"0\" & " << fY << " & \"000\")			when \"011\"| \"100\"," << endl
 						 << tab << tab << rangeAssign(wF+6,0,"'0'") << "when others;" << endl;
 				
 				vhdl << tab << "with " << qi << of(3) << " select" << endl; // Remark here: seli(6)==qi(3) but it we get better results using the latter.
@@ -301,6 +326,8 @@ namespace flopoco{
 #endif
 				vhdl << tab << declare(wim1.str(),wF+6) << " <= " << wim1full.str()<<range(wF+3,0)<<" & \"00\";" << endl;
 			}
+			if(ii>1)
+				buildFoldedLoopExit(pfx+"w0", 4);
 
 
 			vhdl << tab << declare(getTarget()->eqConstComparatorDelay(wF+3), "q0",4) << "(3 downto 0) <= \"0000\" when  w0 = (" << wF+5 << " downto 0 => '0')" << endl;
@@ -379,6 +406,11 @@ namespace flopoco{
 			else THROWERROR("alpha="<< alpha << " is not an option");
 			
 			nDigit = (wF+extraBit) >> 1;
+			if(ii>1) {
+				// round the number of iterations up to a multiple of ii: the extra digits only make the truncated quotient more accurate
+				itersPerCycle = (nDigit-2)/ii + 1;
+				nDigit = itersPerCycle*ii + 1;
+			}
 
 			int dSize, subSize;
 			if(prescaling==0) {
@@ -424,16 +456,40 @@ namespace flopoco{
 			selfunctiontable = new Table(this, target, tableContent,"selFunction", nbBitsD+nbBitsW, 3);
 			selfunctiontable->setShared();
 
-			////////////////////// Main SRT loop, unrolled ///////////////////////
+			// In the folded architecture, the iterations of one cycle work on the loop state, with their own signal names
+			string pfx = (ii>1 ? "loop_" : "");
+			string D = "D";
+			string Dx3 = "Dx3";
+			int firstIter = nDigit-1;
+			if(ii>1) {
+				double iterationDelay = getTarget()->logicDelay(nbBitsD+nbBitsW) + getTarget()->fanoutDelay(subSize)
+					+ (alpha==3 ? 2 : 1) * getTarget()->adderDelay(subSize);
+				string wInit = (alpha==2 ? "\"00\" & psX" : "\"0\" & psX & \"0\"");
+				string wFeedback = "Wreg" + range(subSize-3,0) + " & \"00\"";
+				if(alpha==3) { // 3D is loop-invariant, it is kept in the loop along with D
+					buildFoldedLoopEntry("Dx3 & D", 2*dSize+1, wInit, subSize, wFeedback, iterationDelay);
+					D = "Dloop";
+					Dx3 = "Dx3loop";
+					vhdl << tab << declare(D, dSize) << " <= Dcur" << range(dSize-1, 0) << ";" << endl;
+					vhdl << tab << declare(Dx3, dSize+1) << " <= Dcur" << range(2*dSize, dSize) << ";" << endl;
+				}
+				else {
+					buildFoldedLoopEntry("D", dSize, wInit, subSize, wFeedback, iterationDelay);
+					D = "Dcur";
+				}
+				firstIter = itersPerCycle;
+			}
 
-			for(i=nDigit-1; i>=1; i--) {
+			////////////////////// Main SRT loop, unrolled (or folded on itersPerCycle iterations) ///////////////////////
 
-				string qi =join( "q", i);						//current quotient digit, LUT's output
-				string wi = join("betaw", i);						// current partial remainder
-				string wifull =join("w", i);						// current partial remainder
-				string seli = join("sel", i);					//constructed as the wi's first 4 digits and D's first, LUT's input
-				string qiTimesD = join("absq", i)+"D";		//qi*Y
-				string wim1full = join("w", i-1);	//partial remainder after this iteration, = wi+qi*D
+			for(i=firstIter; i>=1; i--) {
+
+				string qi =pfx+join( "q", i);						//current quotient digit, LUT's output
+				string wi = pfx+join("betaw", i);						// current partial remainder
+				string wifull =pfx+join("w", i);						// current partial remainder
+				string seli = pfx+join("sel", i);					//constructed as the wi's first 4 digits and D's first, LUT's input
+				string qiTimesD = pfx+join("absq", i)+"D";		//qi*Y
+				string wim1full = pfx+join("w", i-1);	//partial remainder after this iteration, = wi+qi*D
 
 				/*
 						Detailed algorithm for alpha=3 :
@@ -449,8 +505,11 @@ rox P						or wi is 26 bits long
 						wi-1full = wi-qi*D
 					*	left shifting wi-1full to obtain wi-1, next partial remainder to work on
 				*/
-				if(i==nDigit-1){
-					if(alpha==2) {
+				if(i==firstIter){
+					if(ii>1) {
+						vhdl << tab << declare(wi, subSize) << " <=  Wcur;" << endl;
+					}
+					else if(alpha==2) {
 						vhdl << tab << declare(wi, subSize) << " <=  \"00\" & psX;" << endl;
 					} 
 					else { // alpha=3
@@ -463,10 +522,10 @@ rox P						or wi is 26 bits long
 				}
 
 				if(prescaling==1) { // now that D may exceed 1, we need to consider its top bit as well
-					vhdl << tab << declare(seli, nbBitsW+nbBitsD) << " <= " << wi << range(subSize-1, subSize-nbBitsW) << " & D" << range(dSize-1,dSize-nbBitsD)  << ";" << endl;
+					vhdl << tab << declare(seli, nbBitsW+nbBitsD) << " <= " << wi << range(subSize-1, subSize-nbBitsW) << " & " << D << range(dSize-1,dSize-nbBitsD)  << ";" << endl;
 				}
 				else {
-					vhdl << tab << declare(seli, nbBitsW+nbBitsD) << " <= " << wi << range(subSize-1, subSize-nbBitsW) << " & D" << range(dSize-2,dSize-1-nbBitsD)  << ";" << endl;				 
+					vhdl << tab << declare(seli, nbBitsW+nbBitsD) << " <= " << wi << range(subSize-1, subSize-nbBitsW) << " & " << D << range(dSize-2,dSize-1-nbBitsD)  << ";" << endl;				 
 				}
 				
 				newSharedInstance(selfunctiontable , "SelFunctionTable" + to_string(i), "X=>"+seli, "Y=>"+ qi);
@@ -479,9 +538,9 @@ rox P						or wi is 26 bits long
 					vhdl << tab << "with " << qi << " select" << endl;
 					vhdl << tab << tab << declare(getTarget()->fanoutDelay(subSize) + getTarget()->adderDelay(subSize), qiTimesD,subSize)
 							 << " <= "<< endl 
-							 << tab << tab << tab << "\"000\" & D  		   when \"001\" | \"111\"," << endl
-							 << tab << tab << tab << "\"00\" & D & \"0\"	 when \"010\" | \"110\"," << endl
-							 << tab << tab << tab << "\"00\" & Dx3    	   when \"011\" | \"101\"," << endl
+							 << tab << tab << tab << "\"000\" & " << D << "  		   when \"001\" | \"111\"," << endl
+							 << tab << tab << tab << "\"00\" & " << D << " & \"0\"	 when \"010\" | \"110\"," << endl
+							 << tab << tab << tab << "\"00\" & " << Dx3 << "    	   when \"011\" | \"101\"," << endl
 							 << tab << tab << tab << "(" << subSize-1 << " downto 0 => '0')	when others;" << endl<< endl;
 #else // Recompute 3Y locally to save the registers: the LUT is used anyway (wrong! on Virtex6 ISE finds a MUX) 
 					// For (8,23) on Virtex6 with ISE this gives 345Mhz, 856 regs+ 1051 LUTs 
@@ -513,8 +572,8 @@ rox P						or wi is 26 bits long
 					vhdl << tab << "with " << qi << " select" << endl;
 					// no delay for qiTimesD, it should be merged in the following addition
 					vhdl << tab << tab << declare(qiTimesD,subSize) << " <= "<< endl 
-							 << tab << tab << tab << "\"000\" & D						 when \"001\" | \"111\", -- mult by 1" << endl
-							 << tab << tab << tab << "\"00\" & D & \"0\"			   when \"010\" | \"110\", -- mult by 2" << endl
+							 << tab << tab << tab << "\"000\" & " << D << "						 when \"001\" | \"111\", -- mult by 1" << endl
+							 << tab << tab << tab << "\"00\" & " << D << " & \"0\"			   when \"010\" | \"110\", -- mult by 2" << endl
 							 << tab << tab << tab << "(" << subSize-1 << " downto 0 => '0')	 when others;        -- mult by 0" << endl << endl;
 					
 					//				vhdl << tab << declare(wi, subSize) << " <= " << wi << " & \"0\";" << endl;
@@ -527,6 +586,8 @@ rox P						or wi is 26 bits long
 
 				}
 			} // end loop
+			if(ii>1)
+				buildFoldedLoopExit(pfx+"w0", 3);
 
 			vhdl << tab << declare("wfinal", wF+2) << " <= w0" <<range(wF+1,0) << ";" << endl;
 			vhdl << tab << declare("qM0") << " <= wfinal" << of(wF+1) << "; -- rounding bit is the sign of the remainder" << endl;
@@ -604,6 +665,40 @@ rox P						or wi is 26 bits long
 
 
 
+	/////////////////////////// The folded architecture ///////////////////////////
+	// The loop is opened by Operator::addLoopEntry(). Each cycle computes itersPerCycle iterations out of the loop registers, or out of a new input when load is set.
+	// After ii cycles, the registers hold the final remainder and all the quotient digits,
+	// which addMultiCycleCopy() passes to the unchanged back-end of the unrolled architecture.
+
+	void FPDiv::buildFoldedLoopEntry(string dInit, int dSize, string wInit, int wSize, string wFeedback, double iterationDelay) {
+		REPORT(INFO, "Folded architecture: " << itersPerCycle << " iteration(s) per cycle, one input every " << ii << " cycles");
+		addLoopEntry("loopIn", "load", "load0", dInit + " & " + wInit, dSize+wSize, getTarget()->lutDelay() + itersPerCycle*iterationDelay);
+		vhdl << tab << declare("Dcur", dSize) << " <= loopIn" << range(dSize+wSize-1, wSize) << " when load='1' else Dreg;" << endl;
+		vhdl << tab << declare("Wcur", wSize) << " <= loopIn" << range(wSize-1, 0) << " when load='1' else " << wFeedback << ";" << endl;
+	}
+
+
+	void FPDiv::buildFoldedLoopExit(string wNext, int digitSize) {
+		int qSize = digitSize*itersPerCycle*ii;
+		vhdl << tab << "-- the quotient digits are shifted in, the first ones end up on the left" << endl;
+		vhdl << tab << declare("Qnext", qSize) << " <= Qreg" << range(qSize-digitSize*itersPerCycle-1, 0);
+		for(int i=itersPerCycle; i>=1; i--)
+			vhdl << " & loop_q" << i;
+		vhdl << ";" << endl;
+		addFeedbackRegister("Dreg", "Dcur", "loopIn");
+		addFeedbackRegister("Wreg", wNext, "loopIn");
+		addFeedbackRegister("Qreg", "Qnext", "loopIn");
+		enablePipelining();
+
+		vhdl << tab << "-- " << ii << " cycles after the load, the loop registers hold the results of the last iteration" << endl;
+		addMultiCycleCopy("w0", "Wreg", ii);
+		addMultiCycleCopy("qFinal", "Qreg", ii);
+		for(int i=nDigit-1; i>=1; i--)
+			vhdl << tab << declare(join("q", i), digitSize) << " <= qFinal" << range(digitSize*i-1, digitSize*(i-1)) << ";" << endl;
+	}
+
+
+
 	// Various functions that used to be in NbBitsMin
 	void SRTDivNbBitsMin::computeNbBit (int radix, int digitSet)
 	{
@@ -964,7 +1059,9 @@ rox P						or wi is 26 bits long
 		UserInterface::parseStrictlyPositiveInt(args, "wF", &wF);
 		int srt;
 		UserInterface::parsePositiveInt(args, "srt", &srt);
-		return new FPDiv(parentOp, target, wE, wF, srt);
+		int ii;
+		UserInterface::parseThroughput(args, "throughput", &ii);
+		return new FPDiv(parentOp, target, wE, wF, srt, ii);
 	}
 
 	TestList FPDiv::unitTest(int index)
@@ -999,6 +1096,19 @@ rox P						or wi is 26 bits long
 					testStateList.push_back(paramList);
 					paramList.clear();
 			}
+			// the folded architectures
+			for(int wF=10; wF<53; wF+=13) {
+				for(int k=2; k<=8; k*=2) {
+					for(string srt: {"42", "43", "87"}) {
+						paramList.push_back(make_pair("wF",to_string(wF)));
+						paramList.push_back(make_pair("wE",to_string(6+(wF/10))));
+						paramList.push_back(make_pair("srt",srt));
+						paramList.push_back(make_pair("throughput","1/"+to_string(k)));
+						testStateList.push_back(paramList);
+						paramList.clear();
+					}
+				}
+			}
 		}
 		else     
 		{
@@ -1016,8 +1126,9 @@ rox P						or wi is 26 bits long
 											 "http://www.cs.ucla.edu/digital_arithmetic/files/ch5.pdf",
 											 "wE(int): exponent size in bits; \
 wF(int): mantissa size in bits;\
-srt(int)=42: Can be 42, 43 or 87 so far. Default 42 means radix 4 with digits between -2 and 2. Other choices may have a better area/speed trade-offs",
-											"The algorithm used here is the division by digit recurrence (SRT). In radix 4, we use a maximally redundant digit set. In radix 8, we use split-digits in [-7,7], and a bit of prescaling.",
+srt(int)=42: Can be 42, 43 or 87 so far. Default 42 means radix 4 with digits between -2 and 2. Other choices may have a better area/speed trade-offs;\
+throughput(string)=1: 1 for the unrolled architecture, or 1/k for a folded one that accepts one input every k cycles",
+											"The algorithm used here is the division by digit recurrence (SRT). In radix 4, we use a maximally redundant digit set. In radix 8, we use split-digits in [-7,7], and a bit of prescaling. With throughput=1/k, the iterations are folded on a loop that computes 1/k of them in each cycle, and is reused for k cycles: the inputs must be presented every k cycles, starting with the cycle after reset.",
 											 FPDiv::parseArguments,
 											 FPDiv::unitTest
 
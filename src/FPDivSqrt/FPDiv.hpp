@@ -20,8 +20,11 @@ namespace flopoco{
 		 * @param[in]		target		the target device
 		 * @param[in]		wE			the width of the exponent for the f-p number X
 		 * @param[in]		wF			the width of the fraction for the f-p number X
+		 * @param[in]		srt			the SRT variant: 42, 43 or 87
+		 * @param[in]		ii			the initiation interval: if larger than 1, the iterations are folded
+		 *									so that one input is accepted every ii cycles
 		 */
-		FPDiv(OperatorPtr parentOp, Target* target, int wE, int wF, int radix=0);
+		FPDiv(OperatorPtr parentOp, Target* target, int wE, int wF, int srt=42, int ii=1);
 
 		/**
 		 * FPDiv destructor
@@ -75,6 +78,31 @@ namespace flopoco{
 		int nDigit;
 		/** prescaling parameter: 0 means no prescaling; 1 means prescaling with 1 addition; 2 means prescaling with 2 additions */
 		int prescaling;
+		/** The initiation interval: 1 for the unrolled architecture, k for the folded one accepting one input every k cycles */
+		int ii;
+		/** In the folded architecture, the number of iterations computed in each cycle */
+		int itersPerCycle;
+
+		/**
+		 * For the folded architecture: declares the input of the iteration loop, and its current state Dcur and Wcur,
+		 * either loaded from dInit and wInit or fed back from the registers Dreg and Wreg, see Operator::addLoopEntry().
+		 * Leaves pipelining disabled for the loop body.
+		 * @param dInit the divisor, or the concatenation of its multiples
+		 * @param dSize its size
+		 * @param wInit the initial partial remainder
+		 * @param wSize its size
+		 * @param wFeedback the expression of Wreg that gives the next partial remainder
+		 * @param iterationDelay the critical path of one iteration
+		 */
+		void buildFoldedLoopEntry(string dInit, int dSize, string wInit, int wSize, string wFeedback, double iterationDelay);
+
+		/**
+		 * For the folded architecture: closes the iteration loop, and declares out of its registers
+		 * the w0 and q_i signals of the unrolled architecture, valid ii cycles later.
+		 * @param wNext the partial remainder after the last iteration of the cycle
+		 * @param digitSize the size of a quotient digit
+		 */
+		void buildFoldedLoopExit(string wNext, int digitSize);
 		
 	};
 
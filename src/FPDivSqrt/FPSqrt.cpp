@@ -37,12 +37,14 @@ namespace flopoco{
 #define DEBUGVHDL 0
 	//#define LESS_DSPS
 
-	FPSqrt::FPSqrt(OperatorPtr parentOp, Target* target, int wE_, int wF_, int method_) :
-		Operator(parentOp,target), wE(wE_), wF(wF_), method(method_) {
+	FPSqrt::FPSqrt(OperatorPtr parentOp, Target* target, int wE_, int wF_, int method_, int ii_) :
+		Operator(parentOp,target), wE(wE_), wF(wF_), method(method_), ii(ii_), correctRounding(true) {
 
 		ostringstream name;
 
 		name<<"FPSqrt_"<<wE<<"_"<<wF;
+		if(ii>1)
+			name << "_II" << ii;
 
 		uniqueName_ = name.str();
 
@@ -55,6 +57,12 @@ namespace flopoco{
 		else  {
 			THROWERROR("Wrong value passed to parameter: method=" << method);
 		}
+		if(ii<1) {
+			THROWERROR("Invalid initiation interval: " << ii);
+		}
+		if(ii>1 && method!=1) {
+			THROWERROR("The folded architecture (throughput=1/" << ii << ") is only implemented for method=1");
+		}
 
 		// -------- Parameter set up -----------------
 
@@ -140,63 +148,117 @@ namespace flopoco{
 			// Sorry for the completely inconsistent signal names in the C++,
 			// this code was incrementally modified to match the mames and indices in the ASA book, and history shows.
 			// TODO refactor the change of variable i -> i-1 in the C++, and rename R into T etc
-			vhdl << tab << declare(getTarget()->lutDelay(),
-														 "fracXnorm", wF+4) << " <= \"1\" & fracX & \"000\" when X(" << wF << ") = '0' else" << endl
-					 << tab << "      \"01\" & fracX&\"00\"; -- pre-normalization" << endl;
-			vhdl << tab << declare("S0", 2) << " <= \"01\";" << endl;
+			if(ii==1) {
+				vhdl << tab << declare(getTarget()->lutDelay(),
+															 "fracXnorm", wF+4) << " <= \"1\" & fracX & \"000\" when X(" << wF << ") = '0' else" << endl
+						 << tab << "      \"01\" & fracX&\"00\"; -- pre-normalization" << endl;
+				vhdl << tab << declare("S0", 2) << " <= \"01\";" << endl;
 
-			vhdl << tab << declare(getTarget()->adderDelay(4),
-														 "T1", wF+4) << " <= (\"0111\" + fracXnorm" << range(wF+3, wF)<< ") & fracXnorm" << range(wF-1, 0)<< ";"<< endl;
+				vhdl << tab << declare(getTarget()->adderDelay(4),
+															 "T1", wF+4) << " <= (\"0111\" + fracXnorm" << range(wF+3, wF)<< ") & fracXnorm" << range(wF-1, 0)<< ";"<< endl;
 
 			
-		//		vhdl << tab << declare(join("d",wF+3)) << " <= '0';" << endl;
-		//		vhdl << tab << declare(join("s",wF+3)) << " <= '1';" << endl;
-			vhdl << tab << "-- now implementing the recurrence " << endl;
-			//			vhdl << tab << "--  w_{i} = 2w_{i-1} -2s_{i}S_{i-1} - 2^{-i-1}s_{i}^2  for i in {1..n}" << endl;
-			vhdl << tab << "--  this is a binary non-restoring algorithm, see ASA book" << endl;
-			int maxstep=wF+2;
-			for(int i=3; i<=maxstep; i++) {
-				double stageDelay= getTarget()->adderDelay(i);
-				REPORT(2, "estimated delay for stage "<< i << " is " << stageDelay << "s");
-				// was: int i = wF+3-step; // to have the same indices as FPLibrary
-				vhdl << tab << "-- Step " << i-1 << endl;
-				string di = join("d", i-2);
-				string TwoRim1 = "T" + to_string(i-2) + "s";
-				string Ri = join("T", i-1);
-				string Rim1 = join("T", i-2);
-				string Si = join("S", i-2);
-				string Sim1 = join("S", i-3);
-				//			string zs = join("zs", i);
-				string ds = join("U", i-2);
-				string TwoRim1H = TwoRim1 + "_h";
-				string TwoRim1L = TwoRim1 + "_l";
-				string wh = "T" + to_string(i) + "_h";
-				vhdl << tab << declare(di) << " <= not "<< Rim1 << "("<< wF+3<<"); --  bit of weight "<< -(i-2) << endl;
-				vhdl << tab << declare(TwoRim1,wF+5) << " <= " << Rim1 << " & \"0\";" << endl;
-				vhdl << tab << declare(TwoRim1H,i+3) << " <= " << TwoRim1 << range(wF+4, wF+2-i) << ";" << endl;
-				if(i <= wF+1) {
-					vhdl << tab << declare(TwoRim1L,wF+2-i) << " <= "  << TwoRim1 << range(wF+1-i, 0) << ";" << endl;
+			//		vhdl << tab << declare(join("d",wF+3)) << " <= '0';" << endl;
+			//		vhdl << tab << declare(join("s",wF+3)) << " <= '1';" << endl;
+				vhdl << tab << "-- now implementing the recurrence " << endl;
+				//			vhdl << tab << "--  w_{i} = 2w_{i-1} -2s_{i}S_{i-1} - 2^{-i-1}s_{i}^2  for i in {1..n}" << endl;
+				vhdl << tab << "--  this is a binary non-restoring algorithm, see ASA book" << endl;
+				int maxstep=wF+2;
+				for(int i=3; i<=maxstep; i++) {
+					double stageDelay= getTarget()->adderDelay(i);
+					REPORT(2, "estimated delay for stage "<< i << " is " << stageDelay << "s");
+					// was: int i = wF+3-step; // to have the same indices as FPLibrary
+					vhdl << tab << "-- Step " << i-1 << endl;
+					string di = join("d", i-2);
+					string TwoRim1 = "T" + to_string(i-2) + "s";
+					string Ri = join("T", i-1);
+					string Rim1 = join("T", i-2);
+					string Si = join("S", i-2);
+					string Sim1 = join("S", i-3);
+					//			string zs = join("zs", i);
+					string ds = join("U", i-2);
+					string TwoRim1H = TwoRim1 + "_h";
+					string TwoRim1L = TwoRim1 + "_l";
+					string wh = "T" + to_string(i) + "_h";
+					vhdl << tab << declare(di) << " <= not "<< Rim1 << "("<< wF+3<<"); --  bit of weight "<< -(i-2) << endl;
+					vhdl << tab << declare(TwoRim1,wF+5) << " <= " << Rim1 << " & \"0\";" << endl;
+					vhdl << tab << declare(TwoRim1H,i+3) << " <= " << TwoRim1 << range(wF+4, wF+2-i) << ";" << endl;
+					if(i <= wF+1) {
+						vhdl << tab << declare(TwoRim1L,wF+2-i) << " <= "  << TwoRim1 << range(wF+1-i, 0) << ";" << endl;
+					}
+					vhdl << tab << declare(ds,i+3) << " <=  \"0\" & ";
+					if (i>1)
+						vhdl 	<< Sim1 << " & ";
+					vhdl << di  << " & (not " << di << ")" << " & \"1\"; " << endl;
+					vhdl << tab <<  declare(stageDelay, wh, i+3) << " <=   " << TwoRim1H << " - " << ds << " when " << di << "='1'" << endl
+							 << tab << tab << "  else " << TwoRim1H << " + " << ds << ";" << endl;
+					vhdl << tab << declare(Ri, wF+4) << " <= " << wh << range(i+1,0);
+					if(i <= wF+1)
+						vhdl << " & " << TwoRim1L << ";" << endl;
+					else
+						vhdl << ";" << endl;
+					vhdl << tab << declare(Si, i) << " <= ";
+					if(i==1)
+						vhdl << "\"\" & " << di << ";"<< endl;
+					else
+						vhdl << Sim1 /*<< range(i-1,1)*/ << " & " << di << "; -- here -1 becomes 0 and 1 becomes 1"<< endl;
 				}
-				vhdl << tab << declare(ds,i+3) << " <=  \"0\" & ";
-				if (i>1)
-					vhdl 	<< Sim1 << " & ";
-				vhdl << di  << " & (not " << di << ")" << " & \"1\"; " << endl;
-				vhdl << tab <<  declare(stageDelay, wh, i+3) << " <=   " << TwoRim1H << " - " << ds << " when " << di << "='1'" << endl
-						 << tab << tab << "  else " << TwoRim1H << " + " << ds << ";" << endl;
-				vhdl << tab << declare(Ri, wF+4) << " <= " << wh << range(i+1,0);
-				if(i <= wF+1)
-					vhdl << " & " << TwoRim1L << ";" << endl;
-				else
-					vhdl << ";" << endl;
-				vhdl << tab << declare(Si, i) << " <= ";
-				if(i==1)
-					vhdl << "\"\" & " << di << ";"<< endl;
-				else
-					vhdl << Sim1 /*<< range(i-1,1)*/ << " & " << di << "; -- here -1 becomes 0 and 1 becomes 1"<< endl;
+				string dfinal=join("d", maxstep);
+				vhdl << tab << declare(dfinal) << " <= not "<< join("T", maxstep-1) << of(wF+3)<<" ; -- the sign of the remainder will become the round bit" << endl;
+				vhdl << tab << declare("mR", wF+3) << " <= "<< join("S", maxstep-2)<<" & "<<dfinal<<"; -- result significand" << endl;
+			}
+			else {
+				// The folded architecture: the iterations are computed itersPerCycle at a time by a loop, reused for ii cycles,
+				// see Operator::addLoopEntry(). All its iterations are identical: they work on the full width of the remainder,
+				// the digits of S being ORed in at the position of a one-hot mask M that is shifted right at each iteration.
+				// The fraction is padded to a multiple of ii: the result is the same, truncated.
+				int itersPerCycle = (wF-1)/ii + 1;
+				int wFp = itersPerCycle*ii;
+				REPORT(INFO, "Folded architecture: " << itersPerCycle << " iteration(s) per cycle, one input every " << ii << " cycles");
+				addInputCounter("load0", "X", ii);
+
+				vhdl << tab << declare(getTarget()->lutDelay(),
+															 "fracXnorm", wFp+4) << " <= \"1\" & fracX & " << zg(wFp-wF+3) << " when X(" << wF << ") = '0' else" << endl
+						 << tab << "      \"01\" & fracX & " << zg(wFp-wF+2) << "; -- pre-normalization" << endl;
+				vhdl << tab << declare(getTarget()->adderDelay(4),
+															 "T1", wFp+4) << " <= (\"0111\" + fracXnorm" << range(wFp+3, wFp)<< ") & fracXnorm" << range(wFp-1, 0)<< ";"<< endl;
+
+				double iterationDelay = getTarget()->lutDelay() + getTarget()->adderDelay(wFp+5);
+				addLoopEntry("loopIn", "load", "load0", "T1", wFp+4, getTarget()->lutDelay() + itersPerCycle*iterationDelay);
+				vhdl << tab << declare("loop_T0", wFp+4) << " <= loopIn" << range(wFp+3, 0) << " when load='1' else Treg;" << endl;
+				vhdl << tab << declare("loop_S0", wFp+5) << " <= \"001\" & " << zg(wFp+2) << " when load='1' else Sreg;" << endl;
+				vhdl << tab << declare("loop_M0", wFp+5) << " <= " << zg(5) << " & \"1\" & " << zg(wFp-1) << " when load='1' else Mreg;" << endl;
+				for(int k=1; k<=itersPerCycle; k++) {
+					string d = join("loop_d", k);
+					string TwoR = join("loop_TwoR", k);
+					string U = join("loop_U", k);
+					string Th = join("loop_T", k, "_h");
+					string T = join("loop_T", k), Tm1 = join("loop_T", k-1);
+					string S = join("loop_S", k), Sm1 = join("loop_S", k-1);
+					string M = join("loop_M", k), Mm1 = join("loop_M", k-1);
+					vhdl << tab << declare(d) << " <= not " << Tm1 << of(wFp+3) << ";" << endl;
+					vhdl << tab << declare(TwoR, wFp+5) << " <= " << Tm1 << " & \"0\";" << endl;
+					vhdl << tab << declare(U, wFp+5) << " <= " << Sm1 << " or " << Mm1 << " or (" << Mm1 << range(wFp+2, 0) << " & \"00\") when " << d << "='1'" << endl
+							 << tab << tab << "  else " << Sm1 << " or " << Mm1 << " or (" << Mm1 << range(wFp+3, 0) << " & \"0\");" << endl;
+					vhdl << tab << declare(Th, wFp+5) << " <=   " << TwoR << " - " << U << " when " << d << "='1'" << endl
+							 << tab << tab << "  else " << TwoR << " + " << U << ";" << endl;
+					vhdl << tab << declare(T, wFp+4) << " <= " << Th << range(wFp+3, 0) << ";" << endl;
+					vhdl << tab << declare(S, wFp+5) << " <= " << Sm1 << " or (" << Mm1 << range(wFp+2, 0) << " & \"00\") when " << d << "='1'" << endl
+							 << tab << tab << "  else " << Sm1 << ";" << endl;
+					vhdl << tab << declare(M, wFp+5) << " <= \"0\" & " << Mm1 << range(wFp+4, 1) << ";" << endl;
+				}
+				addFeedbackRegister("Treg", join("loop_T", itersPerCycle), "loopIn");
+				addFeedbackRegister("Sreg", join("loop_S", itersPerCycle), "loopIn");
+				addFeedbackRegister("Mreg", join("loop_M", itersPerCycle), "loopIn");
+				enablePipelining();
+
+				vhdl << tab << "-- " << ii << " cycles after the load, the loop registers hold the results of the last iteration" << endl;
+				addMultiCycleCopy("Tfinal", "Treg", ii);
+				addMultiCycleCopy("Sfinal", "Sreg", ii);
+				vhdl << tab << declare("dfinal") << " <= not Tfinal" << of(wFp+3) << "; -- the sign of the remainder will become the round bit" << endl;
+				vhdl << tab << declare("mRp", wFp+3) << " <= Sfinal" << range(wFp+3, 2) << " & dfinal; -- result significand on the padded format" << endl;
+				vhdl << tab << declare("mR", wF+3) << " <= mRp" << range(wFp+2, wFp-wF) << ";" << endl;
 			}
-			string dfinal=join("d", maxstep);
-			vhdl << tab << declare(dfinal) << " <= not "<< join("T", maxstep-1) << of(wF+3)<<" ; -- the sign of the remainder will become the round bit" << endl;
-			vhdl << tab << declare("mR", wF+3) << " <= "<< join("S", maxstep-2)<<" & "<<dfinal<<"; -- result significand" << endl;
 
 			// end of component FPSqrt_Sqrt in fplibrary
 			vhdl << tab << declare("fR", wF) << " <= mR" <<range(wF, 1) << ";-- removing leading 1" << endl;
@@ -319,7 +381,9 @@ namespace flopoco{
 			UserInterface::parseStrictlyPositiveInt(args, "wF", &wF);
 			int method;
 			UserInterface::parsePositiveInt(args, "method", &method);
-			return new FPSqrt(parentOp, target, wE, wF, method);
+			int ii;
+			UserInterface::parseThroughput(args, "throughput", &ii);
+			return new FPSqrt(parentOp, target, wE, wF, method, ii);
 		}
 
 
@@ -344,6 +408,16 @@ namespace flopoco{
 					testStateList.push_back(paramList);
 					paramList.clear();
 			}
+			// the folded architectures
+			for(int wF=10; wF<53; wF+=13) {
+				for(int k=2; k<=8; k*=2) {
+					paramList.push_back(make_pair("wF",to_string(wF)));
+					paramList.push_back(make_pair("wE",to_string(6+(wF/10))));
+					paramList.push_back(make_pair("throughput","1/"+to_string(k)));
+					testStateList.push_back(paramList);
+					paramList.clear();
+				}
+			}
 		}
 		else     
 		{
@@ -359,8 +433,9 @@ namespace flopoco{
 												 "",
 												 "wE(int): exponent size in bits; \
 wF(int): mantissa size in bits; \
-method(int)=1: 0 for plain restoring, 1 for nonrestoring method",
-												 "",
+method(int)=1: 0 for plain restoring, 1 for nonrestoring method;\
+throughput(string)=1: 1 for the unrolled architecture, or 1/k for a folded one that accepts one input every k cycles (method=1 only)",
+												 "With throughput=1/k, the iterations are folded on a loop that computes 1/k of them in each cycle, and is reused for k cycles: the inputs must be presented every k cycles, starting with the cycle after reset.",
 												 FPSqrt::parseArguments,
 												 FPSqrt::unitTest
 												 ) ;
@@ -19,8 +19,11 @@ namespace flopoco{
 		 * @param[in]		target		the target device
 		 * @param[in]		wE			the the with of the exponent for the f-p number X
 		 * @param[in]		wF			the the with of the fraction for the f-p number X
+		 * @param[in]		method		0 for the restoring algorithm, 1 for the nonrestoring one
+		 * @param[in]		ii			the initiation interval: if larger than 1, the iterations are folded
+		 *									so that one input is accepted every ii cycles (method 1 only)
 		 */
-		FPSqrt(OperatorPtr parentOp, Target* target, int wE, int wF, int method=0);
+		FPSqrt(OperatorPtr parentOp, Target* target, int wE, int wF, int method=0, int ii=1);
 
 		/**
 		 * FPSqrt destructor
@@ -54,6 +57,8 @@ namespace flopoco{
 		int wF;
 		/** an int that selects the method */
 		int method;
+		/** The initiation interval: 1 for the unrolled architecture, k for the folded one accepting one input every k cycles */
+		int ii;
 		/** A boolean selecting between IEEE-compliant correct rounding
 			 or faithful (last-bit accurate) result  */
 		bool correctRounding;
@@ -10,6 +10,14 @@
 
 #include "ShiftReg.hpp"
 
+#if defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+#include "pagsuite/adder_graph.h"
+#include "ConstMult/AdderGraphSearch.hpp"
+#include "ConstMult/WordLengthCalculator.hpp"
+#include "ConstMult/IntConstMultShiftAddTypes.hpp"
+#include "ConstMult/adder_cost.hpp"
+#endif
+
 using namespace std;
 
 namespace flopoco {
@@ -17,14 +25,14 @@ namespace flopoco {
 	const int veryLargePrec = 6400;  /*6400 bits should be enough for anybody */
 
 	FixFIR::FixFIR(OperatorPtr parentOp, Target* target, int lsbIn_, int lsbOut_):
-		Operator(parentOp, target), lsbIn(lsbIn_), lsbOut(lsbOut_)
+		Operator(parentOp, target), lsbIn(lsbIn_), lsbOut(lsbOut_), transposed(false)
 	{
 		initFilter();
 	};
 
 
-	FixFIR::FixFIR(OperatorPtr parentOp, Target* target, int lsbIn_, int lsbOut_, vector<string> coeff_, int symmetry_, bool rescale_) :
-		Operator(parentOp, target), lsbIn(lsbIn_), lsbOut(lsbOut_), coeff(coeff_), symmetry(symmetry_), rescale(rescale_)
+	FixFIR::FixFIR(OperatorPtr parentOp, Target* target, int lsbIn_, int lsbOut_, vector<string> coeff_, int symmetry_, bool rescale_, bool transposed_) :
+		Operator(parentOp, target), lsbIn(lsbIn_), lsbOut(lsbOut_), coeff(coeff_), symmetry(symmetry_), rescale(rescale_), transposed(transposed_)
 	{
 			initFilter();
 			buildVHDL();
@@ -54,17 +62,24 @@ namespace flopoco {
 		}
 		addInput("X", 1-lsbIn, true);
 
+		// initialize stuff for emulate
+		for(int i=0; i<=n; i++) {
+			xHistory[i]=0;
+		}
+		currentIndex=0;
 
-		// The shift register
-		vhdl << tab << declare("Xd0", 1-lsbIn)  << " <= X;" << endl;
-		// The instance of the shift register for Xd1...Xdn-1
-		string omap="";
-		for(int i = 1; i<n; i++) {
-			omap += join("Xd", i) + "=>" +  join("Xd", i) + (i<n-1?",":"") ;
+		if(!transposed) {
+			// The shift register
+			vhdl << tab << declare("Xd0", 1-lsbIn)  << " <= X;" << endl;
+			// The instance of the shift register for Xd1...Xdn-1
+			string omap="";
+			for(int i = 1; i<n; i++) {
+				omap += join("Xd", i) + "=>" +  join("Xd", i) + (i<n-1?",":"") ;
+			}
+			newInstance("ShiftReg", "inputShiftReg",
+									join("w=",1-lsbIn) + join(" n=", n-1) + join(" reset=", 1), // the parameters
+									"X=>X", omap);  // the in and out port maps
 		}
-		newInstance("ShiftReg", "inputShiftReg",
-								join("w=",1-lsbIn) + join(" n=", n-1) + join(" reset=", 1), // the parameters
-								"X=>X", omap);  // the in and out port maps
 
 		
 		double sumAbs;
@@ -152,6 +167,17 @@ namespace flopoco {
 			msbOut--;
 		}
 		REPORT(INFO, "Computed msbOut=" << msbOut);
+
+		if(transposed) {
+			buildVHDLTransposed();
+			// For the emulate() computation we need the standard SOPC, as in the symmetric case
+			UserInterface::pushAndClearGlobalOpList();
+			refFixSOPC = new FixSOPC(nullptr, getTarget(), lsbIn, msbOut, lsbOut, coeff);
+			REPORT(INFO, "Created reference SOPC called " << refFixSOPC->getName() );
+			UserInterface::popGlobalOpList();
+			fixSOPC = refFixSOPC;
+			return;
+		}
 	
 		// prepare the strings for newInstance()
 		string inportmap = "";
@@ -216,7 +242,9 @@ namespace flopoco {
 		fixSOPC = (FixSOPC*) newInstance("FixSOPCfull", "SOPC",
 																		 parameters, // the parameters
 																		 inportmap, // the in port maps
-																		 "R=>Rtmp" );  // the out port map
+																		 "R=>Rtmp",  // the out port map
+																		 "", // no constant inputs
+																		 false );  // not cacheable: we need the FixSOPC object itself
 
 		if(symmetry!=0){
 			// For the emulate() computation we need to build the standard SOPC that doesn't exploit symmetry
@@ -232,15 +260,180 @@ namespace flopoco {
 
 		addOutput("R", fixSOPC->msbOut - fixSOPC->lsbOut + 1,   true);
 		vhdl << tab << "R <= Rtmp;" << endl;
+	};
 
-		
-		// initialize stuff for emulate
-		for(int i=0; i<=n; i++) {
-			xHistory[i]=0;
+
+
+
+	/* The transposed form computes Y(t) = sum_i c_i.X(t-i) as
+	     S_{n-1}(t) = c_{n-1}.X(t)
+	     S_i(t)     = c_i.X(t) + S_{i+1}(t-1)
+	     Y(t)       = S_0(t)
+	   All the products c_i.X share the same input, so they are computed by one multiple-constant multiplier (MCM):
+	   an adder graph computed by RPAG for the set of the odd parts of the integer coefficients,
+	   realized by IntConstMultShiftAdd, truncated by WordLengthCalculator.
+	   Signs and powers of two are applied to the MCM outputs here.
+
+	   Error analysis: the chain is computed on g guard bits, with lsbInt=lsbOut-g.
+	   Each tap contributes three errors, each bounded by 2^lsbInt:
+	     - the rounding of c_i to an integer multiple K_i of 2^lsbInt (bounded by 2^(lsbInt-1) since |X|<1),
+	     - the truncation inside the adder graph (WordLengthCalculator is given the corresponding epsilon),
+	     - the truncation of the product to lsbInt.
+	   With g=intlog2(n)+3 we have 2^g > 8n, so their sum 3n.2^lsbInt is smaller than 3/8.2^lsbOut,
+	   and the final rounding to nearest adds at most 2^(lsbOut-1): the total error is smaller than 2^lsbOut,
+	   the result is faithful.
+	   The intermediate sums wrap around, which is harmless in two's complement since the final sum fits msbOut.
+	*/
+	void FixFIR::buildVHDLTransposed(){
+		// Equal coefficients already share their MCM output: there is nothing left to gain from the symmetry
+		if(symmetry != 0)
+			THROWERROR("symmetry=" << symmetry << " is not supported by the transposed architecture, which already shares the products of equal coefficients");
+#if defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+		int wIn = 1-lsbIn;
+		int g = intlog2(n) + 3;
+		int lsbInt = lsbOut - g;
+		int wAcc = msbOut - lsbInt + 1;
+		REPORT(DETAILED, "Transposed form: g=" << g << " wAcc=" << wAcc);
+
+		// The integer coefficients K_i = round(c_i.2^-lsbInt), split into sign, odd part and shift
+		vector<mpz_class> oddCoeff;
+		vector<int> shift;
+		vector<bool> negative;
+		int maxShift = 0;
+		for (int i=0; i< n; i++)	{
+			mpfr_t mpfrCoeff;
+			mpfr_init2(mpfrCoeff, veryLargePrec);
+			sollya_obj_t node = sollya_lib_parse_string(coeff[i].c_str());
+			if(node == 0)	{
+				THROWERROR("Unable to parse string " << coeff[i] << " as a numeric constant");
+			}
+			sollya_lib_get_constant(mpfrCoeff, node);
+			sollya_lib_clear_obj(node);
+			mpfr_mul_2si(mpfrCoeff, mpfrCoeff, -lsbInt, GMP_RNDN); // exact
+			mpz_class k;
+			mpfr_get_z(k.get_mpz_t(), mpfrCoeff, GMP_RNDN);
+			mpfr_clear(mpfrCoeff);
+
+			negative.push_back(k<0);
+			k = abs(k);
+			int sh = 0;
+			if(k!=0) {
+				while((k & 1) == 0) {
+					k >>= 1;
+					sh++;
+				}
+			}
+			if(intlog2(k) > 62) {
+				THROWERROR("Coefficient " << coeff[i] << " needs " << intlog2(k) << " bits at lsbOut=" << lsbOut << ", this is too much for RPAG");
+			}
+			oddCoeff.push_back(k);
+			shift.push_back(sh);
+			if(k!=0)
+				maxShift = max(maxShift, sh);
+			REPORT(DETAILED, "  c" << i << " = " << (negative[i]?"-":"") << k << "*2^" << sh+lsbInt);
 		}
-		currentIndex=0;
-	};
 
+		// The MCM, for the odd parts that are neither 0 nor 1
+		set<int64_t> targetSet;
+		for (int i=0; i< n; i++)	{
+			if(oddCoeff[i] > 1)
+				targetSet.insert(oddCoeff[i].get_si());
+		}
+
+		if(!targetSet.empty()) {
+			string adderGraphStr = AdderGraphSearch::compute(getTarget(), targetSet, wIn);
+			REPORT(INFO, "Shared adder graph for " << targetSet.size() << " distinct odd coefficients: " << adderGraphStr);
+
+			PAGSuite::adder_graph_t adderGraph;
+			adderGraph.quiet = (UserInterface::verbose < 3);
+			if(!adderGraph.parse_to_graph(adderGraphStr)) {
+				THROWERROR("Could not parse the adder graph " << adderGraphStr);
+			}
+			adderGraph.check_and_correct(adderGraphStr);
+
+			// The truncation error of an MCM output, in units of its LSB, is scaled by 2^(lsbIn+lsbInt+shift) in the sum
+			string truncationStr = "";
+			int log2Epsilon = -lsbIn - maxShift;
+			if(log2Epsilon >= 0) {
+				WordLengthCalculator wlc = WordLengthCalculator(adderGraph, wIn, ldexp(1.0, log2Epsilon));
+				map<pair<mpz_class, int>, vector<int> > wordSizeMap = wlc.optimizeTruncation();
+				IntConstMultShiftAdd_TYPES::TruncationRegister truncationReg(wordSizeMap);
+				truncationStr = truncationReg.convertToString();
+				REPORT(INFO, "  adder graph requires " << IntConstMultShiftAdd_TYPES::getGraphAdderCost(adderGraph, wIn, false)
+							 << " full adders, " << IntConstMultShiftAdd_TYPES::getGraphAdderCost(adderGraph, wIn, false, truncationReg)
+							 << " after truncation");
+			}
+
+			string outPortMap = "";
+			for(int64_t t : targetSet) {
+				outPortMap += string(outPortMap==""? "" : ",") + "R_c" + to_string(t) + "=>P" + to_string(t);
+			}
+			// The MCM is pipelined as any sub-component, the chain below is aligned on the cycles of its outputs
+			newInstance("IntConstMultShiftAdd", "MCM",
+									join("wIn=", wIn) + " graph=" + adderGraphStr
+									+ (truncationStr=="" ? "" : " truncations=" + truncationStr)
+									+ " sync_inout=false",
+									"X0=>X", outPortMap);
+		}
+
+		// Align each product on lsbInt, with its sign, and wrap it to wAcc bits
+		for (int i=0; i< n; i++)	{
+			if(oddCoeff[i]==0)
+				continue;
+			string p = (oddCoeff[i]==1 ? "X" : "P" + oddCoeff[i].get_str());
+			int wP = getSignalByName(p)->width();
+			// one more bit so that the negation can not overflow
+			vhdl << tab << declare(join("Px", i), wP+1) << " <= " << p << "(" << wP-1 << ") & " << p << ";" << endl;
+			vhdl << tab << declare(negative[i] ? getTarget()->adderDelay(wP+1) : 0.0, join("Pe", i), wP+1) << " <= "
+					 << (negative[i] ? "std_logic_vector(-signed(" + join("Px", i) + "))" : join("Px", i)) << ";" << endl;
+			int lsbP = lsbIn + lsbInt + shift[i]; // weight of the LSB of Pe_i
+			int wT; // the size of Pe_i aligned on lsbInt
+			ostringstream aligned;
+			if(lsbP >= lsbInt) {
+				wT = wP+1 + lsbP-lsbInt;
+				aligned << join("Pe", i) << (lsbP>lsbInt ? " & " + zg(lsbP-lsbInt) : "");
+			}
+			else {
+				int drop = min(lsbInt-lsbP, wP); // keep at least the sign bit
+				wT = wP+1 - drop;
+				aligned << join("Pe", i) << range(wP, drop);
+			}
+			vhdl << tab << declare(join("Pa", i), wT) << " <= " << aligned.str() << ";" << endl;
+			// the contribution of T_i is the adder of the chain that consumes it, so that each step of the chain fits in one cycle
+			vhdl << tab << declare(getTarget()->adderDelay(wAcc), join("T", i), wAcc) << " <= ";
+			if(wT >= wAcc)
+				vhdl << join("Pa", i) << range(wAcc-1, 0) << ";" << endl;
+			else
+				vhdl << "(" << wAcc-1 << " downto " << wT << " => " << join("Pa", i) << "(" << wT-1 << ")) & " << join("Pa", i) << ";" << endl;
+		}
+
+		// The transposed chain is not pipelined: each S_i is registered into Sd_i, scheduled in the cycle of S_i,
+		// and the scheduler delays T_i or Sd_{i+1} to the latest of the two cycles, which preserves the functional delay
+		disablePipelining();
+		if(oddCoeff[n-1]==0)
+			vhdl << tab << declare(join("S", n-1), wAcc) << " <= " << zg(wAcc) << ";" << endl;
+		else
+			vhdl << tab << declare(join("S", n-1), wAcc) << " <= " << join("T", n-1) << ";" << endl;
+		for (int i=n-2; i>=0; i--)	{
+			addFeedbackRegister(join("Sd", i+1), join("S", i+1), join("S", i+1), Signal::syncReset);
+			vhdl << tab << declare(join("S", i), wAcc) << " <= ";
+			if(oddCoeff[i]==0)
+				vhdl << join("Sd", i+1) << ";" << endl;
+			else
+				vhdl << join("T", i) << " + " << join("Sd", i+1) << ";" << endl;
+		}
+
+		enablePipelining();
+
+		// The final rounding
+		int wOut = msbOut - lsbOut + 1;
+		vhdl << tab << declare(getTarget()->adderDelay(wOut+1), "Yrounded", wOut+1) << " <= (S0" << range(wAcc-1, g-1) << ") + (" << zg(wOut) << " & \"1\");" << endl;
+		addOutput("R", wOut, true);
+		vhdl << tab << "R <= Yrounded" << range(wOut, 1) << ";" << endl;
+#else
+		THROWERROR("The transposed architecture requires PAGSuite: please build FloPoCo with PAGLIB, RPAGLIB and ScaLP");
+#endif
+	}
 
 
 
@@ -276,14 +469,51 @@ namespace flopoco {
 		UserInterface::parseInt(args, "symmetry", &symmetry);
 		bool rescale;
 		UserInterface::parseBoolean(args, "rescale", &rescale);
+		bool transposed;
+		UserInterface::parseBoolean(args, "transposed", &transposed);
 		vector<string> coeffs;
 		UserInterface::parseColonSeparatedStringList(args, "coeff", &coeffs);
 
-		OperatorPtr tmpOp = new FixFIR(parentOp, target, lsbIn, lsbOut, coeffs, symmetry, rescale);
+		OperatorPtr tmpOp = new FixFIR(parentOp, target, lsbIn, lsbOut, coeffs, symmetry, rescale, transposed);
 
 		return tmpOp;
 	}
 
+	TestList FixFIR::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+
+		if(index==-1) 	{ // The unit tests
+			const vector<string> coeffs = {
+				"\"0.5:0.25:0.125\"",
+				"\"sin(pi/5):-cos(pi/7):0.3:0:-0.0625\""
+			};
+			for(auto c: coeffs) {
+				for(int lsb=-4; lsb>-16; lsb-=5) {
+					paramList.clear();
+					paramList.push_back(make_pair("lsbIn",  to_string(lsb)));
+					paramList.push_back(make_pair("lsbOut", to_string(lsb)));
+					paramList.push_back(make_pair("coeff",  c));
+					paramList.push_back(make_pair("TestBench n=",  "1000"));
+					testStateList.push_back(paramList);
+#if defined(HAVE_PAGLIB) && defined(HAVE_RPAGLIB) && defined(HAVE_SCALP)
+					// the same filters in transposed form
+					paramList.push_back(make_pair("transposed", "true"));
+					testStateList.push_back(paramList);
+#endif
+				}
+			}
+		}
+		else
+		{
+				// finite number of random test computed out of index
+		}
+
+		return testStateList;
+	}
+
 	void FixFIR::registerFactory(){
 		UserInterface::add("FixFIR", // name
 											 "A fix-point Finite Impulse Filter generator.",
@@ -293,9 +523,11 @@ namespace flopoco {
 											 lsbOut(int): integer size in bits;								\
            						 symmetry(int)=0: 0 for normal filter, 1 for symmetric, -1 for antisymmetric. If not 0, only the first half of the coeff list is used.; \
                        rescale(bool)=false: If true, divides all coefficients by 1/sum(|coeff|);\
+                       transposed(bool)=false: If true, builds a transposed-form filter where all the taps share one RPAG multiple-constant multiplier (requires PAGSuite). It does not support symmetry;\
                        coeff(string): colon-separated list of real coefficients using Sollya syntax. Example: coeff=\"1.234567890123:sin(3*pi/8)\"",
 											 "For more details, see <a href=\"bib/flopoco.html#DinIstoMas2014-SOPCJR\">this article</a>.",
-											 FixFIR::parseArguments
+											 FixFIR::parseArguments,
+											 FixFIR::unitTest
 											 ) ;
 	}
 
@@ -23,8 +23,14 @@ namespace flopoco{
 		 *						If rescale=false, the msb of the output is computed so as to avoid overflow.
 		 *						If rescale=true, all the coefficients are rescaled by 1/sum(|coeffs|).
 		 * This way the output is also in [-1,1], output size is equal to input size, and the output signal makes full use of the output range.
+		 * @param transposed
+		 *						If transposed=false, the filter is a shift register feeding a FixSOPC.
+		 *						If transposed=true, the filter is built in transposed form: the input is multiplied by all the coefficients
+		 *						in a single multiple-constant multiplier (an RPAG adder graph), and the products are accumulated in a chain of registered adders.
+		 *						This requires PAGSuite (PAGLIB, RPAGLIB and ScaLP).
+		 *						It does not support symmetry, since equal coefficients already share their product.
 		*/
-		FixFIR(OperatorPtr parentOp, Target* target, int lsbIn, int lsbOut, vector<string> coeff, int symmetry=0, bool rescale=false);
+		FixFIR(OperatorPtr parentOp, Target* target, int lsbIn, int lsbOut, vector<string> coeff, int symmetry=0, bool rescale=false, bool transposed=false);
 
 		/**
 		 * @brief 				empty constructor, to be called by subclasses.
@@ -45,6 +51,7 @@ namespace flopoco{
 		/** Factory method */
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
 		static void registerFactory();
+		static TestList unitTest(int index);
 
 	protected:
 		/**
@@ -64,6 +71,12 @@ namespace flopoco{
 		 */
 		void buildVHDLSymmetric();
 
+		/**
+		 * @brief The transposed-form architecture, where all the taps share one multiple-constant multiplier.
+		 *        Called by buildVHDL() once msbOut is known.
+		 */
+		void buildVHDLTransposed();
+
 		int n;								/**< number of taps */
 		int lsbIn;							/**< lsbIn of the filter */
 		int lsbOut;							/**< lsbOut of the filter */
@@ -72,6 +85,7 @@ namespace flopoco{
 		vector<string> coeffSymmetric;	  	/**< the coefficients as strings, in case of a symmetric filter */
 		int symmetry;					/**< flag that shows if the filter is implemented as a symmetric filter */
 		bool rescale; 						/**< if true, the output is rescaled to [-1,1]  (to the same format as input) */
+		bool transposed; 					/**< if true, the filter is built in transposed form around a shared MCM adder graph */
 	private:
 		mpz_class xHistory[10000]; 			// history of x used by emulate
 		int currentIndex;
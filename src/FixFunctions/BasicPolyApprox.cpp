@@ -17,23 +17,49 @@
 
 #include "BasicPolyApprox.hpp"
 #include "../UserInterface.hpp"
+#include "../BuildCache.hpp"
 #include <string>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
 namespace flopoco{
 
+	/** Sollya prints the numbers in hexadecimal exactly, which is what we want in a cache key */
+	static string sollyaToExactString(sollya_obj_t objS) {
+		sollya_obj_t displayS = sollya_lib_get_display();
+		sollya_obj_t hexadecimalS = sollya_lib_hexadecimal();
+		sollya_lib_set_display(hexadecimalS);
+		size_t size = sollya_lib_snprintf(NULL, 0, "%b", objS);
+		vector<char> buffer(size+1);
+		sollya_lib_snprintf(buffer.data(), size+1, "%b", objS);
+		sollya_lib_set_display(displayS);
+		sollya_lib_clear_obj(hexadecimalS);
+		sollya_lib_clear_obj(displayS);
+		string r(buffer.data());
+		replace(r.begin(), r.end(), '\n', ' ');
+		replace(r.begin(), r.end(), '\t', ' ');
+		return r;
+	}
+
+	/** A double, printed so that it reads back to the same value */
+	static string to_string_exact(double x) {
+		ostringstream o;
+		o << setprecision(17) << x;
+		return o.str();
+	}
 
 	BasicPolyApprox::BasicPolyApprox(FixFunction *f_, double targetAccuracy, int addGuardBits):
 		f(f_)
 	{
 		needToFreeF = false;
 		initialize();
-		buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);
-		buildFixFormatVector();
+		buildCached("accuracy " + to_string_exact(targetAccuracy) + " guardBits " + to_string(addGuardBits) + " " + functionKey(),
+								[&]() {buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);});
 	}
 
 
@@ -43,8 +69,8 @@ namespace flopoco{
 		f = new FixFunction(sollyaString_, signedIn);
 		needToFreeF = true;
 		initialize();
-		buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);
-		buildFixFormatVector();
+		buildCached("accuracy " + to_string_exact(targetAccuracy) + " guardBits " + to_string(addGuardBits) + " " + functionKey(),
+								[&]() {buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);});
 	}
 
 
@@ -54,8 +80,8 @@ namespace flopoco{
 		f = new FixFunction(fS_,signedIn);
 		needToFreeF = true;
 		initialize();
-		buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);
-		buildFixFormatVector();
+		buildCached("accuracy " + to_string_exact(targetAccuracy) + " guardBits " + to_string(addGuardBits) + " " + functionKey(),
+								[&]() {buildApproxFromTargetAccuracy(targetAccuracy,  addGuardBits);});
 	}
 
 	BasicPolyApprox::BasicPolyApprox(sollya_obj_t fS_, int degree_, int lsb_, bool signedIn):
@@ -64,8 +90,18 @@ namespace flopoco{
 		f = new FixFunction(fS_, signedIn);
 		needToFreeF = true;
 		initialize();
-		buildApproxFromDegreeAndLSBs();
-		buildFixFormatVector();
+		buildCached("degree " + to_string(degree) + " LSB " + to_string(LSB) + " " + functionKey(),
+								[&]() {buildApproxFromDegreeAndLSBs();});
+	}
+
+
+
+	BasicPolyApprox::BasicPolyApprox(int degree_, int LSB_, double approxErrorBound_, vector<FixConstant*> coeff_):
+		degree(degree_), coeff(coeff_), approxErrorBound(approxErrorBound_), LSB(LSB_)
+	{
+		f = nullptr;
+		needToFreeF = false;
+		initialize();
 	}
 
 
@@ -85,6 +121,26 @@ namespace flopoco{
 		srcFileName="BasicPolyApprox"; // should be somehow static but this is too much to ask me -> Matei: typeid() should solve this; note: the name is mangled, so some compiler-specific function to demangle the name is needed
 		fixedS = sollya_lib_fixed();
 		absoluteS = sollya_lib_absolute();
+		polynomialS = NULL; // remains so if the approximation comes from the cache
+	}
+
+
+
+	string BasicPolyApprox::functionKey() {
+		return "f " + sollyaToExactString(f->fS) + " on " + sollyaToExactString(f->inputRangeS);
+	}
+
+
+	void BasicPolyApprox::buildCached(string key, std::function<void()> compute) {
+		string value = BuildCache::lookupValue("BasicPolyApprox", key);
+		if(value != "") {
+			REPORT(DETAILED, "Polynomial approximation found in the cache");
+			parse(value, degree, LSB, approxErrorBound, coeff);
+			return;
+		}
+		compute();
+		buildFixFormatVector();
+		BuildCache::storeValue("BasicPolyApprox", key, serialize());
 	}
 
 
@@ -99,7 +155,8 @@ namespace flopoco{
 		if(needToFreeF)	free(f);
 
 		// clear other attributes
-		sollya_lib_clear_obj(polynomialS);
+		if(polynomialS != NULL)
+			sollya_lib_clear_obj(polynomialS);
 		//	  sollya_lib_clear_obj(S);
 		if(coeff.size()!=0){
 			for (unsigned int i=0; i<coeff.size(); i++)
@@ -113,6 +170,12 @@ namespace flopoco{
 
 	// This is a static (class) method.
 	void BasicPolyApprox::guessDegree(sollya_obj_t fS, sollya_obj_t inputRangeS, double targetAccuracy, int* degreeInfP, int* degreeSupP) {
+		string key = "guessdegree " + to_string_exact(targetAccuracy) + " f " + sollyaToExactString(fS) + " on " + sollyaToExactString(inputRangeS);
+		string cached = BuildCache::lookupValue("BasicPolyApprox", key);
+		if(cached != "") {
+			istringstream(cached) >> *degreeInfP >> *degreeSupP;
+			return;
+		}
 		// Accuracy has to be converted to sollya objects
 		// a few constant objects
 		if(DETAILED <= UserInterface::verbose)
@@ -146,6 +209,8 @@ namespace flopoco{
 		sollya_lib_clear_obj(degreeIntervalS);
 		sollya_lib_clear_obj(degreeInfS);
 		sollya_lib_clear_obj(degreeSupS);
+
+		BuildCache::storeValue("BasicPolyApprox", key, to_string(*degreeInfP) + " " + to_string(*degreeSupP));
 	}
 
 	OperatorPtr BasicPolyApprox::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args)
@@ -405,6 +470,77 @@ g(int)=-1: the number of guardbits added. Using -1 gives sensible default",
 		return debugstring.str();
 	}
 
+
+	string BasicPolyApprox::serialize(){
+		ostringstream o;
+		o << degree << " " << LSB << " " << to_string_exact(approxErrorBound);
+		for (int i=0; i<=degree; i++)
+			o << " " << coeff[i]->MSB << " " << coeff[i]->LSB << " " << coeff[i]->getConstantAsMPZ();
+		return o.str();
+	}
+
+
+	void BasicPolyApprox::parse(string s, int &degree, int &LSB, double &approxErrorBound, vector<FixConstant*> &coeff){
+		istringstream in(s);
+		string error;
+		in >> degree >> LSB >> error;
+		approxErrorBound = strtod(error.c_str(), NULL); // strtod also parses inf
+		for (int i=0; i<=degree; i++) {
+			int msb, lsb;
+			mpz_class c;
+			in >> msb >> lsb >> c;
+			coeff.push_back(new FixConstant(msb, lsb, true/*signed*/, c));
+		}
+	}
+
+
+	BasicPolyApprox* BasicPolyApprox::deserialize(string s){
+		int degree, LSB;
+		double approxErrorBound;
+		vector<FixConstant*> coeff;
+		parse(s, degree, LSB, approxErrorBound, coeff);
+		return new BasicPolyApprox(degree, LSB, approxErrorBound, coeff);
+	}
+
+
+	vector<BasicPolyApprox*> BasicPolyApprox::buildApproximations(std::function<sollya_obj_t(int)> g, int n, int degree, int LSB, double targetAccuracy){
+		vector<BasicPolyApprox*> p(n, nullptr);
+		int failed = -1;
+		forkMap(n, UserInterface::workers,
+						[&](int i) {
+							sollya_obj_t giS = g(i);
+							BasicPolyApprox* pi = new BasicPolyApprox(giS, degree, LSB, true);
+							sollya_lib_clear_obj(giS);
+							string result = pi->serialize();
+							delete pi;
+							return result;
+						},
+						[&](int i, string result) {
+							p[i] = deserialize(result);
+							if(p[i]->getApproxErrorBound() > targetAccuracy) {
+								failed = i;
+								return false;
+							}
+							return true;
+						});
+		if(failed < 0)
+			return p;
+
+		// The computed approximations before the failed one, then the failed one
+		vector<BasicPolyApprox*> r;
+		for (int i=0; i<failed; i++) {
+			if(p[i] != nullptr)
+				r.push_back(p[i]);
+		}
+		r.push_back(p[failed]);
+		for (int i=failed+1; i<n; i++) {
+			if(p[i] != nullptr)
+				delete p[i];
+		}
+		return r;
+	}
+
+
 	// should be computed by one of the constructors, but never set otherwise
 	int  BasicPolyApprox::getDegree(){
 		return degree;
@@ -6,6 +6,7 @@
 
 #include <sollya.h>
 #include <gmpxx.h>
+#include <functional>
 
 #include "../Operator.hpp" // mostly for reporting
 #include "../UserInterface.hpp"
@@ -124,11 +125,41 @@ namespace flopoco{
 		 */
 		static	void guessDegree(sollya_obj_t fS, sollya_obj_t rangeS, double targetAccuracy, int* degreeInfP, int* degreeSupP);
 		string report();
+
+		/** The approximation as a one-line string: degree, LSB, approximation error bound,
+				then the MSB, LSB and value (an integer, to be scaled by 2^LSB) of each coefficient */
+		string serialize();
+
+		/** The converse of serialize(). Beware, as for the constructor from coefficients, f is un-initialized */
+		static BasicPolyApprox* deserialize(string s);
+
+		/** Builds the approximations of g(0) ... g(n-1) on [-1,1], of degree degree and coefficient LSB LSB,
+				computing them in parallel in UserInterface::workers processes.
+				@param g builds the (sollya) function to approximate on subinterval i. It is called in the worker processes.
+				@return on success, the n approximations, in order.
+				As soon as one of them has an approximation error bound larger than targetAccuracy, the others are cancelled:
+				the returned vector then ends with this failed approximation, and may miss some of the previous ones.
+		*/
+		static vector<BasicPolyApprox*> buildApproximations(std::function<sollya_obj_t(int)> g, int n, int degree, int LSB, double targetAccuracy);
 	private:
+		/** The constructor used by deserialize() */
+		BasicPolyApprox(int degree, int LSB, double approxErrorBound, vector<FixConstant*> coeff);
+
+		/** Parses the output of serialize() */
+		static void parse(string s, int &degree, int &LSB, double &approxErrorBound, vector<FixConstant*> &coeff);
+
 		/** initialization of various constant objects for Sollya
 		 * */
 		void initialize();
 
+		/** The part of the cache key that describes the function to approximate and its input range: printed by Sollya in hexadecimal, hence exact */
+		string functionKey();
+
+		/** Reads this approximation from the cache, or computes it with compute() then stores it in the cache.
+				The cache is only used with the generic option cache= (see BuildCache::lookupValue()):
+				Sollya is slow, and we keep regenerating the same functions (e.g. for various frequencies) */
+		void buildCached(string key, std::function<void()> compute);
+
 		/** constructor code for the general case factored out
 		 * */
 		void buildApproxFromTargetAccuracy(double targetAccuracy, int addGuardBitsToConstant);
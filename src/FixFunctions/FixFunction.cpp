@@ -15,6 +15,7 @@
 */
 
 #include "FixFunction.hpp"
+#include "../utils.hpp"
 #include <sstream>
 
 namespace flopoco{
@@ -129,6 +130,7 @@ void	FixFunction::initialize()
 
 	void FixFunction::eval(mpfr_t r, mpfr_t x) const
 	{
+		std::lock_guard<std::recursive_mutex> lock(sollyaMutex);
 		sollya_lib_evaluate_function_at_point(r, fS, x, NULL);
 	}
 
@@ -140,7 +142,10 @@ void	FixFunction::initialize()
 
 		mpfr_inits(mpX, mpR, NULL);
 		mpfr_set_d(mpX, x, GMP_RNDN);
-		sollya_lib_evaluate_function_at_point(mpR, fS, mpX, NULL);
+		{
+			std::lock_guard<std::recursive_mutex> lock(sollyaMutex);
+			sollya_lib_evaluate_function_at_point(mpR, fS, mpX, NULL);
+		}
 		r = mpfr_get_d(mpR, GMP_RNDN);
 
 		mpfr_clears(mpX, mpR, NULL);
@@ -151,6 +156,7 @@ void	FixFunction::initialize()
 	void FixFunction::eval(mpz_class x, mpz_class &rNorD, mpz_class &ru, bool correctlyRounded) const
 	{
 		int precision=100*(wIn+wOut);
+		std::lock_guard<std::recursive_mutex> lock(sollyaMutex); // the precision set below is global to Sollya
 		sollya_lib_set_prec(sollya_lib_constant_from_int(precision));
 
 		mpfr_t mpX, mpR;
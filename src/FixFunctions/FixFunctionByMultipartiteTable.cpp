@@ -102,7 +102,6 @@ namespace flopoco
 
 		// Outer loop on guardBitSlack;
 		guardBitsSlack =-1; // first  try the exploration with one guard bit less than the safe value
-		Multipartite* bestMP;
 		bool successWithguardBitsSlack = false;
 		int rank;
 		while (guardBitsSlack<=0 && !successWithguardBitsSlack) {
@@ -135,31 +134,9 @@ namespace flopoco
 			}
 
 			// Parameter space exploration complete. Now checking the results
-			rank = 0 ;
-			bool tryAgain = true;
-			while (rank < ten && tryAgain) {
-				// time to report
-				bestMP = topTen[rank];
-				if(bestMP->totalSize==sizeMax) { // This is one of the dummy mpts
-					tryAgain=false;
-				}
-				else {						
-					REPORT(INFO, "Now running exhaustive test on candidate #" << rank << " :" << endl
-								 << tab << bestMP->descriptionString() << endl
-								 << tab<< bestMP->descriptionStringLaTeX()  );
-					bestMP->mkTables(target);
-					if (bestMP->exhaustiveTest()) {
-						REPORT(INFO, "... passed, now building the operator");
-						tryAgain = false;
-					}
-					else {
-						REPORT(INFO, "... failed, trying next candidate");
-						rank++;
-					}
-				}
-			}
-				
-			if(rank==ten || bestMP->totalSize==sizeMax) {
+			rank = checkCandidates();
+
+			if(rank==ten) {
 				REPORT(INFO, "It seems we have to use the safe value of g... starting again");
 				for (int i=0; i<ten; i++){
 					topTen[i]-> totalSize =	sizeMax; 
@@ -178,6 +155,7 @@ namespace flopoco
 		// Exploration complete. Now building the operator
 
 		bestMP = topTen[rank];
+		bestMP->mkTables(target); // the exhaustive test may have built them in another process
 
 		REPORT(DEBUG,"Full table dump:" <<endl << bestMP->fullTableDump()); 
 
@@ -297,6 +275,21 @@ namespace flopoco
 		f->emulate(tc);
 	}
 
+
+	bool FixFunctionByMultipartiteTable::emulateReference(TestCase* tc)
+	{
+		int x = tc->getInputValue("X").get_si();
+		int64_t y = bestMP->architectureOutput(x) & ((int64_t(1) << bestMP->outputSize) - 1);
+		tc->addExpectedOutput("Y", mpz_class((long) y));
+		return true;
+	}
+
+
+	bool FixFunctionByMultipartiteTable::hasThreadSafeEmulate()
+	{
+		return true;
+	}
+
 	//------------------------------------------------------------------------------------ Private classes
 	
 	// enumerating the alphas is much simpler
@@ -601,6 +594,77 @@ namespace flopoco
 
 
 	
+	void FixFunctionByMultipartiteTable::buildReferenceValues()
+	{
+		if(!referenceValues.empty()) // already computed for a previous value of guardBitsSlack
+			return;
+		int lsbIn = f->lsbIn;
+		int inputSize = f->wIn;
+		int chunkSize = min(inputSize, 14);
+		int nbChunks = 1 << (inputSize-chunkSize);
+		referenceValues = vector<double>(int64_t(1) << inputSize);
+		REPORT(DETAILED, "Computing the " << referenceValues.size() << " reference values");
+		// Sollya is not reentrant, hence worker processes. The doubles are transmitted exactly, in hexadecimal
+		forkMap(nbChunks, UserInterface::workers,
+						[&](int c) {
+							ostringstream result;
+							char buffer[32];
+							for(int64_t x = int64_t(c) << chunkSize; x < int64_t(c+1) << chunkSize; x++) {
+								snprintf(buffer, sizeof(buffer), " %a", f->eval(ldexp((double)x, lsbIn)));
+								result << buffer;
+							}
+							return result.str();
+						},
+						[&](int c, string result) {
+							const char* p = result.c_str();
+							char* end;
+							for(int64_t x = int64_t(c) << chunkSize; x < int64_t(c+1) << chunkSize; x++) {
+								referenceValues[x] = strtod(p, &end);
+								p = end;
+							}
+							return true;
+						});
+	}
+
+
+
+	int FixFunctionByMultipartiteTable::checkCandidates()
+	{
+		buildReferenceValues();
+		int sizeMax = f->wOut<<f->wIn;
+		int nbCandidates = 0;
+		while(nbCandidates<ten && topTen[nbCandidates]->totalSize < sizeMax) // the others are the dummy ones
+			nbCandidates++;
+
+		// Each candidate builds its tables and runs its exhaustive test in a worker process.
+		// As soon as a candidate passed and all the smaller ones failed, the remaining ones are dominated: cancel them.
+		vector<int> passed(nbCandidates, -1); // -1: unknown, 0: failed, 1: passed
+		int best = ten;
+		forkMap(nbCandidates, UserInterface::workers,
+						[&](int r) {
+							REPORT(INFO, "Now running exhaustive test on candidate #" << r << " :" << endl
+										 << tab << topTen[r]->descriptionString() << endl
+										 << tab<< topTen[r]->descriptionStringLaTeX()  );
+							topTen[r]->mkTables(getTarget());
+							return string(topTen[r]->exhaustiveTest() ? "1" : "0");
+						},
+						[&](int r, string result) {
+							passed[r] = (result=="1" ? 1 : 0);
+							REPORT(INFO, "... candidate #" << r << (passed[r]==1 ? " passed" : " failed"));
+							int k = 0;
+							while(k<nbCandidates && passed[k]==0)
+								k++;
+							if(k<nbCandidates && passed[k]==1) {
+								best = k;
+								return false;
+							}
+							return true;
+						});
+		return best;
+	}
+
+
+
 	/** 5th equation implementation */
 	double FixFunctionByMultipartiteTable::epsilon(int ci_, int gammai, int betai, int pi)
 	{
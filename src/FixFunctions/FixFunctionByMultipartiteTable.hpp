@@ -45,6 +45,10 @@ namespace flopoco
 		//---------------------------------------Public standard methods
 		void buildStandardTestCases(TestCaseList* tcl);
 		void emulate(TestCase * tc);
+		/** bit-exact model of the generated tables and bit heap */
+		bool emulateReference(TestCase * tc);
+		/** both only read the tables and the function, which holds sollyaMutex */
+		bool hasThreadSafeEmulate();
 		static TestList unitTest(int index);
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args);
 		static void registerFactory();
@@ -70,6 +74,17 @@ namespace flopoco
 		 */
 		bool enumerateDec();
 
+		/**
+		 * @brief buildReferenceValues : evaluates f on the whole input space once, in parallel, for the exhaustive tests of the candidates
+		 */
+		void buildReferenceValues();
+
+		/**
+		 * @brief checkCandidates : runs the exhaustive tests of the candidates of topTen concurrently
+		 * @return the rank of the smallest candidate that passed, or ten if none passed
+		 */
+		int checkCandidates();
+
 
 		/** Some needed methods, extracted from the article */
 
@@ -92,10 +107,12 @@ namespace flopoco
 		bool compressTIV; /**< use Hsiao TIV compression or not */
 		vector<vector<vector<double>>> oneTableError;   /** for nbTOi fixed, the errors of each possible table configuration, precomputed  here to speed up exploration  */
 		vector<vector<int>> gammaiMin;  /** for nbTOi fixed, the min value of gamma, precomputed  here to speed up exploration */
+		vector<double> referenceValues; /**< f(x) for every input x, shared by the exhaustive tests of all the candidates */
 
 	private:
 		const int ten=10;
 		vector<Multipartite*> topTen; /**< the top 10 best candidates (for some value of ten), sorted by size */ 
+		Multipartite* bestMP; /**< the candidate actually implemented, one of topTen */
 		int guardBitsSlack; /* this allows first to try the exploration with one guard bit less than the safe value */ 
 		void insertInTopTen(Multipartite* mp);
 	};
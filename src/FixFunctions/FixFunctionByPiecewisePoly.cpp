@@ -66,7 +66,7 @@ namespace flopoco{
 
 
 	FixFunctionByPiecewisePoly::FixFunctionByPiecewisePoly(OperatorPtr parentOp, Target* target, string func, int lsbIn_, int lsbOut_, int degree_, bool finalRounding_, double approxErrorBudget_):
-		Operator(parentOp, target), degree(degree_), lsbIn(lsbIn_), lsbOut(lsbOut_), finalRounding(finalRounding_), approxErrorBudget(approxErrorBudget_){
+		Operator(parentOp, target), degree(degree_), lsbIn(lsbIn_), lsbOut(lsbOut_), horner(NULL), finalRounding(finalRounding_), approxErrorBudget(approxErrorBudget_){
 
 		srcFileName="FixFunctionByPiecewisePoly";
 		setNameWithFreqAndUID("FixFunctionByPiecewisePoly"); 
@@ -158,7 +158,7 @@ namespace flopoco{
 			inPortMap(join("A",i),  join("A",i));
 		}
 		outPortMap("R", "HornerOutput");
-		OperatorPtr h = new  FixHornerEvaluator(this, target, 
+		horner = new  FixHornerEvaluator(this, target, 
 																						lsbIn+alpha+1,
 																						msbOut,
 																						lsbOut,
@@ -166,7 +166,7 @@ namespace flopoco{
 																						// do we need to pass the constant signs of the coefficients? No, they have been added back
 																						// and everybody is signed.
 																						);
-		vhdl << instance(h, "Horner", false);
+		vhdl << instance(horner, "Horner", false);
 			
 		vhdl << tab << "Y <= " << "std_logic_vector(HornerOutput);" << endl;
 
@@ -233,6 +233,52 @@ namespace flopoco{
 		f->emulate(tc);
 	}
 
+
+
+	bool FixFunctionByPiecewisePoly::emulateReference(TestCase* tc){
+		if(horner==NULL || !horner->isNativeEvaluationPossible())
+			return false;
+		int wX=-lsbIn;
+		int wZ=wX-alpha;
+		mpz_class svX = tc->getInputValue("X");
+		int64_t x = svX.get_si(); // TestBench exhaustive inputs are at most 40 bits
+		int64_t a = x >> wZ;
+		int64_t z = x & ((int64_t(1)<<wZ) -1);
+		// Zs is Z with its MSB inverted, read as a signed number
+		int64_t zs = z ^ (int64_t(1)<<(wZ-1));
+		if(zs >= (int64_t(1)<<(wZ-1)))
+			zs -= int64_t(1)<<wZ;
+
+		// Split the table output as the VHDL does, adding back the constant signs
+		vector<int64_t> coeffs(degree+1);
+		mpz_class entry = coeffTableVector[a];
+		for(int i=degree; i>=0; i--) {
+			int size = pwp->MSB[i] - pwp->LSB +1;
+			int actualSize = size - (pwp->coeffSigns[i]==0 ? 0 : 1);
+			mpz_class c = entry & ((mpz_class(1)<<actualSize) -1);
+			entry >>= actualSize;
+			if(pwp->coeffSigns[i]==-1)
+				c += mpz_class(1)<<actualSize;
+			int64_t ci = c.get_si();
+			if(ci >= (int64_t(1)<<(size-1)))
+				ci -= int64_t(1)<<size;
+			coeffs[i] = ci;
+		}
+
+		int64_t r;
+		if(!horner->evaluateNative(zs, coeffs, r))
+			THROWERROR("emulateReference: overflow in the Horner datapath for X=" << svX);
+		int wOut = msbOut-lsbOut+1;
+		tc->addExpectedOutput("Y", mpz_class((long) (r & ((int64_t(1)<<wOut) -1))));
+		return true;
+	}
+
+
+
+	bool FixFunctionByPiecewisePoly::hasThreadSafeEmulate(){
+		return true;
+	}
+
 	void FixFunctionByPiecewisePoly::buildStandardTestCases(TestCaseList* tcl){
 		TestCase *tc;
 
@@ -12,6 +12,7 @@
 
 namespace flopoco{
 
+	class FixHornerEvaluator;
 
 	/** The FixFunctionByPiecewisePoly class */
 	class FixFunctionByPiecewisePoly : public Operator
@@ -44,6 +45,13 @@ namespace flopoco{
 		
 		void emulate(TestCase * tc);
 
+		/** Bit-exact model of the architecture, replaying the coefficient table and the Horner datapath on native integers.
+				With TestBench exhaustive=true simulate=false, it checks the whole error analysis (and the absence of overflow) without a VHDL simulator */
+		bool emulateReference(TestCase * tc);
+
+		/** emulate() goes through the function, which holds sollyaMutex, and emulateReference() only reads the operator */
+		bool hasThreadSafeEmulate();
+
 		void buildStandardTestCases(TestCaseList* tcl);
 
 		static TestList unitTest(int index);
@@ -62,6 +70,7 @@ namespace flopoco{
 		int lsbOut;
 		int alpha;
 		UniformPiecewisePolyApprox *pwp;
+		FixHornerEvaluator *horner;       /**< the Horner evaluator, NULL for degree 0 */
 		int polyTableOutputSize;
 		FixFunction *f;
 		bool finalRounding;
@@ -86,6 +86,7 @@ namespace flopoco{
 	{
 		initialize();
 		computeArchitecturalParameters();
+		checkNativeFormats();
 		generateVHDL();
 	}
 
@@ -343,6 +344,90 @@ namespace flopoco{
 
 
 
+
+
+	/* The native evaluation works on integers of weight 2^lsb, in 128-bit arithmetic.
+		 All the intermediate values, before being wrapped to their format, must fit on less than 127 bits
+		 (the products being the largest). The interface uses int64_t. */
+	
+#define NATIVE_MAX_WIDTH 126
+
+	void FixHornerEvaluator::checkNativeFormats(){
+		int maxWidth=0, maxIOWidth=1-lsbIn;
+		// a resize from (oldMSB, oldLSB) to (MSB, LSB) goes through the union of both formats
+		auto resizeWidth = [](int oldMSB, int oldLSB, int MSB, int LSB) {
+			return max(oldMSB, MSB) - min(oldLSB, LSB) + 1;
+		};
+		maxIOWidth = max(maxIOWidth, msbOut-lsbOut+1);
+		for(int i=0; i<=degree; i++) {
+			maxIOWidth = max(maxIOWidth, coeffMSB[i]-coeffLSB[i]+1);
+		}
+		maxWidth = resizeWidth(coeffMSB[degree], coeffLSB[degree], wcSumMSB[degree], wcSumLSB[degree]);
+		for(int i=degree-1; i>=0; i--) {
+			int pMSB = wcSumMSB[i+1] + 1;
+			int pLSB = wcYLSB[i] + wcSumLSB[i+1];
+			maxWidth = max(maxWidth, pMSB-pLSB+1);
+			maxWidth = max(maxWidth, resizeWidth(pMSB, pLSB, wcSumMSB[i], wcSumLSB[i]-1));
+			maxWidth = max(maxWidth, resizeWidth(coeffMSB[i], coeffLSB[i], wcSumMSB[i], wcSumLSB[i]-1));
+			maxWidth = max(maxWidth, wcSumMSB[i]-wcSumLSB[i]+3); // the sum of the two, and its carry
+		}
+		maxWidth = max(maxWidth, resizeWidth(wcSumMSB[0], wcSumLSB[0], msbOut, lsbOut));
+		nativeEvaluationPossible = (maxIOWidth<=63 && maxWidth<=NATIVE_MAX_WIDTH);
+		REPORT(DETAILED, "Native evaluation " << (nativeEvaluationPossible? "possible" : "impossible")
+					 << ": largest intermediate value on " << maxWidth << " bits");
+	}
+
+
+
+	bool FixHornerEvaluator::isNativeEvaluationPossible() const{
+		return nativeEvaluationPossible;
+	}
+
+
+
+	/** Wraps v to a signed integer of the given width, as the VHDL does; sets overflow if this changed its value */
+	static __int128 wrapNative(__int128 v, int width, bool &overflow){
+		__int128 half = ((__int128)1) << (width-1);
+		if(v < -half || v >= half) {
+			overflow = true;
+			v &= 2*half - 1;
+			if(v >= half)
+				v -= 2*half;
+		}
+		return v;
+	}
+
+	/** Same as Operator::resizeFixPoint() on an integer of weight 2^oldLSB: truncation on the right, wrap-around on the left */
+	static __int128 resizeNative(__int128 v, int oldLSB, int MSB, int LSB, bool &overflow){
+		if(LSB >= oldLSB)
+			v >>= (LSB-oldLSB); // arithmetic shift, i.e. truncation
+		else
+			v *= ((__int128)1) << (oldLSB-LSB);
+		return wrapNative(v, MSB-LSB+1, overflow);
+	}
+
+
+
+	bool FixHornerEvaluator::evaluateNative(int64_t y, const vector<int64_t> &a, int64_t &r) const{
+		if(!nativeEvaluationPossible)
+			THROWERROR("evaluateNative: the datapath is too wide for native evaluation");
+		bool overflow=false;
+		__int128 s = resizeNative(a[degree], coeffLSB[degree], wcSumMSB[degree], wcSumLSB[degree], overflow);
+		for(int i=degree-1; i>=0; i--) {
+			__int128 yTrunc = resizeNative(y, lsbIn, 0, wcYLSB[i], overflow);
+			int pMSB = wcSumMSB[i+1] + 1;
+			int pLSB = wcYLSB[i] + wcSumLSB[i+1];
+			__int128 p = wrapNative(yTrunc*s, pMSB-pLSB+1, overflow);
+			__int128 pTrunc = resizeNative(p, pLSB, wcSumMSB[i], wcSumLSB[i]-1, overflow);
+			__int128 aExt = (isZero[i] ? 0 : resizeNative(a[i], coeffLSB[i], wcSumMSB[i], wcSumLSB[i]-1, overflow));
+			__int128 sBeforeRound = wrapNative(aExt + pTrunc + 1, wcSumMSB[i]-wcSumLSB[i]+2, overflow);
+			s = resizeNative(sBeforeRound, wcSumLSB[i]-1, wcSumMSB[i], wcSumLSB[i], overflow);
+		}
+		r = (int64_t) resizeNative(s, wcSumLSB[0], msbOut, lsbOut, overflow);
+		return !overflow;
+	}
+
+
 	
 	FixHornerEvaluator::~FixHornerEvaluator(){}
 
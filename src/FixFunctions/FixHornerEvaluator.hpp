@@ -51,6 +51,18 @@ namespace flopoco{
 
 		
     ~FixHornerEvaluator();
+
+		/** Replays the datapath of generateVHDL() on native integers, bit-exact, including the truncations and wrap-arounds.
+				Useful for fast emulation, and for an exhaustive check of the error analysis.
+			 @param y the input Y, as a signed integer of weight 2^lsbIn
+			 @param a the coefficients A_0 to A_degree, as signed integers of weight 2^coeffLSB[i]
+			 @param r the output R, as a signed integer of weight 2^lsbOut
+			 @return false if some intermediate value did not fit its format: r is then the wrapped-around value of the hardware
+		*/
+		bool evaluateNative(int64_t y, const vector<int64_t> &a, int64_t &r) const;
+
+		/** Returns true if all the formats of the datapath are small enough for evaluateNative() */
+		bool isNativeEvaluationPossible() const;
 		
 
   private: // we also inherit attribute of FixPolyEval
@@ -61,12 +73,14 @@ namespace flopoco{
 		vector<int> wcSumLSB; /**< from 0 to degree */
 		vector<int> wcYLSB; /**< from 0 to degree-1*/
 		vector<bool> isZero; /*< a vector of size degree, true if all the coeffs of this degree are 0, avoids cornercase bugs*/
+		bool nativeEvaluationPossible; /**< true if evaluateNative() can replay the datapath on 128-bit integers */
 		//		vector <int>  wcProductMSB; /**< from 0 to degree */
 		//		vector <int>  wcProductLSB; /**< from 0 to degree-1 */
 
 		void initialize(); /**< initialization factored out between various constructors */ 
 		void computeArchitecturalParameters(); /**< error analysis that ensures the rounding budget is met */ 
 		void generateVHDL(); /**< generation of the VHDL once all the parameters have been computed */ 
+		void checkNativeFormats(); /**< sets nativeEvaluationPossible */
   };
 
 }
@@ -277,6 +277,7 @@ namespace flopoco
 		// The TOIs
 		//toi = vector<Table*>(m);
 		toi.clear();
+		negativeTOi.clear();
 		for(int i = 0; i < m; ++i)
 		{
 			vector<int64_t> values;
@@ -488,6 +489,52 @@ namespace flopoco
 
 	
 #define ETDEBUG 0
+	int64_t Multipartite::architectureOutput(int x){
+		int64_t result;
+		if(rho==-1) {
+			int a = x>>(inputSize-alpha);
+			int64_t yTIV = tiv[a];
+			result = yTIV;
+#if ETDEBUG 
+			cerr 	<< "  x=" << x<< " tiv=" << result;
+#endif
+		}
+		else { //compressed table
+			int aa = x>>(inputSize-rho);
+			int64_t yATIV = aTIV[aa];
+
+			int adiff = x>>(inputSize-alpha);
+			int64_t yDiffTIV = diffTIV[adiff];
+			result = (yATIV << nbZeroLSBsInATIV) + yDiffTIV;
+#if ETDEBUG 
+			cerr 	<< "  x=" << x<< " yaTIV=" << yATIV << " yDiffTIV=" << yDiffTIV ;
+#endif
+		}
+		for(int i=0; i<m; i++) {
+			int aTOi = (x>>pi[i]) & ((1<<betai[i])-1);
+			int sign = 1-(aTOi >> (betai[i]-1) );
+#if ETDEBUG 
+			cerr << "  aTO" << i << "I=" << aTOi << "  s=" << sign << "  ";
+#endif
+			aTOi = (aTOi & ((1<<(betai[i]-1))-1));
+			if(sign==1)
+				aTOi =  ((1<<(betai[i]-1))-1)  - aTOi; 
+			aTOi +=   ((x>>(inputSize-gammai[i])) << (betai[i]-1));
+			int64_t yTOi = toi[i][aTOi];
+#if ETDEBUG 
+			cerr << " aTO" << i << "F=" << aTOi << " yTOi="  << yTOi;
+#endif
+			if(negativeTOi[i])
+				sign=1-sign; 
+			if(sign==1)
+				yTOi = ~yTOi;
+			result += yTOi;
+		}
+		//final rounding
+		return result >> guardBits;
+	}
+
+
 	bool Multipartite::exhaustiveTest(){
 		double maxError=0;
 		double rulp=1;
@@ -498,52 +545,17 @@ namespace flopoco
 		if(lsbOut>0)
 			rulp =  (double) (1<<lsbOut);
 		for (int x=0; x<(1<<inputSize); x++) {
-			int64_t result;
-			if(rho==-1) {
-				int a = x>>(inputSize-alpha);
-				int64_t yTIV = tiv[a];
-				result = yTIV;
-#if ETDEBUG 
-				cerr 	<< "  x=" << x<< " tiv=" << result;
-#endif
-			}
-			else { //compressed table
-				int aa = x>>(inputSize-rho);
-				int64_t yATIV = aTIV[aa];
-
-				int adiff = x>>(inputSize-alpha);
-				int64_t yDiffTIV = diffTIV[adiff];
-				result = (yATIV << nbZeroLSBsInATIV) + yDiffTIV;
-#if ETDEBUG 
-				cerr 	<< "  x=" << x<< " yaTIV=" << yATIV << " yDiffTIV=" << yDiffTIV ;
-#endif
-			}
-			for(int i=0; i<m; i++) {
-				int aTOi = (x>>pi[i]) & ((1<<betai[i])-1);
-				int sign = 1-(aTOi >> (betai[i]-1) );
-#if ETDEBUG 
-				cerr << "  aTO" << i << "I=" << aTOi << "  s=" << sign << "  ";
-#endif
-				aTOi = (aTOi & ((1<<(betai[i]-1))-1));
-				if(sign==1)
-					aTOi =  ((1<<(betai[i]-1))-1)  - aTOi; 
-				aTOi +=   ((x>>(inputSize-gammai[i])) << (betai[i]-1));
-				int64_t yTOi = toi[i][aTOi];
-#if ETDEBUG 
-				cerr << " aTO" << i << "F=" << aTOi << " yTOi="  << yTOi;
-#endif
-				if(negativeTOi[i])
-					sign=1-sign; 
-				if(sign==1)
-					yTOi = ~yTOi;
-				result += yTOi;
-			}
-			//final rounding
-			result = result >> guardBits;
+			int64_t result = architectureOutput(x);
 			double fresult = ((double) result) * rulp;
-			double ref = f->eval(   ((double)x) / ((double)(1<<(-lsbIn))) );
+			double ref;
+			if(mpt->referenceValues.empty())
+				ref = f->eval(   ((double)x) / ((double)(1<<(-lsbIn))) );
+			else
+				ref = mpt->referenceValues[x];
 			double error = abs(fresult-ref);
 			maxError = max(maxError, error);
+			if(maxError >= rulp) // no need to go further
+				return false;
 #if ETDEBUG 
 			cerr //<< ((double)x) / ((double)(1<<(-lsbIn)))
 			  << "  sum=" << result<< " fresult=" << fresult << "ref=" <<ref << "   e=" << error << " u=" <<rulp << (error > rulp ? " *******  Error here":"") <<  endl;
@@ -53,6 +53,12 @@ namespace flopoco
 		 */
 		string 	fullTableDump(); 
 
+		/**
+		 * @brief architectureOutput(): bit-exact model of the architecture built from the tables, before truncation to outputSize bits
+		 * @param x : the input, as an integer
+		 */
+		int64_t architectureOutput(int x);
+
 		/**
 		 * @brief returns true if the architecture is correct; false if it exceeds the target error
 		 */
@@ -118,28 +118,31 @@ namespace flopoco{
 				nbIntervals = 1<<alpha;
 				alphaOK = true;
 				REPORT(DETAILED, " Testing alpha=" << alpha );
-				for (int i=0; i<nbIntervals; i++) {
-					// The worst case is typically on the left (i==0) or on the right (i==nbIntervals-1).
-					// To test these two first, we do this small rotation of i
-					int ii=(i+nbIntervals-1) & ((1<<alpha)-1);
-
-					// First build g_i(x) = f(2^(-alpha)*x + i*2^(-alpha))
-					sollya_obj_t giS = buildSubIntervalFunction(fS, alpha, ii);
-
-					if(DEBUG <= UserInterface::verbose)
-						sollya_lib_printf("> UniformPiecewisePolyApprox: alpha=%d, ii=%d, testing  %b \n", alpha, ii, giS);
-					// Now what degree do we need to approximate gi?
-					int degreeInf, degreeSup;
-					BasicPolyApprox::guessDegree(giS, rangeS, targetAccuracy, &degreeInf, &degreeSup);
-					// REPORT(DEBUG, " guessDegree returned (" << degreeInf <<  ", " << degreeSup<<")" ); // no need to report, it is done by guessDegree()
-					sollya_lib_clear_obj(giS);
-					// For now we only consider degreeSup. Is this a TODO?
-					if(degreeSup>degree) {
-						REPORT(DEBUG, "   alpha=" << alpha << " failed." );
-						alphaOK=false;
-						break;
-					}
-				} // end for loop on i
+				// The subintervals are tested in parallel (see forkMap()), the first failure cancels the others
+				alphaOK = forkMap(nbIntervals, UserInterface::workers,
+													[&](int i) {
+														// The worst case is typically on the left (i==0) or on the right (i==nbIntervals-1).
+														// To test these two first, we do this small rotation of i
+														int ii=(i+nbIntervals-1) & ((1<<alpha)-1);
+
+														// First build g_i(x) = f(2^(-alpha)*x + i*2^(-alpha))
+														sollya_obj_t giS = buildSubIntervalFunction(fS, alpha, ii);
+
+														if(DEBUG <= UserInterface::verbose)
+															sollya_lib_printf("> UniformPiecewisePolyApprox: alpha=%d, ii=%d, testing  %b \n", alpha, ii, giS);
+														// Now what degree do we need to approximate gi?
+														int degreeInf, degreeSup;
+														BasicPolyApprox::guessDegree(giS, rangeS, targetAccuracy, &degreeInf, &degreeSup);
+														// REPORT(DEBUG, " guessDegree returned (" << degreeInf <<  ", " << degreeSup<<")" ); // no need to report, it is done by guessDegree()
+														sollya_lib_clear_obj(giS);
+														return to_string(degreeSup);
+													},
+													[&](int i, string degreeSup) {
+														// For now we only consider degreeSup. Is this a TODO?
+														return stoi(degreeSup) <= degree;
+													});
+				if(!alphaOK)
+					REPORT(DEBUG, "   alpha=" << alpha << " failed." );
 
 				// Did we succeed?
 				if (alphaOK)
@@ -169,7 +172,6 @@ namespace flopoco{
 				//		LSB=INT_MAX; // very large
 				// MSB=INT_MIN; // very small
 				approxErrorBound = 0.0;
-				BasicPolyApprox *p;
 
 				REPORT(DETAILED, "Computing the actual polynomials ");
 				// initialize the vector of MSB weights
@@ -177,12 +179,12 @@ namespace flopoco{
 					MSB.push_back(INT_MIN);
 				}
 
-				for (int i=0; i<nbIntervals; i++) {
-					REPORT(DETAILED, " ... computing polynomial approx for interval " << i << " / "<< nbIntervals);
-					// Recompute the substitution. No big deal.
-					sollya_obj_t giS = buildSubIntervalFunction(fS, alpha, i);
-
-					p = new BasicPolyApprox(giS, degree, LSB, true);
+				REPORT(DETAILED, " ... computing polynomial approx for " << nbIntervals << " intervals");
+				// Recompute the substitutions. No big deal.
+				vector<BasicPolyApprox*> approximations =
+					BasicPolyApprox::buildApproximations([&](int i) {return buildSubIntervalFunction(fS, alpha, i);},
+																							 nbIntervals, degree, LSB, targetAccuracy);
+				for (auto p: approximations) {
 					poly.push_back(p);
 					if (approxErrorBound < p->getApproxErrorBound()){
 						REPORT(DEBUG, "   new approxErrorBound=" << p->getApproxErrorBound() );
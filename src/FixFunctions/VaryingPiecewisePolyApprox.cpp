@@ -165,7 +165,6 @@ namespace flopoco {
 				//		LSB=INT_MAX; // very large
 				// MSB=INT_MIN; // very small
 				approxErrorBound = 0.0;
-				BasicPolyApprox *p;
 
 				REPORT(DETAILED, "Computing the actual polynomials ");
 				// initialize the vector of MSB weights
@@ -173,18 +172,17 @@ namespace flopoco {
 					MSB.push_back(INT_MIN);
 				}
 
-				for (int i=0; i<nbInterval; i++) {
-					REPORT(DETAILED, " ... computing polynomial approx for interval " << i << " / "<< nbInterval);
-					// Recompute the substitution. No big deal.
-					sollya_obj_t giS;
-					if (i==nbInterval-1 && not tabulateRest) {
-					  giS = buildFinalSubIntervalFunction(fS, i-1);
-					}
-					else {
-					  giS = buildSubIntervalFunction(fS, i);
-					}
-					
-					p = new BasicPolyApprox(giS, degree, LSB, true);
+				REPORT(DETAILED, " ... computing polynomial approx for " << nbInterval << " intervals");
+				// Recompute the substitutions. No big deal.
+				vector<BasicPolyApprox*> approximations =
+					BasicPolyApprox::buildApproximations([&](int i) {
+							if (i==nbInterval-1 && not tabulateRest)
+								return buildFinalSubIntervalFunction(fS, i-1);
+							else
+								return buildSubIntervalFunction(fS, i);
+						},
+						nbInterval, degree, LSB, targetAccuracy);
+				for (auto p: approximations) {
 					poly.push_back(p);
 					if (approxErrorBound < p->getApproxErrorBound()){
 						REPORT(DEBUG, "   new approxErrorBound=" << p->getApproxErrorBound() );
@@ -200,7 +198,6 @@ namespace flopoco {
 						if (  (!p->getCoeff(j)->isZero())  &&  (p->getCoeff(j)->MSB > MSB[j])  )
 							MSB[j] = p->getCoeff(j)->MSB;
 					}
-					sollya_lib_clear_obj(giS);
 					
 
 				} // end for loop on j
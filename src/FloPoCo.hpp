@@ -91,6 +91,7 @@
 #include "FPAddSub/FPAddDualPath.hpp"
 #include "FPAddSub/FPAddSinglePath.hpp"
 #include "FPAddSub/FPAddSinglePathIEEE.hpp"
+#include "FPAddSub/FPAddN.hpp"
 // #include "FPAddSub/FPAdd3Input.hpp"
 // #include "FPAddSub/FPAddSub.hpp"
 
@@ -117,9 +118,9 @@
 //#include "ConstMult/FPConstDiv.hpp"
 
 /* FP composite operators */
-// #include "FPComposite/FPLargeAcc.hpp"
-// #include "FPComposite/LargeAccToFP.hpp"
-// #include "FPComposite/FPDotProduct.hpp"
+#include "FPComposite/FPLargeAcc.hpp"
+#include "FPComposite/LargeAccToFP.hpp"
+#include "FPComposite/FPDotProduct.hpp"
 
 
 /* Fixed-point function generators ---------------------*/
@@ -157,17 +158,20 @@
 
 // AutoTest
 #include "AutoTest/AutoTest.hpp"
+#include "AutoTest/DSE.hpp"
 
 
 
 /* misc ------------------------------------------------------ */
 #include "TestBenches/Wrapper.hpp"
+#include "SIMDOperator.hpp"
 #include "TutorialOperator.hpp"
 
 
 
 /* Complex arithmetic */
 #include "Complex/FixComplexKCM.hpp"
+#include "Complex/FixFFTSDF.hpp"
 
 #if 0
 // Old stuff removed from older versions, some of which to bring back to life
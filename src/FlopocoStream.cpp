@@ -151,6 +151,18 @@ namespace flopoco{
 	}
 
 
+	void FlopocoStream::release(){
+		// str("") keeps the capacity of the underlying strings: swap with empty streams instead
+		ostringstream().swap(vhdlCode);
+		ostringstream().swap(vhdlCodeBuffer);
+		vector<triplet<string, string, int>>().swap(dependenceTable);
+		vector<triplet<string, string, int>>().swap(lexDependenceTable);
+		vector<string>().swap(lexExtraRhsNames);
+		lexLhsName = "";
+		codeParsed = true;
+	}
+
+
 	bool FlopocoStream::setOperator(Operator* op_){
 		if(op == nullptr){
 			op = op_;
@@ -158,6 +158,12 @@ namespace flopoco{
 
 			bool isEmpty();
 
+			/**
+			 * Frees the code and the lexer tables, once the code has been output.
+			 * Unlike str(""), this also releases the memory held by the streams.
+			 */
+			void release();
+
 			bool setOperator(Operator* op);
 
 			/**
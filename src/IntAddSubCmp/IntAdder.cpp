@@ -21,6 +21,7 @@ Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 #include <math.h>
 #include <gmp.h>
 #include <mpfr.h>
@@ -35,7 +36,7 @@ Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
 using namespace std;
 namespace flopoco {
 
-	IntAdder::IntAdder (OperatorPtr parentOp, Target* target, int wIn_):
+	IntAdder::IntAdder (OperatorPtr parentOp, Target* target, int wIn_, int arch, int optObjective, int maxLatency):
 		Operator (parentOp, target), wIn ( wIn_ )
 	{
 		srcFileName="IntAdder";
@@ -67,6 +68,19 @@ namespace flopoco {
 
 		REPORT(DETAILED, "maxCycle=" << maxCycle <<  "  maxCP=" << maxCP <<  "  totalPeriod=" << totalPeriod <<  "  targetPeriod=" << targetPeriod );
 
+		vector<TradeoffPoint> points = getTradeoffPoints(getTarget(), wIn, maxCP);
+		if(points.empty())
+			THROWERROR("Cannot realize IntAdder, because the target periode - FF-Delay (" << targetPeriod << ") is shorter than the adder Delay for a 1 bit adder (" << getTarget()->adderDelay(1) << ").");
+		for(auto p: points)
+			REPORT(DETAILED, (p.arch==0 ? "classical" : "carry-select") << " architecture: latency=" << p.latency << "  LUT=" << p.lut << "  FF=" << p.ff);
+		if(arch == -1) // without a latency budget from the parent, keep the classical architecture
+			selectedVersion = (maxLatency >= 0 ? points[selectTradeoffPoint(points, optObjective, maxLatency)].arch : 0);
+		else if(arch == 0 || arch == 1)
+			selectedVersion = (arch < (int)points.size() ? arch : 0); // carry select is pointless when the addition fits in one cycle
+		else
+			THROWERROR("arch=" << arch << ": should be -1 (automatic), 0 (classical) or 1 (carry-select)");
+		REPORT(DETAILED, "selected the " << (selectedVersion==0 ? "classical" : "carry-select") << " architecture");
+
 		if(totalPeriod <= targetPeriod)		{
 			//REPORT(DEBUG, "1 " << getTarget()->adderDelay(wIn));
 			vhdl << tab << declare(getTarget()->adderDelay(wIn),"Rtmp", wIn); // just to use declare()
@@ -77,50 +91,29 @@ namespace flopoco {
 
 		}
 
-		else		{
-            //cout << "----------totalPeriod" << totalPeriod << " targetPeriod " << targetPeriod << endl;
-			// Here we split into chunks.
-			double remainingSlack = targetPeriod-maxCP;                                                                 //remaining time to do addition in current period
-			int firstSubAdderSize = getMaxAdderSizeForPeriod(getTarget(), remainingSlack);                       //remaining additions that can be performed in current period
-			int maxSubAdderSize = getMaxAdderSizeForPeriod(getTarget(), targetPeriod);                           //total additions that can be performed in a period
-            //cout << "----------SubAdderSize" << firstSubAdderSize << " MaxSubAdderSize " << maxSubAdderSize << " Adder Delay n1 " << getTarget()->adderDelay(1) << " Adder Delay n2 " << getTarget()->adderDelay(2) << " remainingSlack " << remainingSlack << endl;
-			bool loop=true;
-			int subAdderSize=firstSubAdderSize;                                                                         //the size of the first sub-adder can be as large as there is time left to do the addition in the current period
-			int previousSubAdderSize=0;                                                                                 //keep record of the bits already added for the next iteration
+		else if(selectedVersion == 0)		{
+			// Here we split into chunks, one per cycle.
+			// The first sub-adder uses the time left in the current period, possibly 0 bits: then its result is skipped.
+			vector<int> chunks = classicalChunks(getTarget(), wIn, maxCP);
 			int subAdderFirstBit = 0;                                                                                   //Bit 0 is added first
-			int i=0;                                                                                                    //cycle counter
-			int skip_R0 = 0;                                                                                            //skip the result form the first cycle if there was not enough time to do an addition of at leased size one
-			while(loop) {
+			int skip_R0 = (chunks[0] == 0 ? 1 : 0);
+			int i;
+			for(i=skip_R0; i<(int)chunks.size(); i++) {
+				int subAdderSize = chunks[i];
 				REPORT(DETAILED, "Sub-adder " << i << " : first bit=" << subAdderFirstBit << ",  size=" <<  subAdderSize);
-				if(0 < subAdderSize){                                                                                   //there is time to do at least an addition of bit-width one in current cycle
-                    // Cin
-                    if(subAdderFirstBit == 0)	{                                                                       //handle carry-in in first cycle
-                        vhdl << tab << declare(join("Cin_", i)) << " <= Cin;" << endl;
-                    }else	 {                                                                                              //handle carry-in in subsequent cycles
-                        vhdl << tab << declare(join("Cin_", i)) << " <= " << join("S_", i-1) <<	of(previousSubAdderSize) << ";" << endl;
-                    }
-                    // operands
-				    vhdl << tab << declare(join("X_", i), subAdderSize+1) << " <= '0' & X"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
-                    vhdl << tab << declare(join("Y_", i), subAdderSize+1) << " <= '0' & Y"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
-                    vhdl << tab << declare(getTarget()->adderDelay(subAdderSize+1), join("S_", i), subAdderSize+1)
-                         << " <= X_" << i	<<	" + Y_" << i << " + Cin_" << i << ";" << endl;
-                    vhdl << tab << declare(join("R_", i), subAdderSize) << " <= S_" << i	<<	range(subAdderSize-1,0) << ";" << endl;
-				} else {                                                                                                //do addition in the following cycle if there is unsufficient time in the current one
-                    subAdderSize = 0;
-                    subAdderFirstBit = 0;
-                    skip_R0 = 1;
-                    if(!maxSubAdderSize)
-                        THROWERROR("Cannot realize IntAdder, because the target periode - FF-Delay (" << targetPeriod << ") is shorter than the adder Delay for a 1 bit adder (" << getTarget()->adderDelay(1) << ").");
+				// Cin
+				if(subAdderFirstBit == 0)	{                                                                       //handle carry-in in first cycle
+					vhdl << tab << declare(join("Cin_", i)) << " <= Cin;" << endl;
+				}else	 {                                                                                              //handle carry-in in subsequent cycles
+					vhdl << tab << declare(join("Cin_", i)) << " <= " << join("S_", i-1) <<	of(chunks[i-1]) << ";" << endl;
 				}
-
-				// prepare next iteration
-				i++;
+				// operands
+				vhdl << tab << declare(join("X_", i), subAdderSize+1) << " <= '0' & X"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
+				vhdl << tab << declare(join("Y_", i), subAdderSize+1) << " <= '0' & Y"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
+				vhdl << tab << declare(getTarget()->adderDelay(subAdderSize+1), join("S_", i), subAdderSize+1)
+						 << " <= X_" << i	<<	" + Y_" << i << " + Cin_" << i << ";" << endl;
+				vhdl << tab << declare(join("R_", i), subAdderSize, true) << " <= S_" << i	<<	range(subAdderSize-1,0) << ";" << endl;
 				subAdderFirstBit += subAdderSize;                                                                       //add MSBits in next cycle
-				previousSubAdderSize = subAdderSize;                                                                    //keep track of the MSB in current cycle to handle carry for next cycle
-				if (subAdderFirstBit==wIn)                                                                              //no further cycle is needed if all bits are already added
-					loop=false;
-				else
-					subAdderSize = min(wIn-subAdderFirstBit, maxSubAdderSize);                                       //the width of the sub-adder in the next cycle is either the remaining bits, or the maximal number of bits that can be added in one cycle, if there is no time to add all remaining bits in one cycle
 			}
 
 			vhdl << tab << "R <= ";
@@ -130,11 +123,192 @@ namespace flopoco {
 			}
 			vhdl << ";" << endl;
 		}
+
+		else {
+			// Carry select: all the chunks are added at once, for both values of their carry in,
+			// then a chain of multiplexers selects the carries, and the results
+			vector<int> chunks = carrySelectChunks(getTarget(), wIn, maxCP);
+			double muxDelay = getTarget()->logicDelay(3);
+			int subAdderFirstBit = 0;
+			for(int i=0; i<(int)chunks.size(); i++) {
+				int subAdderSize = chunks[i];
+				REPORT(DETAILED, "Sub-adder " << i << " : first bit=" << subAdderFirstBit << ",  size=" <<  subAdderSize);
+				vhdl << tab << declare(join("X_", i), subAdderSize+1) << " <= '0' & X"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
+				vhdl << tab << declare(join("Y_", i), subAdderSize+1) << " <= '0' & Y"	<<	range(subAdderFirstBit+subAdderSize-1, subAdderFirstBit) << ";" << endl;
+				if(i==0) {
+					vhdl << tab << declare(getTarget()->adderDelay(subAdderSize+1), "S_0", subAdderSize+1) << " <= X_0 + Y_0 + Cin;" << endl;
+					vhdl << tab << declare("R_0", subAdderSize, true) << " <= S_0" << range(subAdderSize-1,0) << ";" << endl;
+				}
+				else {
+					vhdl << tab << declare(getTarget()->adderDelay(subAdderSize+1), join("S0_", i), subAdderSize+1)
+							 << " <= X_" << i << " + Y_" << i << ";" << endl;
+					vhdl << tab << declare(getTarget()->adderDelay(subAdderSize+1), join("S1_", i), subAdderSize+1)
+							 << " <= X_" << i << " + Y_" << i << " + '1';" << endl;
+					// the carry in of this chunk
+					if(i==1)
+						vhdl << tab << declare("C_1") << " <= S_0" << of(chunks[0]) << ";" << endl;
+					else
+						vhdl << tab << declare(muxDelay, join("C_", i)) << " <= " << join("S1_", i-1) << of(chunks[i-1]) << " when " << join("C_", i-1) << "='1' else "
+								 << join("S0_", i-1) << of(chunks[i-1]) << ";" << endl;
+					vhdl << tab << declare(muxDelay, join("R_", i), subAdderSize, true) << " <= " << join("S1_", i) << range(subAdderSize-1,0) << " when " << join("C_", i) << "='1' else "
+							 << join("S0_", i) << range(subAdderSize-1,0) << ";" << endl;
+				}
+				subAdderFirstBit += subAdderSize;
+			}
+
+			vhdl << tab << "R <= ";
+			for(int i=chunks.size()-1; i>=0; i--)
+				vhdl <<  "R_" << i << (i==0 ? ";" : " & ");
+			vhdl << endl;
+		}
 		//REPORT(DEBUG, "Exiting");
 
 	}
 
 
+	vector<int> IntAdder::classicalChunks(Target* target, int wIn, double inputCriticalPath) {
+		vector<int> chunks;
+		double targetPeriod = 1.0/target->frequency() - target->ffDelay();
+		if(inputCriticalPath + target->adderDelay(wIn) <= targetPeriod) {
+			chunks.push_back(wIn);
+			return chunks;
+		}
+		int firstSubAdderSize = getMaxAdderSizeForPeriod(target, targetPeriod-inputCriticalPath);                   //remaining additions that can be performed in current period
+		int maxSubAdderSize = getMaxAdderSizeForPeriod(target, targetPeriod);                                        //total additions that can be performed in a period
+		if(maxSubAdderSize == 0)
+			return chunks;
+		int done = min(firstSubAdderSize, wIn);
+		chunks.push_back(done);
+		while(done < wIn) {
+			chunks.push_back(min(wIn-done, maxSubAdderSize));
+			done += chunks.back();
+		}
+		return chunks;
+	}
+
+
+	vector<int> IntAdder::carrySelectChunks(Target* target, int wIn, double inputCriticalPath) {
+		// Either the sums fit in the time left in the cycle of the inputs, or they start in the next cycle with larger chunks
+		double targetPeriod = 1.0/target->frequency() - target->ffDelay();
+		vector<int> best;
+		TradeoffPoint bestCost;
+		for(double slack: {targetPeriod-inputCriticalPath, targetPeriod}) {
+			int subAdderSize = max(getMaxAdderSizeForPeriod(target, slack)-1, 1); // -1 for the carry out
+			vector<int> chunks;
+			for(int done=0; done < wIn; done += chunks.back())
+				chunks.push_back(min(wIn-done, subAdderSize));
+			TradeoffPoint c = carrySelectCost(target, chunks, inputCriticalPath);
+			if(best.empty() || c.latency < bestCost.latency || (c.latency == bestCost.latency && c.ff < bestCost.ff)) {
+				best = chunks;
+				bestCost = c;
+			}
+		}
+		return best;
+	}
+
+
+	IntAdder::TradeoffPoint IntAdder::carrySelectCost(Target* target, vector<int> chunks, double inputCriticalPath) {
+		int k = chunks.size();
+		int wIn = 0;
+		for(int c: chunks)
+			wIn += c;
+		double targetPeriod = 1.0/target->frequency() - target->ffDelay();
+		double muxDelay = target->logicDelay(3);
+		// The timing of the sums, as the scheduler will place them
+		int sumCycle = 0;
+		double t = inputCriticalPath + target->adderDelay(chunks[0]+1);
+		if(t > targetPeriod) {
+			sumCycle = 1;
+			t = target->adderDelay(chunks[0]+1);
+		}
+		// The timing of the chain of carries, and of the results
+		vector<int> carryCycle(k, sumCycle), resultCycle(k, sumCycle);
+		for(int i=2; i<k; i++) {
+			t += muxDelay;
+			carryCycle[i] = carryCycle[i-1];
+			if(t > targetPeriod) {
+				carryCycle[i]++;
+				t = muxDelay;
+			}
+		}
+		for(int i=1; i<k; i++)
+			resultCycle[i] = carryCycle[i];
+		// the last result mux may not fit after the last carry
+		if(k > 1 && t + muxDelay > targetPeriod)
+			resultCycle[k-1]++;
+		int latency = *max_element(resultCycle.begin(), resultCycle.end());
+
+		TradeoffPoint p;
+		p.arch = 1;
+		p.latency = latency;
+		p.lut = chunks[0] + 3*(wIn-chunks[0]) + max(k-2, 0);
+		p.ff = (sumCycle==1 ? 2*wIn+1 : 0);
+		for(int i=0; i<k; i++) {
+			// both sums wait for their carry in, the results wait for the last one
+			int sumLife = (i==0 ? 0 : resultCycle[i] - sumCycle);
+			if(i < k-1)
+				sumLife = max(sumLife, carryCycle[i+1] - sumCycle);
+			p.ff += (i==0 ? 1 : 2) * (chunks[i]+1) * sumLife;
+			p.ff += chunks[i] * (latency - resultCycle[i]);
+		}
+		return p;
+	}
+
+
+	vector<IntAdder::TradeoffPoint> IntAdder::getTradeoffPoints(Target* target, int wIn, double inputCriticalPath) {
+		vector<TradeoffPoint> points;
+		vector<int> chunks = classicalChunks(target, wIn, inputCriticalPath);
+		if(chunks.empty())
+			return points;
+
+		// The classical architecture: chunk i is added in cycle i
+		TradeoffPoint p;
+		p.arch = 0;
+		p.latency = (target->isPipelined() ? chunks.size()-1 : 0);
+		p.lut = wIn;
+		p.ff = 0;
+		for(int i=1; i<(int)chunks.size(); i++) // the operands and the carry in, then the results
+			p.ff += 2*chunks[i]*i + 1;
+		for(int i=0; i<(int)chunks.size(); i++)
+			p.ff += chunks[i]*(p.latency-i);
+		if(!target->isPipelined())
+			p.ff = 0;
+		points.push_back(p);
+
+		// The carry-select architecture, when the addition doesn't fit in one cycle
+		if(chunks.size() > 1 && target->isPipelined())
+			points.push_back(carrySelectCost(target, carrySelectChunks(target, wIn, inputCriticalPath), inputCriticalPath));
+		return points;
+	}
+
+
+	int IntAdder::selectTradeoffPoint(vector<TradeoffPoint> points, int optObjective, int maxLatency) {
+		// the cost of a point: a slice (or ALM) holds about twice as many registers as LUTs
+		auto cost = [optObjective](TradeoffPoint p) {
+			switch(optObjective) {
+			case 0: return p.lut;
+			case 1: return p.ff;
+			default: return max(p.lut, (p.ff+1)/2);
+			}
+		};
+		int best = -1;
+		for(int i=0; i<(int)points.size(); i++) {
+			if(maxLatency >= 0 && points[i].latency > maxLatency)
+				continue;
+			if(best == -1 || cost(points[i]) < cost(points[best])
+				 || (cost(points[i]) == cost(points[best]) && points[i].latency < points[best].latency))
+				best = i;
+		}
+		if(best == -1) { // nothing fits: the smallest latency
+			best = 0;
+			for(int i=1; i<(int)points.size(); i++)
+				if(points[i].latency < points[best].latency)
+					best = i;
+		}
+		return best;
+	}
+
+
 	int IntAdder::getMaxAdderSizeForPeriod(Target* target, double targetPeriod) {
 		int count = 1;                                                                                                  // Start checking the addition width that can be performed int the remaining time in the current cycle at 1-bit
         while(target->adderDelay(count) < targetPeriod){
@@ -164,10 +338,47 @@ namespace flopoco {
 	}
 
 
+	TestList IntAdder::unitTest(int index)
+	{
+		// the static list of mandatory tests
+		TestList testStateList;
+		vector<pair<string,string>> paramList;
+
+		if(index==-1)
+		{ // The unit tests
+			for(int wIn : {1, 8, 64, 200, 1000}) {
+				for(int arch=-1; arch<=1; arch++) {
+					paramList.push_back(make_pair("wIn", to_string(wIn)));
+					paramList.push_back(make_pair("arch", to_string(arch)));
+					if(arch==-1) // the automatic choice, within a tight latency budget
+						paramList.push_back(make_pair("maxLatency", "1"));
+					testStateList.push_back(paramList);
+					paramList.clear();
+				}
+			}
+			// many chunks for the carry-select architecture
+			paramList.push_back(make_pair("wIn", "1000"));
+			paramList.push_back(make_pair("arch", "1"));
+			paramList.push_back(make_pair("frequency", "800"));
+			testStateList.push_back(paramList);
+			paramList.clear();
+		}
+		else
+		{
+			// finite number of random test computed out of index
+		}
+
+		return testStateList;
+	}
+
+
 	OperatorPtr IntAdder::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
-		int wIn;
+		int wIn, arch, optObjective, maxLatency;
 		UserInterface::parseStrictlyPositiveInt(args, "wIn", &wIn, false);
-		return new IntAdder(parentOp, target, wIn);
+		UserInterface::parseInt(args, "arch", &arch);
+		UserInterface::parseInt(args, "optObjective", &optObjective);
+		UserInterface::parseInt(args, "maxLatency", &maxLatency);
+		return new IntAdder(parentOp, target, wIn, arch, optObjective, maxLatency);
 	}
 
 	void IntAdder::registerFactory(){
@@ -176,11 +387,13 @@ namespace flopoco {
 											 "BasicInteger", // category
 											 "",
 											 "wIn(int): input size in bits;\
-					  arch(int)=-1: -1 for automatic, 0 for classical, 1 for alternative, 2 for short latency; \
-					  optObjective(int)=2: 0 to optimize for logic, 1 to optimize for register, 2 to optimize for slice/ALM count; \
+					  arch(int)=-1: -1 for automatic (classical unless maxLatency is given), 0 for classical (one chunk per cycle), 1 for carry select (shorter latency, more logic); \
+					  optObjective(int)=2: for the automatic choice, 0 to optimize for logic, 1 to optimize for register, 2 to optimize for slice/ALM count; \
+					  maxLatency(int)=-1: for the automatic choice, the latency that can be afforded, -1 for no constraint; \
 					  SRL(bool)=true: optimize for shift registers",
 											 "",
-											 IntAdder::parseArguments
+											 IntAdder::parseArguments,
+											 IntAdder::unitTest
 											 );
 		
 	}
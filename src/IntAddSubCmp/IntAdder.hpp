@@ -10,6 +10,14 @@
 namespace flopoco {
 
 	/** The IntAdder class for pipelined integer adders.
+	 * When the addition doesn't fit in the time left in the cycle of its inputs, it is split into chunks.
+	 * Two architectures are possible, with different latency/area trade-offs:
+	 * - the classical one adds one chunk per cycle, propagating the carry through a register:
+	 *   it is the smallest in logic, but the operands and results are delayed, which costs latency and registers;
+	 * - the carry-select one adds all the chunks in parallel, for both values of their carry in,
+	 *   then selects the results once the carries are known: more logic, but less latency and fewer registers.
+	 * getTradeoffPoints() estimates both for a given width and input timing, so that a parent may choose.
+	 * The classical architecture is the default, unless the parent gives a latency budget.
 	 */
 	class IntAdder : public Operator {
 	public:
@@ -23,13 +31,24 @@ namespace flopoco {
 		} Type;
 		
 
+		/** A point of the latency/area trade-off: an architecture and its estimated cost */
+		typedef struct {
+			int arch;       /**< 0 for classical, 1 for carry-select */
+			int latency;    /**< number of cycles from the inputs to the output */
+			int lut;        /**< estimated number of LUTs */
+			int ff;         /**< estimated number of register bits, including the delays of the operands and results */
+		} TradeoffPoint;
+
 		/**
 		 * The IntAdder constructor
 		 * @param[in] parentOp         the parent operator of this component
 		 * @param[in] target           the target device
 		 * @param[in] wIn              the with of the inputs and output
+		 * @param[in] arch             -1 for automatic (classical unless maxLatency is given), 0 for classical, 1 for carry-select
+		 * @param[in] optObjective     for the automatic choice: 0 to optimize for logic, 1 for registers, 2 for slices
+		 * @param[in] maxLatency       for the automatic choice: if not -1, the latency the parent can afford
 		 **/
-		IntAdder ( OperatorPtr parentOp, Target* target, int wIn);
+		IntAdder ( OperatorPtr parentOp, Target* target, int wIn, int arch=-1, int optObjective=2, int maxLatency=-1);
 
 		/**
 		 *  Destructor
@@ -47,17 +66,42 @@ namespace flopoco {
 		 */
 		static int getMaxAdderSizeForPeriod(Target* target, double TargetPeriod);
 
+		/**
+		 * The latency/area trade-off points of an adder: one point when the addition fits in the cycle of its inputs,
+		 * one per architecture otherwise. The list is empty when the target period is too short for a one-bit addition.
+		 * @param[in] wIn               the width of the adder
+		 * @param[in] inputCriticalPath the critical path of the inputs in their cycle, i.e. the period minus the slack left to the adder
+		 */
+		static vector<TradeoffPoint> getTradeoffPoints(Target* target, int wIn, double inputCriticalPath);
+
+		/**
+		 * Select a point among the ones returned by getTradeoffPoints().
+		 * The points within maxLatency (all of them if maxLatency is -1) are compared according to optObjective,
+		 * then according to their latency. If none is within maxLatency, the one of smallest latency is returned.
+		 * @return the index of the selected point
+		 */
+		static int selectTradeoffPoint(vector<TradeoffPoint> points, int optObjective=2, int maxLatency=-1);
+
 		// User-interface stuff
 		/** Factory method */
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
 
 		static void registerFactory();
 
+		/** Unit tests */
+		static TestList unitTest(int index);
+
 	protected:
 		int wIn;                                    /**< the width for X, Y and R*/
 	private:
-		vector<Operator*> addImplementationList;     /**< this list will be populated with possible adder architectures*/
-		int selectedVersion;                         /**< the selected version from the addImplementationList */
+		int selectedVersion;                         /**< the selected architecture, 0 for classical, 1 for carry-select */
+
+		/** The chunk sizes of the classical architecture. The first one may be 0, when no bit can be added in the cycle of the inputs */
+		static vector<int> classicalChunks(Target* target, int wIn, double inputCriticalPath);
+		/** The chunk sizes of the carry-select architecture */
+		static vector<int> carrySelectChunks(Target* target, int wIn, double inputCriticalPath);
+		/** The cost of the carry-select architecture with the given chunk sizes */
+		static TradeoffPoint carrySelectCost(Target* target, vector<int> chunks, double inputCriticalPath);
 	};
 
 }
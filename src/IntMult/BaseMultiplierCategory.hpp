@@ -80,6 +80,7 @@ namespace flopoco {
 					bool isFlippedXY() const {return isFlippedXY_;}
 					int getShapePara() const {return shape_para_;}
 				    string getMultType() const {return bmCat_->getType();}
+					BaseMultiplierCategory const * getCategory() const {return bmCat_;}
                     Parametrization tryDSPExpand(int m_x_pos, int m_y_pos, int wX, int wY, bool signedIO);
                     Parametrization setSignStatus(int m_x_pos, int m_y_pos, int wX, int wY, bool signedIO);
                     Parametrization shrinkFitDSP(int m_x_pos, int m_y_pos, int wX, int wY);
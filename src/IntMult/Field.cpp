@@ -1,12 +1,11 @@
 #include "Field.hpp"
 #include <iostream>
+#include <algorithm>
 
 namespace flopoco {
     Field::Field(unsigned int wX, unsigned int wY, bool signedIO, FieldState& baseState) : wX_(wX), wY_(wY), signedIO_(signedIO), currentStateID_(0U), baseState_{&baseState} {
-        field_.resize(wY_);
-        for(unsigned int i = 0; i < wY_; i++) {
-            field_[i] = vector<ID>(wX_, currentStateID_);
-        }
+        words_ = (wX_ + 63) / 64;
+        base_.assign(wY_ * words_, 0U);
         currentStateID_++;
 
         initFieldState(baseState);
@@ -16,33 +15,98 @@ namespace flopoco {
     Field::Field(const Field &copy) {
         wX_ = copy.wX_;
         wY_ = copy.wY_;
+        words_ = copy.words_;
+        base_ = copy.base_;
+        stateBits_ = copy.stateBits_;
+
+        signedIO_ = copy.signedIO_;
+        currentStateID_ = copy.currentStateID_;
+        baseState_ = copy.baseState_;
+        baseID_ = copy.baseID_;
+    }
+
+    Field::~Field() {
+        base_.clear();
+        stateBits_.clear();
+    }
 
-        field_.resize(wY_);
-        for(unsigned int i = 0U; i < wY_; i++) {
-            field_[i].resize(wX_);
-            for(unsigned int j = 0; j < wX_; j++) {
-                field_[i][j] = copy.field_[i][j];
+    uint64_t Field::rowMask(unsigned int from, unsigned int to, unsigned int w) {
+        unsigned int lo = std::max(from, 64 * w);
+        unsigned int hi = std::min(to, 64 * (w + 1));
+        if(lo >= hi) {
+            return 0U;
+        }
+        unsigned int n = hi - lo;
+        uint64_t mask = (n == 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1));
+        return mask << (lo - 64 * w);
+    }
+
+    uint64_t Field::occupiedWord(unsigned int y, unsigned int w, ID id) const {
+        uint64_t bits = base_[y * words_ + w];
+        if(id != baseID_) {
+            auto it = stateBits_.find(id);
+            if(it != stateBits_.end()) {
+                bits |= it->second[y * words_ + w];
             }
         }
+        return bits;
+    }
 
-        signedIO_ = copy.signedIO_;
+    bool Field::isOccupied(unsigned int x, unsigned int y, ID id) const {
+        if(x >= wX_ || y >= wY_) {
+            return false;
+        }
+        return (occupiedWord(y, x / 64, id) >> (x % 64)) & 1;
     }
 
-    Field::~Field() {
-        field_.clear();
+    void Field::occupy(unsigned int y, unsigned int w, uint64_t bits, ID id) {
+        if(bits == 0U) {
+            return;
+        }
+        unsigned int index = y * words_ + w;
+        // a bit belongs to one state only, as the last one that placed a tile there
+        for(auto& s: stateBits_) {
+            if(s.first != id) {
+                s.second[index] &= ~bits;
+            }
+        }
+        if(id == baseID_) {
+            base_[index] |= bits;
+            return;
+        }
+        auto it = stateBits_.find(id);
+        if(it == stateBits_.end()) {
+            vector<uint64_t> bitmap;
+            bitmap.swap(spare_);
+            bitmap.assign(wY_ * words_, 0U);
+            it = stateBits_.emplace(id, std::move(bitmap)).first;
+        }
+        it->second[index] |= bits;
+    }
+
+    void Field::releaseState(ID id) {
+        auto it = stateBits_.find(id);
+        if(it != stateBits_.end()) {
+            spare_.swap(it->second);
+            stateBits_.erase(it);
+        }
     }
 
     void Field::initFieldState(FieldState& fieldState) {
+        releaseState(fieldState.getID());
         fieldState.reset(this, currentStateID_++, wX_ * wY_);
         fieldState.setCursor(0U, 0U);
         fieldState.setField(this);
     }
 
     void Field::updateStateID(Field::FieldState &fieldState) {
+        releaseState(fieldState.getID());
         fieldState.setID(currentStateID_++);
     }
 
     void Field::reset() {
+        std::fill(base_.begin(), base_.end(), 0U);
+        stateBits_.clear();
         initFieldState(*baseState_);
         baseID_ = baseState_->getID();
     }
@@ -52,24 +116,11 @@ namespace flopoco {
         unsigned int sizeY = std::min((unsigned int)tile->wY_DSPexpanded(coord.first, coord.second, wX_, wY_, signedIO_), maxY);
         ID fieldID = fieldState.getID();
 
-        for (unsigned int i = coord.second; i < sizeY + coord.second; i++) {
-            for (unsigned int j = coord.first; j < sizeX + coord.second; j++) {
-                if (field_[i][j] == fieldID || field_[i][j] == baseID_) {
-                    unsigned int area1 = i - coord.second + 1 * maxY;
-                    unsigned int area2 = maxX * j - coord.second + 1;
-                    if(area1 > area2) {
-                        maxX = i - coord.second + 1;
-                    }
-                    else {
-                        maxY = j - coord.second + 1;
-                    }
-                }
-            }
-        }
-
-        for (unsigned int i = coord.second; i < sizeY; i++) {
-            for (unsigned int j = coord.first; j < sizeX; j++) {
-                if (field_[i][j] == fieldID || field_[i][j] == baseID_) {
+        unsigned int endX = std::min(sizeX, wX_);
+        unsigned int endY = std::min(sizeY, wY_);
+        for (unsigned int i = coord.second; i < endY; i++) {
+            for (unsigned int w = coord.first / 64; w < words_; w++) {
+                if (occupiedWord(i, w, fieldID) & rowMask(coord.first, endX, w)) {
                     return tile->parametrize(0, 0, false, false);
                 }
             }
@@ -88,32 +139,25 @@ namespace flopoco {
 
         unsigned int covered = 0;
         ID fieldID = fieldState.getID();
-
-        if (tile->isIrregular() || tile->isKaratsuba()) {
-            for (unsigned int i = coord.second; i < maxY; i++) {
-                for (unsigned int j = coord.first; j < maxX; j++) {
-                    //check if tile could cover this area
-                    if (!tile->shape_contribution(j, i, coord.first, coord.second, wX_, wY_, signedIO_)) {
-                        continue;
-                    }
-
-                    if (field_[i][j] == fieldID || field_[i][j] == baseID_) {
-                        return 0;
+        bool shaped = tile->isIrregular() || tile->isKaratsuba();
+
+        for (unsigned int i = coord.second; i < maxY; i++) {
+            for (unsigned int w = coord.first / 64; w < words_ && 64 * w < maxX; w++) {
+                uint64_t mask = rowMask(coord.first, maxX, w);
+                if (shaped) {
+                    //keep the bits this tile could cover
+                    for (unsigned int j = std::max(coord.first, 64 * w); j < std::min(maxX, 64 * (w + 1)); j++) {
+                        if (!tile->shape_contribution(j, i, coord.first, coord.second, wX_, wY_, signedIO_)) {
+                            mask &= ~((uint64_t)1 << (j % 64));
+                        }
                     }
-
-                    covered++;
                 }
-            }
-        }
-        else {
-            for (unsigned int i = coord.second; i < maxY; i++) {
-                for (unsigned int j = coord.first; j < maxX; j++) {
-                    if (field_[i][j] == fieldID || field_[i][j] == baseID_) {
-                        return 0;
-                    }
 
-                    covered++;
+                if (occupiedWord(i, w, fieldID) & mask) {
+                    return 0;
                 }
+
+                covered += __builtin_popcountll(mask);
             }
         }
 
@@ -130,27 +174,24 @@ namespace flopoco {
 
         ID fieldID = fieldState.getID();
         unsigned int updateMissing = 0U;
-
-        if(tile->isIrregular() || tile->isKaratsuba()) {
-            for (unsigned int i = coord.second; i < maxY; i++) {
-                for (unsigned int j = coord.first; j < maxX; j++) {
-                    //check if tile could cover this area and if area is free
-                    if (tile->shape_contribution(j, i, coord.first, coord.second, wX_, wY_, signedIO_) &&
-                        field_[i][j] != fieldID && field_[i][j] != baseID_) {
-                        field_[i][j] = fieldID;
-                        updateMissing++;
-                    }
-                }
-            }
-        }
-        else {
-            for (unsigned int i = coord.second; i < maxY; i++) {
-                for (unsigned int j = coord.first; j < maxX; j++) {
-                    if (field_[i][j] != fieldID && field_[i][j] != baseID_) {
-                        field_[i][j] = fieldID;
-                        updateMissing++;
+        bool shaped = tile->isIrregular() || tile->isKaratsuba();
+
+        for (unsigned int i = coord.second; i < maxY; i++) {
+            for (unsigned int w = coord.first / 64; w < words_ && 64 * w < maxX; w++) {
+                uint64_t mask = rowMask(coord.first, maxX, w);
+                if (shaped) {
+                    //only the area this tile could cover
+                    for (unsigned int j = std::max(coord.first, 64 * w); j < std::min(maxX, 64 * (w + 1)); j++) {
+                        if (!tile->shape_contribution(j, i, coord.first, coord.second, wX_, wY_, signedIO_)) {
+                            mask &= ~((uint64_t)1 << (j % 64));
+                        }
                     }
                 }
+
+                //only the area that is free
+                uint64_t newBits = mask & ~occupiedWord(i, w, fieldID);
+                occupy(i, w, newBits, fieldID);
+                updateMissing += __builtin_popcountll(newBits);
             }
         }
 
@@ -169,18 +210,18 @@ namespace flopoco {
     }
 
     unsigned int Field::getMissingLine(FieldState& fieldState) {
-        unsigned int missing = 0U;
         Cursor c = fieldState.getCursor();
         ID fieldID = fieldState.getID();
 
-        for(unsigned int i = c.first; i < wX_; i++) {
-            if(field_[c.second][i] == fieldID || field_[c.second][i] == baseID_) {
-                break;
+        //the first occupied position at or after the cursor
+        for(unsigned int w = c.first / 64; w < words_; w++) {
+            uint64_t bits = occupiedWord(c.second, w, fieldID) & rowMask(c.first, wX_, w);
+            if(bits != 0U) {
+                return 64 * w + __builtin_ctzll(bits) - c.first;
             }
-            missing++;
         }
 
-        return missing;
+        return wX_ - c.first;
     }
 
     unsigned int Field::getMissingHeight(FieldState& fieldState) {
@@ -189,7 +230,7 @@ namespace flopoco {
         ID fieldID = fieldState.getID();
 
         for(unsigned int i = c.second; i < wY_; i++) {
-            if(field_[i][c.first] == fieldID || field_[i][c.first] == baseID_) {
+            if(isOccupied(c.first, i, fieldID)) {
                 break;
             }
             missing++;
@@ -200,16 +241,20 @@ namespace flopoco {
 
     void Field::printField() {
         //TODO: mirror output
-        for(auto v: field_) {
-            for(auto c: v) {
-                cout << c;
+        for(unsigned int y = 0; y < wY_; y++) {
+            for(unsigned int x = 0; x < wX_; x++) {
+                bool occupied = isOccupied(x, y, baseID_);
+                for(auto& s: stateBits_) {
+                    occupied = occupied || ((s.second[y * words_ + x / 64] >> (x % 64)) & 1);
+                }
+                cout << occupied;
             }
             cout << endl;
         }
     }
 
     bool Field::checkPosition(unsigned int x, unsigned int y, Field::FieldState &fieldState) {
-        return (field_[y][x] == fieldState.getID() || field_[y][x] == baseID_);
+        return isOccupied(x, y, fieldState.getID());
     }
 
     void Field::setTruncated(unsigned int range, FieldState& fieldState) {
@@ -220,13 +265,12 @@ namespace flopoco {
                 break;
             }
 
-            for(unsigned int x = 0; x < wX_; x++) {
-                if(y + x > range) {
-                   break;
-                }
-
-                field_[y][x] = fieldID;
-                updateMissing++;
+            //the positions x <= range-y, overwritten whatever their state
+            unsigned int endX = std::min(wX_, range - y + 1);
+            for(unsigned int w = 0; w < words_; w++) {
+                uint64_t bits = rowMask(0, endX, w);
+                occupy(y, w, bits, fieldID);
+                updateMissing += __builtin_popcountll(bits);
             }
         }
 
@@ -241,14 +285,14 @@ namespace flopoco {
         for(unsigned int y = 0; y < wY_; y++) {
             for(unsigned int x = 0; x < wX_; x++) {
                 if((x+y) < ((int)prodWidth-wOut-guardBits)){
-                    field_[y][x] = fieldID;
+                    occupy(y, x / 64, (uint64_t)1 << (x % 64), fieldID);
                     updateMissing++;
                 } else if((x+y) == ((int)prodWidth-wOut-guardBits)){
                     if((keepBits)?keepBits--:0){
                         cout << "keepBit at" << x << "," << y << endl;
                     } else {
                         cout << "NO keepBit at" << x << "," << y << endl;
-                        field_[y][x] = fieldID;
+                        occupy(y, x / 64, (uint64_t)1 << (x % 64), fieldID);
                         updateMissing++;
                     }
                 }
@@ -262,9 +306,9 @@ namespace flopoco {
     void Field::printField(FieldState& fieldState) {
         ID fieldID = fieldState.getID();
 
-        for(auto v: field_) {
-            for(auto c: v) {
-                cout << (c == fieldID || c == baseID_);
+        for(unsigned int y = 0; y < wY_; y++) {
+            for(unsigned int x = 0; x < wX_; x++) {
+                cout << isOccupied(x, y, fieldID);
             }
             cout << endl;
         }
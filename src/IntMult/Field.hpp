@@ -3,6 +3,8 @@
 
 #include <utility>
 #include <vector>
+#include <map>
+#include <cstdint>
 #include "BaseMultiplierCategory.hpp"
 
 using namespace std;
@@ -80,7 +82,26 @@ namespace flopoco {
         void printField(FieldState& fieldState);
 
     protected:
-        vector<vector<ID>> field_;
+        /** The bits of the words of row y that are occupied for the state id (the base state, or its own tiles) */
+        uint64_t occupiedWord(unsigned int y, unsigned int w, ID id) const;
+        bool isOccupied(unsigned int x, unsigned int y, ID id) const;
+        /** Marks bits of word w of row y as occupied by the state id */
+        void occupy(unsigned int y, unsigned int w, uint64_t bits, ID id);
+        /** Forgets the tiles of a state that is getting a new ID */
+        void releaseState(ID id);
+        /** The bits [from, to) of word w of a row */
+        static uint64_t rowMask(unsigned int from, unsigned int to, unsigned int w);
+
+        /*
+         * Occupancy is stored as bitmasks, words_ 64-bit words per row.
+         * The tiles of the base state are in base_, those of the other states in stateBits_, one bitmap per state ID.
+         * A reset state owns no bitmap until it places its first tile,
+         * so that resetting a state to the base state costs nothing (copy on write).
+         */
+        unsigned int words_;
+        vector<uint64_t> base_;
+        map<ID, vector<uint64_t>> stateBits_;
+        vector<uint64_t> spare_;    /**< a released bitmap, recycled by the next state that places a tile */
         unsigned int wX_;
         unsigned int wY_;
         bool signedIO_;
@@ -33,6 +33,7 @@
 #include "TilingStrategyXGreedy.hpp"
 #include "TilingStrategyBeamSearch.hpp"
 #include "TilingAndCompressionOptILP.hpp"
+#include "TilingStrategyPortfolio.hpp"
 
 using namespace std;
 
@@ -213,6 +214,30 @@ namespace flopoco {
                     optiTrunc
 			);
 
+		} else if(tilingMethod.compare("portfolio") == 0 || tilingMethod.compare("portfolioOptimal") == 0){
+			tilingStrategy = new TilingStrategyPortfolio(
+					wX,
+					wY,
+					wOut,
+					signedIO,
+					&baseMultiplierCollection,
+					baseMultiplierCollection.getPreferedMultiplier(),
+					dspOccupationThreshold,
+					maxDSP,
+					useirregular,
+					use2xk,
+					superTiles,
+					useKaratsuba,
+					multiplierTileCollection,
+					beamRange,
+                    guardBits,
+                    keepBits,
+                    errorBudget,
+                    centerErrConstant,
+                    optiTrunc,
+                    tilingMethod.compare("portfolioOptimal") == 0
+			);
+
 		} else {
 			THROWERROR("Tiling strategy " << tilingMethod << " unknown");
 		}
@@ -930,33 +955,33 @@ namespace flopoco {
 					}
 			}
 
+		// a clock enable tree of depth at least 2, which moves the inputs back by as many cycles
+		paramList.push_back(make_pair("wX", "53"));
+		paramList.push_back(make_pair("wY", "53"));
+		paramList.push_back(make_pair("target", "Kintex7"));
+		paramList.push_back(make_pair("frequency", "800"));
+		paramList.push_back(make_pair("clockEnable", "1"));
+		paramList.push_back(make_pair("clockEnableTree", "1"));
+		testStateList.push_back(paramList);
+		paramList.clear();
+
+		// the portfolio of heuristic tilings, in worker processes
+		paramList.push_back(make_pair("wX", "27"));
+		paramList.push_back(make_pair("wY", "41"));
+		paramList.push_back(make_pair("tiling", "portfolio"));
+		testStateList.push_back(paramList);
+		paramList.clear();
+
 		return testStateList;
 	}
 
     mpz_class IntMultiplier::checkTruncationError(list<TilingStrategy::mult_tile_t> &solution, unsigned guardBits, const mpz_class& errorBudget, const mpz_class& constant) const{
-        std::vector<std::vector<bool>> mulArea(wX, std::vector<bool>(wY,false));
-
-        for(auto & tile : solution) {
-            auto &parameters = tile.first;
-            auto &anchor = tile.second;
-            int xPos = anchor.first;
-            int yPos = anchor.second;
-
-            for(int x = 0; x < parameters.getMultXWordSize(); x++){
-                for(int y = 0; y < parameters.getMultYWordSize(); y++){
-                    if(0 <= xPos+x && 0 <= yPos+y && xPos+x < wX && yPos+y < wY)
-                        mulArea[xPos+x][yPos+y] = mulArea[xPos+x][yPos+y] || parameters.shapeValid(x,y);
-                }
-            }
-        }
-
-        mpz_class truncError, maxErr = errorBudget+constant;
-        truncError = mpz_class(0);
-        for(int y = 0; y < wY; y++){
+        vector<uint8_t> covered = TilingStrategy::coveredBits(solution, wX, wY);
+        mpz_class maxErr = errorBudget+constant;
+        mpz_class truncError = TilingStrategy::weightedColumnSum(TilingStrategy::uncoveredBitsPerColumn(covered, wX, wY));
+        for(int y = 0; y < (int)wY; y++){
             for(int x = wX-1; 0 <= x; x--){
-                if(!mulArea[x][y])
-                    truncError += (mpz_class(1)<<(x+y));
-                cout << (mulArea[x][y] ? 1 : 0);
+                cout << (covered[y*wX+x] ? 1 : 0);
             }
             cout << endl;
         }
@@ -10,6 +10,50 @@ namespace flopoco {
 
 	}
 
+	vector<uint8_t> TilingStrategy::coveredBits(list<mult_tile_t> &solution, int wX, int wY)
+	{
+		vector<uint8_t> covered(wX*wY, 0);
+		for(auto & tile : solution) {
+			auto &parameters = tile.first;
+			int xPos = tile.second.first;
+			int yPos = tile.second.second;
+			for(int y = max(0, -yPos); y < (int)parameters.getMultYWordSize() && yPos+y < wY; y++) {
+				uint8_t* row = covered.data() + (yPos+y)*wX;
+				for(int x = max(0, -xPos); x < (int)parameters.getMultXWordSize() && xPos+x < wX; x++) {
+					row[xPos+x] |= parameters.shapeValid(x,y);
+				}
+			}
+		}
+		return covered;
+	}
+
+	vector<int> TilingStrategy::uncoveredBitsPerColumn(const vector<uint8_t> &covered, int wX, int wY)
+	{
+		vector<int> columnCount(wX+wY, 0);
+		// row by row, so that the inner loop is a plain vector addition
+		for(int y = 0; y < wY; y++) {
+			const uint8_t* row = covered.data() + y*wX;
+			int* column = columnCount.data() + y;
+			for(int x = 0; x < wX; x++)
+				column[x] += 1 - row[x];
+		}
+		return columnCount;
+	}
+
+	mpz_class TilingStrategy::weightedColumnSum(const vector<int> &columnCount)
+	{
+		mpz_class sum(0);
+		uint64_t carry = 0;
+		for(size_t w = 0; w < columnCount.size() || carry != 0; w++) {
+			if(w < columnCount.size())
+				carry += columnCount[w];
+			if(carry & 1)
+				mpz_setbit(sum.get_mpz_t(), w);
+			carry >>= 1;
+		}
+		return sum;
+	}
+
 	void TilingStrategy::printSolution()
 	{
 		for (auto& tile : solution)
@@ -27,6 +27,18 @@ namespace flopoco {
 			return solution;
 		}
 
+		/**
+		 * The partial-product bits of the wX x wY array covered by the tiles of solution
+		 * @return one flag per bit, the bit (x,y) at index y*wX+x
+		 */
+		static vector<uint8_t> coveredBits(list<mult_tile_t> &solution, int wX, int wY);
+
+		/** For each weight w=x+y, the number of bits of the array that are not covered */
+		static vector<int> uncoveredBitsPerColumn(const vector<uint8_t> &covered, int wX, int wY);
+
+		/** The sum of the columnCount[w].2^w, the propagation of the carries is done on machine integers */
+		static mpz_class weightedColumnSum(const vector<int> &columnCount);
+
 	protected:
 		/*!
 		 * The solution data structure represents a tiling solution
@@ -337,6 +337,15 @@ void TilingStrategyOptimalILP::constructProblem()
         solver->addConstraint(truncConstraint);
     }
 
+    //prune the tilings that are worse than the known one
+    if(0 <= costBound)
+    {
+        cout << "   adding the constraint to limit the cost to " << costBound << "..." << endl;
+        ScaLP::Constraint boundConstraint = obj <= costBound;
+        boundConstraint.name = "costBound";
+        solver->addConstraint(boundConstraint);
+    }
+
     // Set the Objective
     cout << "   setting objective (minimize cost function)..." << endl;
     solver->setObjective(ScaLP::minimize(obj));
@@ -371,32 +380,9 @@ void TilingStrategyOptimalILP::constructProblem()
     }
 
     bool TilingStrategyOptimalILP::checkTruncationError(list<TilingStrategy::mult_tile_t> &solution, unsigned guardBits, mpz_class errorBudget, mpz_class constant){
-        std::vector<std::vector<bool>> mulArea(wX, std::vector<bool>(wY,false));
-
-        for(auto & tile : solution) {
-            auto &parameters = tile.first;
-            auto &anchor = tile.second;
-            int xPos = anchor.first;
-            int yPos = anchor.second;
-
-            for(int x = 0; x < parameters.getMultXWordSize(); x++){
-                for(int y = 0; y < parameters.getMultYWordSize(); y++){
-                    if(0 <= xPos+x && 0 <= yPos+y && xPos+x < wX && yPos+y < wY)
-                        mulArea[xPos+x][yPos+y] = mulArea[xPos+x][yPos+y] || parameters.shapeValid(x,y);
-                }
-            }
-        }
-
-        mpz_class truncError, maxErr = errorBudget+constant;
-        truncError = mpz_class(0);
-        for(int y = 0; y < wY; y++){
-            for(int x = wX-1; 0 <= x; x--){
-                if(mulArea[x][y] == false)
-                    truncError += (mpz_class(1)<<(x+y));
-                //cout << ((mulArea[x][y] == true)?1:0);
-            }
-            //cout << endl;
-        }
+        vector<uint8_t> covered = TilingStrategy::coveredBits(solution, wX, wY);
+        mpz_class maxErr = errorBudget+constant;
+        mpz_class truncError = TilingStrategy::weightedColumnSum(TilingStrategy::uncoveredBitsPerColumn(covered, wX, wY));
 
         if(truncError <= maxErr){
             cout << "OK: actual truncation error=" << truncError << " is smaller than the max. permissible error=" << maxErr << " by " << maxErr-truncError << "." << endl;
@@ -41,6 +41,9 @@ public:
 
     void solve() override;
 
+    /** Restricts the search to the tilings of LUT cost at most bound, e.g. the cost of a known heuristic tiling */
+    void setCostBound(double bound) {costBound = bound;}
+
 private:
     float occupation_threshold_;
     int dpX, dpY, dpS, dpC, wS, max_pref_mult_;
@@ -49,6 +52,7 @@ private:
     unsigned long long  errorBudget;
     vector<BaseMultiplierCategory*> tiles;
     bool performOptimalTruncation;
+    double costBound = -1;
 #ifdef HAVE_SCALP
     void constructProblem();
 
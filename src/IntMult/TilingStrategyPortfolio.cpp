@@ -0,0 +1,207 @@
+#include "TilingStrategyPortfolio.hpp"
+#include "TilingStrategyGreedy.hpp"
+#include "TilingStrategyXGreedy.hpp"
+#include "TilingStrategyBeamSearch.hpp"
+#include "TilingStrategyOptimalILP.hpp"
+#include "utils.hpp"
+#include "UserInterface.hpp"
+#include "Operator.hpp"
+
+#include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+namespace flopoco {
+    TilingStrategyPortfolio::TilingStrategyPortfolio(
+            unsigned int wX,
+            unsigned int wY,
+            unsigned int wOut,
+            bool signedIO,
+            BaseMultiplierCollection* bmc,
+            base_multiplier_id_t prefered_multiplier,
+            float occupation_threshold,
+            int maxPrefMult,
+            bool useIrregular,
+            bool use2xk,
+            bool useSuperTiles,
+            bool useKaratsuba,
+            MultiplierTileCollection& tiles,
+            unsigned int beamRange,
+            unsigned guardBits,
+            unsigned keepBits,
+            mpz_class errorBudget,
+            mpz_class &centerErrConstant,
+            bool performOptimalTruncation,
+            bool useILP):TilingStrategy(wX, wY, wOut, signedIO, bmc),
+                                prefered_multiplier_{prefered_multiplier},
+                                occupation_threshold_{occupation_threshold},
+                                max_pref_mult_{maxPrefMult},
+                                useIrregular_{useIrregular},
+                                use2xk_{use2xk},
+                                useSuperTiles_{useSuperTiles},
+                                useKaratsuba_{useKaratsuba},
+                                tileCollection_{tiles},
+                                beamRange_{beamRange},
+                                guardBits_{guardBits},
+                                keepBits_{keepBits},
+                                errorBudget_{errorBudget},
+                                centerErrConstant_{centerErrConstant},
+                                performOptimalTruncation_{performOptimalTruncation},
+                                useILP_{useILP}
+    {
+        srcFileName = "TilingStrategyPortfolio";
+        uniqueName_ = "portfolio";
+        for(auto collection: {&tiles.MultTileCollection, &tiles.BaseTileCollection, &tiles.VariableXTileCollection, &tiles.VariableYTileCollection, &tiles.SuperTileCollection}) {
+            categories_.insert(categories_.end(), collection->begin(), collection->end());
+        }
+    }
+
+    TilingStrategy* TilingStrategyPortfolio::heuristic(int i) {
+        //each worker process works on its own copy of the tile collection
+        switch(i) {
+            case 0:
+                return new TilingStrategyGreedy(wX, wY, wOut, signedIO, baseMultiplierCollection, prefered_multiplier_, occupation_threshold_, max_pref_mult_,
+                                                useIrregular_, use2xk_, useSuperTiles_, useKaratsuba_, tileCollection_, guardBits_, keepBits_);
+            case 1:
+                return new TilingStrategyXGreedy(wX, wY, wOut, signedIO, baseMultiplierCollection, prefered_multiplier_, occupation_threshold_, max_pref_mult_,
+                                                 useIrregular_, use2xk_, useSuperTiles_, useKaratsuba_, tileCollection_, guardBits_, keepBits_);
+            default:
+                return new TilingStrategyBeamSearch(wX, wY, wOut, signedIO, baseMultiplierCollection, prefered_multiplier_, occupation_threshold_, max_pref_mult_,
+                                                    useIrregular_, use2xk_, useSuperTiles_, useKaratsuba_, tileCollection_, beamRange_, guardBits_, keepBits_);
+        }
+    }
+
+    void TilingStrategyPortfolio::solve() {
+        const vector<string> names = {"greedy", "XGreedy", "beam search"};
+        double bestCost = DBL_MAX;
+        int bestDSPs = INT_MAX;
+
+        forkMap(names.size(), UserInterface::workers,
+                [&](int i) {
+                    TilingStrategy* strategy = heuristic(i);
+                    string tiling;
+                    //a failing heuristic only removes a candidate, its error is passed instead of the tiling
+                    try {
+                        strategy->solve();
+                        tiling = serialize(strategy->getSolution());
+                    }
+                    catch(string &e) {
+                        tiling = "!" + e;
+                    }
+                    catch(std::exception &e) {
+                        tiling = string("!") + e.what();
+                    }
+                    catch(...) {
+                        tiling = "!unknown exception";
+                    }
+                    delete strategy;
+                    replace(tiling.begin(), tiling.end(), '\n', ' ');
+                    return tiling;
+                },
+                [&](int i, string tiling) {
+                    if(!tiling.empty() && tiling[0] == '!') {
+                        REPORT(INFO, "the " << names[i] << " tiling strategy failed: " << tiling.substr(1));
+                        return true;
+                    }
+                    if(tiling.empty()) {
+                        cerr << "WARNING: the " << names[i] << " tiling strategy found no solution" << endl;
+                        return true;
+                    }
+                    list<mult_tile_t> candidate = deserialize(tiling);
+                    pair<double, int> c = cost(candidate);
+                    REPORT(DETAILED, names[i] << " tiling has LUT cost " << c.first << " and uses " << c.second << " DSPs");
+                    if(c.first < bestCost || (c.first == bestCost && c.second < bestDSPs)) {
+                        bestCost = c.first;
+                        bestDSPs = c.second;
+                        solution = candidate;
+                    }
+                    return true;
+                });
+
+        if(!useILP_) {
+            return;
+        }
+#ifndef HAVE_SCALP
+        cerr << "WARNING: FloPoCo was not built with ScaLP, the portfolio tiling keeps the best heuristic solution" << endl;
+#else
+        //the ILP may update the constant, which is only valid if its solution is used
+        mpz_class ilpCenterErrConstant = centerErrConstant_;
+        TilingStrategyOptimalILP ilp(wX, wY, wOut, signedIO, baseMultiplierCollection, prefered_multiplier_, occupation_threshold_, max_pref_mult_,
+                                     tileCollection_, guardBits_, keepBits_, errorBudget_, ilpCenterErrConstant, performOptimalTruncation_);
+        if(bestCost < DBL_MAX) {
+            ilp.setCostBound(bestCost);
+        }
+        ilp.solve();
+
+        list<mult_tile_t> &ilpSolution = ilp.getSolution();
+        if(ilpSolution.empty()) { //infeasible with the bound, or timeout without solution
+            REPORT(DETAILED, "the ILP found no better tiling");
+            return;
+        }
+        pair<double, int> c = cost(ilpSolution);
+        REPORT(DETAILED, "ILP tiling has LUT cost " << c.first << " and uses " << c.second << " DSPs");
+        if(c.first <= bestCost) {
+            solution = ilpSolution;
+            centerErrConstant_ = ilpCenterErrConstant;
+        }
+#endif
+    }
+
+    pair<double, int> TilingStrategyPortfolio::cost(list<mult_tile_t> &tiling) {
+        double lutCost = 0;
+        int dsps = 0;
+        for(auto &tile: tiling) {
+            auto category = std::find(categories_.begin(), categories_.end(), tile.first.getCategory());
+            if(category == categories_.end()) {
+                throw string("TilingStrategyPortfolio: tile of type ") + tile.first.getMultType() + " not in the tile collection";
+            }
+            lutCost += (*category)->getLUTCost(tile.second.first, tile.second.second, wX, wY, signedIO);
+            dsps += (*category)->getDSPCost();
+        }
+        return make_pair(lutCost, dsps);
+    }
+
+    string TilingStrategyPortfolio::serialize(list<mult_tile_t> &tiling) {
+        //one line of text, as forkMap() passes the results of the workers
+        ostringstream s;
+        s << tiling.size();
+        for(auto &tile: tiling) {
+            auto &p = tile.first;
+            auto category = std::find(categories_.begin(), categories_.end(), p.getCategory());
+            if(category == categories_.end()) {
+                throw string("TilingStrategyPortfolio: tile of type ") + p.getMultType() + " not in the tile collection";
+            }
+            s << " " << (category - categories_.begin()) << " " << p.getMultXWordSize() << " " << p.getMultYWordSize()
+              << " " << p.isSignedMultX() << " " << p.isSignedMultY() << " " << p.getShapePara();
+            vector<int> weights = p.getOutputWeights();
+            s << " " << weights.size();
+            for(auto w: weights) {
+                s << " " << w;
+            }
+            s << " " << tile.second.first << " " << tile.second.second;
+        }
+        return s.str();
+    }
+
+    list<TilingStrategy::mult_tile_t> TilingStrategyPortfolio::deserialize(string str) {
+        istringstream s(str);
+        list<mult_tile_t> tiling;
+        size_t n;
+        s >> n;
+        for(size_t i = 0; i < n; i++) {
+            size_t category, nWeights;
+            int wX, wY, shape, x, y;
+            bool signedX, signedY;
+            s >> category >> wX >> wY >> signedX >> signedY >> shape >> nWeights;
+            vector<int> weights(nWeights);
+            for(auto &w: weights) {
+                s >> w;
+            }
+            s >> x >> y;
+            //the factories never flip a parametrization, so this is all there is to it
+            tiling.push_back(make_pair(categories_[category]->parametrize(wX, wY, signedX, signedY, shape, "undefined!", true, weights), make_pair(x, y)));
+        }
+        return tiling;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef FLOPOCO_TILINGSTRATEGYPORTFOLIO_HPP
+#define FLOPOCO_TILINGSTRATEGYPORTFOLIO_HPP
+
+#include "TilingStrategy.hpp"
+#include "MultiplierTileCollection.hpp"
+
+namespace flopoco {
+    /*!
+     * The TilingStrategyPortfolio class: runs the heuristic tiling strategies (greedy, XGreedy, beam search)
+     * in parallel worker processes and keeps the cheapest tiling.
+     * Optionally, the optimal ILP tiling is then computed, restricted to the tilings that improve on the best heuristic one.
+     */
+    class TilingStrategyPortfolio : public TilingStrategy {
+    public:
+        TilingStrategyPortfolio(
+                unsigned int wX,
+                unsigned int wY,
+                unsigned int wOut,
+                bool signedIO,
+                BaseMultiplierCollection* bmc,
+                base_multiplier_id_t prefered_multiplier,
+                float occupation_threshold,
+                int maxPrefMult,
+                bool useIrregular,
+                bool use2xk,
+                bool useSuperTiles,
+                bool useKaratsuba,
+                MultiplierTileCollection& tiles,
+                unsigned int beamRange,
+                unsigned guardBits,
+                unsigned keepBits,
+                mpz_class errorBudget,
+                mpz_class &centerErrConstant,
+                bool performOptimalTruncation,
+                bool useILP);
+
+        void solve() override;
+
+    private:
+        base_multiplier_id_t prefered_multiplier_;
+        float occupation_threshold_;
+        int max_pref_mult_;
+        bool useIrregular_;
+        bool use2xk_;
+        bool useSuperTiles_;
+        bool useKaratsuba_;
+        MultiplierTileCollection& tileCollection_;
+        unsigned int beamRange_;
+        unsigned guardBits_;
+        unsigned keepBits_;
+        mpz_class errorBudget_;
+        mpz_class &centerErrConstant_;
+        bool performOptimalTruncation_;
+        bool useILP_;
+
+        string srcFileName;               /**< useful only to enable same kind of reporting as for FloPoCo operators. */
+        string uniqueName_;               /**< useful only to enable same kind of reporting as for FloPoCo operators. */
+
+        /** All the tiles a strategy may place, the index in this vector identifies a tile category across processes */
+        vector<BaseMultiplierCategory*> categories_;
+
+        /** The heuristic strategy i of the portfolio */
+        TilingStrategy* heuristic(int i);
+
+        /** The LUT cost of a tiling, and its number of DSP blocks */
+        pair<double, int> cost(list<mult_tile_t> &tiling);
+
+        string serialize(list<mult_tile_t> &tiling);
+        list<mult_tile_t> deserialize(string s);
+    };
+}
+
+#endif //FLOPOCO_TILINGSTRATEGYPORTFOLIO_HPP
@@ -37,6 +37,7 @@
 */
 
 #include <iostream>
+#include <unordered_set>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -44,6 +45,7 @@
 #include <set>
 #include "Operator.hpp"  // Useful only for reporting. TODO split out the REPORT and THROWERROR #defines from Operator to another include.
 #include "utils.hpp"
+#include "BuildCache.hpp"
 #if 0 // these seem to be unused
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/variate_generator.hpp>
@@ -69,17 +71,20 @@ namespace flopoco{
 		stdLibType_                 = 0;						// unfortunately this is the historical default.
 		target_                     = target;
 		pipelineDepth_              = 0;
+		initiationInterval_         = 1;
 
 		myuid                       = getNewUId();
 		architectureName_			= "arch";
 		indirectOperator_           = NULL;
 		hasDelay1Feedbacks_         = false;
+		clockEnableTreeDepth_       = 0;
 
 		isShared_                   = false;
 		isTopLevelDotDrawn_ 		= false;
 		isLibraryComponent_         = false;
 		noParseNoSchedule_          = false;
 		isOperatorScheduled_        = false;
+		isSignalGraphReleased_      = false;
 
  		parentOp_                   = parentOp;
 		isOperatorApplyScheduleDone_= false;
@@ -472,6 +477,9 @@ namespace flopoco{
 
 		//search for the signal in the list of signals
 		if(!isSignalDeclared(name)) {
+			if(isSignalGraphReleased_)
+				THROWERROR("In getSignalByName, signal " << name << " of operator " << getName()
+									 << " was freed after the VHDL output (lowMemory option), only its IOs remain.");
 			//signal not found, throw an error
 			THROWERROR("In getSignalByName, signal " << name << " not declared (operator " << this << ").");
 		}
@@ -725,8 +733,11 @@ namespace flopoco{
 
 
 	void Operator::pipelineInfo(std::ostream& o){
-		if(isSequential())
+		if(isSequential()) {
 			o<<"-- Pipeline depth: " << getPipelineDepth() << " cycles"  <<endl;
+			if(getInitiationInterval() > 1)
+				o<<"-- Initiation interval: " << getInitiationInterval() << " cycles"  <<endl;
+		}
 		else
 			o << "-- combinatorial"  <<endl;
 
@@ -788,6 +799,16 @@ namespace flopoco{
 	}
 
 
+	int Operator::getInitiationInterval() {
+		return initiationInterval_;
+	}
+
+
+	void Operator::setInitiationInterval(int ii) {
+		initiationInterval_ = ii;
+	}
+
+
 
 
 	int Operator::getCycleFromSignal(string name, bool report) {
@@ -1109,6 +1130,84 @@ namespace flopoco{
 	}
 
 
+	void Operator::addFeedbackRegister(string copyName, string sourceName, string timeRefName, Signal::ResetType regType, int cycles)
+	{
+		Signal *s, *t;
+		try{
+			s = getSignalByName(sourceName);
+			t = getSignalByName(timeRefName);
+		}
+		catch(string &e2) {
+			THROWERROR("In addFeedbackRegister(): " << e2);
+		}
+		s->setResetType(regType);
+		if(cycles < 1)
+			THROWERROR("In addFeedbackRegister(): the feedback delay should be at least one cycle, got " << cycles);
+		vhdl << tab << declare(0.0, copyName, s->width(), s->isBus()) << " <= "<<sourceName<<"^"<<cycles<<";" << endl;
+		// The lexer has recorded a dependency from sourceName to the copy, which closes the loop and would prevent its scheduling.
+		// Move it to the signal graph now, and replace it with a dependency on timeRefName.
+		moveDependenciesToSignalGraph();
+		Signal* c = getSignalByName(copyName);
+		c->removePredecessor(s, cycles);
+		s->removeSuccessor(c, cycles);
+		c->addPredecessor(t, 0);
+		t->addSuccessor(c, 0);
+	}
+
+
+
+
+	void Operator::addMultiCycleCopy(string copyName, string sourceName, int cycles)
+	{
+		Signal *s;
+		try{
+			s = getSignalByName(sourceName);
+		}
+		catch(string &e2) {
+			THROWERROR("In addMultiCycleCopy(): " << e2);
+		}
+		vhdl << tab << declare(copyName, s->width(), s->isBus()) << " <= " << sourceName << "; -- valid " << cycles << " cycles later" << endl;
+		// Replace the dependency recorded by the lexer with a delayed one:
+		// the scheduler places the copy that many cycles later, and doApplySchedule() inserts no register for it.
+		moveDependenciesToSignalGraph();
+		Signal* c = getSignalByName(copyName);
+		c->removePredecessor(s, 0);
+		s->removeSuccessor(c, 0);
+		c->addPredecessor(s, cycles);
+		s->addSuccessor(c, cycles);
+	}
+
+
+	void Operator::addInputCounter(string loadName, string timeRefName, int ii)
+	{
+		if(ii < 2)
+			THROWERROR("In addInputCounter(): the initiation interval should be at least 2, got " << ii);
+		setInitiationInterval(ii);
+		setSequential();
+		string cnt = loadName + "_cnt";
+		int w = intlog2(ii-1);
+		vhdl << tab << "-- one input is accepted every " << ii << " cycles, when the counter is zero" << endl;
+		disablePipelining();
+		vhdl << tab << declare(cnt+"_next", w, true) << " <= " << zg(w) << " when " << cnt << " = CONV_STD_LOGIC_VECTOR(" << ii-1 << ", " << w << ") else " << cnt << " + 1;" << endl;
+		addFeedbackRegister(cnt, cnt+"_next", timeRefName, Signal::syncReset);
+		vhdl << tab << declare(loadName) << " <= '1' when " << cnt << " = " << zg(w) << " else '0';" << endl;
+		enablePipelining();
+	}
+
+
+	void Operator::addLoopEntry(string loopInName, string loopLoadName, string loadName, string initValue, int initSize, double loopDelay)
+	{
+		double cycleTime = 1.0/getTarget()->frequency() - getTarget()->ffDelay();
+		if(getTarget()->isPipelined() && loopDelay > cycleTime) {
+			REPORT(LIST, "WARNING: the loop takes about " << loopDelay*1e9 << "ns, more than the cycle time:"
+						 << " the target frequency will not be reached with an initiation interval of " << getInitiationInterval());
+		}
+		vhdl << tab << "-- the iteration loop, reused " << getInitiationInterval() << " times for each input" << endl;
+		// the contribution of loopIn is the critical path of the loop, so that the loop fits in one cycle
+		vhdl << tab << declare(min(loopDelay, cycleTime), loopInName, 1+initSize) << " <= " << loadName << " & " << initValue << ";" << endl;
+		disablePipelining();
+		vhdl << tab << declare(loopLoadName) << " <= " << loopInName << of(initSize) << ";" << endl;
+	}
 
 
 	void Operator::disablePipelining(){
@@ -1302,6 +1401,13 @@ namespace flopoco{
 			}
 		} // End of the I/O sanity check
 
+		// The input counter of an iterative sub-component (see addInputCounter()) counts from reset, not from the inputs of its parent:
+		// its inputs would only be loaded if the parent happened to schedule them on the right cycles.
+		// Only a top-level operator, that the test bench or a wrapper paces itself, may have an initiation interval larger than 1.
+		if(op->getInitiationInterval() > 1 && op->getParentOp() != nullptr)
+			THROWERROR("In instance() while trying to create a new instance of " << op->getName() << " called " << instanceName
+								 << ": this operator accepts an input only every " << op->getInitiationInterval() << " cycles, it cannot be used as a sub-component");
+
 #if 0
 		if(!op->isOperatorScheduled()) {
 			op->schedule();
@@ -1415,7 +1521,8 @@ namespace flopoco{
 									cloneOrActual = clone;
 								}
 						}
-						actual->setCriticalPathContribution(criticalPath);
+						// like declare(), ignore the delay where pipelining is disabled, e.g. in a loop
+						actual->setCriticalPathContribution(UserInterface::pipelineActive_ ? criticalPath : 0);
 						cloneNamesMap[actual->getName()] = cloneOrActual->getName();
 
 						for (auto i: inputActualList) {
@@ -1486,7 +1593,7 @@ namespace flopoco{
 		vhdl << this->instance(op, instanceName, false);
 	}
 
-	OperatorPtr Operator::newInstance(string opName, string instanceName, string parameters, string inPortMaps, string outPortMaps, string inPortMapsCst)
+	OperatorPtr Operator::newInstance(string opName, string instanceName, string parameters, string inPortMaps, string outPortMaps, string inPortMapsCst, bool cacheable)
 	{
 		OperatorFactoryPtr instanceOpFactory = UserInterface::getFactoryByName(opName);
 		OperatorPtr instance = nullptr;
@@ -1522,8 +1629,17 @@ namespace flopoco{
 		for (auto i: parametersVector){
 			REPORT(DEBUG, i);
 		}
-		//create the operator
-		instance = instanceOpFactory->parseArguments(this, target_, parametersVector);
+		//create the operator, or get it from the build cache
+		string cacheKey = (cacheable ? BuildCache::key(this, parametersVector, tmpInPortMap_) : "");
+		if(cacheKey != "") {
+			instance = BuildCache::lookup(this, target_, cacheKey);
+			if(instance != nullptr)
+				REPORT(DETAILED, "newInstance: " << instanceName << " (" << opName << ") found in the build cache");
+		}
+		if(instance == nullptr) {
+			instance = instanceOpFactory->parseArguments(this, target_, parametersVector);
+			instance->setBuildCacheKey(cacheKey);
+		}
 
 		REPORT(DEBUG, "   newInstance("<< opName << ", " << instanceName <<"): after factory call" );
 
@@ -1773,75 +1889,245 @@ namespace flopoco{
 			siglist.insert( siglist.end(), signalList_.begin(), signalList_.end() );
 			siglist.insert( siglist.end(), ioList_.begin(), ioList_.end() );
 
+			set<Signal*> delayLineSignals;
+			for(auto d: delayLines_)
+				delayLineSignals.insert(d.first);
+
+			// The registers are spread over the leaves of the clock enable tree, in declaration order.
+			// Without a tree there is a single leaf, ce itself.
+			vector<int> ceWidths = clockEnableTreeWidths();
+			int ceDepth = ceWidths.size();
+			int ceLeaves = (ceDepth == 0 ? 1 : ceWidths.back());
+			int ceFanout = (ceDepth == 0 ? 1 : getTarget()->clockEnableMaxFanout());
+			int ceLoad = 0; // the register bits already given to a leaf
+			// the first stages of the inputs of the root operator are free-running, see setupClockEnableTree()
+			int freeStages = (ceDepth > 0 && parentOp_ == nullptr ? ceDepth : 0);
+
 			// look up for delayed signals of various types, and build intermediate VHDL if needed
-			ostringstream regs, aregs, aregsinit, sregs, sregsinit;
+			ostringstream freeRegs;
+			vector<ostringstream> regs(ceLeaves), aregs(ceLeaves), aregsinit(ceLeaves), sregs(ceLeaves), sregsinit(ceLeaves);
 			for(auto s: siglist) {
-				if(s->getLifeSpan() > 0) { // This catches all the registered signals
+				if(s->getLifeSpan() > 0 && delayLineSignals.count(s) == 0) { // This catches all the registered signals
 					for(int j=1; j <= s->getLifeSpan(); j++) {
+						if (s->type() == Signal::in && j <= freeStages) {
+							freeRegs << tab << tab << tab << tab << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
+							continue;
+						}
+						int leaf = min(ceLeaves-1, ceLoad/ceFanout);
+						ceLoad += s->width();
 						if (s->resetType() == Signal::noReset) {
-							regs << recTab << tab << tab <<tab << tab << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
+							regs[leaf] << recTab << tab << tab <<tab << tab << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
 						}
 						if (s->resetType() == Signal::asyncReset) {
 							if ( (s->width()>1) || (s->isBus()))
-								aregsinit << recTab << tab << tab << tab << tab  << s->delayedName(j) << " <=  (others => '0');" << endl;
+								aregsinit[leaf] << recTab << tab << tab << tab << tab  << s->delayedName(j) << " <=  (others => '0');" << endl;
 							else
-								aregsinit << recTab << tab <<tab << tab << tab   << s->delayedName(j) << " <=  '0';" << endl;
-							aregs << recTab << tab << tab << tab << tab        << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
+								aregsinit[leaf] << recTab << tab <<tab << tab << tab   << s->delayedName(j) << " <=  '0';" << endl;
+							aregs[leaf] << recTab << tab << tab << tab << tab        << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
 						}
 						if (s->resetType() == Signal::syncReset) {
 							if ( (s->width()>1) || (s->isBus()))
-								sregsinit << recTab << tab << tab << tab << tab  << s->delayedName(j) << " <=  (others => '0');" << endl;
+								sregsinit[leaf] << recTab << tab << tab << tab << tab  << s->delayedName(j) << " <=  (others => '0');" << endl;
 							else
-								sregsinit << recTab << tab <<tab << tab << tab   << s->delayedName(j) << " <=  '0';" << endl;
-							sregs << recTab << tab << tab << tab << tab        << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
+								sregsinit[leaf] << recTab << tab <<tab << tab << tab   << s->delayedName(j) << " <=  '0';" << endl;
+							sregs[leaf] << recTab << tab << tab << tab << tab        << s->delayedName(j) << " <=  " << s->delayedName(j-1) <<";" << endl;
 						}						
 					}
 				}
 			}
 
 			// Now output the actual VHDL.
-			// First registers without reset
-			if (regs.str() != "") {
+			// First the clock enable tree and the input registers that match its latency, which are free-running
+			if (ceDepth > 0) {
 				o << tab << "process(clk)" << endl;
 				o << tab << tab << "begin" << endl;
 				o << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
-				if (hasClockEnable())
-					o << tab << tab << tab << tab << "if ce = '1' then" << endl;
-				o << regs.str();
-				if (hasClockEnable())
-					o << tab << tab << tab << tab << "end if;" << endl;
+				for(int level=1; level <= ceDepth; level++) {
+					for(int i=0; i < ceWidths[level-1]; i++) {
+						string father = (level == 1 ? "ce" : clockEnableName(level-1, i/ceFanout));
+						o << tab << tab << tab << tab << clockEnableName(level, i) << " <= " << father << ";" << endl;
+					}
+				}
+				o << freeRegs.str();
 				o << tab << tab << tab << "end if;\n";
 				o << tab << tab << "end process;\n";
 			}
 
-			// then registers with asynchronous reset
-			if (aregsinit.str() !="") {
-				o << tab << "process(clk, rst)" << endl;
-				o << tab << tab << "begin" << endl;
-				o << tab << tab << tab << "if rst = '1' then" << endl;
-				o << aregsinit.str();
-				o << tab << tab << tab << "elsif clk'event and clk = '1' then" << endl;
-			  if (hasClockEnable()) o << tab << tab << tab << tab << "if ce = '1' then" << endl;
-				o << aregs.str();
-				if (hasClockEnable())	o << tab << tab << tab << tab << "end if;" << endl;
-				o << tab << tab << tab << "end if;" << endl;
-				o << tab << tab <<"end process;" << endl;
-			}			
+			for(int leaf=0; leaf < ceLeaves; leaf++) {
+				string ce = clockEnableName(ceDepth, leaf);
+				// registers without reset
+				if (regs[leaf].str() != "") {
+					o << tab << "process(clk)" << endl;
+					o << tab << tab << "begin" << endl;
+					o << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
+					if (hasClockEnable())
+						o << tab << tab << tab << tab << "if " << ce << " = '1' then" << endl;
+					o << regs[leaf].str();
+					if (hasClockEnable())
+						o << tab << tab << tab << tab << "end if;" << endl;
+					o << tab << tab << tab << "end if;\n";
+					o << tab << tab << "end process;\n";
+				}
+
+				// then registers with asynchronous reset
+				if (aregsinit[leaf].str() !="") {
+					o << tab << "process(clk, rst)" << endl;
+					o << tab << tab << "begin" << endl;
+					o << tab << tab << tab << "if rst = '1' then" << endl;
+					o << aregsinit[leaf].str();
+					o << tab << tab << tab << "elsif clk'event and clk = '1' then" << endl;
+				  if (hasClockEnable()) o << tab << tab << tab << tab << "if " << ce << " = '1' then" << endl;
+					o << aregs[leaf].str();
+					if (hasClockEnable())	o << tab << tab << tab << tab << "end if;" << endl;
+					o << tab << tab << tab << "end if;" << endl;
+					o << tab << tab <<"end process;" << endl;
+				}			
+
+				// then registers with synchronous reset
+				if (sregsinit[leaf].str() !="") {
+					o << tab << "process(clk, rst)" << endl;
+					o << tab << tab << "begin" << endl;
+					o << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
+					o << tab << tab << tab << tab << "if rst = '1' then" << endl;
+					o << sregsinit[leaf].str();
+					o << tab << tab << tab << tab << "else" << endl;
+					if (hasClockEnable()) o << tab << tab << tab << tab << "if " << ce << " = '1' then" << endl;
+					o << sregs[leaf].str();
+					if (hasClockEnable())	o << tab << tab << tab << tab << "end if;" << endl;
+					o << tab << tab << tab << tab << "end if;" << endl;
+					o << tab << tab << tab << "end if;" << endl;
+					o << tab << tab << "end process;" << endl;
+				}
+			}
 
-			// then registers with synchronous reset
-			if (sregsinit.str() !="") {
-				o << tab << "process(clk, rst)" << endl;
+			// finally the delay lines, one process each
+			for(auto d: delayLines_) {
+				Signal* s = d.first;
+				string name = s->getName();
+				int depth = s->getLifeSpan();
+				string ce = clockEnableName(ceDepth, min(ceLeaves-1, ceLoad/ceFanout));
+				ceLoad += s->width();
+				o << tab << "process(clk)" << endl;
 				o << tab << tab << "begin" << endl;
 				o << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
-				o << tab << tab << tab << tab << "if rst = '1' then" << endl;
-				o << sregsinit.str();
-				o << tab << tab << tab << tab << "else" << endl;
-				if (hasClockEnable()) o << tab << tab << tab << tab << "if ce = '1' then" << endl;
-				o << sregs.str();
-				if (hasClockEnable())	o << tab << tab << tab << tab << "end if;" << endl;
-				o << tab << tab << tab << tab << "end if;" << endl;
+				if (hasClockEnable())
+					o << tab << tab << tab << tab << "if " << ce << " = '1' then" << endl;
+				if(d.second) {
+					// read-first circular buffer of depth-2 words, plus the RAM output register and the final one
+					o << recTab << tab << tab << tab << tab << name << "_ram(" << name << "_ptr) <= " << name << ";" << endl;
+					o << recTab << tab << tab << tab << tab << name << "_ramout <= " << name << "_ram(" << name << "_ptr);" << endl;
+					o << recTab << tab << tab << tab << tab << s->delayedName(depth) << " <= " << name << "_ramout;" << endl;
+					o << recTab << tab << tab << tab << tab << "if " << name << "_ptr = " << depth-3 << " then" << endl;
+					o << recTab << tab << tab << tab << tab << tab << name << "_ptr <= 0;" << endl;
+					o << recTab << tab << tab << tab << tab << "else" << endl;
+					o << recTab << tab << tab << tab << tab << tab << name << "_ptr <= " << name << "_ptr + 1;" << endl;
+					o << recTab << tab << tab << tab << tab << "end if;" << endl;
+				}
+				else {
+					o << recTab << tab << tab << tab << tab << name << "_srl <= " << name << " & " << name << "_srl(1 to " << depth-1 << ");" << endl;
+				}
+				if (hasClockEnable())
+					o << tab << tab << tab << tab << "end if;" << endl;
 				o << tab << tab << tab << "end if;" << endl;
 				o << tab << tab << "end process;" << endl;
+				// every tap remains available, synthesis removes the unused ones
+				if(!d.second) {
+					for(int j=1; j <= depth; j++)
+						o << tab << s->delayedName(j) << " <= " << name << "_srl(" << j << ");" << endl;
+				}
+			}
+		}
+		return o.str();
+	}
+
+
+	void Operator::mapDelayLines(const string &code)
+	{
+		delayLines_.clear();
+		if(!isSequential() || !getTarget()->useDelayLines())
+			return;
+
+		// The identifiers of the code, to find out which taps of the register chains are used
+		unordered_set<string> identifiers;
+		size_t start = string::npos;
+		for(size_t i=0; i <= code.size(); i++) {
+			bool idChar = i < code.size() && (isalnum(code[i]) || code[i] == '_');
+			if(idChar && start == string::npos)
+				start = i;
+			if(!idChar && start != string::npos) {
+				identifiers.insert(code.substr(start, i-start));
+				start = string::npos;
+			}
+		}
+
+		int minSRLDepth = getTarget()->shiftRegisterMinDepth();
+		bool freeInputs = parentOp_ == nullptr && hasClockEnable() && clockEnableTreeDepth_ > 0;
+		vector<Signal*> siglist;
+		siglist.insert( siglist.end(), signalList_.begin(), signalList_.end() );
+		siglist.insert( siglist.end(), ioList_.begin(), ioList_.end() );
+		for(auto s: siglist) {
+			int depth = s->getLifeSpan();
+			// registers with a reset can't go to SRLs or RAM
+			if(depth == 0 || s->resetType() != Signal::noReset || (s->type() != Signal::wire && s->type() != Signal::in))
+				continue;
+			// nor the inputs of the root whose first registers are free-running, see setupClockEnableTree()
+			if(freeInputs && s->type() == Signal::in)
+				continue;
+			bool intermediateTaps = false;
+			for(int j=1; j < depth; j++)
+				intermediateTaps = intermediateTaps || identifiers.count(s->delayedName(j)) > 0;
+
+			if(!intermediateTaps && getTarget()->delayInBlockRAM(s->width(), depth)) {
+				delayLines_.push_back(make_pair(s, true));
+				if (getTarget()->getVendor() == "Xilinx")
+					addAttribute("ram_style", "string", s->getName()+"_ram", "block", true);
+			}
+			else if(minSRLDepth > 0 && depth >= minSRLDepth) {
+				delayLines_.push_back(make_pair(s, false));
+				if (getTarget()->getVendor() == "Xilinx")
+					addAttribute("srl_style", "string", s->getName()+"_srl", "srl_reg", true);
+			}
+		}
+		if(!delayLines_.empty())
+			REPORT(DETAILED, "mapDelayLines(): " << delayLines_.size() << " register chains built as delay lines");
+	}
+
+
+	string Operator::buildVHDLDelayLineDeclarations()
+	{
+		ostringstream o;
+		for(auto d: delayLines_) {
+			Signal* s = d.first;
+			string name = s->getName();
+			int depth = s->getLifeSpan();
+			if(d.second) {
+				o << "type " << name << "_ram_t is array(0 to " << depth-3 << ") of" << s->toVHDLType() << ";" << endl;
+				o << "signal " << name << "_ram : " << name << "_ram_t;" << endl;
+				o << "signal " << name << "_ramout :" << s->toVHDLType() << ";" << endl;
+				o << "signal " << name << "_ptr : integer range 0 to " << depth-3 << " := 0;" << endl;
+			}
+			else {
+				o << "type " << name << "_srl_t is array(1 to " << depth << ") of" << s->toVHDLType() << ";" << endl;
+				o << "signal " << name << "_srl : " << name << "_srl_t;" << endl;
+			}
+		}
+		return o.str();
+	}
+
+
+	string Operator::buildVHDLClockEnableTreeDeclarations()
+	{
+		ostringstream o;
+		vector<int> widths = clockEnableTreeWidths();
+		for(unsigned level=1; level <= widths.size(); level++) {
+			for(int i=0; i < widths[level-1]; i++) {
+				string name = clockEnableName(level, i);
+				o << "signal " << name << " : std_logic;" << endl;
+				// the registers of the tree are identical by construction
+				if (getTarget()->getVendor() == "Xilinx")
+					addAttribute("keep", "string", name, "true", true);
+				else if (getTarget()->getVendor() == "Altera")
+					addAttribute("preserve", "boolean", name, "true", true);
 			}
 		}
 		return o.str();
@@ -1985,6 +2271,10 @@ namespace flopoco{
 		return subComponentList_;
 	}
 
+	map<string, OperatorPtr> Operator::getInstanceOps(){
+		return instanceOp_;
+	}
+
 	vector<Operator*>& Operator::getSubComponentListR(){
 		return subComponentList_;
 	}
@@ -2004,7 +2294,9 @@ namespace flopoco{
 				return;
 			}
 
-		if (! vhdl.isEmpty() ){
+		// str() flushes the buffer, so an empty code means an empty stream, as isEmpty() would tell, without copying the code twice
+		string code = vhdl.str();
+		if (! code.empty() ){
 			licence(o);
 			pipelineInfo(o);
 			signalSignature(o);
@@ -2013,9 +2305,12 @@ namespace flopoco{
 			stdLibs(o);
 			outputVHDLEntity(o);
 			newArchitecture(o,name);
+			mapDelayLines(getIndirectOperator() ? getIndirectOperator()->vhdl.str() : code);
 			o << buildVHDLComponentDeclarations();
 			o << buildVHDLTypeDeclarations();
 			o << buildVHDLSignalDeclarations();			//TODO: this cannot be called before scheduling the signals (it requires the lifespan of the signals, which is not yet computed)
+			o << buildVHDLDelayLineDeclarations();
+			o << buildVHDLClockEnableTreeDeclarations();
 			o << buildVHDLConstantDeclarations();
 			o << buildVHDLAttributes();
 			beginArchitecture(o);
@@ -2023,12 +2318,61 @@ namespace flopoco{
 			if(getIndirectOperator())
 				o << getIndirectOperator()->vhdl.str();
 			else
-				o << vhdl.str();
+				o << code;
 			endArchitecture(o);
 		}
 	}
 
 
+	void Operator::releaseVHDL() {
+		vhdl.release();
+	}
+
+
+	void Operator::releaseSignalGraph() {
+		// An interface operator shares its signals with its implementation
+		if(isSignalGraphReleased_ || getIndirectOperator())
+			return;
+		REPORT(DEBUG, "releaseSignalGraph(): freeing " << signalList_.size() << " internal signals");
+		unordered_set<Signal*> internal(signalList_.begin(), signalList_.end());
+
+		// Remove the edges that lead to the internal signals: from our IOs, and from the IOs of our subcomponents.
+		// The edges between our IOs and the signals of the parent operator remain.
+		vector<Signal*> boundary = ioList_;
+		for(auto op: subComponentList_)
+			boundary.insert(boundary.end(), op->getIOList()->begin(), op->getIOList()->end());
+		for(auto s: boundary) {
+			vector<pair<Signal*, int>> preds, succs;
+			for(auto p: *s->predecessors())
+				if(internal.find(p.first) == internal.end())
+					preds.push_back(p);
+			for(auto p: *s->successors())
+				if(internal.find(p.first) == internal.end())
+					succs.push_back(p);
+			*s->predecessors() = preds;
+			*s->successors() = succs;
+		}
+
+		for(auto s: signalList_)
+			delete s;
+		vector<Signal*>().swap(signalList_);
+		signalMap_.clear();
+		for(auto s: ioList_)
+			signalMap_[s->getName()] = s;
+
+		// Everything else that was only needed to build the VHDL
+		set<Signal*>().swap(alreadyScheduled);
+		set<string>().swap(allSignalsLowercased);
+		vector<triplet<string, string, int>>().swap(unresolvedDependenceTable);
+		instanceOp_.clear();
+		instanceActualIO_.clear();
+		constants_.clear();
+		types_.clear();
+		ostringstream().swap(dotDiagram);
+		isSignalGraphReleased_ = true;
+	}
+
+
 
 
 	// Comment by F2D: this whas parse2().
@@ -2049,6 +2393,8 @@ namespace flopoco{
 
 		//set the old code to the vhdl code stored in the FlopocoStream
 		oldStr = vhdl.str();
+		// from now on the code stream is only a second copy of oldStr: free it
+		ostringstream().swap(vhdl.vhdlCode);
 
 		//iterate through the old code, one statement at the time
 		// code that doesn't need to be modified: goes directly to the new vhdl code buffer
@@ -2401,14 +2747,20 @@ namespace flopoco{
 					if(isSequential() && !unknownLHSName && !unknownRHSName) {
 						// Should we insert a pipeline register ?
 						int deltaCycle = lhsSignal->getCycle() - rhsSignal->getCycle();
-						if(deltaCycle>0)
-							newStr << "_d" << vhdlize(deltaCycle);
-					
-						// Should we insert a functional register ? This case is exclusive with the previous as long as functional delays are introduced only by the functionalRegister method.
+						// The cycles of a multi-cycle copy need no pipeline register, see addMultiCycleCopy()
+						if(functionalDelay == 0) {
+							for(auto p: *lhsSignal->predecessors())
+								if(p.first == rhsSignal && p.second > 0)
+									deltaCycle -= p.second;
+						}
+						// Should we insert a functional register ? Both delays add up on the same register chain:
+						// this happens when the source is an input delayed by the clock enable tree, see setupClockEnableTree()
 						if(functionalDelay>0) {
-							getSignalByName(newRhsName) -> updateLifeSpan(functionalDelay); // wonder where it is done for pipeline registers???
-							newStr << "_d" << vhdlize(functionalDelay);
+							deltaCycle = max(deltaCycle, 0) + functionalDelay;
+							getSignalByName(newRhsName) -> updateLifeSpan(deltaCycle); // wonder where it is done for pipeline registers???
 						}
+						if(deltaCycle>0)
+							newStr << "_d" << vhdlize(deltaCycle);
 					}
 					
 					//find the next rhsName, if there is one
@@ -2438,6 +2790,7 @@ namespace flopoco{
 
 		//copy the remaining code to the vhdl code buffer
 		newStr << oldStr.substr(currentPos, oldStr.size()-currentPos);
+		string().swap(oldStr); // free it before the new code gets copied into the stream
 
 		vhdl.setSecondLevelCode(newStr.str());
 
@@ -2850,7 +3203,8 @@ namespace flopoco{
 				if((targetSignal->parentOp()->getName() != i.first->parentOp()->getName()) &&
 					 (i.first->type() == Signal::out))
 					continue;
-				i.first->updateLifeSpan(targetSignal->getCycle() - i.first->getCycle());
+				// a positive delay on the dependency is covered by the predecessor itself, see addMultiCycleCopy()
+				i.first->updateLifeSpan(targetSignal->getCycle() - i.first->getCycle() - max(0, i.second));
 			}
 
 		targetSignal->setHasBeenScheduled(true);
@@ -2859,6 +3213,147 @@ namespace flopoco{
 
 
 
+	void Operator::retime()
+	{
+		vector<Signal*> candidates;
+		collectRetimingCandidates(candidates);
+		double maxCriticalPath = 1.0 / getTarget()->frequency() - getTarget()->ffDelay();
+
+		int savedBits = 0;
+		bool moved = true;
+		// Each move may enable others (a predecessor registered anyway), hence a few passes
+		for(int pass = 0; moved && pass < 10; pass++) {
+			moved = false;
+			// latest signals first, so that the successors of a signal have already been moved
+			sort(candidates.begin(), candidates.end(),
+					 [](Signal* a, Signal* b) { return a->getCycle() > b->getCycle(); });
+			for(auto s: candidates) {
+				// the signal may not move beyond its first consumer
+				int latest = INT_MAX;
+				for(auto i: *s->successors())
+					latest = min(latest, i.first->getCycle());
+				if(latest == INT_MAX || latest <= s->getCycle())
+					continue;
+
+				vector<pair<int,int>> moves; // (gain, cycle)
+				for(int cycle = s->getCycle()+1; cycle <= latest; cycle++) {
+					int gain = retimingGain(s, cycle);
+					if(gain > 0)
+						moves.push_back(make_pair(gain, cycle));
+				}
+				sort(moves.rbegin(), moves.rend());
+				for(auto m: moves) {
+					int from = s->getCycle();
+					if(tryRetiming(s, m.second, maxCriticalPath)) {
+						REPORT(DEBUG, "retime(): moved " << s->getUniqueName() << " from cycle " << from << " to cycle " << m.second << ", saving " << m.first << " register bits");
+						savedBits += m.first;
+						moved = true;
+						break;
+					}
+				}
+			}
+		}
+		REPORT(DETAILED, "retime(): saved " << savedBits << " register bits");
+	}
+
+
+
+	void Operator::collectRetimingCandidates(vector<Signal*> &candidates)
+	{
+		if(isShared() || noParseNoSchedule_ || isOperatorApplyScheduleDone_)
+			return;
+		for(auto s: signalList_) {
+			if(s->type() != Signal::wire || !s->hasBeenScheduled())
+				continue;
+			// multi-cycle signals (DSP blocks, block RAMs) stay where the scheduler put them
+			if(s->getCriticalPathContribution() > 1.0 / getTarget()->frequency() - getTarget()->ffDelay())
+				continue;
+			// only plain combinatorial dependencies within this operator: no functional delay, no port of a subcomponent
+			bool movable = true;
+			for(auto i: *s->predecessors())
+				movable = movable && i.second == 0 && i.first->parentOp() == this;
+			for(auto i: *s->successors())
+				movable = movable && i.second == 0 && i.first->parentOp() == this;
+			if(movable)
+				candidates.push_back(s);
+		}
+		for(auto op: subComponentList_)
+			op->collectRetimingCandidates(candidates);
+	}
+
+
+
+	int Operator::retimingGain(Signal* s, int cycle)
+	{
+		// the register chain of s gets shorter
+		int gain = s->width() * (cycle - s->getCycle());
+		// the register chains of its predecessors may get longer
+		set<Signal*> predecessors;
+		for(auto i: *s->predecessors()) {
+			Signal* p = i.first;
+			if((p->type() == Signal::constant) || (p->type() == Signal::constantWithDeclaration) || !predecessors.insert(p).second)
+				continue;
+			gain -= p->width() * max(0, cycle - p->getCycle() - p->getLifeSpan());
+		}
+		return gain;
+	}
+
+
+
+	bool Operator::tryRetiming(Signal* s, int cycle, double maxCriticalPath)
+	{
+		int oldCycle = s->getCycle();
+		map<Signal*, double> oldCriticalPaths;
+		oldCriticalPaths[s] = s->getCriticalPath();
+
+		// all the predecessors of s now come from registers
+		s->setCycle(cycle);
+		s->setCriticalPath(s->getCriticalPathContribution());
+
+		// the consumers of s in its new cycle no longer start from a register: propagate the longer critical paths
+		bool ok = true;
+		vector<Signal*> front(1, s);
+		while(ok && !front.empty()) {
+			Signal* u = front.back();
+			front.pop_back();
+			for(auto i: *u->successors()) {
+				Signal* t = i.first;
+				if(i.second != 0 || t->getCycle() != u->getCycle())
+					continue;
+				double criticalPath = u->getCriticalPath() + t->getCriticalPathContribution();
+				if(criticalPath <= t->getCriticalPath())
+					continue;
+				if(criticalPath > maxCriticalPath) {
+					ok = false;
+					break;
+				}
+				if(oldCriticalPaths.find(t) == oldCriticalPaths.end())
+					oldCriticalPaths[t] = t->getCriticalPath();
+				t->setCriticalPath(criticalPath);
+				front.push_back(t);
+			}
+		}
+
+		if(!ok) {
+			s->setCycle(oldCycle);
+			for(auto i: oldCriticalPaths)
+				i.first->setCriticalPath(i.second);
+			return false;
+		}
+
+		// the register chains, as setSignalTiming() would have built them
+		for(auto i: *s->predecessors())
+			i.first->updateLifeSpan(cycle - i.first->getCycle());
+		int lifeSpan = 0;
+		for(auto i: *s->successors())
+			lifeSpan = max(lifeSpan, i.first->getCycle() - cycle);
+		s->setLifeSpan(lifeSpan);
+		return true;
+	}
+
+
+
+
 	void Operator::computePipelineDepths()
 	{
 		// first compute it for the subcomponents
@@ -2878,7 +3373,8 @@ namespace flopoco{
 		REPORT(DEBUG, "Input timing:  " << in.str());
 		REPORT(DEBUG, "Output timing: " << out.str());
 		
-		int maxInputCycle  = -1;
+		// the inputs of the root may start before cycle 0, see setupClockEnableTree()
+		int maxInputCycle  = INT_MIN;
 		int maxOutputCycle = -1;
 
 		for(auto i: ioList_) {
@@ -2897,6 +3393,8 @@ namespace flopoco{
 				REPORT(DEBUG, "A warining from computePipelineDepths(): this operator's outputs are not synchronized!");
 		}
 
+		if(maxInputCycle == INT_MIN) // no input
+			maxInputCycle = -1;
 		pipelineDepth_ = maxOutputCycle-maxInputCycle;
 	}
 
@@ -2989,12 +3487,14 @@ namespace flopoco{
 			file << tabs << "ratio=auto;\n";
 
 		//check if it's worth drawing the subcomponent in the compact style
-		int maxInputCycle = -1, maxOutputCycle = -1;
+		int maxInputCycle = INT_MIN, maxOutputCycle = -1;
 		for(int i=0; (unsigned int)i<ioList_.size(); i++)
 			if((ioList_[i]->type() == Signal::in) && (ioList_[i]->getCycle() > maxInputCycle))
 				maxInputCycle = ioList_[i]->getCycle();
 			else if((ioList_[i]->type() == Signal::out) && (ioList_[i]->getCycle() > maxOutputCycle))
 				maxOutputCycle = ioList_[i]->getCycle();
+		if(maxInputCycle == INT_MIN) // no input, as in computePipelineDepths()
+			maxInputCycle = -1;
 		//if the inputs and outputs of a subcomponent are at the same cycle,
 		//	then it's probably not worth drawing the operator in the compact style
 		if((maxOutputCycle-maxInputCycle < 1) && (dotDrawingMode == "compact") && (mode == 2))
@@ -3292,6 +3792,14 @@ namespace flopoco{
 		throw std::string("emulate() not implemented for ") + uniqueName_;
 	}
 
+	bool Operator::emulateReference(TestCase * tc) {
+		return false;
+	}
+
+	bool Operator::hasThreadSafeEmulate() {
+		return false;
+	}
+
 	bool Operator::hasComponent(string s){
 		return (getSubComponent(s) != NULL);
 	}
@@ -3332,6 +3840,7 @@ namespace flopoco{
 		stdLibType_                 = op->getStdLibType();
 		isSequential_               = op->isSequential();
 		pipelineDepth_              = op->getPipelineDepth();
+		initiationInterval_         = op->getInitiationInterval();
 		signalMap_                  = op->getSignalMap();
 		constants_                  = op->getConstants();
 		attributes_                 = op->getAttributes();
@@ -3342,6 +3851,7 @@ namespace flopoco{
 		headerComment_              = op->headerComment_;
 		copyrightString_            = op->getCopyrightString();
 		hasClockEnable_             = op->hasClockEnable();
+		clockEnableTreeDepth_       = op->clockEnableTreeDepth_;
 		indirectOperator_           = op->getIndirectOperator();
 		hasDelay1Feedbacks_         = op->hasDelay1Feedbacks();
 
@@ -3350,6 +3860,8 @@ namespace flopoco{
 
 		isShared_                   = op->isShared();
 		isLibraryComponent_         = op->isLibraryComponent();
+		buildCacheKey_              = op->getBuildCacheKey();
+		isSignalGraphReleased_      = op->isSignalGraphReleased_;
 
 		resourceEstimate.str(op->resourceEstimate.str());
 		resourceEstimateReport.str(op->resourceEstimateReport.str());
@@ -3611,6 +4123,14 @@ namespace flopoco{
 		return isShared_;
 	}
 
+	string Operator::getBuildCacheKey(){
+		return buildCacheKey_;
+	}
+
+	void Operator::setBuildCacheKey(string key){
+		buildCacheKey_ = key;
+	}
+
 	void Operator::setLibraryComponent(){
 		isLibraryComponent_ = true;
 	}
@@ -3623,10 +4143,99 @@ namespace flopoco{
 		return generics_;
 	}
 
+	int Operator::clockEnableLoad()
+	{
+		vector<Signal*> siglist;
+		siglist.insert( siglist.end(), signalList_.begin(), signalList_.end() );
+		siglist.insert( siglist.end(), ioList_.begin(), ioList_.end() );
+		int load = 0;
+		for(auto s: siglist) {
+			int stages = s->getLifeSpan();
+			// the registers that delay the inputs of the root operator are free-running
+			if(parentOp_ == nullptr && s->type() == Signal::in)
+				stages -= clockEnableTreeDepth_;
+			if(stages > 0)
+				load += s->width() * stages;
+		}
+		return load;
+	}
+
+
+	int Operator::maxClockEnableLoad()
+	{
+		int load = clockEnableLoad();
+		for(auto op: subComponentList_)
+			load = max(load, op->maxClockEnableLoad());
+		return load;
+	}
+
+
+	void Operator::setClockEnableTreeDepth(int depth)
+	{
+		clockEnableTreeDepth_ = depth;
+		for(auto op: subComponentList_)
+			op->setClockEnableTreeDepth(depth);
+	}
+
+
+	vector<int> Operator::clockEnableTreeWidths()
+	{
+		vector<int> widths;
+		if(!hasClockEnable() || clockEnableTreeDepth_ == 0)
+			return widths;
+		int fanout = getTarget()->clockEnableMaxFanout();
+		int maxLeaves = 1;
+		for(int j = 0; j < clockEnableTreeDepth_ && maxLeaves <= INT_MAX/fanout; j++)
+			maxLeaves *= fanout;
+		int leaves = (clockEnableLoad() + fanout - 1) / fanout;
+		widths.push_back(max(1, min(leaves, maxLeaves)));
+		while((int)widths.size() < clockEnableTreeDepth_)
+			widths.insert(widths.begin(), (widths.front() + fanout - 1) / fanout);
+		return widths;
+	}
+
+
+	string Operator::clockEnableName(int level, int node)
+	{
+		if(!hasClockEnable() || clockEnableTreeDepth_ == 0)
+			return "ce";
+		return join("ce_l", level, "_", node);
+	}
+
+
+	void Operator::setupClockEnableTree()
+	{
+		int fanout = getTarget()->clockEnableMaxFanout();
+		int leaves = (maxClockEnableLoad() + fanout - 1) / fanout;
+		int depth = 0;
+		for(long reach = 1; reach < leaves; reach *= fanout)
+			depth++;
+		REPORT(DETAILED, "setupClockEnableTree(): fanout " << fanout << ", depth " << depth);
+		if(depth == 0)
+			return;
+
+		// The inputs enter the design D cycles before the registers see the corresponding ce
+		for(auto s: ioList_) {
+			if(s->type() == Signal::in) {
+				s->setCycle(s->getCycle() - depth);
+				s->updateLifeSpan(s->getLifeSpan() + depth);
+			}
+		}
+		setClockEnableTreeDepth(depth);
+		REPORT(INFO, "Clock enable distributed by a tree of depth " << depth << ", which adds " << depth << " cycles of latency");
+	}
+
+
 	void Operator::applySchedule()
 	{
 		// launch the second VHDL parsing step. Works for sequential and combinatorial operators as well
 		if(!isOperatorApplyScheduleDone_) {
+			// retiming must see the whole schedule, hence is only performed from the root
+			if(parentOp_ == nullptr && getTarget()->isPipelined() && getTarget()->retiming())
+				retime();
+			// so is the clock enable tree, which must see the final lifespans
+			if(parentOp_ == nullptr && isSequential() && hasClockEnable() && getTarget()->isPipelined() && getTarget()->useClockEnableTree())
+				setupClockEnableTree();
 			isOperatorApplyScheduleDone_=true;
 			doApplySchedule();
 			// recursive call for the operator's subcomponents
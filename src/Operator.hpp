@@ -612,6 +612,65 @@ namespace flopoco {
 		 */
 		void  addRegisteredSignalCopy(string registeredCopyName, string sourceName, Signal::ResetType regType=Signal::noReset);
 
+		/**
+		 * addFeedbackRegister closes a feedback loop (e.g. an accumulator) in the middle of a pipeline.
+		 * Like addRegisteredSignalCopy, it declares registeredCopyName as sourceName delayed by functional registers (one by default),
+		 * but sourceName is typically computed out of registeredCopyName.
+		 * The registered copy is scheduled in the cycle of timeRefName instead of cycle 0,
+		 * so that the loop sits where its inputs arrive.
+		 * The loop itself (from registeredCopyName to sourceName) must be declared with pipelining disabled, so that it fits in one cycle:
+		 * its delay should be accounted for in the critical path contribution of timeRefName.
+		 * @param registeredCopyName as the name suggests
+		 * @param sourceName  the signal to register, already declared
+		 * @param timeRefName an already declared signal that gives the cycle of the loop
+		 * @param sigType the type of delay inserted (with or without reset, etc...), defaults to usual pipeline register without reset
+		 * @param cycles the number of registers in the loop. Without reset, a long loop is built as a delay line (see mapDelayLines())
+		 */
+		void  addFeedbackRegister(string registeredCopyName, string sourceName, string timeRefName, Signal::ResetType regType=Signal::noReset, int cycles=1);
+
+		/**
+		 * addMultiCycleCopy takes the result out of an iterative loop built with addFeedbackRegister().
+		 * Such a loop is scheduled in one cycle, but its result for a given input is only valid
+		 * after it has iterated for some more cycles.
+		 * copyName is declared as a plain copy of sourceName, scheduled that many cycles later,
+		 * without pipeline register in between:
+		 * the signals computed out of it, and the latency of the operator, account for the iterations.
+		 * @param copyName the name of the copy
+		 * @param sourceName the loop signal that holds the result in the last cycle of the iterations
+		 * @param cycles the number of cycles between the cycle of sourceName and the one where it holds the result
+		 */
+		void  addMultiCycleCopy(string copyName, string sourceName, int cycles);
+
+		/**
+		 * addInputCounter builds the control of an iterative operator that accepts an input every ii cycles:
+		 * it sets the initiation interval to ii (see getInitiationInterval()), makes the operator sequential
+		 * since the loop needs its registers even if the target is not pipelined,
+		 * and declares loadName, which is '1' in the cycles where an input is accepted.
+		 * It is computed out of a modulo-ii counter with synchronous reset, so inputs are accepted
+		 * in the cycle after reset, then every ii cycles.
+		 * @param loadName the name of the load signal; the counter is called loadName_cnt
+		 * @param timeRefName an already declared signal that gives the cycle of the counter, typically an input
+		 * @param ii the initiation interval, at least 2
+		 */
+		void  addInputCounter(string loadName, string timeRefName, int ii);
+
+		/**
+		 * addLoopEntry opens an iterative loop, reused for each input during the initiation interval (see addInputCounter()).
+		 * Such a loop is built as the accumulation loop of FPLargeAcc: with pipelining disabled, closed by addFeedbackRegister() with loopInName as time reference,
+		 * and its results are taken out by addMultiCycleCopy().
+		 * This method declares loopInName as the concatenation of loadName and initValue. Its critical path contribution is the delay of the loop,
+		 * so that the loop is scheduled in one cycle; a warning is issued if it does not fit in a cycle.
+		 * Then it disables pipelining for the loop body, and declares loopLoadName as the load bit of loopInName.
+		 * The loop body selects its state out of loopInName(initSize-1 downto 0) when loopLoadName is '1', and out of the feedback registers otherwise.
+		 * @param loopInName the name of the input of the loop
+		 * @param loopLoadName the name of the load bit inside the loop
+		 * @param loadName the load signal built by addInputCounter()
+		 * @param initValue the expression of the initial state of the loop
+		 * @param initSize its size
+		 * @param loopDelay the critical path of the loop body
+		 */
+		void  addLoopEntry(string loopInName, string loopLoadName, string loadName, string initValue, int initSize, double loopDelay);
+
 		/**
 		 * Disables pipeline locally. All the delays passed to declare() will be ignored until the next invokation of  enablePipelining();
 		 */
@@ -693,8 +752,9 @@ namespace flopoco {
 		 * 				specified as a string containing 'portName=>signalName' separated by ','(as on VHDL port maps)
 		 * @param inPortMapsCst the constant port mappings for the inputs, if there are any
 		 * 				specified as a string containing 'portName=>signalName' separated by ','(as on VHDL port maps)
+		 * @param cacheable false if the caller needs the actual operator object, which the build cache can't provide
 		 */
-		OperatorPtr newInstance(string opName, string instanceName, string parameters, string inPortMaps, string outPortMaps, string inPortMapsCst = "");
+		OperatorPtr newInstance(string opName, string instanceName, string parameters, string inPortMaps, string outPortMaps, string inPortMapsCst = "", bool cacheable = true);
 
 		/**
 		 * Create a new instance of a shared operator that has been constructed beforehand.inside
@@ -775,6 +835,22 @@ namespace flopoco {
 		 */
 		virtual void emulate(TestCase * tc);
 
+		/**
+		 * A second, independent model of the operator, typically a bit-exact model of the generated architecture.
+		 * It fills tc with the single value the hardware should output, which is then checked against the
+		 * set of values allowed by emulate() (see TestBench simulate=false).
+		 * @param tc the test case, filled with the input values, to be filled with the output values.
+		 * @return false if the operator does not provide such a model (the default)
+		 */
+		virtual bool emulateReference(TestCase * tc);
+
+		/**
+		 * Tells if emulate() and emulateReference() may be called concurrently from several threads
+		 * (see TestBench threads=), which requires them to keep no state in the operator.
+		 * @return false by default: an operator has to opt in
+		 */
+		virtual bool hasThreadSafeEmulate();
+
 		/**
 		 * Append standard test cases to a test case list. Standard test
 		 * cases are operator-dependent and should include any specific
@@ -848,6 +924,26 @@ namespace flopoco {
 		 */
 		string buildVHDLRegisters();
 
+		/**
+		 * Choose the register chains that are built as delay lines instead of flip-flops:
+		 * a shift register (SRL) above Target::shiftRegisterMinDepth(),
+		 * or a block RAM circular buffer when Target::delayInBlockRAM() and only the last tap is used.
+		 * Adds the corresponding synthesis attributes.
+		 * @param code the final VHDL code of the architecture body, where the used taps are looked up
+		 */
+		void mapDelayLines(const string &code);
+
+		/**
+		 * Build the type and signal declarations of the delay lines chosen by mapDelayLines()
+		 */
+		string buildVHDLDelayLineDeclarations();
+
+		/**
+		 * Build the signal declarations of the clock enable tree chosen by setupClockEnableTree(),
+		 * and add the attributes that prevent synthesis from merging its registers back
+		 */
+		string buildVHDLClockEnableTreeDeclarations();
+
 		/**
 		 * Build all the type declarations.
 		 */
@@ -883,6 +979,21 @@ namespace flopoco {
 		 */
 		void outputVHDL(std::ostream& o);
 
+		/**
+		 * Frees the VHDL code of the operator once it has been output.
+		 * Its interface, its signals and its timing remain available, e.g. for the final report,
+		 * but outputVHDL() will output nothing any more.
+		 */
+		void releaseVHDL();
+
+		/**
+		 * Frees the internal signal graph of the operator once its VHDL has been output.
+		 * Only the IOs, with their timing, and the pipeline depth remain.
+		 * Any later getSignalByName() on an internal signal throws an error.
+		 * Used by the lowMemory generic option.
+		 */
+		void releaseSignalGraph();
+
 
 
 		/**
@@ -1091,6 +1202,19 @@ namespace flopoco {
 		 * Computes pipeline depth after scheduling, for this operator and all its subcomponents
 		 */
 		void computePipelineDepths();
+
+		/**
+		 * Returns the number of cycles between two successive inputs: 1 for a fully pipelined operator,
+		 * more for an iterative operator that reuses its datapath for each input (see addMultiCycleCopy()).
+		 * The test bench holds each test case this number of cycles.
+		 * Such an operator can only be a top-level one, see instance().
+		 */
+		int getInitiationInterval();
+
+		/**
+		 * Sets the initiation interval of the operator, see getInitiationInterval()
+		 */
+		void setInitiationInterval(int ii);
 		/**
 		 * Return the target member
 		 */
@@ -1133,7 +1257,7 @@ namespace flopoco {
 
 		bool getHasRegistersWithSyncReset();
 
-		bool hasReset();
+		virtual bool hasReset();
 
 		bool hasClockEnable();
 
@@ -1149,6 +1273,9 @@ namespace flopoco {
 
 		vector<Operator*>& getSubComponentListR();
 
+		/** The operator of each instance, by instance name: a shared operator appears once per instance */
+		map<string, OperatorPtr> getInstanceOps();
+
 
 		bool hasComponent(string s);
 
@@ -1197,6 +1324,54 @@ namespace flopoco {
 		 */
 		void setSignalTiming(Signal* targetSignal);
 
+		/**
+		 * Register-saving retiming of the ASAP schedule of this root operator (generic option retiming=1).
+		 * A signal that is consumed in later cycles is moved to a later cycle
+		 * when registering its predecessors costs fewer bits than registering the signal itself,
+		 * typically for signals wider than their inputs (zero padding, sign extension, concatenations).
+		 * Inputs and outputs keep their cycles, so the latency is unchanged,
+		 * and a move is only accepted if the critical paths it lengthens still fit in the target period.
+		 * Called by applySchedule(), before the VHDL is rewritten according to the schedule.
+		 */
+		void retime();
+
+		/** The signals of this operator and its unique subcomponents that retime() may move */
+		void collectRetimingCandidates(vector<Signal*> &candidates);
+
+		/** The register bits saved by moving s to cycle (may be negative) */
+		int retimingGain(Signal* s, int cycle);
+
+		/** Moves s to cycle if the critical paths remain within maxCriticalPath, otherwise leaves the schedule untouched */
+		bool tryRetiming(Signal* s, int cycle, double maxCriticalPath);
+
+		/**
+		 * Clock enable tree of this root operator (generic options clockEnable=1 clockEnableTree=1).
+		 * Instead of driving all the pipeline registers, ce drives a pipelined tree of registers,
+		 * each of which drives at most Target::clockEnableMaxFanout() loads.
+		 * The depth D of the tree is the one required by the largest entity of the hierarchy,
+		 * and every entity builds its own tree of depth D from its ce input,
+		 * so that all the registers of the design see ce delayed by D cycles.
+		 * The inputs of the root operator are delayed accordingly by D free-running registers:
+		 * the operator behaves as its plain clock enable version, with D more cycles of latency.
+		 * Called by applySchedule(), before the VHDL is rewritten according to the schedule.
+		 */
+		void setupClockEnableTree();
+
+		/** The number of register bits driven by the clock enable of this entity */
+		int clockEnableLoad();
+
+		/** The largest clockEnableLoad() of this operator and all its subcomponents */
+		int maxClockEnableLoad();
+
+		/** Sets the depth of the clock enable tree of this operator and all its subcomponents */
+		void setClockEnableTreeDepth(int depth);
+
+		/** The number of registers of each level of the clock enable tree, the last level being the leaves */
+		vector<int> clockEnableTreeWidths();
+
+		/** The name of a register of the clock enable tree: ce itself when there is no tree */
+		string clockEnableName(int level, int node);
+
 
 		/**
 		 * Start drawing the dot diagram for this Operator
@@ -1311,6 +1486,13 @@ namespace flopoco {
 		 */
 		bool isLibraryComponent();
 
+		/**
+		 * The key of this operator in the build cache, empty if it was not built through a cacheable newInstance() (see BuildCache)
+		 */
+		string getBuildCacheKey();
+
+		void setBuildCacheKey(string key);
+
 		/**
 		 * Has the dot file having this operator as top level one been produced 
 		 */
@@ -1757,6 +1939,7 @@ private:
 	int                    stdLibType_;                     /**< 0 will use the Synopsys ieee.std_logic_unsigned, -1 uses std_logic_signed, 1 uses ieee numeric_std  (preferred) */
 	bool                   isSequential_;                   /**< True if the operator needs a clock signal */
 	int                    pipelineDepth_;                  /**< The pipeline depth of the operator. 0 for combinatorial circuits. A non-pipelined signal can still be sequential, e.g. a FIR. */
+	int                    initiationInterval_;             /**< The number of cycles between two successive inputs, 1 for a fully pipelined operator */
 	map<string, Signal*>   signalMap_;                      /**< A dictionary of signals, for recovering a signal based on it's name */
 	map<string, OperatorPtr> instanceOp_ ;                  /**< A map to get instance info   */
 	map<string, vector<string>> instanceActualIO_ ;         /**< A map to get instance info. This list is in the same order as the ioList of the subcomponent   */
@@ -1765,11 +1948,13 @@ private:
 	map<pair<string,string>, string >  attributesValues_;   /**< attribute values <attribute name, object (component, signal, etc)> ,  value> */
 	map<string, bool>      attributesAddSignal_;            /**< Vivado requires to add :signal, I have to read a VHDL book to understand how to do this cleany */
 	map<string, string>    types_;                          /**< The list of type declarations (name, type) */
+	vector<pair<Signal*, bool>> delayLines_;                /**< The signals whose register chain is a delay line, true for a block RAM one, see mapDelayLines() */
 	string                 commentedName_;                  /**< Usually is the default name of the architecture.  */
 	string                 headerComment_;                  /**< Optional comment that gets added to the header. Possibly multiline.  */
 	string                 copyrightString_;                /**< Authors and years.  */
 	string                 additionalHeaderString_;         /**< User-defined header information (used, e.g., for primitives that require extra libraries).  */
 	bool                   hasClockEnable_;    	            /**< True if the operator has a clock enable signal  */
+	int                    clockEnableTreeDepth_;           /**< The depth of the pipelined clock enable tree, 0 if the registers are enabled by ce directly, see setupClockEnableTree() */
 	int		                 hasDelay1Feedbacks_;             /**< True if this operator has feedbacks of one cycle, and no more than one cycle (i.e. an error if the distance is more). False gives warnings */
 	Operator*              indirectOperator_;               /**< NULL if this operator is just an interface operator to several possible implementations, otherwise points to the instance*/
 	// small TODO: rename 
@@ -1780,6 +1965,8 @@ private:
 	bool                   noParseNoSchedule_;              /**< Flag instructing the VHDL to go through unchanged */
 	bool                   isShared_;                       /**< Flag to show whether the instances of this operator are flattened in the design or not */
 	bool                   isLibraryComponent_;             /**< Flag that indicates the the component is a library component (e.g., like primitives) and no code for the component or entity is generated. */
+	string                 buildCacheKey_;                  /**< The key of this operator in the build cache, if any */
+	bool                   isSignalGraphReleased_;          /**< Flag to show whether the internal signals were freed by releaseSignalGraph() */
 
 	vector<triplet<string, string, int>> unresolvedDependenceTable;   /**< The list of dependence relations which contain on either the lhs or rhs an (still) unknown name */
 	std::ostringstream     dotDiagram;                          /**< The internal stream to which the drawing methods will output */
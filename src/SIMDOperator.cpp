@@ -0,0 +1,225 @@
+/*
+  A SIMD operator generator for FloPoCo.
+
+  N lanes of the same operator, with the inputs and outputs packed in
+  wide buses. The lane is generated once and instantiated N times.
+
+  This file is part of the FloPoCo project
+
+  Author: agent
+
+  Initial software.
+  Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
+  2026.
+  All rights reserved.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include "Operator.hpp"
+#include "SIMDOperator.hpp"
+
+namespace flopoco{
+
+	SIMDOperator::SIMDOperator(Target* target, Operator *op, int lanes, vector<string> shared):
+		Operator(nullptr, target), op_(op), lanes_(lanes), shared_(shared)
+	{
+		srcFileName="SIMDOperator";
+		// the lane has already been scheduled, the VHDL of the lanes is written by hand
+		setNoParseNoSchedule();
+		setCopyrightString("agent (2026)");
+		setNameWithFreqAndUID(op_->getName() + "_x" + to_string(lanes));
+		if(op->isSequential())
+			setSequential();
+		else
+			setCombinatorial();
+
+		if(lanes < 1)
+			THROWERROR("the number of lanes should be at least 1");
+		for(auto i: shared) {
+			if(!op->isSignalDeclared(i) || op->getSignalByName(i)->type() != Signal::in)
+				THROWERROR("cannot share " << i << ", which is not an input of " << op->getName());
+		}
+
+		// the packed ports
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() == Signal::in){
+				if(isSharedInput(s->getName()))
+					addInput(s->getName(), s->width(), s->isBus());
+				else
+					addInput(s->getName(), lanes*s->width());
+			}else if(s->type() == Signal::out){
+				addOutput(s->getName(), lanes*s->width());
+				// all the lanes have the latency of the lane operator
+				getSignalByName(s->getName())->setCycle(op->getPipelineDepth());
+				for(int k=0; k<lanes; k++) {
+					string name = s->getName() + "_lane" + to_string(k);
+					if(s->isFP() || s->isIEEE())
+						declareFloatingPoint(name, s->wE(), s->wF(), Signal::wire, s->isIEEE());
+					else
+						declare(name, s->width(), s->isBus());
+					laneOutputs_.push_back(make_pair(getSignalByName(name), laneSlice(s, k)));
+				}
+			}
+		}
+
+		// the lane operator is declared once, and instantiated once per lane
+		addSubComponent(op);
+		for(int k=0; k<lanes; k++) {
+			vector<string> portMap;
+			if(op->isSequential()) {
+				portMap.push_back("clk  => clk");
+				if(op->hasReset())
+					portMap.push_back("rst  => rst");
+				if(op->hasClockEnable())
+					portMap.push_back("ce => ce");
+			}
+			for(int i=0; i<op->getIOListSize(); i++){
+				Signal* s = op->getIOListSignal(i);
+				if(s->type() == Signal::in)
+					portMap.push_back(s->getName() + " => " + (isSharedInput(s->getName()) ? s->getName() : laneSlice(s, k)));
+				else if(s->type() == Signal::out)
+					portMap.push_back(s->getName() + " => " + s->getName() + "_lane" + to_string(k));
+			}
+			vhdl << tab << "lane" << k << ": " << op->getName() << endl;
+			vhdl << tab << tab << "port map ( ";
+			for(size_t j=0; j<portMap.size(); j++)
+				vhdl << (j>0 ? ",\n" + tab + tab + "           " : "") << portMap[j];
+			vhdl << ");" << endl;
+		}
+
+		// pack the outputs, lane 0 in the LSBs
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() != Signal::out)
+				continue;
+			vhdl << tab << s->getName() << " <= ";
+			for(int k=lanes-1; k>=0; k--)
+				vhdl << s->getName() << "_lane" << k << (k>0 ? " & " : ";");
+			vhdl << endl;
+		}
+	}
+
+	SIMDOperator::~SIMDOperator() {
+	}
+
+	vector<pair<Signal*, string>> SIMDOperator::getLaneOutputs() {
+		return laneOutputs_;
+	}
+
+	string SIMDOperator::laneSlice(Signal* s, int k) {
+		if(s->width() == 1 && !s->isBus())
+			return s->getName() + "(" + to_string(k) + ")";
+		return s->getName() + "(" + to_string((k+1)*s->width()-1) + " downto " + to_string(k*s->width()) + ")";
+	}
+
+	bool SIMDOperator::isSharedInput(string input) {
+		return std::find(shared_.begin(), shared_.end(), input) != shared_.end();
+	}
+
+	void SIMDOperator::emulate(TestCase* tc) {
+		// each lane is emulated separately, and its outputs are checked separately
+		for(int k=0; k<lanes_; k++) {
+			TestCase laneTestCase(op_);
+			for(int i=0; i<op_->getIOListSize(); i++){
+				Signal* s = op_->getIOListSignal(i);
+				if(s->type() != Signal::in)
+					continue;
+				mpz_class v = tc->getInputValue(s->getName());
+				if(!isSharedInput(s->getName()))
+					v = (v >> (k*s->width())) & ((mpz_class(1) << s->width()) - 1);
+				laneTestCase.addInput(s->getName(), v);
+			}
+			op_->emulate(&laneTestCase);
+			for(int i=0; i<op_->getIOListSize(); i++){
+				Signal* s = op_->getIOListSignal(i);
+				if(s->type() != Signal::out)
+					continue;
+				for(auto v: laneTestCase.getExpectedOutputValues(s->getName()))
+					tc->addExpectedOutput(s->getName() + "_lane" + to_string(k), v);
+			}
+		}
+	}
+
+	TestCase* SIMDOperator::packLanes(vector<TestCase*> &laneTestCases) {
+		TestCase* tc = new TestCase(this);
+		for(int i=0; i<op_->getIOListSize(); i++){
+			Signal* s = op_->getIOListSignal(i);
+			if(s->type() != Signal::in)
+				continue;
+			mpz_class v = 0;
+			if(isSharedInput(s->getName()))
+				v = laneTestCases[0]->getInputValue(s->getName()); // the shared inputs of lane 0 win
+			else {
+				for(int k=0; k<lanes_; k++)
+					v += laneTestCases[k]->getInputValue(s->getName()) << (k*s->width());
+			}
+			tc->addInput(s->getName(), v);
+		}
+		emulate(tc);
+		return tc;
+	}
+
+	void SIMDOperator::buildStandardTestCases(TestCaseList* tcl) {
+		TestCaseList laneTcl;
+		op_->buildStandardTestCases(&laneTcl);
+		int n = laneTcl.getNumberOfTestCases();
+		// test case j puts the standard test case j+k of the lane operator in lane k, so each one goes through all the lanes
+		for(int j=0; j<n; j++) {
+			vector<TestCase*> laneTestCases;
+			for(int k=0; k<lanes_; k++)
+				laneTestCases.push_back(laneTcl.getTestCase((j+k) % n));
+			tcl->add(packLanes(laneTestCases));
+		}
+		for(int j=0; j<n; j++)
+			delete laneTcl.getTestCase(j);
+	}
+
+	TestCase* SIMDOperator::buildRandomTestCase(int i) {
+		// the random test cases of the lane operator, which are often biased towards the interesting cases
+		vector<TestCase*> laneTestCases;
+		for(int k=0; k<lanes_; k++)
+			laneTestCases.push_back(op_->buildRandomTestCase(i*lanes_ + k));
+		TestCase* tc = packLanes(laneTestCases);
+		for(auto l: laneTestCases)
+			delete l;
+		return tc;
+	}
+
+	OperatorPtr SIMDOperator::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
+		if(UserInterface::globalOpList.empty()){
+			throw("ERROR: SIMDOperator has no operator to replicate (it should come after the operator of one lane)");
+		}
+		int lanes;
+		string sharedList;
+		UserInterface::parseStrictlyPositiveInt(args, "lanes", &lanes);
+		UserInterface::parseString(args, "shared", &sharedList);
+		vector<string> shared;
+		if(sharedList != "none") {
+			std::stringstream ss(sharedList);
+			string item;
+			while (std::getline(ss, item, ':'))
+				shared.push_back(item);
+		}
+
+		Operator* lane = UserInterface::globalOpList.back();
+		UserInterface::globalOpList.pop_back();
+
+		return new SIMDOperator(target, lane, lanes, shared);
+	}
+
+	void SIMDOperator::registerFactory(){
+			UserInterface::add("SIMDOperator", // name
+								 "Places several lanes of the preceding operator side by side, with packed inputs and outputs (lane 0 in the LSBs).",
+								 "Miscellaneous",
+								 "Wrapper", // seeAlso
+								 "lanes(int): number of lanes;\
+                        shared(string)=none: colon-separated list of the inputs shared by all the lanes (e.g. a rounding mode), or none",
+								 "The lane operator is generated and scheduled once, and instantiated once per lane, so the generation time does not depend on the number of lanes. All the lanes have the latency of the lane operator.",
+								 SIMDOperator::parseArguments
+								 ) ;
+	}
+
+}
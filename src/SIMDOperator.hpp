@@ -0,0 +1,64 @@
+#ifndef SIMDOPERATOR_HPP
+#define SIMDOPERATOR_HPP
+#include "Operator.hpp"
+
+/**
+ * A SIMD operator places several lanes of the same operator side by side,
+ * with their inputs and outputs packed in wide buses (lane 0 in the LSBs).
+ * The lane is generated and scheduled once, and instantiated once per lane,
+ * so the generation time does not depend on the number of lanes.
+ * Control inputs (rounding mode, etc.) may be shared by all the lanes.
+ **/
+
+namespace flopoco{
+
+	class SIMDOperator : public Operator
+	{
+	public:
+		/**
+		 * The SIMDOperator constructor
+		 * @param[in] target the target device
+		 * @param[in] op the operator of one lane, already scheduled
+		 * @param[in] lanes the number of lanes
+		 * @param[in] shared the inputs of op that are shared by all the lanes, instead of being packed
+		 **/
+		SIMDOperator(Target* target, Operator* op, int lanes, vector<string> shared);
+
+		/** The destructor */
+		~SIMDOperator();
+
+		/** The outputs of each lane, with the slice of the packed output they occupy, so that they can be tested separately */
+		vector<pair<Signal*, string>> getLaneOutputs();
+
+		void emulate(TestCase* tc);
+		void buildStandardTestCases(TestCaseList* tcl);
+		TestCase* buildRandomTestCase(int i);
+
+		// User-interface stuff
+
+		/**
+		 * Factory method that parses arguments and calls the constructor
+		 */
+		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args);
+
+		/**
+		 * Factory register method
+		 */
+		static void registerFactory();
+
+	private:
+		Operator* op_; /**< The operator of one lane */
+		int lanes_; /**< The number of lanes */
+		vector<string> shared_; /**< The inputs shared by all the lanes */
+		vector<pair<Signal*, string>> laneOutputs_; /**< The outputs of each lane, and the slice of the packed output they occupy */
+
+		/** The slice of a packed port of this operator corresponding to the port s of lane k */
+		string laneSlice(Signal* s, int k);
+		/** Whether the input of the lane operator with this name is shared by all the lanes */
+		bool isSharedInput(string input);
+
+		/** A test case of this operator, packing the inputs of one test case per lane */
+		TestCase* packLanes(vector<TestCase*> &laneTestCases);
+	};
+}
+#endif
@@ -543,6 +543,10 @@ namespace flopoco{
 			lifeSpan_=delay;
 	}
 
+	void Signal::setLifeSpan(int delay) {
+		lifeSpan_=delay;
+	}
+
 	int Signal::getLifeSpan() {
 		return lifeSpan_;
 	}
@@ -464,6 +464,11 @@ class Operator;
 		 */
 		void updateLifeSpan(int delay) ;
 
+		/**
+		 * Sets the max delay associated to a signal, also when it decreases (used by Operator::retime())
+		 */
+		void setLifeSpan(int delay) ;
+
 
 		/**
 		 * Obtain max delay that has been applied to this signal
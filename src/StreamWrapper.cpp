@@ -0,0 +1,214 @@
+/*
+  A valid/ready stream wrapper generator for FloPoCo.
+
+  The wrapped operator keeps running without stalls: a valid bit follows
+  each input along the pipeline, and the results are collected in a FIFO
+  sized to the number of data in flight. The input is ready when the FIFO
+  is guaranteed to accept the corresponding result, which requires no
+  clock enable in the core, and no combinatorial path from m_ready to s_ready.
+
+  This file is part of the FloPoCo project
+
+  Author: agent
+
+  Initial software.
+  Copyright © ENS-Lyon, INRIA, CNRS, UCBL,
+  2026.
+  All rights reserved.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <climits>
+#include "Operator.hpp"
+#include "StreamWrapper.hpp"
+
+namespace flopoco{
+
+	StreamWrapper::StreamWrapper(Target* target, Operator *op):
+		Operator(nullptr, target), op_(op)
+	{
+		srcFileName="StreamWrapper";
+		// the core has already been scheduled, the wrapper VHDL is written by hand
+		setNoParseNoSchedule();
+		setCopyrightString("agent (2026)");
+		setNameWithFreqAndUID(op_->getName() + "_Stream");
+		setSequential();
+
+		const vector<string> handshake = {"s_valid", "s_ready", "m_valid", "m_ready"};
+		for(auto h: handshake) {
+			if(op->isSignalDeclared(h))
+				THROWERROR("cannot wrap " << op->getName() << ", which already has a signal named " << h);
+		}
+		if(op->getInitiationInterval() > 1)
+			THROWERROR("cannot wrap " << op->getName() << ", which accepts an input only every " << op->getInitiationInterval() << " cycles");
+
+		// Number of cycles between an input and its result
+		int latency = op->getPipelineDepth();
+		// The valid bit is delayed by this latency, which is only correct if all the outputs are ready at the same cycle
+		int maxInputCycle = INT_MIN;
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() == Signal::in && s->getCycle() > maxInputCycle)
+				maxInputCycle = s->getCycle();
+		}
+		if(maxInputCycle == INT_MIN) // no input, as in computePipelineDepths()
+			maxInputCycle = -1;
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() == Signal::out && s->getCycle() - maxInputCycle != latency)
+				THROWERROR("cannot wrap " << op->getName() << ", whose output " << s->getName() << " is ready after "
+									 << s->getCycle() - maxInputCycle << " cycles instead of its pipeline depth " << latency);
+		}
+		// Number of data in flight at full throughput: the pipeline, plus the cycle a result spends in the FIFO,
+		// plus the cycle it takes for the freed slot to become visible on s_ready
+		int depth = latency + 2;
+		REPORT(DETAILED, "wrapping " << op->getName() << " of latency " << latency << " with a FIFO of depth " << depth);
+
+		addInput("s_valid");
+		addOutput("s_ready");
+		addOutput("m_valid");
+		addInput("m_ready");
+
+		// copy the data ports of the wrapped operator
+		int fifoWidth = 0;
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() == Signal::in){
+				addInput(s->getName(), s->width(), s->isBus());
+				inPortMap(s->getName(), s->getName());
+			}else if(s->type() == Signal::out){
+				addOutput(s->getName(), s->width(), s->isBus());
+				outPortMap(s->getName(), "core_" + s->getName());
+				fifoWidth += s->width();
+			}
+		}
+		if(fifoWidth == 0)
+			THROWERROR("cannot wrap " << op->getName() << ", which has no output");
+
+		// the core never stalls
+		setClockEnable(false);
+		if(op->hasClockEnable())
+			vhdl << tab << declare("ce") << " <= '1';" << endl;
+
+		vhdl << instance(op, "core", false);
+
+		declare("accept");
+		declare("push");
+		declare("pop");
+		declareCustom("credits", "integer range 0 to " + to_string(depth));
+		declareCustom("count", "integer range 0 to " + to_string(depth));
+		declareCustom("wrPtr", "integer range 0 to " + to_string(depth-1));
+		declareCustom("rdPtr", "integer range 0 to " + to_string(depth-1));
+		addType("fifo_t", "array(0 to " + to_string(depth-1) + ") of std_logic_vector(" + to_string(fifoWidth-1) + " downto 0)");
+		declareCustom("fifo", "fifo_t");
+		declare("fifo_in", fifoWidth);
+		declare("fifo_out", fifoWidth);
+		if(latency > 0)
+			declare("valid_pipe", latency);
+		// the control registers need a reset, it also puts rst in the port list
+		Signal::ResetType resetType = (UserInterface::allRegistersWithAsyncReset ? Signal::asyncReset : Signal::syncReset);
+		getSignalByName("credits")->setResetType(resetType);
+
+		vhdl << endl << tab << "-- an input is accepted when the FIFO will have room for its result" << endl;
+		vhdl << tab << "s_ready <= '1' when credits /= 0 else '0';" << endl;
+		vhdl << tab << "accept <= s_valid when credits /= 0 else '0';" << endl;
+		vhdl << tab << "-- a valid bit follows each accepted input through the pipeline of the core" << endl;
+		if(latency == 0)
+			vhdl << tab << "push <= accept;" << endl;
+		else
+			vhdl << tab << "push <= valid_pipe(" << latency-1 << ");" << endl;
+		vhdl << tab << "m_valid <= '1' when count /= 0 else '0';" << endl;
+		vhdl << tab << "pop <= m_ready when count /= 0 else '0';" << endl;
+
+		// the results, packed in one FIFO word
+		int lsb = 0;
+		ostringstream unpack;
+		for(int i=0; i<op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if(s->type() != Signal::out)
+				continue;
+			string range = ((s->width() > 1 || s->isBus()) ? "(" + to_string(lsb+s->width()-1) + " downto " + to_string(lsb) + ")" : "(" + to_string(lsb) + ")");
+			vhdl << tab << "fifo_in" << range << " <= core_" << s->getName() << ";" << endl;
+			unpack << tab << s->getName() << " <= fifo_out" << range << ";" << endl;
+			lsb += s->width();
+		}
+		vhdl << tab << "fifo_out <= fifo(rdPtr);" << endl;
+		vhdl << unpack.str();
+
+		vhdl << endl << tab << "-- the FIFO memory, without reset so that it may be mapped to distributed RAM" << endl;
+		vhdl << tab << "process(clk)" << endl;
+		vhdl << tab << tab << "begin" << endl;
+		vhdl << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
+		vhdl << tab << tab << tab << tab << "if push = '1' then" << endl;
+		vhdl << tab << tab << tab << tab << tab << "fifo(wrPtr) <= fifo_in;" << endl;
+		vhdl << tab << tab << tab << tab << "end if;" << endl;
+		vhdl << tab << tab << tab << "end if;" << endl;
+		vhdl << tab << tab << "end process;" << endl;
+
+		ostringstream init, update;
+		string ind = string(tab) + tab + tab + tab + (resetType == Signal::asyncReset ? "" : tab);
+		if(latency > 0)
+			init << ind << "valid_pipe <= (others => '0');" << endl;
+		init << ind << "credits <= " << depth << ";" << endl;
+		init << ind << "count <= 0;" << endl;
+		init << ind << "wrPtr <= 0;" << endl;
+		init << ind << "rdPtr <= 0;" << endl;
+
+		if(latency == 1)
+			update << ind << "valid_pipe(0) <= accept;" << endl;
+		else if(latency > 1)
+			update << ind << "valid_pipe <= valid_pipe(" << latency-2 << " downto 0) & accept;" << endl;
+		update << ind << "if accept = '1' and pop = '0' then" << endl;
+		update << ind << tab << "credits <= credits - 1;" << endl;
+		update << ind << "elsif accept = '0' and pop = '1' then" << endl;
+		update << ind << tab << "credits <= credits + 1;" << endl;
+		update << ind << "end if;" << endl;
+		update << ind << "if push = '1' and pop = '0' then" << endl;
+		update << ind << tab << "count <= count + 1;" << endl;
+		update << ind << "elsif push = '0' and pop = '1' then" << endl;
+		update << ind << tab << "count <= count - 1;" << endl;
+		update << ind << "end if;" << endl;
+		for(string ptr: {"wrPtr", "rdPtr"}) {
+			update << ind << "if " << (ptr == "wrPtr" ? "push" : "pop") << " = '1' then" << endl;
+			update << ind << tab << "if " << ptr << " = " << depth-1 << " then" << endl;
+			update << ind << tab << tab << ptr << " <= 0;" << endl;
+			update << ind << tab << "else" << endl;
+			update << ind << tab << tab << ptr << " <= " << ptr << " + 1;" << endl;
+			update << ind << tab << "end if;" << endl;
+			update << ind << "end if;" << endl;
+		}
+
+		vhdl << endl << tab << "-- the handshake control" << endl;
+		if(resetType == Signal::asyncReset) {
+			vhdl << tab << "process(clk, rst)" << endl;
+			vhdl << tab << tab << "begin" << endl;
+			vhdl << tab << tab << tab << "if rst = '1' then" << endl;
+			vhdl << init.str();
+			vhdl << tab << tab << tab << "elsif clk'event and clk = '1' then" << endl;
+			vhdl << update.str();
+			vhdl << tab << tab << tab << "end if;" << endl;
+			vhdl << tab << tab << "end process;" << endl;
+		}
+		else {
+			vhdl << tab << "process(clk)" << endl;
+			vhdl << tab << tab << "begin" << endl;
+			vhdl << tab << tab << tab << "if clk'event and clk = '1' then" << endl;
+			vhdl << tab << tab << tab << tab << "if rst = '1' then" << endl;
+			vhdl << init.str();
+			vhdl << tab << tab << tab << tab << "else" << endl;
+			vhdl << update.str();
+			vhdl << tab << tab << tab << tab << "end if;" << endl;
+			vhdl << tab << tab << tab << "end if;" << endl;
+			vhdl << tab << tab << "end process;" << endl;
+		}
+	}
+
+	StreamWrapper::~StreamWrapper() {
+	}
+
+	Operator* StreamWrapper::getWrappedOperator() {
+		return op_;
+	}
+
+}
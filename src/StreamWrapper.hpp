@@ -0,0 +1,37 @@
+#ifndef STREAMWRAPPER_HPP
+#define STREAMWRAPPER_HPP
+#include "Operator.hpp"
+
+/**
+ * A stream wrapper turns a pipelined operator into a latency-insensitive one,
+ * with AXI-Stream-style valid/ready handshakes on its inputs and outputs.
+ * The core itself is never stalled: a valid bit travels along its pipeline,
+ * and its results are pushed into an output FIFO large enough for all the
+ * data in flight. An input is accepted only if its result will find room in
+ * the FIFO, which keeps the full throughput without a clock enable fanning out
+ * to all the registers of the core.
+ **/
+
+namespace flopoco{
+
+	class StreamWrapper : public Operator
+	{
+	public:
+		/**
+		 * The StreamWrapper constructor
+		 * @param[in] target the target device
+		 * @param[in] op the operator to be wrapped, already scheduled
+		 **/
+		StreamWrapper(Target* target, Operator* op);
+
+		/** The destructor */
+		~StreamWrapper();
+
+		/** The wrapped operator, which defines the data ports and the test cases */
+		Operator* getWrappedOperator();
+
+	private:
+		Operator* op_; /**< The operator to wrap */
+	};
+}
+#endif
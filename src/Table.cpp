@@ -233,7 +233,12 @@ namespace flopoco{
 
 
 	int Table::size_in_LUTs() {
-		return wOut*int(intpow2(wIn-getTarget()->lutInputs()));
+		return wOut*int(intpow2(max(wIn-getTarget()->lutInputs(), 0)));
+	}
+
+
+	bool Table::isLogicTable() {
+		return logicTable;
 	}
 
 
@@ -38,8 +38,12 @@ namespace flopoco{
 			useHardMultipliers_= true;
 			unusedHardMultThreshold_=0.5;
 			registerLargeTables_=true; 
+			retiming_=false;
+			useClockEnableTree_=false;
+			useDelayLines_=false;
 			tableCompression_=true;
 			ilpTimeout_=0;
+			adderGraphTimeout_=0;
 			generateFigures_=false;
 		}
 
@@ -134,6 +138,33 @@ namespace flopoco{
       registerLargeTables_ = b;
     }
 	
+	bool  Target::useDelayLines(){
+		return useDelayLines_;
+	}
+
+    void  Target::setUseDelayLines(bool b)
+    {
+      useDelayLines_ = b;
+    }
+
+	bool  Target::retiming(){
+		return retiming_;
+	}
+
+    void  Target::setRetiming(bool b)
+    {
+      retiming_ = b;
+    }
+
+	bool  Target::useClockEnableTree(){
+		return useClockEnableTree_;
+	}
+
+    void  Target::setUseClockEnableTree(bool b)
+    {
+      useClockEnableTree_ = b;
+    }
+
 	bool  Target::tableCompression(){
 		return tableCompression_;
 	}
@@ -184,6 +215,16 @@ namespace flopoco{
 		return ilpTimeout_;
 	}
 
+	void Target::setAdderGraphTimeout(int adderGraphTimeout)
+	{
+		adderGraphTimeout_ = adderGraphTimeout;
+	}
+
+	int Target::getAdderGraphTimeout()
+	{
+		return adderGraphTimeout_;
+	}
+
 	void Target::setTilingMethod(string method)
 	{
 		tiling_ = method;
@@ -1154,6 +1195,47 @@ namespace flopoco{
 	}
 
 
+	int Target::shiftRegisterLUTs(int depth){
+		if(vendor_ == "Xilinx"){
+			if(id_ == "Spartan3" || id_ == "Virtex4")
+				return ceil(depth/16.0); // cascaded SRL16
+			else
+				return ceil(depth/32.0); // cascaded SRL32, from Virtex5 on
+		}
+		return 0;
+	}
+
+
+	int Target::shiftRegisterMinDepth(){
+		if(shiftRegisterLUTs(32) == 0)
+			return 0;
+		// Flip-flops are abundant: there are two per LUT on the current families
+		double ffCost = 0.5;
+		// The SRL is followed by a flip-flop for timing
+		for(int depth=2; depth<128; depth++) {
+			if(shiftRegisterLUTs(depth) + ffCost < ffCost*depth)
+				return depth;
+		}
+		return 0;
+	}
+
+
+	bool Target::delayInBlockRAM(int width, int depth){
+		// deeper than a few cascaded SRLs, and filling a good part of a block
+		return depth >= 128 && (long)width*depth >= sizeOfMemoryBlock()/2;
+	}
+
+
+	int Target::clockEnableMaxFanout(){
+		// what is left of the cycle once the enable register and the enable input of the driven flip-flops are paid for
+		double budget = 1.0/frequency() - ffDelay() - lutDelay();
+		int fanout = 2; // below that, a tree makes no sense
+		while(fanout < 4096 && fanoutDelay(2*fanout) <= budget)
+			fanout *= 2;
+		return fanout;
+	}
+
+
 	double Target::getLUTPerSRL(int depth){
 
 		if(vendor_ == "Xilinx"){
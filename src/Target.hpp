@@ -133,6 +133,18 @@ namespace flopoco{
 		bool tableCompression();
 		void setTableCompression(bool v);
 
+		/** should the long register chains be built as shift registers or block RAM, see Operator::mapDelayLines() */
+		bool useDelayLines();
+		void setUseDelayLines(bool v);
+
+		/** should the schedule be retimed to save registers, see Operator::retime() */
+		bool retiming();
+		void setRetiming(bool v);
+
+		/** should the clock enable be distributed by a pipelined tree of registers, see Operator::setupClockEnableTree() */
+		bool useClockEnableTree();
+		void setUseClockEnableTree(bool v);
+
 
 		/** Returns true if the target has fast ternary adders in the logic blocks
 		 * @return the status of the hasFastLogicTernaryAdder_ parameter
@@ -175,6 +187,12 @@ namespace flopoco{
 		/** returns the ILP solver timeout in seconds */
 		int getILPTimeout();
 
+		/** sets the time budget in seconds for the search of the adder graphs of shift-and-add constant multipliers, 0 for a single RPAG run.*/
+		void setAdderGraphTimeout(int adderGraphTimeout);
+
+		/** returns the time budget of the adder graph search in seconds */
+		int getAdderGraphTimeout();
+
 		/** returns the compression method used for multiplier tiling */
 		string  getTilingMethod();
 
@@ -626,6 +644,34 @@ namespace flopoco{
 		 */
 		virtual double getRAMPerSRL(int depth);
 
+		/**
+		 * The number of LUTs of a delay line of @depth cycles built as cascaded shift register primitives.
+		 * This is the model of the delay lines, independent of the resource estimation model of getLUTPerSRL().
+		 * @return the number of LUTs, 0 if the target has no shift register primitive
+		 */
+		virtual int shiftRegisterLUTs(int depth);
+
+		/**
+		 * The minimal depth from which a pipeline register chain
+		 * is better built as a shift register (SRL) than as flip-flops,
+		 * according to shiftRegisterLUTs().
+		 * @return the depth, 0 if the target has no shift register primitive or if it never pays off
+		 */
+		virtual int shiftRegisterMinDepth();
+
+		/**
+		 * Should a pipeline delay of @depth cycles on a @width-bit signal,
+		 * without intermediate tap, be built as a circular buffer in block RAM
+		 */
+		virtual bool delayInBlockRAM(int width, int depth);
+
+		/**
+		 * The number of flip-flops one register of a clock enable tree
+		 * may drive while its fanout delay still fits in a cycle
+		 * at the target frequency.
+		 */
+		virtual int clockEnableMaxFanout();
+
 		/**
 		 * Determine the required number of LUTs for a multiplexer having
 		 * @nrInputs inputs. The number of LUTs depends on the target
@@ -777,6 +823,9 @@ namespace flopoco{
 																		1 means: any sub-multiplier, even very small ones, go to DSP*/
 		bool   plainVHDL_;     /**< True if we want the VHDL code to be concise and readable, with + and * instead of optimized FloPoCo operators. */
 		bool   registerLargeTables_;     /**< if true, a register is forced on the output of a Table objects that is larger than the blockRAM size, otherwise BlockRAM will not be used. Defaults to true, but sometimes you want to force a large table into LUTs. */
+		bool   useDelayLines_;     /**< if true, the long register chains are built as shift registers or block RAM */
+		bool   retiming_;     /**< if true, the signals are moved to later cycles after scheduling when this saves register bits */
+		bool   useClockEnableTree_;     /**< if true, the clock enable is distributed by a pipelined tree of registers of bounded fanout */
 		bool   tableCompression_;     /**< if true, Hsiao table compression will be used. Should default to true, the flag is there for experiments measuring how useful it is */
 		bool   generateFigures_;  /**< If true, some operators will generate figures which will clutter your directory  */
         bool   useTargetOptimizations_; /**< If true, target specific optimizations using primitives are performed. Vendor specific libraries are necessary for simulation. */
@@ -785,6 +834,7 @@ namespace flopoco{
 		string tiling_; /**< Defines the multiplier tiling method*/
 		string ilpSolverName_; /*** Defines the ILP solver for operators optimized by ILP. It has to match a solver name known by the ScaLP library */
 		int ilpTimeout_; /*** Defines the timeout in seconds for the ILP solver for operators optimized by ILP.*/
+		int adderGraphTimeout_; /*** Defines the time budget in seconds for the search of adder graphs, 0 for a single RPAG run.*/
 	};
 
 }
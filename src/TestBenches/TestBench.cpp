@@ -18,28 +18,37 @@
 #include <sstream>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 #include <gmp.h>
 #include <mpfr.h>
 #include <gmpxx.h>
 #include "utils.hpp"
 #include "Operator.hpp"
 #include "TestBench.hpp"
+#include "StreamWrapper.hpp"
+#include "SIMDOperator.hpp"
 
 using namespace std;
 
 namespace flopoco{
 
 
-	TestBench::TestBench(Target* target, Operator* op, int n, bool fromFile):
-		Operator(nullptr, target), op_(op), n_(n), fromFile_(fromFile)
+	TestBench::TestBench(Target* target, Operator* op, int n, bool fromFile, int threads):
+		Operator(nullptr, target), op_(op), n_(n), fromFile_(fromFile), threads_(threads)
 	{
+		// a stream wrapper is tested through its handshakes, on the test cases of the operator it wraps
+		StreamWrapper* stream = dynamic_cast<StreamWrapper*>(op);
+		dataOp_ = (stream ? stream->getWrappedOperator() : op);
+
 		//We do not set the parent operator to this operator
 		setNoParseNoSchedule();
 
 		useNumericStd();
 		// This allows the op under test to know how long it is being tested.
 		// useful only for testing the long acc, but who knows.
-		op->numberOfTests = n;
+		dataOp_->numberOfTests = n;
 
 		srcFileName="TestBench";
 		setNameWithFreqAndUID("TestBench_" + op_->getName());
@@ -51,10 +60,10 @@ namespace flopoco{
 		//        maybe best to be placed in main.cpp ?
 		FloPoCoRandomState::init(n);
 		// Generate the standard and random test cases for this operator
-		op-> buildStandardTestCases(&tcl_);
+		dataOp_-> buildStandardTestCases(&tcl_);
 		// initialization of randomstate generator with the seed base on the number of
 		// random testcase to be generated
-		if (!fromFile) op-> buildRandomTestCaseList(&tcl_, n);
+		if (!fromFile) dataOp_-> buildRandomTestCaseList(&tcl_, n);
 
 
 		// The instance
@@ -83,6 +92,13 @@ namespace flopoco{
 		vhdl << endl << instance(op, "test", false) << endl;
 		subComponentList_.clear(); // it is unfortunately set by instance()
 
+		// the lanes of a SIMD operator are checked separately
+		SIMDOperator* simd = dynamic_cast<SIMDOperator*>(dataOp_);
+		if(simd) {
+			for(auto l: simd->getLaneOutputs())
+				vhdl << tab << declare(l.first->getName(), l.first->width(), l.first->isBus()) << " <= " << l.second << ";" << endl;
+		}
+
 		vhdl << tab << "-- Ticking clock signal" <<endl;
 		vhdl << tab << "process" <<endl;
 		vhdl << tab << "begin" <<endl;
@@ -95,7 +111,9 @@ namespace flopoco{
 
 		setSequential();
 
-		if (fromFile)
+		if (stream)
+			generateStreamTest();
+		else if (fromFile)
 			generateTestFromFile();
 		else
 			generateTestInVhdl();
@@ -113,13 +131,11 @@ namespace flopoco{
 	 */
 	void TestBench::generateTestFromFile() {
 		vector<Signal*> inputSignalVector;
-		vector<Signal*> outputSignalVector;
+		vector<Signal*> outputSignalVector = checkedOutputs();
 
 		for(int i=0; i < op_->getIOListSize(); i++){
 			Signal* s = op_->getIOListSignal(i);
-			if (s->type() == Signal::out)
-				outputSignalVector.push_back(s);
-			else if (s->type() == Signal::in)
+			if (s->type() == Signal::in)
 				inputSignalVector.push_back(s);
 		};
 
@@ -182,7 +198,7 @@ namespace flopoco{
 			IOorderInput.push_back(s->getName());
 		}
 		vhdl << tab << tab << tab << "readline(inputsFile,inline);" << endl;  // it consume output line
-		vhdl << tab << tab << tab << "wait for 10 ns;" << endl; // let 10 ns between each input
+		vhdl << tab << tab << tab << "wait for " << 10*op_->getInitiationInterval() << " ns;" << endl; // let 10 ns between each input, or more for an iterative operator
 		vhdl << tab << tab << "end loop;" << endl;
 		vhdl << tab << tab << "wait for 10000 ns; -- wait for simulation to finish" << endl; // TODO : tune correctly with pipeline depth
 		vhdl << tab << "end process;" << endl;
@@ -242,65 +258,12 @@ namespace flopoco{
 
 		// vhdl << tab << tab << tab << "wait for "<< op_->getPipelineDepth()*10 <<" ns; -- wait for pipeline to flush" <<endl;
 		for(Signal* s: outputSignalVector){
-			vhdl << tab << tab << tab << "read(inline, possibilityNumber);" << endl;
-			vhdl << tab << tab << tab << "localErrorCounter := 0;" << endl;
-			vhdl << tab << tab << tab << "read(inline,tmpChar);" << endl; // we consume the character after output list
-			vhdl << tab << tab << tab << "expected_size_"<< s->getName() << " := inline'Length;"<< endl; // the remainder is the vector of expected outputs: remember how long it is
-			vhdl << tab << tab << tab << "expected_"<< s->getName() << " := inline.all & (expected_size_"<< s->getName() << "+1 to 1000 => ' ');"<< endl; // because we have to pad it to 1000 chars
-			string expectedString = "expected_" +  s->getName() + "(1 to expected_size_" + s->getName() + ")"; //  will be used several times below, so better have a Single Source of Bug
-			vhdl << tab << tab << tab << "if possibilityNumber = 0 then" << endl;
-			vhdl << tab << tab << tab << tab << "localErrorCounter := 0;" << endl;//read(inline,tmpChar);" << endl; // we consume the character between each outputs
-			vhdl << tab << tab << tab << "elsif possibilityNumber = 1 then " << endl;
-			vhdl << tab << tab << tab << tab << "read(inline ,V_"<< s->getName() << ");" << endl;
-			vhdl << tab << tab << tab << tab << "if ";
-			if (s->isFP()) {
-				vhdl << "not fp_equal(fp"<< s->width() << "'(" << s->getName() << ") ,to_stdlogicvector(V_" <<  s->getName() << "))";
-			} else if (s->isIEEE()) {
-			    vhdl << "not fp_equal_ieee(" << s->getName() << " ,to_stdlogicvector(V_" <<  s->getName() << "),"<<s->wE()<<" , "<<s->wF()<<")";
-			} else if ((s->width() == 1) && (!s->isBus())) {
-				vhdl << "not (" << s->getName() << "= to_stdlogic(V_" << s->getName() << "))";
-			} else {
-				vhdl << "not (" << s->getName() << "= to_stdlogicvector(V_" << s->getName() << "))";
-			}
-			vhdl << " then " << endl;
-			vhdl << tab << tab << tab << tab << tab << " errorCounter := errorCounter + 1;" << endl;
-			vhdl << tab << tab << tab << tab << tab << "assert false report(\"Line \" & integer'image(counter) & \" of input file, incorrect output for "
-					 << s->getName() << ": \" & lf & ";
-			vhdl << "\"  expected value: \" & "  << expectedString;
-			vhdl << " & lf & \"          result: \" & str(" << s->getName() <<")) ;"<< endl;
-			vhdl << tab << tab << tab << tab << "end if;" << endl;
-
-			vhdl << tab << tab << tab << "else" << endl;
-			vhdl << tab << tab << tab << tab << "for i in possibilityNumber downto 1 loop " << endl;
-			vhdl << tab << tab << tab << tab << tab << "read(inline ,V_"<< s->getName() << ");" << endl;
-			vhdl << tab << tab << tab << tab << tab << "read(inline,tmpChar);" << endl; // we consume the character between each outputs
-			if (s->isFP()) {
-				vhdl << tab << tab << tab << tab << tab << "if fp_equal(fp"<< s->width() << "'(" << s->getName() << ") ,to_stdlogicvector(V_" <<  s->getName() << ")) " << "  then localErrorCounter := 1; end if; " << endl;
-			} else if (s->isIEEE()) {
-				vhdl << tab << tab << tab << tab << tab << "if fp_equal_ieee(" << s->getName() << " ,to_stdlogicvector(V_" <<  s->getName() << "),"<<s->wE()<<" , "<<s->wF()<<")" << " then localErrorCounter := 1; end if;" << endl;
-			} else if ((s->width() == 1) && (!s->isBus())) {
-				vhdl << tab << tab << tab << tab << tab << "if (" << s->getName() << "= to_stdlogic(V_" << s->getName() << ")) " << " then localErrorCounter := 1; end if;" << endl;
-			} else {
-				vhdl << tab << tab << tab << tab << tab << "if (" << s->getName() << "= to_stdlogicvector(V_" << s->getName() << ")) " << " then localErrorCounter := 1; end if;" << endl;
-			}
-			vhdl << tab << tab << tab << tab << "end loop;" << endl;
-			vhdl << tab << tab << tab << tab << " if (localErrorCounter = 0) then " << endl;
-			vhdl << tab << tab << tab << tab << tab << "errorCounter := errorCounter + 1; -- incrementing global error counter" << endl;
-
-			// **** better aligned reporting here ****
-			vhdl << tab << tab << tab << tab << tab << "assert false report(\"Line \" & integer'image(counter) & \" of input file, incorrect output for "
-					 << s->getName() << ": \" & lf & ";
-			vhdl << "\" expected values: \" & "  << expectedString;
-			vhdl << " & lf & \"          result: \" & str(" << s->getName() <<")) ;"<< endl;
-
-			vhdl << tab << tab << tab << tab << "end if;" << endl;
-			vhdl << tab << tab << tab << "end if;" << endl;
-			// TODO add test to increment global error counter
+			generateOutputCheck(s);
 			/* adding the IO to the IOorder list */
 			IOorderOutput.push_back(s->getName());
 		};
-		vhdl << tab << tab << tab << " wait for 10 ns; -- wait for pipeline to flush" << endl;
-		currentOutputTime += 10 * (tcl_.getNumberOfTestCases()+n_); // time for simulation
+		vhdl << tab << tab << tab << " wait for " << 10*op_->getInitiationInterval() << " ns; -- wait for pipeline to flush" << endl;
+		currentOutputTime += 10 * op_->getInitiationInterval() * (tcl_.getNumberOfTestCases()+n_); // time for simulation
 		vhdl << tab << tab << tab << "counter := counter + 2;" << endl; // incrementing by 2 because a testcase takes two lines (one for input, one for output)
 		vhdl << tab << tab << "end loop;" << endl;
 		vhdl << tab << tab << "report (integer'image(errorCounter) & \" error(s) encoutered.\");" << endl;
@@ -310,6 +273,29 @@ namespace flopoco{
 		/* Setting the computed simulation Time */
 		simulationTime = currentOutputTime;
 
+		// exhaustive test: the simulation time depends on the size of the input space
+		if(n_ == -2) {
+			uint64_t number = 1;
+			for (Signal* s: inputSignalVector)
+				number <<= s->width();
+
+			// simulation time computation
+			currentOutputTime = 0;
+			// init
+			currentOutputTime += 10;
+			currentOutputTime += 5 * number * op_->getInitiationInterval();
+			currentOutputTime += op_->getPipelineDepth()*10;
+			currentOutputTime += 5 * number * op_->getInitiationInterval();
+			currentOutputTime += 2;
+			simulationTime=currentOutputTime;
+		}
+
+		writeTestFile(IOorderInput, IOorderOutput);
+	}
+
+
+	/* Writes the inputs and expected outputs of the test cases to test.input, in the order given by IOorderInput and IOorderOutput */
+	void TestBench::writeTestFile(list<string> &IOorderInput, list<string> &IOorderOutput) {
 		/* Generating a file of inputs */
 		// opening a file to write down the output (for text-file based test)
 		// if n < 0 we do not generate a file
@@ -327,14 +313,14 @@ namespace flopoco{
 			/*
 			// generation on the fly of random test case
 			for (int i = 0; i < n_; i++) {
-				TestCase* tc = op_->buildRandomTestCase(i);
+				TestCase* tc = dataOp_->buildRandomTestCase(i);
 				if (fileOut) fileOut << tc->generateInputString(IOorderInput,IOorderOutput);
 				delete tc;
 			};
 			*/
 			TestCaseList *tcl = new TestCaseList();
 
-			op_->buildRandomTestCaseList(tcl, n_);
+			dataOp_->buildRandomTestCaseList(tcl, n_);
 			for (int i = 0; i < n_; i++) {
 				TestCase* tc = tcl->getTestCase(i);
 				if (fileOut) fileOut << tc->generateInputString(IOorderInput,IOorderOutput);
@@ -356,58 +342,91 @@ namespace flopoco{
 				THROWERROR("Not able to open " << inputFileName << " in order to write inputs. ");
 
 			REPORT(LIST,"Generating the exhaustive test bench, this may take some time");
-			// exhaustive test
-			int length = inputSignalVector.size();
-			//			REPORT(0, "Found " << length << "inputs"); 
-			int* InWidth = new int[length];
-			// getting signal width
-			for (int i = 0; i < length; i++) InWidth[i] = inputSignalVector[i]->width();
-			mpz_class* bound = new mpz_class[length];
-			mpz_class* counters = new mpz_class[length];
-			int number = 1;
-			for (int i = 0; i < length; i++) {
-				bound[i] = (mpz_class(1) << InWidth[i]);// * tmp;
-				counters[i] = 0;
-				number *= intpow2(InWidth[i]);
-			}
-			// getting signal name
-			string* IOname = new string[length];
-			for (int i = 0; i < length; i++) IOname[i] = inputSignalVector[i]->getName();
-			TestCase* tc;
+			enumerateInputSpace(dataOp_, threads_,
+													[&](TestCase* tc, ostream& o) {
+														dataOp_->emulate(tc);
+														o << tc->generateInputString(IOorderInput,IOorderOutput);
+													},
+													fileOut);
+			fileOut.close();
+		}
+	}
 
-			// simulation time computation
-			currentOutputTime = 0;
-			// init
-			currentOutputTime += 10;
-			currentOutputTime += 5 * number;
-			currentOutputTime += op_->getPipelineDepth()*10;
-			currentOutputTime += 5 * number;
-			currentOutputTime += 2;
-			simulationTime=currentOutputTime;
 
+	/* The outputs of dataOp_, or the outputs of each lane if it is a SIMD operator */
+	vector<Signal*> TestBench::checkedOutputs() {
+		vector<Signal*> outputs;
+		SIMDOperator* simd = dynamic_cast<SIMDOperator*>(dataOp_);
+		if(simd) {
+			for(auto l: simd->getLaneOutputs())
+				outputs.push_back(l.first);
+			return outputs;
+		}
+		for(int i=0; i < dataOp_->getIOListSize(); i++){
+			Signal* s = dataOp_->getIOListSignal(i);
+			if (s->type() == Signal::out)
+				outputs.push_back(s);
+		}
+		return outputs;
+	}
 
-			while (true) {
-				for (int i = 0; i < length-1; i++) {
-            		if (counters[i] >= bound[i]) {
-						counters[i] = 0;
-						counters[i+1] += 1;
-					}
-				}
-				// if the max counter overflows, break
-				if (counters[length-1] >= bound[length-1]) break;
-				// Test Case inputs
-				tc = new TestCase(op_);
-				for (int i = 0; i < length; i++) {
-					tc->addInput(IOname[i],counters[i]);
-				}
-				op_->emulate(tc);
-				if (fileOut) fileOut << tc->generateInputString(IOorderInput,IOorderOutput);
-				// incrementation
-				counters[0]++;
-				delete tc;
-			}
-			fileOut.close();
+
+	/* Compares the output s to the values read from the line of expected outputs (variable inline) */
+	void TestBench::generateOutputCheck(Signal* s) {
+		vhdl << tab << tab << tab << "read(inline, possibilityNumber);" << endl;
+		vhdl << tab << tab << tab << "localErrorCounter := 0;" << endl;
+		vhdl << tab << tab << tab << "read(inline,tmpChar);" << endl; // we consume the character after output list
+		vhdl << tab << tab << tab << "expected_size_"<< s->getName() << " := inline'Length;"<< endl; // the remainder is the vector of expected outputs: remember how long it is
+		vhdl << tab << tab << tab << "expected_"<< s->getName() << " := inline.all & (expected_size_"<< s->getName() << "+1 to 1000 => ' ');"<< endl; // because we have to pad it to 1000 chars
+		string expectedString = "expected_" +  s->getName() + "(1 to expected_size_" + s->getName() + ")"; //  will be used several times below, so better have a Single Source of Bug
+		vhdl << tab << tab << tab << "if possibilityNumber = 0 then" << endl;
+		vhdl << tab << tab << tab << tab << "localErrorCounter := 0;" << endl;//read(inline,tmpChar);" << endl; // we consume the character between each outputs
+		vhdl << tab << tab << tab << "elsif possibilityNumber = 1 then " << endl;
+		vhdl << tab << tab << tab << tab << "read(inline ,V_"<< s->getName() << ");" << endl;
+		vhdl << tab << tab << tab << tab << "if ";
+		if (s->isFP()) {
+			vhdl << "not fp_equal(fp"<< s->width() << "'(" << s->getName() << ") ,to_stdlogicvector(V_" <<  s->getName() << "))";
+		} else if (s->isIEEE()) {
+		    vhdl << "not fp_equal_ieee(" << s->getName() << " ,to_stdlogicvector(V_" <<  s->getName() << "),"<<s->wE()<<" , "<<s->wF()<<")";
+		} else if ((s->width() == 1) && (!s->isBus())) {
+			vhdl << "not (" << s->getName() << "= to_stdlogic(V_" << s->getName() << "))";
+		} else {
+			vhdl << "not (" << s->getName() << "= to_stdlogicvector(V_" << s->getName() << "))";
+		}
+		vhdl << " then " << endl;
+		vhdl << tab << tab << tab << tab << tab << " errorCounter := errorCounter + 1;" << endl;
+		vhdl << tab << tab << tab << tab << tab << "assert false report(\"Line \" & integer'image(counter) & \" of input file, incorrect output for "
+				 << s->getName() << ": \" & lf & ";
+		vhdl << "\"  expected value: \" & "  << expectedString;
+		vhdl << " & lf & \"          result: \" & str(" << s->getName() <<")) ;"<< endl;
+		vhdl << tab << tab << tab << tab << "end if;" << endl;
+
+		vhdl << tab << tab << tab << "else" << endl;
+		vhdl << tab << tab << tab << tab << "for i in possibilityNumber downto 1 loop " << endl;
+		vhdl << tab << tab << tab << tab << tab << "read(inline ,V_"<< s->getName() << ");" << endl;
+		vhdl << tab << tab << tab << tab << tab << "read(inline,tmpChar);" << endl; // we consume the character between each outputs
+		if (s->isFP()) {
+			vhdl << tab << tab << tab << tab << tab << "if fp_equal(fp"<< s->width() << "'(" << s->getName() << ") ,to_stdlogicvector(V_" <<  s->getName() << ")) " << "  then localErrorCounter := 1; end if; " << endl;
+		} else if (s->isIEEE()) {
+			vhdl << tab << tab << tab << tab << tab << "if fp_equal_ieee(" << s->getName() << " ,to_stdlogicvector(V_" <<  s->getName() << "),"<<s->wE()<<" , "<<s->wF()<<")" << " then localErrorCounter := 1; end if;" << endl;
+		} else if ((s->width() == 1) && (!s->isBus())) {
+			vhdl << tab << tab << tab << tab << tab << "if (" << s->getName() << "= to_stdlogic(V_" << s->getName() << ")) " << " then localErrorCounter := 1; end if;" << endl;
+		} else {
+			vhdl << tab << tab << tab << tab << tab << "if (" << s->getName() << "= to_stdlogicvector(V_" << s->getName() << ")) " << " then localErrorCounter := 1; end if;" << endl;
 		}
+		vhdl << tab << tab << tab << tab << "end loop;" << endl;
+		vhdl << tab << tab << tab << tab << " if (localErrorCounter = 0) then " << endl;
+		vhdl << tab << tab << tab << tab << tab << "errorCounter := errorCounter + 1; -- incrementing global error counter" << endl;
+
+		// **** better aligned reporting here ****
+		vhdl << tab << tab << tab << tab << tab << "assert false report(\"Line \" & integer'image(counter) & \" of input file, incorrect output for "
+				 << s->getName() << ": \" & lf & ";
+		vhdl << "\" expected values: \" & "  << expectedString;
+		vhdl << " & lf & \"          result: \" & str(" << s->getName() <<")) ;"<< endl;
+
+		vhdl << tab << tab << tab << tab << "end if;" << endl;
+		vhdl << tab << tab << tab << "end if;" << endl;
+		// TODO add test to increment global error counter
 	}
 
 
@@ -421,7 +440,7 @@ namespace flopoco{
 		vhdl << tab << tab << "rst <= '0';" << endl;
 		for (int i = 0; i < tcl_.getNumberOfTestCases(); i++){
 			vhdl << tcl_.getTestCase(i)->getInputVHDL(tab + tab);
-			vhdl << tab << tab << "wait for 10 ns;" <<endl;
+			vhdl << tab << tab << "wait for " << 10*op_->getInitiationInterval() << " ns;" <<endl;
 		}
 		/* COULD NOT BE USED BECAUSE IT HAS TO BE THE SAME TESTCASE FOR INPUT AND OUTPUT GENERATION
 		// generation on the fly of random test case (VALID only for FPFMA)
@@ -456,8 +475,8 @@ namespace flopoco{
 				vhdl << tab <<  "-- " << tc->getComment() << endl;
 			vhdl << tc->getInputVHDL(tab + tab + "-- input: ");
 			vhdl << tc->getExpectedOutputVHDL(tab + tab);
-			vhdl << tab << tab << "wait for 10 ns;" <<endl;
-			currentOutputTime += 10;
+			vhdl << tab << tab << "wait for " << 10*op_->getInitiationInterval() << " ns;" <<endl;
+			currentOutputTime += 10*op_->getInitiationInterval();
 		}
 		/* SEE REMARK FOR ON THE FLY INPUT GENERATION
                 // generation on the fly of random test case (VALID only for FPFMA)
@@ -478,6 +497,167 @@ namespace flopoco{
 		simulationTime=currentOutputTime;
 	}
 
+	/* Testing a stream wrapper: the inputs are sent and the outputs received through the valid/ready handshakes,
+	 * both sides stalling at random, and the results must come out in order.
+	 */
+	void TestBench::generateStreamTest() {
+		vector<Signal*> inputSignalVector;
+		vector<Signal*> outputSignalVector = checkedOutputs();
+
+		for(int i=0; i < dataOp_->getIOListSize(); i++){
+			Signal* s = dataOp_->getIOListSignal(i);
+			if (s->type() == Signal::in)
+				inputSignalVector.push_back(s);
+		};
+
+		list<string> IOorderInput;
+		list<string> IOorderOutput;
+
+		// One transfer on each side, where the testbench stalls one cycle out of four on average.
+		// The stimuli change on the falling edge, the handshake signals are sampled on the rising edge.
+		auto sendInput = [](string t) {
+			ostringstream o;
+			o << t << "uniform(seed1, seed2, r);" << endl;
+			o << t << "while r < 0.25 loop" << endl;
+			o << t << tab << "wait until falling_edge(clk);" << endl;
+			o << t << tab << "uniform(seed1, seed2, r);" << endl;
+			o << t << "end loop;" << endl;
+			o << t << "s_valid <= '1';" << endl;
+			o << t << "loop" << endl;
+			o << t << tab << "wait until rising_edge(clk);" << endl;
+			o << t << tab << "exit when s_ready = '1';" << endl;
+			o << t << "end loop;" << endl;
+			o << t << "wait until falling_edge(clk);" << endl;
+			o << t << "s_valid <= '0';" << endl;
+			return o.str();
+		};
+		auto receiveOutput = [](string t) {
+			ostringstream o;
+			o << t << "loop" << endl;
+			o << t << tab << "uniform(seed1, seed2, r);" << endl;
+			o << t << tab << "if r < 0.25 then" << endl;
+			o << t << tab << tab << "m_ready <= '0';" << endl;
+			o << t << tab << "else" << endl;
+			o << t << tab << tab << "m_ready <= '1';" << endl;
+			o << t << tab << "end if;" << endl;
+			o << t << tab << "wait until rising_edge(clk);" << endl;
+			o << t << tab << "exit when m_valid = '1' and m_ready = '1';" << endl;
+			o << t << tab << "wait until falling_edge(clk);" << endl;
+			o << t << "end loop;" << endl;
+			return o.str();
+		};
+
+		vhdl << tab << "-- Sending the inputs, with random stalls" << endl;
+		vhdl << tab << "process" <<endl;
+		if(fromFile_) {
+			vhdl << tab << tab << "variable inline : line; " << endl;
+			vhdl << tab << tab << "variable tmpChar : character;" << endl;
+			vhdl << tab << tab << "file inputsFile : text is \"test.input\"; " << endl;
+			for(Signal* s: inputSignalVector)
+				vhdl << tab << tab << "variable V_" << s->getName() << " : bit_vector("<< s->width() - 1 << " downto 0);" << endl;
+		}
+		vhdl << tab << tab << "variable seed1 : positive := 1;" << endl;
+		vhdl << tab << tab << "variable seed2 : positive := 2;" << endl;
+		vhdl << tab << tab << "variable r : real;" << endl;
+		vhdl << tab << "begin" << endl;
+		vhdl << tab << tab << "s_valid <= '0';" << endl;
+		vhdl << tab << tab << "-- Send reset" <<endl;
+		vhdl << tab << tab << "rst <= '1';" << endl;
+		vhdl << tab << tab << "wait for 10 ns;" << endl;
+		vhdl << tab << tab << "rst <= '0';" << endl;
+		if(fromFile_) {
+			vhdl << tab << tab << "while not endfile(inputsFile) loop" << endl;
+			vhdl << tab << tab << tab << "readline(inputsFile,inline);" << endl;
+			for(Signal* s: inputSignalVector){
+				vhdl << tab << tab << tab << "read(inline ,V_"<< s->getName() << ");" << endl;
+				vhdl << tab << tab << tab << "read(inline,tmpChar);" << endl; // we consume the character between each inputs
+				if ((s->width() == 1) && (!s->isBus())) vhdl << tab << tab << tab << s->getName() << " <= to_stdlogicvector(V_" << s->getName() << ")(0);" << endl;
+				else vhdl << tab << tab << tab << s->getName() << " <= to_stdlogicvector(V_" << s->getName() << ");" << endl;
+				IOorderInput.push_back(s->getName());
+			}
+			vhdl << tab << tab << tab << "readline(inputsFile,inline);" << endl;  // it consumes the output line
+			vhdl << sendInput(tab + tab + tab);
+			vhdl << tab << tab << "end loop;" << endl;
+		}
+		else {
+			for (int i = 0; i < tcl_.getNumberOfTestCases(); i++){
+				vhdl << tcl_.getTestCase(i)->getInputVHDL(tab + tab);
+				vhdl << sendInput(tab + tab);
+			}
+		}
+		vhdl << tab << tab << "wait;" << endl;
+		vhdl << tab << "end process;" <<endl;
+		vhdl <<endl;
+
+		vhdl << tab << "-- Checking the outputs, with random stalls" << endl;
+		vhdl << tab << "process" <<endl;
+		if(fromFile_) {
+			vhdl << tab << tab << "variable inline0 : line; " << endl;
+			vhdl << tab << tab << "variable inline : line; " << endl;
+			vhdl << tab << tab << "variable counter : integer := 1;" << endl;
+			vhdl << tab << tab << "variable errorCounter : integer := 0;" << endl;
+			vhdl << tab << tab << "variable possibilityNumber : integer := 0;" << endl;
+			vhdl << tab << tab << "variable localErrorCounter : integer := 0;" << endl;
+			vhdl << tab << tab << "variable tmpChar : character;" << endl;
+			vhdl << tab << tab << "file inputsFile : text is \"test.input\"; " << endl;
+			for(Signal* s: outputSignalVector){
+				vhdl << tab << tab << "variable V_" << s->getName();
+				if ((s->width() != 1) || (s->isBus())) vhdl << " : bit_vector("<< s->width() - 1 << " downto 0);" << endl;
+				else  vhdl << " : bit;" << endl;
+				vhdl << tab << tab << "variable expected_"  << s->getName() << ": string (1 to 1000);" << endl;
+				vhdl << tab << tab << "variable expected_size_"  << s->getName() << " : integer;" << endl;
+			}
+		}
+		vhdl << tab << tab << "variable seed1 : positive := 3;" << endl;
+		vhdl << tab << tab << "variable seed2 : positive := 4;" << endl;
+		vhdl << tab << tab << "variable r : real;" << endl;
+		vhdl << tab << "begin" << endl;
+		vhdl << tab << tab << "m_ready <= '0';" << endl;
+		vhdl << tab << tab << "wait for 10 ns; -- wait for reset to complete" <<endl;
+		if(fromFile_) {
+			vhdl << tab << tab << "while not endfile(inputsFile) loop" << endl;
+			vhdl << tab << tab << tab << "readline(inputsFile,inline0);" << endl; // it consumes the input line
+			vhdl << tab << tab << tab << "readline(inputsFile,inline);" << endl;
+			vhdl << receiveOutput(tab + tab + tab);
+			for(Signal* s: outputSignalVector){
+				generateOutputCheck(s);
+				IOorderOutput.push_back(s->getName());
+			}
+			vhdl << tab << tab << tab << "wait until falling_edge(clk);" << endl;
+			vhdl << tab << tab << tab << "counter := counter + 2;" << endl; // a testcase takes two lines
+			vhdl << tab << tab << "end loop;" << endl;
+			vhdl << tab << tab << "report (integer'image(errorCounter) & \" error(s) encoutered.\");" << endl;
+			vhdl << tab << tab << "report \"End of simulation\" severity note;" <<endl;
+		}
+		else {
+			for (int i = 0; i < tcl_.getNumberOfTestCases(); i++) {
+				TestCase* tc = tcl_.getTestCase(i);
+				vhdl << receiveOutput(tab + tab);
+				if (tc->getComment() != "")
+					vhdl << tab <<  "-- " << tc->getComment() << endl;
+				vhdl << tc->getInputVHDL(tab + tab + "-- input: ");
+				vhdl << tc->getExpectedOutputVHDL(tab + tab);
+				vhdl << tab << tab << "wait until falling_edge(clk);" << endl;
+			}
+			vhdl << tab << tab << "assert false report \"End of simulation\" severity failure;" <<endl;
+		}
+		vhdl << tab << tab << "wait;" << endl;
+		vhdl << tab << "end process;" <<endl;
+
+		// The stalls make the timing of the test random: budget 4 cycles per test, which is plenty
+		uint64_t tests = tcl_.getNumberOfTestCases() + (fromFile_ ? max(n_, 0) : 0);
+		if(n_ == -2) {
+			tests = 1;
+			for (Signal* s: inputSignalVector)
+				tests <<= s->width();
+		}
+		simulationTime = 10 + 10 * (dataOp_->getPipelineDepth() + 2) + 40 * tests;
+
+		if(fromFile_)
+			writeTestFile(IOorderInput, IOorderOutput);
+	}
+
+
 	TestBench::~TestBench() {
 	}
 
@@ -494,6 +674,8 @@ namespace flopoco{
 		*/
 
 		Operator::stdLibs(o);
+		if(dataOp_ != op_) // for the random stalls
+			o << "use ieee.math_real.all;" << endl << endl;
 
 		outputVHDLEntity(o);
 		o << "architecture behavorial of " << name  << " is" << endl;
@@ -677,11 +859,141 @@ namespace flopoco{
 
 
 
+	void TestBench::enumerateInputSpace(Operator* op, int threads, std::function<void(TestCase*, ostream&)> processTestCase, ostream& out) {
+		vector<Signal*> inputSignalVector;
+		int totalWidth = 0;
+		for(int i=0; i < op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if (s->type() == Signal::in) {
+				inputSignalVector.push_back(s);
+				totalWidth += s->width();
+			}
+		}
+		if(totalWidth > 40) {
+			ostringstream e;
+			e << "ERROR in TestBench: an exhaustive test of " << op->getName() << " would have 2^" << totalWidth << " test cases, the limit is 2^40";
+			throw e.str();
+		}
+		if(threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		if(threads > 1 && !op->hasThreadSafeEmulate()) {
+			cerr << "WARNING: " << op->getName() << " does not declare a thread-safe emulate(), its exhaustive test uses a single thread" << endl;
+			threads = 1;
+		}
+
+		const uint64_t number = uint64_t(1) << totalWidth;
+		const uint64_t sliceSize = uint64_t(1) << 16; // test cases per thread and per round
+		for(uint64_t roundStart = 0; roundStart < number; roundStart += threads*sliceSize) {
+			vector<ostringstream> buffers(threads);
+			vector<string> errors(threads);
+			vector<std::thread> workers;
+			for(int t = 0; t < threads; t++) {
+				uint64_t first = roundStart + t*sliceSize;
+				if(first >= number)
+					break;
+				uint64_t last = std::min(first + sliceSize, number);
+				workers.push_back(std::thread([&, t, first, last]() {
+							try {
+								for(uint64_t x = first; x < last; x++) {
+									TestCase tc(op);
+									uint64_t v = x;
+									for(Signal* s: inputSignalVector) {
+										tc.addInput(s->getName(), mpz_class((unsigned long)(v & ((uint64_t(1) << s->width()) - 1))));
+										v >>= s->width();
+									}
+									processTestCase(&tc, buffers[t]);
+								}
+							}
+							catch(string &e) {
+								errors[t] = e;
+							}
+							catch(std::exception &e) {
+								errors[t] = e.what();
+							}
+						}));
+			}
+			for(auto &w: workers)
+				w.join();
+			for(auto &e: errors)
+				if(e != "")
+					throw e;
+			for(auto &b: buffers)
+				out << b.str();
+		}
+	}
+
+
+
+	uint64_t TestBench::checkEmulateExhaustively(Operator* op, int threads) {
+		vector<string> inputNames;
+		vector<string> outputNames;
+		for(int i=0; i < op->getIOListSize(); i++){
+			Signal* s = op->getIOListSignal(i);
+			if (s->type() == Signal::in)
+				inputNames.push_back(s->getName());
+			else if (s->type() == Signal::out)
+				outputNames.push_back(s->getName());
+		}
+
+		string mismatchFileName = "test.mismatches";
+		ofstream fileOut(mismatchFileName.c_str(), ios::out);
+		if (!fileOut)
+			throw string("ERROR in TestBench: not able to open " + mismatchFileName);
+
+		std::atomic<uint64_t> mismatches(0);
+		cerr << "> TestBench: checking emulate() against emulateReference() exhaustively for " << op->getName() << endl;
+		enumerateInputSpace(op, threads,
+												[&](TestCase* tc, ostream& o) {
+													TestCase ref(op);
+													for(string name: inputNames)
+														ref.addInput(name, tc->getInputValue(name));
+													if(!op->emulateReference(&ref))
+														throw string("ERROR in TestBench: ") + op->getName() + " does not provide emulateReference(), use simulate=true";
+													op->emulate(tc);
+													bool ok = true;
+													for(string name: outputNames) {
+														vector<mpz_class> allowed = tc->getExpectedOutputValues(name);
+														for(mpz_class v: ref.getExpectedOutputValues(name)) {
+															if(find(allowed.begin(), allowed.end(), v) == allowed.end())
+																ok = false;
+														}
+													}
+													if(!ok) {
+														mismatches++;
+														for(string name: inputNames)
+															o << name << "=" << tc->getInputValue(name).get_str(2) << " ";
+														o << "-> ";
+														for(string name: outputNames) {
+															o << name << ": reference";
+															for(mpz_class v: ref.getExpectedOutputValues(name))
+																o << " " << v.get_str(2);
+															o << ", allowed";
+															for(mpz_class v: tc->getExpectedOutputValues(name))
+																o << " " << v.get_str(2);
+															o << "  ";
+														}
+														o << endl;
+													}
+												},
+												fileOut);
+		fileOut.close();
+		cerr << "> TestBench: " << mismatches << " mismatch(es)";
+		if(mismatches > 0)
+			cerr << ", see " << mismatchFileName;
+		cerr << endl;
+		return mismatches;
+	}
+
+
+
 
 
 	OperatorPtr TestBench::parseArguments(OperatorPtr parentOp, Target *target, vector<string> &args) {
 		int n;
 		bool file;
+		bool exhaustive;
+		bool simulate;
+		int threads;
 
 		if(UserInterface::globalOpList.empty()){
 			throw(string("TestBench has no operator to wrap (it should come after the operator it wraps)"));
@@ -689,8 +1001,22 @@ namespace flopoco{
 
 		UserInterface::parseInt(args, "n", &n);
 		UserInterface::parseBoolean(args, "file", &file);
+		UserInterface::parseBoolean(args, "exhaustive", &exhaustive);
+		UserInterface::parseBoolean(args, "simulate", &simulate);
+		UserInterface::parseInt(args, "threads", &threads);
+		if(exhaustive) {
+			if(!file)
+				throw(string("TestBench: exhaustive=true requires file=true"));
+			n = -2;
+		}
 		Operator* toWrap = UserInterface::globalOpList.back();
-		Operator* newOp = new TestBench(target, toWrap, n, file);
+		if(!simulate) {
+			if(n != -2)
+				throw(string("TestBench: simulate=false is only supported for the exhaustive test"));
+			checkEmulateExhaustively(toWrap, threads);
+			return nullptr;
+		}
+		Operator* newOp = new TestBench(target, toWrap, n, file, threads);
 		// the instance in newOp has added toWrap as a subcomponent of newOp,
 		// so we may remove it from globalOpList
 		//UserInterface::globalOpList.pop_back();
@@ -703,7 +1029,10 @@ namespace flopoco{
 											 "TestBenches",
 											 "fixed-point function evaluator; fixed-point", // categories
 											 "n(int)=-2: number of random tests. If n=-2, an exhaustive test is generated (use only for small operators);\
-                        file(bool)=true:Inputs and outputs are stored in file test.input (lower VHDL compilation time). If false, they are stored in the VHDL;",
+                        file(bool)=true:Inputs and outputs are stored in file test.input (lower VHDL compilation time). If false, they are stored in the VHDL;\
+                        exhaustive(bool)=false: same as n=-2;\
+                        threads(int)=1: number of threads used to compute the exhaustive test, 0 for one per hardware thread (only for the operators that declare a thread-safe emulate);\
+                        simulate(bool)=true: if false, no VHDL is generated: emulate() is checked exhaustively against the bit-exact model emulateReference() of the operator, and mismatches are written to test.mismatches;",
 											 "",
 											 TestBench::parseArguments
 											 ) ;
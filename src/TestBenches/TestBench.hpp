@@ -6,6 +6,8 @@
  * The test cases are generated by the unit under test (UUT).
  */
 
+#include <functional>
+
 namespace flopoco{
 
 	class TestBench : public Operator
@@ -16,8 +18,9 @@ namespace flopoco{
 		 * @param target The target architecture
 		 * @param op The operator which is the UUT
 		 * @param n Number of tests
+		 * @param threads Number of threads used to compute the exhaustive test (n=-2), 0 for one per hardware thread
 		 */
-		TestBench(Target *target, Operator *op, int n, bool fromFile = false);
+		TestBench(Target *target, Operator *op, int n, bool fromFile = false, int threads = 1);
 
 		/** Destructor */
 		~TestBench();
@@ -39,9 +42,32 @@ namespace flopoco{
 		 */
 		void generateTestInVhdl();
 
+		/* Generating the tests of a stream wrapper, through its valid/ready handshakes with random stalls,
+		 * from a file or from the vhdl code
+		 */
+		void generateStreamTest();
+
 		/** Return the total simulation time*/
 		int getSimulationTime();
 
+		/** Enumerate all the input values of op (the first input varies fastest), using several threads.
+		 * The input space is cut in contiguous slices, each thread writes to its own buffer,
+		 * and the buffers are flushed to out in order, so the output does not depend on the number of threads.
+		 * Only the operators whose hasThreadSafeEmulate() is true use several threads.
+		 * @param op the operator whose input space is enumerated
+		 * @param threads the number of threads, 0 for one per hardware thread
+		 * @param processTestCase called on a TestCase holding only the inputs, and the stream of the current thread
+		 * @param out the stream where the buffers are flushed
+		 */
+		static void enumerateInputSpace(Operator* op, int threads, std::function<void(TestCase*, ostream&)> processTestCase, ostream& out);
+
+		/** Exhaustively check, without any VHDL simulation, that the output of op->emulateReference()
+		 * belongs to the set of values allowed by op->emulate().
+		 * Mismatches are written to test.mismatches.
+		 * @return the number of mismatches
+		 */
+		static uint64_t checkEmulateExhaustively(Operator* op, int threads);
+
 
 		/** Factory method that parses arguments and calls the constructor */
 		static OperatorPtr parseArguments(OperatorPtr parentOp, Target *target , vector<string> &args);
@@ -51,11 +77,22 @@ namespace flopoco{
 
 		
 	private:
+		/** Writes the inputs and expected outputs of the test cases to test.input */
+		void writeTestFile(list<string> &IOorderInput, list<string> &IOorderOutput);
+
+		/** The outputs to check: those of dataOp_, or those of each lane if it is a SIMD operator */
+		vector<Signal*> checkedOutputs();
+
+		/** Compares the output s to the values read from the line of expected outputs */
+		void generateOutputCheck(Signal* s);
+
 		Operator *op_; /**< The unit under test UUT */
+		Operator *dataOp_; /**< The operator that builds and emulates the test cases: op_, or the operator wrapped in op_ if it is a stream wrapper */
 		int       n_;   /**< The parameter from the constructor */
 		TestCaseList tcl_; /**< Test case list */
 		int simulationTime; /**< Total simulation time */
 		bool fromFile_; /**< Flag for external file I/O */
+		int threads_; /**< Number of threads for the exhaustive test generation */
 	};
 
 }
@@ -1,8 +1,10 @@
 #include "UserInterface.hpp"
 #include "Targets/AllTargetsHeaders.hpp"
 #include "TestBenches/TestBench.hpp"
+#include "StreamWrapper.hpp"
 
 #include "AutoTest/AutoTest.hpp"
+#include "BuildCache.hpp"
 
 #include <algorithm>
 #include <sys/stat.h>
@@ -36,6 +38,10 @@ namespace flopoco
 	bool   UserInterface::clockEnable;
 	bool   UserInterface::useHardMult;
 	bool   UserInterface::registerLargeTables;
+	bool   UserInterface::retiming;
+	bool   UserInterface::delayLines;
+	bool   UserInterface::clockEnableTree;
+	bool   UserInterface::stream=false; // used for the -stream option
 	bool   UserInterface::tableCompression;
 	bool   UserInterface::plainVHDL;
 	bool   UserInterface::generateFigures;
@@ -45,7 +51,10 @@ namespace flopoco
 	string   UserInterface::tiling;
 	string UserInterface::ilpSolver;
 	int    UserInterface::ilpTimeout;
+	int    UserInterface::adderGraphTimeout;
 	bool   UserInterface::allRegistersWithAsyncReset;
+	bool   UserInterface::lowMemory;
+	int    UserInterface::workers;
 #if 0 // Shall we resurrect all this some day?
 	int    UserInterface::resourceEstimation;
 	bool   UserInterface::floorplanning;
@@ -119,12 +128,18 @@ namespace flopoco
 				v.push_back(option_t("clockEnable", values));
 				v.push_back(option_t("plainVHDL", values));
 				v.push_back(option_t("generateFigures", values));
+				v.push_back(option_t("lowMemory", values));
 				v.push_back(option_t("useHardMults", values));
 				v.push_back(option_t("registerLargeTables", values));
+				v.push_back(option_t("retiming", values));
+				v.push_back(option_t("delayLines", values));
+				v.push_back(option_t("clockEnableTree", values));
+				v.push_back(option_t("stream", values));
 				v.push_back(option_t("tableCompression", values));
 				v.push_back(option_t("useTargetOptimizations", values));
 				v.push_back(option_t("ilpSolver", values));
 				v.push_back(option_t("ilpTimeout", values));
+				v.push_back(option_t("adderGraphTimeout", values));
 				v.push_back(option_t("compression", values));
 				v.push_back(option_t("tiling", values));
 
@@ -134,6 +149,8 @@ namespace flopoco
 				v.push_back(option_t("outputFile", values));
 				v.push_back(option_t("hardMultThreshold", values));
 				v.push_back(option_t("frequency", values));
+				v.push_back(option_t("cache", values));
+				v.push_back(option_t("workers", values));
 
 				//verbosity level
 				values.clear();
@@ -174,6 +191,8 @@ namespace flopoco
 				drawDotDiagram(UserInterface::globalOpList);
 			}
 
+			// The build cache needs the VHDL code, which outputVHDL() frees as it goes
+			BuildCache::saveAll(UserInterface::globalOpList);
 			outputVHDL();
 			finalReport(cerr);
 			sollya_lib_close();
@@ -199,17 +218,25 @@ namespace flopoco
 		parseFloat(args, "hardMultThreshold", &unusedHardMultThreshold, true); // sticky option
 		parseBoolean(args, "useHardMult", &useHardMult, true);
 		parseBoolean(args, "registerLargeTables", &registerLargeTables, true);
+		parseBoolean(args, "retiming", &retiming, true);
+		parseBoolean(args, "delayLines", &delayLines, true);
+		parseBoolean(args, "clockEnableTree", &clockEnableTree, true);
+		parseBoolean(args, "stream", &stream, true); // not sticky: will be used, and reset, after the operator parser
 		parseBoolean(args, "tableCompression", &tableCompression, true);
 		parseBoolean(args, "generateFigures", &generateFigures, true);
 		parseBoolean(args, "useTargetOptimizations", &useTargetOptimizations, true);
 		parseString(args, "ilpSolver", &ilpSolver, true); // sticky option
 		parsePositiveInt(args, "ilpTimeout", &ilpTimeout, true); // sticky option
+		parsePositiveInt(args, "adderGraphTimeout", &adderGraphTimeout, true); // sticky option
 		parseString(args, "compression", &compression, true);
 		parseString(args, "tiling", &tiling, true);
 		parseBoolean(args, "allRegistersWithAsyncReset", &allRegistersWithAsyncReset, true);
+		parseBoolean(args, "lowMemory", &lowMemory, true);
+		parsePositiveInt(args, "workers", &workers, true); // sticky option
 		//		parseBoolean(args, "floorplanning", &floorplanning, true);
 		//		parseBoolean(args, "reDebug", &reDebug, true );
 		parseString(args, "dependencyGraph", &depGraphDrawing, true);
+		parseString(args, "cache", &BuildCache::directory, true); // sticky option
 		//	parseBoolean(args, "", &  );
 	}
 
@@ -261,12 +288,12 @@ namespace flopoco
 
 	void UserInterface::outputVHDLToFile(ofstream& file){
 		set<string> alreadyOutput; // to avoid redundant output
-		outputVHDLToFile(UserInterface::globalOpList, file, alreadyOutput);
+		outputVHDLToFile(UserInterface::globalOpList, file, alreadyOutput, true);
 	}
 
 
 	/* The recursive method */
-	void UserInterface::outputVHDLToFile(vector<OperatorPtr> &oplist, ofstream& file, set<string> &alreadyOutput )
+	void UserInterface::outputVHDLToFile(vector<OperatorPtr> &oplist, ostream& file, set<string> &alreadyOutput, bool release)
 	{
 
 		for(auto i: oplist) {
@@ -274,13 +301,19 @@ namespace flopoco
 				// check for subcomponents
 				if(! i->getSubComponentListR().empty() ){
 					//recursively call to print subcomponents
-					outputVHDLToFile(i->getSubComponentListR(), file, alreadyOutput);
+					outputVHDLToFile(i->getSubComponentListR(), file, alreadyOutput, release);
 				}
 
 				//output the vhdl code to file if it was not done already
 				if(alreadyOutput.find(i->getName())==alreadyOutput.end()) {
 					i->outputVHDL(file);
 					alreadyOutput.insert(i->getName());
+					// Only the interface of this operator is needed from now on (by the component declarations of its parent)
+					if(release) {
+						i->releaseVHDL();
+						if(lowMemory)
+							i->releaseSignalGraph();
+					}
 				}
 			}
 			catch (std::string &s)	{
@@ -358,14 +391,20 @@ namespace flopoco
 		targetFrequencyMHz=400;
 		useHardMult=true;
 		registerLargeTables=false;
+		retiming=false;
+		delayLines=false;
+		clockEnableTree=false;
 		tableCompression=false;
 		allRegistersWithAsyncReset=false;
+		lowMemory=false;
+		workers=0;
 		unusedHardMultThreshold=0.7;
 		compression = "heuristicMaxEff";
 		tiling = "heuristicBasicTiling"; //should be heuristicBeamSearchTiling in future
 
 		ilpSolver = "Gurobi";
 		ilpTimeout = 0; //timeout disabled
+		adderGraphTimeout = 0; //single RPAG run
 
 		depGraphDrawing = "no";
 		generateFigures = false;
@@ -477,6 +516,9 @@ namespace flopoco
 				target->setUseHardMultipliers(useHardMult);
 				target->setUnusedHardMultThreshold(unusedHardMultThreshold);
 				target->setRegisterLargeTables(registerLargeTables);
+				target->setRetiming(retiming);
+				target->setUseDelayLines(delayLines);
+				target->setUseClockEnableTree(clockEnableTree);
 				target->setTableCompression(tableCompression);
 				target->setPlainVHDL(plainVHDL);
 				target->setGenerateFigures(generateFigures);
@@ -484,6 +526,7 @@ namespace flopoco
 				target->setCompressionMethod(compression);
 				target->setILPSolver(ilpSolver);
 				target->setILPTimeout(ilpTimeout);
+				target->setAdderGraphTimeout(adderGraphTimeout);
 				target->setTilingMethod(tiling);
 
 				// Now build the operator
@@ -493,6 +536,8 @@ namespace flopoco
 				}
 				// Call the constructor at last (through the factory)
 				OperatorPtr op = fp->parseArguments(nullptr, target, opParams);
+				bool streamOp = stream; // not sticky
+				stream = false;
 				if(op!=NULL)	{// Some factories don't actually create an operator
 					if(entityName!="") {
 						op->changeName(entityName);
@@ -502,6 +547,11 @@ namespace flopoco
 					// Schedule it
 					op->schedule();
 					op->applySchedule();
+					if(streamOp) {
+						// the top-level operator is replaced by its valid/ready wrapper, which instantiates it
+						UserInterface::globalOpList.pop_back();
+						UserInterface::globalOpList.push_back(new StreamWrapper(target, op));
+					}
 				}
 			}
 		}catch(std::string &s){
@@ -758,6 +808,24 @@ namespace flopoco
 	}
 
 
+	void UserInterface::parseThroughput(vector<string> &args, string key, int* initiationInterval, bool genericOption){
+		string val;
+		parseString(args, key, &val, genericOption);
+		if(val=="")
+			return;
+		string denominator = val;
+		if(val.substr(0,2) == "1/")
+			denominator = val.substr(2);
+		else if(val != "1")
+			throw (args[0] +": expecting 1 or 1/k for parameter " + key + ", got " + val);
+		size_t end;
+		int intval=stoi(denominator, &end);
+		if (denominator.length() != end || intval <= 0)
+			throw (args[0] +": expecting 1 or 1/k with k a strictly positive int for parameter " + key + ", got " + val);
+		*initiationInterval = intval;
+	}
+
+
 	void UserInterface::add( string name,
 													 string description, /**< for the HTML doc and the detailed help */
 													 string category,
@@ -794,6 +862,7 @@ namespace flopoco
 		s << COLOR_BLUE_NORMAL<< "Example: " << COLOR_NORMAL << "flopoco  frequency=300 target=Virtex5   FPExp  wE=8 wF=23 name=SinglePrecisionFPExp" << endl;
 		s << "Generic options include:" << endl;
 		s << "  " << COLOR_BOLD << "name" << COLOR_NORMAL << "=<string>:                override the the default entity name "<<endl;
+		s << "  " << COLOR_BOLD << "stream" << COLOR_NORMAL << "=<0|1>:                 wrap the operator in AXI-Stream-style valid/ready handshakes (s_valid, s_ready, m_valid, m_ready), without stalling its pipeline (default false)"<<endl;
 		s << "  " << COLOR_BOLD << "outputFile" << COLOR_NORMAL << "=<string>:          override the the default output file name " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL <<endl;
 		s << "  " << COLOR_BOLD << "target" << COLOR_NORMAL << "=<string>:              target FPGA (default " << defaultFPGA << ") " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "     Supported targets: Kintex7, StratixV, Virtex6, Zynq7000, VirtexUltrascalePlus"<<endl;
@@ -802,16 +871,23 @@ namespace flopoco
 		s << "  " << COLOR_BOLD << "useHardMult" << COLOR_NORMAL << "=<0|1>:            use hardware multipliers " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "tableCompression" << COLOR_NORMAL << "=<0|1>:       use errorless table compression when possible (default false while experimental)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "registerLargeTables" << COLOR_NORMAL << "=<0|1>:    force registering of large ROMs to force the use of blockRAMs (default false)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "retiming" << COLOR_NORMAL << "=<0|1>:               after scheduling, move signals to later cycles when this saves register bits, without changing the latency (default false)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "delayLines" << COLOR_NORMAL << "=<0|1>:             build the long pipeline register chains as shift registers (SRL) or block RAM delay lines when the target allows (default false)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "clockEnableTree" << COLOR_NORMAL << "=<0|1>:        with clockEnable=1, distribute the clock enable through a pipelined register tree of bounded fanout, at the cost of a few cycles of latency (default false)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "useTargetOptimizations" << COLOR_NORMAL << "=<0|1>: use target specific optimizations (e.g., using primitives) " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "allRegistersWithAsyncReset" << COLOR_NORMAL << "=<0|1>: if set, all the pipeline registers have an asynchronous reset signal" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "ilpSolver" << COLOR_NORMAL << "=<string>:           override ILP solver for operators optimized by ILP, has to match a solver name known by the ScaLP library" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "ilpTimeout" << COLOR_NORMAL << "=<int>:             sets the timeout in seconds for the ILP solver for operators optimized by ILP (default=3600)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "adderGraphTimeout" << COLOR_NORMAL << "=<int>:      time budget in seconds for the search of the adder graphs of shift-and-add constant multipliers, found graphs are cached with cache= (default 0: a single RPAG run)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "compression" << COLOR_NORMAL << "=<heuristicMaxEff,heuristicPA,heuristicFirstFit,optimal,optimalMinStages>:        compression method (default=heuristicMaxEff)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
-		s << "  " << COLOR_BOLD << "tiling" << COLOR_NORMAL << "=<heuristicBasicTiling,optimal,heuristicGreedyTiling,heuristicXGreedyTiling,heuristicBeamSearchTiling>:        tiling method (default=heuristicBeamSearchTiling)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "tiling" << COLOR_NORMAL << "=<heuristicBasicTiling,optimal,heuristicGreedyTiling,heuristicXGreedyTiling,heuristicBeamSearchTiling,portfolio,portfolioOptimal>:        tiling method (default=heuristicBeamSearchTiling)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
         s << "  " << COLOR_BOLD << "hardMultThreshold" << COLOR_NORMAL << "=<float>: unused hard mult threshold (O..1, default 0.7) " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "verbose" << COLOR_NORMAL << "=<int>:        verbosity level (0-4, default=1)" << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "  " << COLOR_BOLD << "generateFigures" << COLOR_NORMAL << "=<0|1>:generate graphics in SVG or LaTeX for some operators (default off) " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL << endl;
 		s << "  " << COLOR_BOLD << "dependencyGraph" << COLOR_NORMAL << "=<no|compact|full>: generate data dependence drawing of the Operator (default no) " << COLOR_RED_NORMAL << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "lowMemory" << COLOR_NORMAL << "=<0|1>:              free the internal signals of each operator once its VHDL is output (default off) " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "workers" << COLOR_NORMAL << "=<int>:              number of worker processes for the slow parts of the generation, e.g. polynomial approximations (default 0: one per core) " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
+		s << "  " << COLOR_BOLD << "cache" << COLOR_NORMAL << "=<directory>:        reuse the sub-operators built by previous runs with the same parameters and options (default: no cache). The polynomial approximations are also cached there " << COLOR_RED_NORMAL << "(sticky option)" << COLOR_NORMAL<<endl;
 		s << "Sticky options apply to the rest of the command line, unless changed again" <<endl;
 		s <<endl;
 		s <<  COLOR_BOLD << "List of operators with command-line interface"<< COLOR_NORMAL << " (a few more are hidden inside FloPoCo)" <<endl;
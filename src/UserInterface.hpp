@@ -89,6 +89,8 @@ namespace flopoco
 		static void parseStrictlyPositiveInt(vector<string> &args, string key, int* variable, bool genericOption=false);
 		static void parseFloat(vector<string> &args, string key, double* variable, bool genericOption=false);
 		static void parseString(vector<string> &args, string key, string* variable, bool genericOption=false);
+		/** Parses a throughput given as 1 or 1/k, and returns the initiation interval k */
+		static void parseThroughput(vector<string> &args, string key, int* initiationInterval, bool genericOption=false);
 		static void parseColonSeparatedStringList(vector<string> &args, string key, vector<string>* variable, bool genericOption=false);
 		static void parseColonSeparatedIntList(vector<string> &args, string key, vector<int>* variable, bool genericOption=false);
 
@@ -118,11 +120,13 @@ namespace flopoco
 		*/
 		static void popGlobalOpList();
 
-		/** generates the code for operators in globalOpList, and all their subcomponents */
+		/** generates the code for operators in globalOpList, and all their subcomponents.
+				The code of each operator is freed as soon as it is written, so this can be done only once. */
 		static void outputVHDLToFile(ofstream& file);
 
-		/** generates the code for operators in oplist, and all their subcomponents */
-		static void outputVHDLToFile(vector<OperatorPtr> &oplist, ofstream& file, set<string> &alreadyOutput);
+		/** generates the code for operators in oplist, and all their subcomponents
+				@param release if true, free the code of each operator once it is written (see Operator::releaseVHDL()) */
+		static void outputVHDLToFile(vector<OperatorPtr> &oplist, ostream& file, set<string> &alreadyOutput, bool release=false);
 
 	private:
 		/** register a factory */
@@ -149,6 +153,8 @@ namespace flopoco
 		static int    verbose;
 		static int pipelineActive_;
 		static bool   allRegistersWithAsyncReset; // too lazy to write setters/getters
+		static bool   lowMemory;
+		static int    workers;  /**< number of worker processes for the parallel parts of operator construction, 0 for one per hardware thread */
 	private:
 		static string outputFileName;
 		static string entityName;
@@ -159,6 +165,10 @@ namespace flopoco
 		static bool   useHardMult;
 		static bool   plainVHDL;
 		static bool   registerLargeTables;
+		static bool   retiming;
+		static bool   delayLines;
+		static bool   clockEnableTree;
+		static bool   stream;
 		static bool   tableCompression;
 		static bool   generateFigures;
 		static double unusedHardMultThreshold;
@@ -167,6 +177,7 @@ namespace flopoco
 		static string tiling;
 		static string ilpSolver;
 		static int    ilpTimeout;
+		static int    adderGraphTimeout;
 #if 0 // Shall we resurrect all this some day?
 		static int    resourceEstimation;
 		static bool   floorplanning;
@@ -25,11 +25,173 @@
 #include <gmp.h>
 #include <gmpxx.h>
 #include "math.h"
+#include <thread>
+#include <chrono>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "TestBenches/IEEENumber.hpp"
 using namespace std;
 
 
 namespace flopoco{
+	std::recursive_mutex sollyaMutex;
+
+
+
+	bool forkMap(int n, int workers, std::function<string(int)> job, std::function<bool(int, string)> accept, double timeout, bool isolate)
+	{
+		if(n <= 0)
+			return true;
+		if(workers <= 0)
+			workers = std::max(1u, std::thread::hardware_concurrency());
+		workers = std::min(workers, n);
+		if(workers <= 1 && timeout <= 0 && !isolate) { // a job can only be interrupted in a worker process
+			for(int i=0; i<n; i++) {
+				if(!accept(i, job(i)))
+					return false;
+			}
+			return true;
+		}
+
+		vector<pid_t> pids(workers, -1);
+		vector<struct pollfd> fds(workers);
+		vector<string> buffers(workers);
+		vector<int> jobOf(workers, -1); // with isolate, the job of each worker process
+		vector<bool> received(n, false);
+		int next = 0; // with isolate, the next job to launch
+
+		// Forks a worker process that computes the jobs first, first+step... and sends their results on a pipe
+		auto spawn = [&](int w, int first, int step) {
+			int fd[2];
+			if(pipe(fd) != 0)
+				throw(string("forkMap: pipe() failed"));
+			cout.flush();
+			cerr.flush();
+			pid_t pid = fork();
+			if(pid < 0)
+				throw(string("forkMap: fork() failed"));
+			if(pid == 0) { // worker process
+				close(fd[0]);
+				for(auto f: fds)
+					if(f.fd >= 0)
+						close(f.fd);
+				for(int i=first; i<n; i+=step) {
+					string line;
+					// never unwind into the code of the parent
+					try {
+						line = to_string(i) + " " + job(i) + "\n";
+					}
+					catch(string &e) {
+						cerr << e << endl;
+						_exit(1);
+					}
+					catch(std::exception &e) {
+						cerr << e.what() << endl;
+						_exit(1);
+					}
+					catch(...) {
+						_exit(1);
+					}
+					size_t written = 0;
+					while(written < line.size()) {
+						ssize_t k = write(fd[1], line.c_str()+written, line.size()-written);
+						if(k <= 0)
+							_exit(1);
+						written += k;
+					}
+				}
+				close(fd[1]);
+				_exit(0);
+			}
+			close(fd[1]);
+			pids[w] = pid;
+			fds[w].fd = fd[0];
+			fds[w].events = POLLIN;
+			fds[w].revents = 0;
+		};
+
+		for(int w=0; w<workers; w++)
+			fds[w].fd = -1;
+		for(int w=0; w<workers; w++) {
+			if(isolate) {
+				jobOf[w] = next;
+				spawn(w, next++, n);
+			}
+			else
+				spawn(w, w, workers);
+		}
+
+		// Collect the results as they come
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+		int openPipes = workers;
+		bool cancelled = false;
+		while(openPipes > 0 && !cancelled) {
+			int pollTimeout = -1;
+			if(timeout > 0) {
+				pollTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if(pollTimeout <= 0) {
+					cancelled = true;
+					break;
+				}
+			}
+			int ready = poll(fds.data(), fds.size(), pollTimeout);
+			if(ready <= 0)
+				continue; // EINTR, or the deadline, checked above
+			for(int w=0; w<workers && !cancelled; w++) {
+				if(fds[w].fd < 0 || fds[w].revents == 0)
+					continue;
+				char chunk[4096];
+				ssize_t k = read(fds[w].fd, chunk, sizeof(chunk));
+				if(k <= 0) {
+					close(fds[w].fd);
+					fds[w].fd = -1; // ignored by poll from now on
+					openPipes--;
+					if(isolate) {
+						waitpid(pids[w], nullptr, 0);
+						pids[w] = -1;
+						if(!received[jobOf[w]]) { // the process of this job died
+							received[jobOf[w]] = true;
+							if(!accept(jobOf[w], ""))
+								cancelled = true;
+						}
+						if(!cancelled && next < n) {
+							jobOf[w] = next;
+							spawn(w, next++, n);
+							openPipes++;
+						}
+					}
+					continue;
+				}
+				buffers[w].append(chunk, k);
+				size_t eol;
+				while(!cancelled && (eol = buffers[w].find('\n')) != string::npos) {
+					string line = buffers[w].substr(0, eol);
+					buffers[w].erase(0, eol+1);
+					size_t space = line.find(' ');
+					int i = stoi(line.substr(0, space));
+					received[i] = true;
+					if(!accept(i, line.substr(space+1)))
+						cancelled = true;
+				}
+			}
+		}
+
+		for(int w=0; w<workers; w++) {
+			if(pids[w] < 0)
+				continue;
+			if(cancelled)
+				kill(pids[w], SIGKILL);
+			if(fds[w].fd >= 0)
+				close(fds[w].fd);
+			waitpid(pids[w], nullptr, 0);
+		}
+		if(!cancelled && std::find(received.begin(), received.end(), false) != received.end())
+			throw(string("forkMap: a worker process died"));
+		return !cancelled;
+	}
+
 	/** Initialization of FloPoCoRandomState state */
 	gmp_randstate_t FloPoCoRandomState::m_state;
 	
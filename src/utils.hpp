@@ -13,6 +13,8 @@
 #include <inttypes.h>
 
 #include <stdarg.h>
+#include <mutex>
+#include <functional>
 
 
 using namespace std;
@@ -542,6 +544,24 @@ namespace flopoco{
 
 	/** A helper function that will convert a signal name into its lowercase version */
 	string toLower(const string& str);
+
+	/** Sollya is not reentrant. Code that may run in several threads (e.g. emulate() called
+			by the multi-threaded exhaustive TestBench) must hold this lock around its Sollya calls */
+	extern std::recursive_mutex sollyaMutex;
+
+	/** Computes job(0) ... job(n-1) in at most workers forked processes, which is how Sollya-heavy loops can use several cores.
+			Worker w computes the jobs w, w+workers, w+2*workers... in this order.
+			The results (strings without newline) are passed to accept() in the parent process, in no particular order.
+			If accept() returns false, the remaining jobs are cancelled.
+			With workers<=1, or n<=1, and no timeout, everything happens in the current process, in increasing order of i.
+			If a worker process dies, an exception is thrown once the other jobs are done.
+			@param workers the number of processes, 0 for one per hardware thread
+			@param timeout a wall-clock budget in seconds, after which the remaining jobs are cancelled (0 for none)
+			@param isolate if true, each job runs in its own process, forked when a previous one ends, in increasing order of i.
+			A job whose process dies then only passes an empty result to accept(). Nothing happens in the current process.
+			@return false if the jobs were cancelled
+	*/
+	bool forkMap(int n, int workers, std::function<string(int)> job, std::function<bool(int, string)> accept, double timeout=0, bool isolate=false);
 }
 
 